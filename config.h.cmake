@@ -40,6 +40,7 @@
 #cmakedefine HAVE_NDIR_H 1 
 #cmakedefine HAVE_POPEN 1 
 #cmakedefine HAVE_PWD_H 1 
+#cmakedefine HAVE_REALPATH 1 
 #cmakedefine HAVE_SELECT 1 
 #cmakedefine HAVE_STDINT_H 1 
 #cmakedefine HAVE_STDLIB_H 1 
@@ -0,0 +1,83 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       :  resample_bench
+@DESCRIPTION:  compares the resampler with the per-voxel loop of trilinear_resample
+@COPYRIGHT  :
+              Copyright 2011 Vladimir Fonov, McConnell Brain Imaging Centre,
+              Montreal Neurological Institute, McGill University.
+              Permission to use, copy, modify, and distribute this
+              software and its documentation for any purpose and without
+              fee is hereby granted, provided that the above copyright
+              notice appear in all copies.  The author and McGill University
+              make no representations about the suitability of this
+              software for any purpose.  It is provided "as is" without
+              express or implied warranty.
+---------------------------------------------------------------------------- */
+#include <iostream>
+#include <algorithm>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/time.h>
+#include "minc_io_resample.h"
+
+using namespace minc;
+
+static double now(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv,NULL);
+  return tv.tv_sec+tv.tv_usec*1e-6;
+}
+
+int main(int argc,char **argv)
+{
+  int size=argc>1?atoi(argv[1]):192;
+  double _step=argc>2?atof(argv[2]):0.7;
+
+  if(size<2 || _step<=0.0)
+  {
+    std::cerr<<"Usage: "<<argv[0]<<" [size] [step]"<<std::endl;
+    return 1;
+  }
+
+  try
+  {
+    simple_volume<float> input_vol(size,size,size);
+    for(size_t i=0;i<input_vol.c_buf_size();i++)
+      input_vol.c_buf()[i]=static_cast<float>(sin(i*0.001)*100.0);
+
+    int new_size=static_cast<int>((size-1)/_step);
+    simple_volume<float> output_vol(new_size,new_size,new_size);
+    simple_volume<float> output_vol2(new_size,new_size,new_size);
+    output_vol2.step()=IDX<double>(_step,_step,_step);
+
+    //same loop as in trilinear_resample
+    double t0=now();
+    for(int z=0;z<new_size;z++)
+      for(int y=0;y<new_size;y++)
+        for(int x=0;x<new_size;x++)
+        {
+          minc::fixed_vec<3,float> cc=IDX<float>(x*_step,y*_step,z*_step);
+          output_vol.set(x,y,z,input_vol.interpolate(cc[0],cc[1],cc[2]));
+        }
+    double t1=now();
+
+    resample_volume<trilinear_kernel>(input_vol,output_vol2,affine_transform());
+    double t2=now();
+
+    double max_diff=0.0;
+    for(size_t i=0;i<output_vol.c_buf_size();i++)
+      max_diff=std::max(max_diff,(double)fabs(output_vol.c_buf()[i]-output_vol2.c_buf()[i]));
+
+    std::cout<<"output voxels:   "<<output_vol.c_buf_size()<<std::endl
+             <<"per voxel loop:  "<<t1-t0<<" s"<<std::endl
+             <<"resample_volume: "<<t2-t1<<" s"<<std::endl
+             <<"speedup:         "<<(t1-t0)/(t2-t1)<<std::endl
+             <<"max difference:  "<<max_diff<<std::endl;
+
+  } catch (const minc::generic_error & err) {
+    std::cerr << "Got an error at:" << err.file () << ":" << err.line () << std::endl;
+    std::cerr << err.msg()<<std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -95,20 +95,22 @@ int main(int argc,char **argv)
     
     minc_1_reader rdr1;
     rdr1.open(argv[optind]);
-    minc_float_volume _avg;
+    rdr1.setup_read_float();
     
-    load_simple_volume<float>(rdr1,_avg);
-    
-    minc_float_volume _sd(_avg);
-    minc_float_volume _tmp(_avg);
-    
-
-    for(size_t i=0;i<_avg.c_buf_size();i++)
+    //volumes are accumulated in the file order of the first input
+    std::vector<size_t> strides(MAX_VAR_DIMS,0);
+    size_t volume_size=1;
+    for(int i=rdr1.dim_no()-1;i>=0;i--)
     {
-      _sd.c_buf()[i]=_avg.c_buf()[i]*_avg.c_buf()[i];
+      strides[i]=volume_size;
+      volume_size*=rdr1.dim(i).length;
     }
     
-    for(int i=1;i<(argc-1);i++)
+    std::vector<float> _avg(volume_size,0.0f);
+    std::vector<float> _sd(volume_size,0.0f);
+    std::vector<float> _tmp;
+    
+    for(int i=0;i<(argc-1);i++)
     {
       minc_1_reader rdr2;
       rdr2.open(argv[optind+i]);
@@ -116,26 +118,59 @@ int main(int argc,char **argv)
       {
         return 1;
       }
+      rdr2.setup_read_float();
       
-      load_simple_volume<float>(rdr2,_tmp);
-      _avg+=_tmp;
-      _tmp*=_tmp;
-      _sd+=_tmp;
+      if(is_same_layout(rdr1,rdr2))
+      {
+        minc_input_span_iterator<float> in(rdr2);
+        float *avg=&_avg[0];
+        float *sd=&_sd[0];
+        for(in.begin();!in.last();in.next(),avg+=in.size(),sd+=in.size())
+        {
+          const float *v=in.data();
+          const size_t len=in.size();
+          for(size_t j=0;j<len;j++)
+          {
+            avg[j]+=v[j];
+            sd[j]+=v[j]*v[j];
+          }
+        }
+      } else {
+        //same volume stored in a different order, map it into ours
+        std::vector<size_t> strides2(MAX_VAR_DIMS,0);
+        for(int j=0;j<rdr2.dim_no();j++)
+          for(int k=0;k<rdr1.dim_no();k++)
+            if(rdr1.dim(k).dim==rdr2.dim(j).dim)
+              strides2[j]=strides[k];
+        
+        _tmp.resize(volume_size);
+        load_strided_volume<float>(rdr2,&_tmp[0],strides2);
+        for(size_t j=0;j<volume_size;j++)
+        {
+          _avg[j]+=_tmp[j];
+          _sd[j]+=_tmp[j]*_tmp[j];
+        }
+      }
     }
-    _avg/=(float)(argc-1);
-    for(size_t i=0;i<_avg.c_buf_size();i++)
+    
+    const float n=(float)(argc-1);
+    for(size_t i=0;i<volume_size;i++)
     {
-      _sd.c_buf()[i]=sqrt(_sd.c_buf()[i]/(argc-1) - _avg.c_buf()[i]*_avg.c_buf()[i] );
+      _avg[i]/=n;
+      _sd[i]=sqrt(_sd[i]/n - _avg[i]*_avg[i]);
     }
+    
     minc_1_writer wrt;
     wrt.open(output.c_str(),rdr1.info(),2,NC_FLOAT);
-    save_simple_volume<float>(wrt,_avg);
+    wrt.setup_write_float();
+    save_strided_volume<float>(wrt,&_avg[0],strides);
     
     if(!sd_f.empty())
     {
       minc_1_writer wrt2;
       wrt2.open(sd_f.c_str(),rdr1.info(),2,NC_FLOAT);
-      save_simple_volume<float>(wrt2,_sd);
+      wrt2.setup_write_float();
+      save_strided_volume<float>(wrt2,&_sd[0],strides);
     }
     
 	} catch (const minc::generic_error & err) {
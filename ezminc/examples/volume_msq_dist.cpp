@@ -64,21 +64,46 @@ int main(int argc,char **argv)
     rdr2.setup_read_float();
     rdr_m.setup_read_byte();
     
-    std::vector<float> buffer1(size),buffer2(size);
-    std::vector<unsigned char> mask(size);
-    
-    load_standard_volume<float>(rdr1,&buffer1[0]);
-    load_standard_volume<float>(rdr2,&buffer2[0]);
-    load_standard_volume<unsigned char>(rdr_m,&mask[0]);
-    
     double avg=0;
-    int cnt=0;
-    for(unsigned long i=0;i<size;i++)
+    unsigned long cnt=0;
+    if(is_same_layout(rdr1,rdr2) && is_same_layout(rdr1,rdr_m))
     {
-      if(!mask[i]) continue;
-      double d=buffer1[i]-buffer2[i];
-      avg+=d*d;
-      cnt++;
+      //all files are stored the same way, compare them slice by slice
+      minc_input_span_iterator<float> in1(rdr1);
+      minc_input_span_iterator<float> in2(rdr2);
+      minc_input_span_iterator<unsigned char> in_m(rdr_m);
+      
+      for(in1.begin(),in2.begin(),in_m.begin();!in1.last();in1.next(),in2.next(),in_m.next())
+      {
+        const float *b1=in1.data();
+        const float *b2=in2.data();
+        const unsigned char *m=in_m.data();
+        const size_t len=in1.size();
+        double s=0;
+        unsigned long c=0;
+        for(size_t i=0;i<len;i++)
+        {
+          double d=m[i]?(double)b1[i]-b2[i]:0.0;
+          s+=d*d;
+          c+=m[i]?1:0;
+        }
+        avg+=s;
+        cnt+=c;
+      }
+    } else {
+      std::vector<float> buffer1(size),buffer2(size);
+      std::vector<unsigned char> mask(size);
+      
+      load_standard_volume<float>(rdr1,&buffer1[0]);
+      load_standard_volume<float>(rdr2,&buffer2[0]);
+      load_standard_volume<unsigned char>(rdr_m,&mask[0]);
+      
+      for(unsigned long i=0;i<size;i++)
+      {
+        double d=mask[i]?(double)buffer1[i]-buffer2[i]:0.0;
+        avg+=d*d;
+        cnt+=mask[i]?1:0;
+      }
     }
     if(cnt)
       avg/=cnt;
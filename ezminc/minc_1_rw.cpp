@@ -96,6 +96,7 @@ namespace minc
 
   void minc_1_base::close(void)
   {
+    minc_io_lock lock;
     if(_icvid!=MI_ERROR)
     {
       CHECK_MINC_CALL(miicv_free(_icvid));
@@ -108,6 +109,7 @@ namespace minc
 
   std::string minc_1_base::history(void) const
   {
+    minc_io_lock lock;
     nc_type datatype;
     int att_length;
     if ((ncattinq(_mincid, NC_GLOBAL, MIhistory, &datatype,&att_length) == MI_ERROR) ||
@@ -126,6 +128,7 @@ namespace minc
   //code from mincinfo
   int minc_1_base::var_number(void) const
   {
+    minc_io_lock lock;
     int nvars;
     if(ncinquire(_mincid, NULL, &nvars, NULL, NULL)!=MI_ERROR)
       return nvars;
@@ -134,6 +137,7 @@ namespace minc
   
   std::string minc_1_base::var_name(int no) const
   {
+    minc_io_lock lock;
     char name[MAX_NC_NAME];
     if(ncvarinq(_mincid, no, name, NULL, NULL, NULL, NULL)!=MI_ERROR)
       return name;
@@ -142,6 +146,7 @@ namespace minc
 
   std::vector<double> minc_1_base::var_value_double(int varid) const
   {
+    minc_io_lock lock;
     nc_type var_type;
     int vardims;
     int dims[MAX_VAR_DIMS];
@@ -180,6 +185,7 @@ namespace minc
 
   int minc_1_base::att_number(const char *var_name) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0') {
         varid = NC_GLOBAL;
@@ -192,6 +198,7 @@ namespace minc
   
   int minc_1_base::var_id(const char *var_name) const
   {
+    minc_io_lock lock;
     return ncvarid(_mincid, var_name);
   }
 
@@ -206,6 +213,7 @@ namespace minc
     
   long minc_1_base::var_length(int var_id) const
   {
+    minc_io_lock lock;
     int vardims;
     
     if(ncvarinq(_mincid, var_id, NULL, NULL, &vardims, NULL, NULL)!=MI_ERROR)
@@ -234,6 +242,7 @@ namespace minc
   //! get the number of attributes associated with variable
   int minc_1_base::att_number(int var_no) const
   {
+    minc_io_lock lock;
     int natts;
     if(ncvarinq(_mincid, var_no, NULL, NULL, NULL, NULL, &natts)!=MI_ERROR)
       return natts;
@@ -243,6 +252,7 @@ namespace minc
   
   std::string minc_1_base::att_name(const char *var_name,int no) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0')
         varid = NC_GLOBAL;
@@ -256,6 +266,7 @@ namespace minc
   
   std::string minc_1_base::att_name(int varid,int no) const
   {
+    minc_io_lock lock;
     char name[MAX_NC_NAME];
     if(ncattname(_mincid, varid, no, name)==MI_ERROR)
       return "";
@@ -265,6 +276,7 @@ namespace minc
   
   std::string minc_1_base::att_value_string(const char *var_name,const char *att_name) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0')
         varid = NC_GLOBAL;
@@ -278,6 +290,7 @@ namespace minc
   
   std::string minc_1_base::att_value_string(int varid,const char *att_name) const
   {
+    minc_io_lock lock;
     int att_length;
     nc_type datatype;
     
@@ -299,6 +312,7 @@ namespace minc
   
   std::vector<double> minc_1_base::att_value_double(const char *var_name,const char *att_name) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0') 
         varid = NC_GLOBAL;
@@ -312,6 +326,7 @@ namespace minc
   
   std::vector<short> minc_1_base::att_value_short(const char *var_name,const char *att_name) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0') 
       varid = NC_GLOBAL;
@@ -325,6 +340,7 @@ namespace minc
   
   std::vector<unsigned char> minc_1_base::att_value_byte(const char *var_name,const char *att_name) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0') 
       varid = NC_GLOBAL;
@@ -339,6 +355,7 @@ namespace minc
   
   std::vector<int> minc_1_base::att_value_int(const char *var_name,const char *att_name) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0') 
       varid = NC_GLOBAL;
@@ -352,6 +369,7 @@ namespace minc
   
   std::vector<int> minc_1_base::att_value_int(int varid,const char *att_name) const 
   {
+    minc_io_lock lock;
     int att_length;
     nc_type datatype;
     
@@ -370,6 +388,7 @@ namespace minc
   
   std::vector<double> minc_1_base::att_value_double(int varid,const char *att_name) const
   {
+    minc_io_lock lock;
     int att_length;
     nc_type datatype;
     
@@ -388,6 +407,7 @@ namespace minc
   
   std::vector<short> minc_1_base::att_value_short(int varid,const char *att_name) const
   {
+    minc_io_lock lock;
     int att_length;
     nc_type datatype;
     
@@ -406,6 +426,7 @@ namespace minc
   
   std::vector<unsigned char> minc_1_base::att_value_byte(int varid,const char *att_name) const
   {
+    minc_io_lock lock;
     int att_length;
     nc_type datatype;
     
@@ -425,6 +446,7 @@ namespace minc
   
   nc_type minc_1_base::att_type(const char *var_name,const char *att_name) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0') 
         varid = NC_GLOBAL;
@@ -438,6 +460,7 @@ namespace minc
   
   nc_type minc_1_base::att_type(int varid,const char *att_name) const
   {
+    minc_io_lock lock;
     int att_length;
     nc_type datatype;
     
@@ -449,6 +472,7 @@ namespace minc
 
   int minc_1_base::att_length(const char *var_name,const char *att_name) const
   {
+    minc_io_lock lock;
     int varid;
     if (*var_name=='\0') 
         varid = NC_GLOBAL;
@@ -462,6 +486,7 @@ namespace minc
   
   int minc_1_base::att_length(int varid,const char *att_name) const
   {
+    minc_io_lock lock;
     int att_length;
     nc_type datatype;
     
@@ -486,6 +511,7 @@ namespace minc
   //based on the code from mincextract
   void minc_1_reader::open(const char *path,bool positive_directions/*=true*/,bool metadate_only/*=false*/,bool rw/*=false*/)
   {
+    minc_io_lock lock;
     if(_icvid==MI_ERROR) CHECK_MINC_CALL(_icvid=miicv_create());
 #ifndef WIN32
     set_ncopts(0);
@@ -690,6 +716,7 @@ namespace minc
   
   void minc_1_writer::open(const char *path,const minc_info& inf,int slice_dimensions,nc_type datatype,int _s)
   {
+    minc_io_lock lock;
     if(_icvid==MI_ERROR) CHECK_MINC_CALL(_icvid=miicv_create());
 #ifndef WIN32
     set_ncopts(0);
@@ -812,6 +839,7 @@ namespace minc
    
   void minc_1_writer::setup_write_float()
   {
+    minc_io_lock lock;
     _image_range[0]=DBL_MAX;_image_range[1]=-DBL_MAX;
     
     switch(_datatype)
@@ -888,6 +916,7 @@ namespace minc
   
   void minc_1_writer::setup_write_double()
   {
+    minc_io_lock lock;
     _image_range[0]=DBL_MAX;_image_range[1]=-DBL_MAX;
     
     switch(_datatype)
@@ -973,6 +1002,7 @@ namespace minc
   
   void minc_1_writer::setup_write_short(bool n)
   {
+    minc_io_lock lock;
     CHECK_MINC_CALL(_icmax=micreate_std_variable(_mincid, MIimagemax, NC_DOUBLE, 0, NULL));
     CHECK_MINC_CALL(_icmin=micreate_std_variable(_mincid, MIimagemin, NC_DOUBLE, 0, NULL));
     _set_image_range=true;
@@ -999,6 +1029,7 @@ namespace minc
   
   void minc_1_writer::setup_write_ushort(bool n)
   {
+    minc_io_lock lock;
     CHECK_MINC_CALL(_icmax=micreate_std_variable(_mincid, MIimagemax, NC_DOUBLE, 0, NULL));
     CHECK_MINC_CALL(_icmin=micreate_std_variable(_mincid, MIimagemin, NC_DOUBLE, 0, NULL));
     _set_image_range=true;
@@ -1023,6 +1054,7 @@ namespace minc
   
   void minc_1_writer::setup_write_byte(bool n)
   {
+    minc_io_lock lock;
     CHECK_MINC_CALL(_icmax=micreate_std_variable(_mincid, MIimagemax, NC_DOUBLE, 0, NULL));
     CHECK_MINC_CALL(_icmin=micreate_std_variable(_mincid, MIimagemin, NC_DOUBLE, 0, NULL));
     _set_image_range=true;
@@ -1048,6 +1080,7 @@ namespace minc
   
   void minc_1_writer::setup_write_int(bool n)
   {
+    minc_io_lock lock;
     CHECK_MINC_CALL(_icmax=micreate_std_variable(_mincid, MIimagemax, NC_DOUBLE, 0, NULL));
     CHECK_MINC_CALL(_icmin=micreate_std_variable(_mincid, MIimagemin, NC_DOUBLE, 0, NULL));
     _set_image_range=true;
@@ -1074,6 +1107,7 @@ namespace minc
   
   void minc_1_writer::setup_write_uint(bool n)
   {
+    minc_io_lock lock;
     CHECK_MINC_CALL(_icmax=micreate_std_variable(_mincid, MIimagemax, NC_DOUBLE, 0, NULL));
     CHECK_MINC_CALL(_icmin=micreate_std_variable(_mincid, MIimagemin, NC_DOUBLE, 0, NULL));
     _set_image_range=true;
@@ -1098,6 +1132,7 @@ namespace minc
   
   void minc_1_reader::_setup_dimensions(void)
   {
+    minc_io_lock lock;
     if(_metadate_only)
       REPORT_ERROR("Minc file in metadate only mode!");
     if(_positive_directions)
@@ -1137,6 +1172,7 @@ namespace minc
   
   void minc_1_reader::setup_read_float(void)
   {
+    minc_io_lock lock;
     if(_metadate_only)
       REPORT_ERROR("Minc file in metadate only mode!");
     
@@ -1155,6 +1191,7 @@ namespace minc
   
   void minc_1_reader::setup_read_double(void)
   {
+    minc_io_lock lock;
     if(_metadate_only)
       REPORT_ERROR("Minc file in metadate only mode!");
     
@@ -1173,6 +1210,7 @@ namespace minc
 
   void minc_1_reader::setup_read_short(bool n)
   {
+    minc_io_lock lock;
     if(_metadate_only)
       REPORT_ERROR("Minc file in metadate only mode!");
     
@@ -1198,6 +1236,7 @@ namespace minc
   
   void minc_1_reader::setup_read_ushort(bool n)
   {
+    minc_io_lock lock;
     if(_metadate_only)
       REPORT_ERROR("Minc file in metadate only mode!");
     
@@ -1223,6 +1262,7 @@ namespace minc
   
   void minc_1_reader::setup_read_byte(bool n)
   {
+    minc_io_lock lock;
     if(_metadate_only)
       REPORT_ERROR("Minc file in metadate only mode!");
     CHECK_MINC_CALL(miicv_setint(_icvid, MI_ICV_TYPE, NC_BYTE));
@@ -1245,6 +1285,7 @@ namespace minc
   
   void minc_1_reader::setup_read_int(bool n)
   {
+    minc_io_lock lock;
     if(_metadate_only)
       REPORT_ERROR("Minc file in metadate only mode!");
     CHECK_MINC_CALL(miicv_setint(_icvid, MI_ICV_TYPE, NC_INT));
@@ -1267,6 +1308,7 @@ namespace minc
   
   void minc_1_reader::setup_read_uint(bool n)
   {
+    minc_io_lock lock;
     if(_metadate_only)
       REPORT_ERROR("Minc file in metadate only mode!");
     CHECK_MINC_CALL(miicv_setint(_icvid, MI_ICV_TYPE, NC_INT));
@@ -1289,6 +1331,7 @@ namespace minc
   
   void minc_1_reader::read(void* buffer)
   {
+    minc_io_lock lock;
     if(!_read_prepared)
       REPORT_ERROR("Not ready to read, use setup_read_XXXX");
 
@@ -1297,6 +1340,7 @@ namespace minc
   
   void minc_1_writer::write(void* buffer)
   {
+    minc_io_lock lock;
     if(!_write_prepared)
       REPORT_ERROR("Not ready to write, use setup_write_XXXX");
     
@@ -1389,6 +1433,7 @@ namespace minc
 
   void minc_1_writer::close(void)
   {
+    minc_io_lock lock;
     if(_set_image_range)
     {
       CHECK_MINC_CALL(mivarput1(_mincid, _icmin, 0, NC_DOUBLE, NULL, &_image_range[0]));
@@ -1411,6 +1456,7 @@ namespace minc
   
   void minc_1_writer::copy_headers(const minc_1_base& src)
   {
+    minc_io_lock lock;
     
     //code copied from mincresample
     int nexcluded, excluded_vars[10] = {0,0,0,0,0,0,0,0,0,0};
@@ -1448,6 +1494,7 @@ namespace minc
   //! append a line into minc history
   void minc_1_writer::append_history(const char *append_history)
   {
+    minc_io_lock lock;
     nc_type datatype;
     int att_length;
     //ncopts=0;
@@ -1466,6 +1513,7 @@ namespace minc
   
   int minc_1_base::create_var_id(const char *varname)
   {
+    minc_io_lock lock;
     int old_ncopts =get_ncopts(); set_ncopts(0);
     int res=var_id(varname);
     if(res==MI_ERROR) //need to create a variable
@@ -1478,31 +1526,37 @@ namespace minc
       
   void minc_1_base::insert(const char *varname,const char *attname,double val)
   {
+    minc_io_lock lock;
     ncattput(_mincid, create_var_id(varname),attname, NC_DOUBLE, 1, &val);
   }
   
   void minc_1_base::insert(const char *varname,const char *attname,const char* val)
   {
+    minc_io_lock lock;
     ncattput(_mincid, create_var_id(varname),attname, NC_CHAR, strlen(val) + 1, val);
   }
   
   void minc_1_base::insert(const char *varname,const char *attname,const std::vector<double> &val)
   {
+    minc_io_lock lock;
     ncattput(_mincid, create_var_id(varname),attname, NC_DOUBLE, val.size(), &val[0]);
   }
   
   void minc_1_base::insert(const char *varname,const char *attname,const std::vector<int> &val)
   {
+    minc_io_lock lock;
     ncattput(_mincid, create_var_id(varname),attname, NC_INT, val.size(), &val[0]);
   }
   
   void minc_1_base::insert(const char *varname,const char *attname,const std::vector<short> &val)
   {
+    minc_io_lock lock;
     ncattput(_mincid, create_var_id(varname),attname, NC_SHORT, val.size(), &val[0]);
   }
   
   void minc_1_base::insert(const char *varname,const char *attname,const std::vector<unsigned char> &val)
   {
+    minc_io_lock lock;
     ncattput(_mincid, create_var_id(varname),attname, NC_BYTE, val.size(), &val[0]);
   }
 }
@@ -19,6 +19,7 @@
 #include <string>
 
 #include "minc_io_exceptions.h"
+#include "minc_io_lock.h"
 
 #ifdef USE_MINC2
 #define MINC2 1
@@ -15,15 +15,17 @@
 #ifndef MINC_1_SIMPLE_H
 #define MINC_1_SIMPLE_H
 
+#include <algorithm>
 #include "minc_1_rw.h"
 
 namespace minc
 {
   
-  template <class T> class minc_input_iterator
+  //! iterates over the voxels of a file opened with minc_1_reader or minc_2_reader
+  template <class T,class R=minc_1_reader> class minc_input_iterator
   {
     protected:
-      mutable minc_1_reader* _rw;
+      mutable R* _rw;
       std::vector<T> _buf;
       std::vector<long> _cur;
       bool _last;
@@ -36,11 +38,11 @@ namespace minc
     }
     
     
-    minc_input_iterator(const minc_input_iterator<T>& a):_rw(a._rw),_cur(a._cur),_last(a._last),_count(a._count)
+    minc_input_iterator(const minc_input_iterator<T,R>& a):_rw(a._rw),_cur(a._cur),_last(a._last),_count(a._count)
     {
     }
     
-    minc_input_iterator(minc_1_reader& rw):_rw(&rw),_last(false),_count(0)
+    minc_input_iterator(R& rw):_rw(&rw),_last(false),_count(0)
     {
     }
     
@@ -48,7 +50,7 @@ namespace minc
     {
     }
     
-    void attach(minc_1_reader& rw)
+    void attach(R& rw)
     {
       _rw=&rw;
       _last=false;
@@ -111,10 +113,11 @@ namespace minc
     }
   };
   
-  template <class T> class minc_output_iterator
+  //! iterates over the voxels of a file opened with minc_1_writer or minc_2_writer
+  template <class T,class W=minc_1_writer> class minc_output_iterator
   {
     protected:
-      mutable minc_1_writer* _rw;
+      mutable W* _rw;
       std::vector<T> _buf;
       std::vector<long> _cur;
       bool _last;
@@ -125,11 +128,11 @@ namespace minc
       return _cur;
     }
     
-    minc_output_iterator(const minc_output_iterator<T>& a):_rw(a._rw),_cur(a._cur),_last(a._last),_count(a._count)
+    minc_output_iterator(const minc_output_iterator<T,W>& a):_rw(a._rw),_cur(a._cur),_last(a._last),_count(a._count)
     {
     }
     
-    minc_output_iterator(minc_1_writer& rw):_rw(&rw),_last(false),_count(0)
+    minc_output_iterator(W& rw):_rw(&rw),_last(false),_count(0)
     {
       _buf.resize(rw.slice_len()); 
     }
@@ -138,7 +141,7 @@ namespace minc
     {
     }
     
-    void attach(minc_1_writer& rw)
+    void attach(W& rw)
     {
       _rw=&rw;
       _last=false;
@@ -205,8 +208,332 @@ namespace minc
     }
   };
   
+  //! iterates over the slices of a file opened with minc_1_reader or minc_2_reader
+  //! hands out each slice as one contiguous block, so that loops over
+  //! the voxels of a slice don't have to go through next() and value()
+  template <class T,class R=minc_1_reader> class minc_input_span_iterator
+  {
+    protected:
+      mutable R* _rw;
+      std::vector<T> _buf;
+      std::vector<long> _cur;
+      bool _last;
+    public:
+
+    //! index of the first voxel of the current slice
+    const std::vector<long>& cur(void) const
+    {
+      return _cur;
+    }
+
+    minc_input_span_iterator(R& rw):_rw(&rw),_last(false)
+    {
+    }
+
+    minc_input_span_iterator():_rw(NULL),_last(false)
+    {
+    }
+
+    void attach(R& rw)
+    {
+      _rw=&rw;
+      _last=false;
+    }
+
+    //! read the next slice
+    bool next(void)
+    {
+      if(_last) return false;
+      // the case when slice_dimensions==dim_no: single slice
+      if(_rw->slice_dimensions()>=_rw->dim_no() || !_rw->next_slice())
+      {
+        _last=true;
+        return false;
+      }
+      _rw->read(&_buf[0]);
+      _cur=_rw->current_slice();
+      return true;
+    }
+
+    bool last(void) const
+    {
+      return _last;
+    }
+
+    void begin(void)
+    {
+      _buf.resize(_rw->slice_len());
+      _last=false;
+      _rw->begin();
+      _rw->read(&_buf[0]);
+      _cur=_rw->current_slice();
+    }
+
+    //! voxels of the current slice, in file order
+    const T* data(void) const
+    {
+      return &_buf[0];
+    }
+
+    //! number of voxels in the current slice
+    size_t size(void) const
+    {
+      return _buf.size();
+    }
+  };
+
+  //! iterates over the slices of a file opened with minc_1_writer or minc_2_writer
+  //! the current slice is filled through data() and written by next()
+  template <class T,class W=minc_1_writer> class minc_output_span_iterator
+  {
+    protected:
+      mutable W* _rw;
+      std::vector<T> _buf;
+      std::vector<long> _cur;
+      bool _last;
+    public:
+
+    //! index of the first voxel of the current slice
+    const std::vector<long>& cur(void) const
+    {
+      return _cur;
+    }
+
+    minc_output_span_iterator(W& rw):_rw(&rw),_last(false)
+    {
+    }
+
+    minc_output_span_iterator():_rw(NULL),_last(false)
+    {
+    }
+
+    void attach(W& rw)
+    {
+      _rw=&rw;
+      _last=false;
+    }
+
+    //! write the current slice and move to the next one
+    bool next(void)
+    {
+      if(_last) return false;
+      _rw->write(&_buf[0]);
+      // the case when slice_dimensions==dim_no: single slice
+      if(_rw->slice_dimensions()>=_rw->dim_no() || !_rw->next_slice())
+      {
+        _last=true;
+        return false;
+      }
+      _cur=_rw->current_slice();
+      return true;
+    }
+
+    bool last(void) const
+    {
+      return _last;
+    }
+
+    void begin(void)
+    {
+      _buf.resize(_rw->slice_len());
+      _last=false;
+      _rw->begin();
+      _cur=_rw->current_slice();
+    }
+
+    //! voxels of the current slice, in file order
+    T* data(void)
+    {
+      return &_buf[0];
+    }
+
+    //! number of voxels in the current slice
+    size_t size(void) const
+    {
+      return _buf.size();
+    }
+  };
+
+  //! check if two files have the same dimensions in the same file order,
+  //! i.e. their slices can be combined voxel by voxel
+  template<class A,class B> bool is_same_layout(const A& one,const B& two)
+  {
+    if(one.dim_no()!=two.dim_no() || one.slice_len()!=two.slice_len())
+      return false;
+    for(int i=0;i<one.dim_no();i++)
+      if(one.dim(i).dim!=two.dim(i).dim || one.dim(i).length!=two.dim(i).length)
+        return false;
+    return true;
+  }
+
+  //! copies a slab of N file dimensions between a contiguous slice buffer
+  //! and a strided volume, loops over the dimensions are unrolled at compile time
+  template<class T,int N> struct strided_slab
+  {
+    static void load(const T*& src,T* dst,const size_t* len,const size_t* stride)
+    {
+      for(size_t i=0;i<len[0];i++,dst+=stride[0])
+        strided_slab<T,N-1>::load(src,dst,len+1,stride+1);
+    }
+
+    static void save(T*& dst,const T* src,const size_t* len,const size_t* stride)
+    {
+      for(size_t i=0;i<len[0];i++,src+=stride[0])
+        strided_slab<T,N-1>::save(dst,src,len+1,stride+1);
+    }
+  };
+
+  //! two innermost dimensions: whole rows when the volume is contiguous along
+  //! them, otherwise a blocked transpose so that neither side is walked with
+  //! a large stride for long
+  template<class T> struct strided_slab<T,2>
+  {
+    enum {block=32};
+
+    static void load(const T*& src,T* dst,const size_t* len,const size_t* stride)
+    {
+      if(stride[1]==1)
+      {
+        for(size_t i=0;i<len[0];i++,src+=len[1])
+          std::copy(src,src+len[1],dst+i*stride[0]);
+        return;
+      }
+      for(size_t i0=0;i0<len[0];i0+=block)
+      {
+        const size_t i1=std::min<size_t>(i0+block,len[0]);
+        for(size_t j0=0;j0<len[1];j0+=block)
+        {
+          const size_t j1=std::min<size_t>(j0+block,len[1]);
+          for(size_t j=j0;j<j1;j++)
+            for(size_t i=i0;i<i1;i++)
+              dst[i*stride[0]+j*stride[1]]=src[i*len[1]+j];
+        }
+      }
+      src+=len[0]*len[1];
+    }
+
+    static void save(T*& dst,const T* src,const size_t* len,const size_t* stride)
+    {
+      if(stride[1]==1)
+      {
+        for(size_t i=0;i<len[0];i++,dst+=len[1])
+          std::copy(src+i*stride[0],src+i*stride[0]+len[1],dst);
+        return;
+      }
+      for(size_t i0=0;i0<len[0];i0+=block)
+      {
+        const size_t i1=std::min<size_t>(i0+block,len[0]);
+        for(size_t j0=0;j0<len[1];j0+=block)
+        {
+          const size_t j1=std::min<size_t>(j0+block,len[1]);
+          for(size_t j=j0;j<j1;j++)
+            for(size_t i=i0;i<i1;i++)
+              dst[i*len[1]+j]=src[i*stride[0]+j*stride[1]];
+        }
+      }
+      dst+=len[0]*len[1];
+    }
+  };
+
+  template<class T> struct strided_slab<T,1>
+  {
+    static void load(const T*& src,T* dst,const size_t* len,const size_t* stride)
+    {
+      if(stride[0]==1)
+        std::copy(src,src+len[0],dst);
+      else
+        for(size_t j=0;j<len[0];j++)
+          dst[j*stride[0]]=src[j];
+      src+=len[0];
+    }
+
+    static void save(T*& dst,const T* src,const size_t* len,const size_t* stride)
+    {
+      if(stride[0]==1)
+        std::copy(src,src+len[0],dst);
+      else
+        for(size_t j=0;j<len[0];j++)
+          dst[j]=src[j*stride[0]];
+      dst+=len[0];
+    }
+  };
+
+  //! strided_slab for a rank only known at run time
+  template<class T> void load_strided_slab(const T*& src,T* dst,const size_t* len,const size_t* stride,int n)
+  {
+    switch(n)
+    {
+      case 1: strided_slab<T,1>::load(src,dst,len,stride);break;
+      case 2: strided_slab<T,2>::load(src,dst,len,stride);break;
+      case 3: strided_slab<T,3>::load(src,dst,len,stride);break;
+      case 4: strided_slab<T,4>::load(src,dst,len,stride);break;
+      case 5: strided_slab<T,5>::load(src,dst,len,stride);break;
+      default:
+        for(size_t i=0;i<len[0];i++,dst+=stride[0])
+          load_strided_slab(src,dst,len+1,stride+1,n-1);
+    }
+  }
+
+  template<class T> void save_strided_slab(T*& dst,const T* src,const size_t* len,const size_t* stride,int n)
+  {
+    switch(n)
+    {
+      case 1: strided_slab<T,1>::save(dst,src,len,stride);break;
+      case 2: strided_slab<T,2>::save(dst,src,len,stride);break;
+      case 3: strided_slab<T,3>::save(dst,src,len,stride);break;
+      case 4: strided_slab<T,4>::save(dst,src,len,stride);break;
+      case 5: strided_slab<T,5>::save(dst,src,len,stride);break;
+      default:
+        for(size_t i=0;i<len[0];i++,src+=stride[0])
+          save_strided_slab(dst,src,len+1,stride+1,n-1);
+    }
+  }
+
+  //! load the whole file into buffer, with the given stride for each file dimension
+  //! each slice is copied as one slab of the slice dimensions
+  template<class T,class R> void load_strided_volume(R& rw, T* volume,const std::vector<size_t>& strides)
+  {
+    const int n=std::min(rw.slice_dimensions(),rw.dim_no());
+    const int first_dim=rw.dim_no()-n;
+    std::vector<size_t> len(n);
+    for(int i=0;i<n;i++)
+      len[i]=rw.dim(first_dim+i).length;
+
+    minc_input_span_iterator<T,R> in(rw);
+    for(in.begin();!in.last();in.next())
+    {
+      size_t address=0;
+      for(int i=0;i<first_dim;i++)
+        address+=in.cur()[i]*strides[i];
+
+      const T* src=in.data();
+      load_strided_slab(src,volume+address,&len[0],&strides[first_dim],n);
+    }
+  }
+
+  //! save the whole file from buffer, with the given stride for each file dimension
+  template<class T,class W> void save_strided_volume(W& rw, const T* volume,const std::vector<size_t>& strides)
+  {
+    const int n=std::min(rw.slice_dimensions(),rw.dim_no());
+    const int first_dim=rw.dim_no()-n;
+    std::vector<size_t> len(n);
+    for(int i=0;i<n;i++)
+      len[i]=rw.dim(first_dim+i).length;
+
+    minc_output_span_iterator<T,W> out(rw);
+    for(out.begin();!out.last();out.next())
+    {
+      size_t address=0;
+      for(int i=0;i<first_dim;i++)
+        address+=out.cur()[i]*strides[i];
+
+      T* dst=out.data();
+      save_strided_slab(dst,volume+address,&len[0],&strides[first_dim],n);
+    }
+  }
+
   //! will attempt to laod the whole volume in T Z Y X V order into buffer, file should be prepared (setup_read_XXXX)
-  template<class T> void load_standard_volume(minc_1_reader& rw, T* volume)
+  template<class T,class R> void load_standard_volume(R& rw, T* volume)
   {
     std::vector<size_t> strides(MAX_VAR_DIMS,0);
     size_t str=1;
@@ -217,19 +544,11 @@ namespace minc
       str*=rw.ndim(i);
     }
 
-    minc_input_iterator<T> in(rw);
-    for(in.begin();!in.last();in.next())
-    {
-      size_t address=0;
-      for(size_t i=0;i<static_cast<size_t>(rw.dim_no());i++)
-        address+=in.cur()[i]*strides[i];
-        
-      volume[address]=in.value();
-    }
+    load_strided_volume(rw,volume,strides);
   }
   
   //! will attempt to save the whole volume in T Z Y X V order from buffer, file should be prepared (setup_read_XXXX)
-  template<class T> void save_standard_volume(minc_1_writer& rw, const T* volume)
+  template<class T,class W> void save_standard_volume(W& rw, const T* volume)
   {
     std::vector<size_t> strides(MAX_VAR_DIMS,0);
     size_t str=1;
@@ -240,19 +559,11 @@ namespace minc
       str*=rw.ndim(i);
     }
     
-    minc_output_iterator<T> out(rw);
-    for(out.begin();!out.last();out.next())
-    {
-      size_t address=0;
-      for(size_t i=0;i<static_cast<size_t>(rw.dim_no());i++)
-        address+=out.cur()[i]*strides[i];
-        
-      out.value(volume[address]);
-    }
+    save_strided_volume(rw,volume,strides);
   }
 
   //! will attempt to load the whole volume in Z Y X T V  order into buffer, file should be prepared (setup_read_XXXX)
-  template<class T> void load_non_standard_volume(minc_1_reader& rw, T* volume)
+  template<class T,class R> void load_non_standard_volume(R& rw, T* volume)
   {
     std::vector<size_t> strides(MAX_VAR_DIMS,0);
     size_t str=1;
@@ -264,19 +575,11 @@ namespace minc
       str*=rw.ndim(dimorder[i]);
     }
     
-    minc_input_iterator<T> in(rw);
-    for(in.begin();!in.last();in.next())
-    {
-      size_t address=0;
-      for(int i=0;i<rw.dim_no();i++)
-        address+=in.cur()[i]*strides[i];
-      
-      volume[address]=in.value();
-    }
+    load_strided_volume(rw,volume,strides);
   }
   
   //! will attempt to save the whole volume in V T Z Y X order from buffer, file should be prepared (setup_read_XXXX)
-  template<class T> void save_non_standard_volume(minc_1_writer& rw, const T* volume)
+  template<class T,class W> void save_non_standard_volume(W& rw, const T* volume)
   {
     std::vector<size_t> strides(MAX_VAR_DIMS,0);
     size_t str=1;
@@ -287,15 +590,7 @@ namespace minc
       strides[rw.map_space(dimorder[i])]=str;
       str*=rw.ndim(dimorder[i]);
     }
-    minc_output_iterator<T> out(rw);
-    for(out.begin();!out.last();out.next())
-    {
-      size_t address=0;
-      for(int i=0;i<rw.dim_no();i++)
-        address+=out.cur()[i]*strides[i];
-
-      out.value(volume[address]);
-    }
+    save_strided_volume(rw,volume,strides);
   }
   
   
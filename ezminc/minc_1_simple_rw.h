@@ -23,7 +23,7 @@
 namespace minc
 {
   
-  template<class T> void load_simple_volume(minc_1_reader& rw,simple_volume<T>& vol)
+  template<class T,class R> void load_simple_volume(R& rw,simple_volume<T>& vol)
   {
     if(rw.ndim(1)<=0||rw.ndim(2)<=0||rw.ndim(3)<=0||rw.ndim(4)>0) 
       REPORT_ERROR("Need 3D minc file");
@@ -79,7 +79,7 @@ namespace minc
     }
   }
   
-  template<class T> void save_simple_volume(minc_1_writer& rw,const simple_volume<T>& vol)
+  template<class T,class W> void save_simple_volume(W& rw,const simple_volume<T>& vol)
   {
     if(typeid(T)==typeid(unsigned char))
     {
@@ -116,7 +116,7 @@ namespace minc
   }
   
   
-  template<class T> void load_4d_volume(minc_1_reader& rw,simple_4d_volume<T>& vol)
+  template<class T,class R> void load_4d_volume(R& rw,simple_4d_volume<T>& vol)
   {
     //if(rw.ndim(1)<=0||rw.ndim(2)<=0||rw.ndim(3)<=0||rw.ndim(4)<=0) 
     //  REPORT_ERROR("Need 4D minc file");
@@ -151,7 +151,7 @@ namespace minc
     if(rw.map_space(4)>=0)
       strides[rw.map_space(4)]=0; //t dimension
 
-    minc_input_iterator<T> in(rw);
+    minc_input_iterator<T,R> in(rw);
     for(in.begin();!in.last();in.next())
     {
       size_t address=0;
@@ -191,7 +191,7 @@ namespace minc
     }
   }
   
-  template<class T> void save_4d_volume(minc_1_writer& rw,const simple_4d_volume<T>& vol)
+  template<class T,class W> void save_4d_volume(W& rw,const simple_4d_volume<T>& vol)
   {
     if(typeid(T)==typeid(unsigned char))
       rw.setup_write_byte();
@@ -220,7 +220,7 @@ namespace minc
     if(rw.map_space(4)>=0)
       strides[rw.map_space(4)]=0; //t dimension
     
-    minc_output_iterator<T> out(rw);
+    minc_output_iterator<T,W> out(rw);
     for(out.begin();!out.last();out.next())
     {
       size_t address=0;
@@ -236,6 +236,90 @@ namespace minc
     }
   }
   
+  //! strides of the file dimensions inside a simple_4d_series buffer
+  template<class T,class RW> std::vector<size_t> series_strides(RW& rw,const simple_4d_series<T>& vol)
+  {
+    std::vector<size_t> strides(MAX_VAR_DIMS,0);
+    for(size_t i=1;i<5;i++)
+    {
+      if(rw.map_space(i)<0) continue;
+      strides[rw.map_space(i)]=vol.stride(i-1);
+    }
+    return strides;
+  }
+
+  //! load 4D file into a single buffer with the requested layout
+  //! works with either time fastest or slowest varying in the file,
+  //! rows are copied directly when their order matches the layout
+  template<class T,class R> void load_4d_volume(R& rw,simple_4d_series<T>& vol,
+                                                typename simple_4d_series<T>::layout_t layout)
+  {
+    if(rw.ndim(0)>0)
+      REPORT_ERROR("Vector dimension is not supported");
+
+    vol.resize(rw.ndim(1),rw.ndim(2),rw.ndim(3),rw.ndim(4)>0?rw.ndim(4):1,layout); //always assume 4 dimensions
+
+    if(typeid(T)==typeid(unsigned char))
+      rw.setup_read_byte();
+    else if(typeid(T)==typeid(int))
+      rw.setup_read_int();
+    else if(typeid(T)==typeid(float))
+      rw.setup_read_float();
+    else if(typeid(T)==typeid(double))
+      rw.setup_read_double();
+    else
+      REPORT_ERROR("Data type not supported for minc io");
+
+    load_strided_volume(rw,vol.c_buf(),series_strides(rw,vol));
+
+    //set coordinate transfer parameters
+    for(int i=0;i<3;i++)
+    {
+      vol.step()[i]=rw.nspacing(i+1);
+      vol.start()[i]=rw.nstart(i+1);
+
+      if(rw.have_dir_cos(i+1))
+      {
+        for(int j=0;j<3;j++)
+          vol.direction_cosines(i)[j]=rw.ndir_cos(i+1,j);
+      } else {
+        for(int j=0;j<3;j++)
+          vol.direction_cosines(i)[j]=(i==j?1.0:0.0); //identity
+      }
+    }
+    if(rw.ndim(4)>0)
+    {
+      vol.t_start()=rw.nstart(4);//T
+      vol.t_step()=rw.nspacing(4);//T
+    } else {
+      vol.t_start()=0;//T
+      vol.t_step()=0;//T
+    }
+  }
+
+  //! load 4D file, keeping the layout the volume already has
+  template<class T,class R> void load_4d_volume(R& rw,simple_4d_series<T>& vol)
+  {
+    load_4d_volume(rw,vol,vol.layout());
+  }
+
+  //! save 4D volume from either layout, into a file with any dimension order
+  template<class T,class W> void save_4d_volume(W& rw,const simple_4d_series<T>& vol)
+  {
+    if(typeid(T)==typeid(unsigned char))
+      rw.setup_write_byte();
+    else if(typeid(T)==typeid(int))
+      rw.setup_write_int();
+    else if(typeid(T)==typeid(float))
+      rw.setup_write_float();
+    else if(typeid(T)==typeid(double))
+      rw.setup_write_double();
+    else
+      REPORT_ERROR("Data type not supported for minc io");
+
+    save_strided_volume(rw,vol.c_buf(),series_strides(rw,vol));
+  }
+
   bool is_same(minc_1_reader& one,minc_1_reader& two,bool verbose=true);
   
   template<class T> void load_minc_file(const char *file,simple_4d_volume<T>& vol)
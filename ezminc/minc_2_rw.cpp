@@ -0,0 +1,911 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : minc_2_rw.cpp
+@DESCRIPTION: Primitive C++ interface to minc files, uses MINC2 API only
+@COPYRIGHT  :
+              Copyright McConnell Brain Imaging Centre,
+              Montreal Neurological Institute, McGill University.
+              Permission to use, copy, modify, and distribute this
+              software and its documentation for any purpose and without
+              fee is hereby granted, provided that the above copyright
+              notice appear in all copies.  The author and McGill University
+              make no representations about the suitability of this
+              software for any purpose.  It is provided "as is" without
+              express or implied warranty.
+---------------------------------------------------------------------------- */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <algorithm>
+#ifndef WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+#include "minc_2_rw.h"
+
+namespace minc
+{
+  minc_2_base::minc_2_base():
+    _vol(NULL),
+    _slab_len(0),
+    _slice_dimensions(0),
+    _last(false),
+    _positive_directions(false),
+    _datatype(MI_TYPE_UNKNOWN),
+    _io_datatype(MI_TYPE_UNKNOWN),
+    _ndims(0),
+    _is_signed(0),
+    _map_to_std(5,-1)
+  {
+    _image_range[0]=_image_range[1]=0.0;
+  }
+
+#if __cplusplus >= 201103L
+  minc_2_base::minc_2_base(minc_2_base&& that):
+    minc_2_base()
+  {
+    _swap(that);
+  }
+
+  minc_2_base& minc_2_base::operator=(minc_2_base&& that)
+  {
+    if(this!=&that)
+    {
+      close();
+      _swap(that);
+    }
+    return *this;
+  }
+#endif
+
+  void minc_2_base::_swap(minc_2_base& that)
+  {
+    std::swap(_vol,that._vol);
+    _dim_handles.swap(that._dim_handles);
+    std::swap(_slab_len,that._slab_len);
+    _cur.swap(that._cur);
+    _slab.swap(that._slab);
+    std::swap(_slice_dimensions,that._slice_dimensions);
+    std::swap(_last,that._last);
+    std::swap(_positive_directions,that._positive_directions);
+    std::swap(_datatype,that._datatype);
+    std::swap(_io_datatype,that._io_datatype);
+    std::swap(_ndims,that._ndims);
+    std::swap(_is_signed,that._is_signed);
+    std::swap(_image_range[0],that._image_range[0]);
+    std::swap(_image_range[1],that._image_range[1]);
+    _map_to_std.swap(that._map_to_std);
+    _info.swap(that._info);
+  }
+
+  minc_2_base::~minc_2_base()
+  {
+    minc_2_base::close();
+  }
+
+  void minc_2_base::close(void)
+  {
+    minc_io_lock lock;
+    if(_vol)
+      miclose_volume(_vol);
+    _vol=NULL;
+    _dim_handles.clear();
+  }
+
+  void minc_2_base::_setup_slab(void)
+  {
+    _cur.resize(_ndims);
+    _slab.resize(_ndims);
+    std::fill(_cur.begin(),_cur.end(),0);
+    std::fill(_slab.begin(),_slab.end(),1);
+    _slab_len=1;
+    for(size_t i=0;i<_slice_dimensions;i++)
+    {
+      _slab[_ndims-i-1]=_info[_ndims-i-1].length;
+      _slab_len*=_info[_ndims-i-1].length;
+    }
+    _last=false;
+  }
+
+  void minc_2_base::_cur_start(std::vector<misize_t>& start) const
+  {
+    start.resize(_ndims);
+    for(int i=0;i<_ndims;i++)
+      start[i]=_cur[i];
+  }
+
+  std::string minc_2_base::history(void) const
+  {
+    return att_value_string("","history");
+  }
+
+  std::string minc_2_base::att_value_string(const char *var_name,const char *att_name) const
+  {
+    minc_io_lock lock;
+    size_t att_length;
+    mitype_t att_type;
+    if(miget_attr_type(_vol,var_name,att_name,&att_type)<0 || att_type!=MI_TYPE_STRING)
+      return "";
+    if(miget_attr_length(_vol,var_name,att_name,&att_length)<0)
+      return "";
+    std::string tmp(att_length+1,'\0');
+    CHECK_MINC_CALL(miget_attr_values(_vol,MI_TYPE_STRING,var_name,att_name,att_length+1,&tmp[0]));
+    tmp.resize(strlen(tmp.c_str()));
+    return tmp;
+  }
+
+  std::vector<double> minc_2_base::att_value_double(const char *var_name,const char *att_name) const
+  {
+    minc_io_lock lock;
+    size_t att_length;
+    mitype_t att_type;
+    if(miget_attr_type(_vol,var_name,att_name,&att_type)<0 || att_type==MI_TYPE_STRING)
+      REPORT_ERROR("Attribute is not numeric");
+    CHECK_MINC_CALL(miget_attr_length(_vol,var_name,att_name,&att_length));
+    std::vector<double> tmp(att_length);
+    if(att_length>0)
+      CHECK_MINC_CALL(miget_attr_values(_vol,MI_TYPE_DOUBLE,var_name,att_name,att_length,&tmp[0]));
+    return tmp;
+  }
+
+  std::vector<int> minc_2_base::att_value_int(const char *var_name,const char *att_name) const
+  {
+    minc_io_lock lock;
+    size_t att_length;
+    mitype_t att_type;
+    if(miget_attr_type(_vol,var_name,att_name,&att_type)<0 || att_type==MI_TYPE_STRING)
+      REPORT_ERROR("Attribute is not numeric");
+    CHECK_MINC_CALL(miget_attr_length(_vol,var_name,att_name,&att_length));
+    std::vector<int> tmp(att_length);
+    if(att_length>0)
+      CHECK_MINC_CALL(miget_attr_values(_vol,MI_TYPE_INT,var_name,att_name,att_length,&tmp[0]));
+    return tmp;
+  }
+
+  //! copy the C statistics into the C++ structure and release them
+  static volume_statistics _convert_statistics(mivolstats_t& st)
+  {
+    volume_statistics ret;
+    ret.count=st.count;
+    ret.min=st.min;
+    ret.max=st.max;
+    ret.sum=st.sum;
+    ret.sum2=st.sum2;
+    ret.mean=st.mean;
+    ret.stddev=st.stddev;
+    ret.hist_min=st.hist_min;
+    ret.hist_max=st.hist_max;
+    if(st.histogram)
+      ret.histogram.assign(st.histogram,st.histogram+st.bins);
+    mifree_volume_statistics(&st);
+    return ret;
+  }
+
+  volume_statistics minc_2_base::statistics(int bins) const
+  {
+    minc_io_lock lock;
+    mivolstats_t st;
+    CHECK_MINC_CALL(micompute_masked_statistics(_vol,NULL,bins,&st));
+    return _convert_statistics(st);
+  }
+
+  volume_statistics minc_2_base::statistics(const minc_2_base& mask,int bins) const
+  {
+    minc_io_lock lock;
+    mivolstats_t st;
+    CHECK_MINC_CALL(micompute_masked_statistics(_vol,mask.handle(),bins,&st));
+    return _convert_statistics(st);
+  }
+
+  std::map<int,volume_statistics> minc_2_base::label_statistics(const minc_2_base& labels,int bins) const
+  {
+    minc_io_lock lock;
+    std::map<int,volume_statistics> ret;
+    int n_labels=0;
+    int *label_values=NULL;
+    mivolstats_t *st=NULL;
+    CHECK_MINC_CALL(micompute_label_statistics(_vol,labels.handle(),NULL,bins,&n_labels,&label_values,&st));
+    for(int i=0;i<n_labels;i++)
+      ret[label_values[i]]=_convert_statistics(st[i]);
+    mifree_label_statistics(0,label_values,st);
+    return ret;
+  }
+
+  void minc_2_base::insert(const char *varname,const char *attname,double val)
+  {
+    minc_io_lock lock;
+    CHECK_MINC_CALL(miset_attr_values(_vol,MI_TYPE_DOUBLE,varname,attname,1,&val));
+  }
+
+  void minc_2_base::insert(const char *varname,const char *attname,const char* val)
+  {
+    minc_io_lock lock;
+    CHECK_MINC_CALL(miset_attr_values(_vol,MI_TYPE_STRING,varname,attname,strlen(val)+1,val));
+  }
+
+  void minc_2_base::insert(const char *varname,const char *attname,const std::vector<double> &val)
+  {
+    minc_io_lock lock;
+    if(val.empty()) return;
+    CHECK_MINC_CALL(miset_attr_values(_vol,MI_TYPE_DOUBLE,varname,attname,val.size(),&val[0]));
+  }
+
+  void minc_2_base::insert(const char *varname,const char *attname,const std::vector<int> &val)
+  {
+    minc_io_lock lock;
+    if(val.empty()) return;
+    CHECK_MINC_CALL(miset_attr_values(_vol,MI_TYPE_INT,varname,attname,val.size(),&val[0]));
+  }
+
+  minc_2_reader::minc_2_reader():
+    _metadate_only(false),
+    _read_prepared(false),
+    _cache_first(0),
+    _cache_count(0),
+    _cache_slices(1),
+    _cache_dim(-1)
+  {
+  }
+
+#if __cplusplus >= 201103L
+  minc_2_reader::minc_2_reader(minc_2_reader&& that):
+    minc_2_reader()
+  {
+    _swap(that);
+    std::swap(_metadate_only,that._metadate_only);
+    std::swap(_read_prepared,that._read_prepared);
+    _path.swap(that._path);
+    _flipped.swap(that._flipped);
+    _cache.swap(that._cache);
+    _cache_cur.swap(that._cache_cur);
+    std::swap(_cache_first,that._cache_first);
+    std::swap(_cache_count,that._cache_count);
+    std::swap(_cache_slices,that._cache_slices);
+    std::swap(_cache_dim,that._cache_dim);
+  }
+#endif
+
+  minc_2_reader::~minc_2_reader()
+  {
+    minc_2_reader::close();
+  }
+
+  void minc_2_reader::close(void)
+  {
+    minc_2_base::close();
+    _path.clear();
+    _read_prepared=false;
+    _cache.clear();
+    _cache_count=0;
+  }
+
+  bool minc_2_reader::flipped(void) const
+  {
+    return std::find(_flipped.begin(),_flipped.end(),true)!=_flipped.end();
+  }
+
+  void minc_2_reader::open(const char *path,bool positive_directions/*=false*/,bool metadate_only/*=false*/,bool rw/*=false*/)
+  {
+    minc_io_lock lock;
+    close();
+    _metadate_only=metadate_only;
+    _read_prepared=false;
+    _positive_directions=positive_directions;
+
+    if(miopen_volume(path,rw?MI2_OPEN_RDWR:MI2_OPEN_READ,&_vol)<0)
+    {
+      _vol=NULL;
+      REPORT_ERROR("Can't open minc file for reading!");
+    }
+    _path=path;
+
+    CHECK_MINC_CALL(miget_volume_dimension_count(_vol,MI_DIMCLASS_ANY,MI_DIMATTR_ALL,&_ndims));
+    if(_ndims<1)
+      REPORT_ERROR("Minc file has no dimensions");
+    _dim_handles.resize(_ndims);
+    CHECK_MINC_CALL(miget_volume_dimensions(_vol,MI_DIMCLASS_ANY,MI_DIMATTR_ALL,MI_DIMORDER_FILE,_ndims,&_dim_handles[0]));
+
+    CHECK_MINC_CALL(miget_data_type(_vol,&_datatype));
+    _is_signed=(_datatype==MI_TYPE_BYTE || _datatype==MI_TYPE_SHORT || _datatype==MI_TYPE_INT ||
+                _datatype==MI_TYPE_FLOAT || _datatype==MI_TYPE_DOUBLE);
+    //fails for slice scaled volumes, where there is no single range
+    if(miget_volume_range(_vol,&_image_range[1],&_image_range[0])<0)
+      CHECK_MINC_CALL(miget_volume_valid_range(_vol,&_image_range[1],&_image_range[0]));
+
+    _info.resize(_ndims);
+    _flipped.assign(_ndims,false);
+    std::fill(_map_to_std.begin(),_map_to_std.end(),-1);
+
+    for(int i=_ndims-1;i>=0;i--)
+    {
+      char *dimname=NULL;
+      misize_t dimlength;
+      CHECK_MINC_CALL(miget_dimension_name(_dim_handles[i],&dimname));
+      CHECK_MINC_CALL(miget_dimension_size(_dim_handles[i],&dimlength));
+      _info[i].name=dimname;
+      _info[i].length=dimlength;
+      _info[i].have_dir_cos=false;
+      mifree_name(dimname);
+
+      if(_info[i].name==MIxspace)
+      {
+        _info[i].dim=dim_info::DIM_X;
+        _map_to_std[1]=i;
+      } else if(_info[i].name==MIyspace) {
+        _info[i].dim=dim_info::DIM_Y;
+        _map_to_std[2]=i;
+      } else if(_info[i].name==MIzspace) {
+        _info[i].dim=dim_info::DIM_Z;
+        _map_to_std[3]=i;
+      } else if(_info[i].name==MIvector_dimension) {
+        _info[i].dim=dim_info::DIM_VEC;
+        _map_to_std[0]=i;
+      } else if(_info[i].name==MItime) {
+        _info[i].dim=dim_info::DIM_TIME;
+        _map_to_std[4]=i;
+      } else {
+        _info[i].dim=dim_info::DIM_UNKNOWN;
+        REPORT_ERROR ("Unknown dimension");
+      }
+
+      if(_info[i].dim!=dim_info::DIM_VEC)
+      {
+        CHECK_MINC_CALL(miget_dimension_separation(_dim_handles[i],MI_ORDER_FILE,&_info[i].step));
+        if(_info[i].step == 0.0)
+          _info[i].step = 1.0;
+        CHECK_MINC_CALL(miget_dimension_start(_dim_handles[i],MI_ORDER_FILE,&_info[i].start));
+
+        //only spatial dimensions are flipped, like in minc_1_reader
+        if(_positive_directions && _info[i].step<0.0 && _info[i].dim!=dim_info::DIM_TIME)
+        {
+          _info[i].start+=_info[i].step*(dimlength-1);
+          _info[i].step=-_info[i].step;
+          CHECK_MINC_CALL(miset_dimension_apparent_voxel_order(_dim_handles[i],MI_POSITIVE));
+          _flipped[i]=true;
+        }
+
+        if(_info[i].dim!=dim_info::DIM_TIME &&
+           miget_dimension_cosines(_dim_handles[i],_info[i].dir_cos)==MI_NOERROR)
+        {
+          _info[i].have_dir_cos=true;
+
+          /* Normalize the direction cosine */
+          double len=sqrt(_info[i].dir_cos[0]*_info[i].dir_cos[0]+
+                          _info[i].dir_cos[1]*_info[i].dir_cos[1]+
+                          _info[i].dir_cos[2]*_info[i].dir_cos[2]);
+
+          if(len>1e-6 && fabs(len-1.0)>1e-6)
+          {
+            for(int a=0;a<3;a++)
+              _info[i].dir_cos[a]/=len;
+          }
+        }
+      } else { //vectors don't have spatial component!
+        _info[i].start=0;
+        _info[i].step=0.0;
+        _info[i].dir_cos[0]=_info[i].dir_cos[1]=_info[i].dir_cos[2]=0.0;
+        _info[i].have_dir_cos=false;
+      }
+    }
+
+    //the hyperslab functions only flip dimensions when an apparent
+    //dimension order is set, use the file order for that
+    if(flipped())
+      CHECK_MINC_CALL(miset_apparent_dimension_order(_vol,_ndims,&_dim_handles[0]));
+
+    // now let's find out the slice dimensions
+    miboolean_t slice_scaling=FALSE;
+    miget_slice_scaling_flag(_vol,&slice_scaling);
+    _slice_dimensions=0;
+    if(slice_scaling && _ndims>2)
+      _slice_dimensions=2;
+
+    if(_slice_dimensions<=0)
+    {
+      if(_info[_ndims-1].dim==dim_info::DIM_VEC || _info[_ndims-1].dim==dim_info::DIM_TIME)
+        _slice_dimensions=std::min(_ndims,3);
+      else
+        _slice_dimensions=std::min(_ndims,2);
+    }
+    _setup_slab();
+
+    //slices are read in groups matching the file chunking along the
+    //innermost dimension that is not part of the slice
+    _cache_dim=_ndims-_slice_dimensions-1;
+    _cache_slices=1;
+    _cache_count=0;
+    if(_cache_dim>=0)
+    {
+      mivolumeprops_t props;
+      if(miget_volume_props(_vol,&props)==MI_NOERROR)
+      {
+        int edge_count=0;
+        int edge_lengths[MI2_MAX_VAR_DIMS];
+        if(miget_props_blocking(props,&edge_count,edge_lengths,MI2_MAX_VAR_DIMS)==MI_NOERROR &&
+           edge_count==_ndims && edge_lengths[_cache_dim]>1)
+          _cache_slices=std::min<long>(edge_lengths[_cache_dim],_info[_cache_dim].length);
+        mifree_volume_props(props);
+      }
+    }
+  }
+
+  void minc_2_reader::_setup_read(mitype_t io_datatype)
+  {
+    if(_metadate_only)
+      REPORT_ERROR("Minc file in metadate only mode!");
+    _io_datatype=io_datatype;
+    _cache_count=0;
+    _read_prepared=true;
+  }
+
+  void minc_2_reader::setup_read_float(void)
+  {
+    _setup_read(MI_TYPE_FLOAT);
+  }
+
+  void minc_2_reader::setup_read_double(void)
+  {
+    _setup_read(MI_TYPE_DOUBLE);
+  }
+
+  void minc_2_reader::setup_read_short(bool /*normalized*/)
+  {
+    _setup_read(MI_TYPE_SHORT);
+  }
+
+  void minc_2_reader::setup_read_ushort(bool /*normalized*/)
+  {
+    _setup_read(MI_TYPE_USHORT);
+  }
+
+  void minc_2_reader::setup_read_byte(bool /*normalized*/)
+  {
+    _setup_read(MI_TYPE_UBYTE);
+  }
+
+  void minc_2_reader::setup_read_int(bool /*normalized*/)
+  {
+    _setup_read(MI_TYPE_INT);
+  }
+
+  void minc_2_reader::setup_read_uint(bool /*normalized*/)
+  {
+    _setup_read(MI_TYPE_UINT);
+  }
+
+  void minc_2_reader::_fill_cache(void)
+  {
+    minc_io_lock lock;
+    long pos=_cur[_cache_dim];
+    long len=_info[_cache_dim].length;
+
+    //align the block with the chunk boundaries in file order
+    if(_flipped[_cache_dim])
+    {
+      long file_first=((len-1-pos)/_cache_slices)*_cache_slices;
+      long file_last=std::min(file_first+_cache_slices,len);
+      _cache_first=len-file_last;
+      _cache_count=file_last-file_first;
+    } else {
+      _cache_first=(pos/_cache_slices)*_cache_slices;
+      _cache_count=std::min(_cache_slices,len-_cache_first);
+    }
+
+    std::vector<misize_t> start,count(_slab);
+    _cur_start(start);
+    start[_cache_dim]=_cache_first;
+    count[_cache_dim]=_cache_count;
+
+    _cache.resize(static_cast<size_t>(_cache_count)*_slab_len*element_size());
+    CHECK_MINC_CALL(miget_real_value_hyperslab(_vol,_io_datatype,&start[0],&count[0],&_cache[0]));
+    _cache_cur=_cur;
+  }
+
+  void minc_2_reader::read(void* buffer)
+  {
+    minc_io_lock lock;
+    if(!_read_prepared)
+      REPORT_ERROR("Not ready to read, use setup_read_XXXX");
+
+    if(_cache_slices<=1)
+    {
+      std::vector<misize_t> start;
+      _cur_start(start);
+      CHECK_MINC_CALL(miget_real_value_hyperslab(_vol,_io_datatype,&start[0],&_slab[0],buffer));
+      return;
+    }
+
+    bool hit=_cache_count>0 &&
+             _cur[_cache_dim]>=_cache_first &&
+             _cur[_cache_dim]<_cache_first+_cache_count;
+    for(int i=0;hit && i<_cache_dim;i++)
+      hit=(_cur[i]==_cache_cur[i]);
+
+    if(!hit)
+      _fill_cache();
+
+    size_t slice_bytes=static_cast<size_t>(_slab_len)*element_size();
+    memcpy(buffer,&_cache[(_cur[_cache_dim]-_cache_first)*slice_bytes],slice_bytes);
+  }
+
+  void minc_2_reader::read_all(void* buffer)
+  {
+    minc_io_lock lock;
+    if(!_read_prepared)
+      REPORT_ERROR("Not ready to read, use setup_read_XXXX");
+
+    std::vector<misize_t> start(_ndims,0),count(_ndims);
+    for(int i=0;i<_ndims;i++)
+      count[i]=_info[i].length;
+    CHECK_MINC_CALL(miget_real_value_hyperslab(_vol,_io_datatype,&start[0],&count[0],buffer));
+  }
+
+  minc_2_writer::minc_2_writer():
+    _set_image_range(false),
+    _set_slice_range(false),
+    _write_prepared(false),
+    _compress(true)
+  {
+  }
+
+#if __cplusplus >= 201103L
+  minc_2_writer::minc_2_writer(minc_2_writer&& that):
+    minc_2_writer()
+  {
+    _swap(that);
+    std::swap(_set_image_range,that._set_image_range);
+    std::swap(_set_slice_range,that._set_slice_range);
+    std::swap(_write_prepared,that._write_prepared);
+    std::swap(_compress,that._compress);
+  }
+#endif
+
+  void minc_2_writer::open(const char *path,const minc_info& inf,int slice_dimensions,nc_type datatype,int is_signed/*=0*/)
+  {
+    mitype_t t;
+    switch(datatype)
+    {
+      case NC_BYTE:  t=is_signed?MI_TYPE_BYTE:MI_TYPE_UBYTE;break;
+      case NC_SHORT: t=is_signed?MI_TYPE_SHORT:MI_TYPE_USHORT;break;
+      case NC_INT:   t=is_signed?MI_TYPE_INT:MI_TYPE_UINT;break;
+      case NC_FLOAT: t=MI_TYPE_FLOAT;break;
+      case NC_DOUBLE:t=MI_TYPE_DOUBLE;break;
+      default: REPORT_ERROR("Unsupported data type");
+    }
+    open(path,inf,slice_dimensions,t);
+  }
+
+  void minc_2_writer::open(const char *path,const minc_info& inf,int slice_dimensions,mitype_t datatype)
+  {
+    minc_io_lock lock;
+    close();
+    _info=inf;
+    _write_prepared=false;
+    _ndims=_info.size();
+    _datatype=datatype;
+    _slice_dimensions=std::min(slice_dimensions,_ndims);
+    _is_signed=(_datatype==MI_TYPE_BYTE || _datatype==MI_TYPE_SHORT || _datatype==MI_TYPE_INT ||
+                _datatype==MI_TYPE_FLOAT || _datatype==MI_TYPE_DOUBLE);
+    std::fill(_map_to_std.begin(),_map_to_std.end(),-1);
+    _dim_handles.resize(_ndims);
+
+    for(int i=_ndims-1;i>=0;i--)
+    {
+      midimclass_t dimclass=MI_DIMCLASS_SPATIAL;
+      //just a precaution
+      switch(_info[i].dim)
+      {
+        case dim_info::DIM_X:_info[i].name=MIxspace;_map_to_std[1]=i;break;
+        case dim_info::DIM_Y:_info[i].name=MIyspace;_map_to_std[2]=i;break;
+        case dim_info::DIM_Z:_info[i].name=MIzspace;_map_to_std[3]=i;break;
+        case dim_info::DIM_TIME:_info[i].name=MItime;_map_to_std[4]=i;dimclass=MI_DIMCLASS_TIME;break;
+        default:
+        case dim_info::DIM_VEC:_info[i].name=MIvector_dimension;_map_to_std[0]=i;dimclass=MI_DIMCLASS_RECORD;break;
+      }
+      CHECK_MINC_CALL(micreate_dimension(_info[i].name.c_str(),dimclass,MI_DIMATTR_REGULARLY_SAMPLED,_info[i].length,&_dim_handles[i]));
+      if(_info[i].dim!=dim_info::DIM_VEC)
+      {
+        CHECK_MINC_CALL(miset_dimension_separation(_dim_handles[i],_info[i].step));
+        CHECK_MINC_CALL(miset_dimension_start(_dim_handles[i],_info[i].start));
+        if(_info[i].have_dir_cos)
+          CHECK_MINC_CALL(miset_dimension_cosines(_dim_handles[i],_info[i].dir_cos));
+      }
+    }
+
+    mivolumeprops_t props;
+    CHECK_MINC_CALL(minew_volume_props(&props));
+    if(_compress)
+    {
+      miset_props_compression_type(props,MI_COMPRESS_ZLIB);
+      miset_props_access_pattern(props,MI_ACCESS_SLICE);
+    } else {
+      miset_props_compression_type(props,MI_COMPRESS_NONE);
+    }
+    int r=micreate_volume(path,_ndims,&_dim_handles[0],_datatype,MI_CLASS_REAL,props,&_vol);
+    mifree_volume_props(props);
+    if(r<0)
+    {
+      _vol=NULL;
+      REPORT_ERROR("Error opening minc file for writing");
+    }
+    _setup_slab();
+    _image_range[0]=DBL_MAX;_image_range[1]=-DBL_MAX;
+  }
+
+  void minc_2_writer::open(const char *path,const minc_2_base& imitate)
+  {
+    open(path,imitate.info(),imitate.slice_dimensions(),imitate.datatype());
+    copy_headers(imitate);
+  }
+
+  void minc_2_writer::open(const char *path,const char *imitate_file)
+  {
+    minc_2_reader rdr;
+    rdr.open(imitate_file,false,true);
+    open(path,rdr);
+  }
+
+  void minc_2_writer::_setup_write(mitype_t io_datatype)
+  {
+    minc_io_lock lock;
+    if(!_vol)
+      REPORT_ERROR("Minc file is not open");
+    if(_write_prepared)
+      REPORT_ERROR("Minc file is already prepared for writing");
+
+    bool float_file=(_datatype==MI_TYPE_FLOAT || _datatype==MI_TYPE_DOUBLE);
+    bool float_io=(io_datatype==MI_TYPE_FLOAT || io_datatype==MI_TYPE_DOUBLE);
+
+    //real values stored in an integer file are scaled slice by slice,
+    //the MINC2 image-max/image-min cover all but the two fastest dimensions
+    _set_slice_range=float_io && !float_file;
+    _set_image_range=float_file;
+    if(_set_slice_range && _ndims>2)
+    {
+      if(_slice_dimensions<2)
+        REPORT_ERROR("Need at least two dimensions per slice to store scaled data");
+      CHECK_MINC_CALL(miset_slice_scaling_flag(_vol,TRUE));
+    }
+    CHECK_MINC_CALL(micreate_volume_image(_vol));
+
+    switch(_datatype)
+    {
+      case MI_TYPE_BYTE:  CHECK_MINC_CALL(miset_volume_valid_range(_vol,SCHAR_MAX,SCHAR_MIN));break;
+      case MI_TYPE_UBYTE: CHECK_MINC_CALL(miset_volume_valid_range(_vol,UCHAR_MAX,0));break;
+      case MI_TYPE_SHORT: CHECK_MINC_CALL(miset_volume_valid_range(_vol,SHRT_MAX,SHRT_MIN));break;
+      case MI_TYPE_USHORT:CHECK_MINC_CALL(miset_volume_valid_range(_vol,USHRT_MAX,0));break;
+      case MI_TYPE_INT:   CHECK_MINC_CALL(miset_volume_valid_range(_vol,INT_MAX,INT_MIN));break;
+      case MI_TYPE_UINT:  CHECK_MINC_CALL(miset_volume_valid_range(_vol,UINT_MAX,0));break;
+      default:break;
+    }
+
+    //integer values are stored as they are
+    if(!float_io && !float_file)
+    {
+      double valid_max,valid_min;
+      CHECK_MINC_CALL(miget_volume_valid_range(_vol,&valid_max,&valid_min));
+      CHECK_MINC_CALL(miset_volume_range(_vol,valid_max,valid_min));
+    }
+
+    _io_datatype=io_datatype;
+    _image_range[0]=DBL_MAX;_image_range[1]=-DBL_MAX;
+    _write_prepared=true;
+  }
+
+  void minc_2_writer::setup_write_float(void)
+  {
+    _setup_write(MI_TYPE_FLOAT);
+  }
+
+  void minc_2_writer::setup_write_double(void)
+  {
+    _setup_write(MI_TYPE_DOUBLE);
+  }
+
+  void minc_2_writer::setup_write_short(bool /*normalize*/)
+  {
+    _setup_write(MI_TYPE_SHORT);
+  }
+
+  void minc_2_writer::setup_write_ushort(bool /*normalize*/)
+  {
+    _setup_write(MI_TYPE_USHORT);
+  }
+
+  void minc_2_writer::setup_write_byte(bool /*normalize*/)
+  {
+    _setup_write(MI_TYPE_UBYTE);
+  }
+
+  void minc_2_writer::setup_write_int(bool /*normalize*/)
+  {
+    _setup_write(MI_TYPE_INT);
+  }
+
+  void minc_2_writer::setup_write_uint(bool /*normalize*/)
+  {
+    _setup_write(MI_TYPE_UINT);
+  }
+
+  template<class T> static void _minmax(const void *buffer,size_t len,double &r_min,double &r_max)
+  {
+    const T *tmp=static_cast<const T*>(buffer);
+    for(size_t i=0;i<len;i++)
+    {
+      if(r_min>tmp[i]) r_min=tmp[i];
+      if(r_max<tmp[i]) r_max=tmp[i];
+    }
+  }
+
+  void minc_2_writer::_slab_range(const void *buffer,double &r_min,double &r_max) const
+  {
+    r_min= DBL_MAX;
+    r_max=-DBL_MAX;
+    switch(_io_datatype)
+    {
+      case MI_TYPE_FLOAT: _minmax<float>(buffer,_slab_len,r_min,r_max);break;
+      case MI_TYPE_DOUBLE:_minmax<double>(buffer,_slab_len,r_min,r_max);break;
+      case MI_TYPE_SHORT: _minmax<short>(buffer,_slab_len,r_min,r_max);break;
+      case MI_TYPE_USHORT:_minmax<unsigned short>(buffer,_slab_len,r_min,r_max);break;
+      case MI_TYPE_UBYTE: _minmax<unsigned char>(buffer,_slab_len,r_min,r_max);break;
+      case MI_TYPE_INT:   _minmax<int>(buffer,_slab_len,r_min,r_max);break;
+      case MI_TYPE_UINT:  _minmax<unsigned int>(buffer,_slab_len,r_min,r_max);break;
+      default:break;
+    }
+  }
+
+  void minc_2_writer::write(void* buffer)
+  {
+    minc_io_lock lock;
+    if(!_write_prepared)
+      REPORT_ERROR("Not ready to write, use setup_write_XXXX");
+
+    std::vector<misize_t> start;
+    _cur_start(start);
+
+    double r_min,r_max;
+    _slab_range(buffer,r_min,r_max);
+    if(r_min>r_max) r_min=r_max=0.0; //empty slab
+    if(_image_range[0]>r_min) _image_range[0]=r_min;
+    if(_image_range[1]<r_max) _image_range[1]=r_max;
+
+    if(_set_slice_range)
+    {
+      if(_ndims>2)
+      {
+        //the same range for every 2D slice within the slab
+        std::vector<misize_t> pos(start);
+        int first=_ndims-_slice_dimensions;
+        for(;;)
+        {
+          CHECK_MINC_CALL(miset_slice_range(_vol,&pos[0],_ndims,r_max,r_min));
+          int i;
+          for(i=_ndims-3;i>=first;i--)
+          {
+            if(++pos[i]<static_cast<misize_t>(_info[i].length))
+              break;
+            pos[i]=0;
+          }
+          if(i<first) break;
+        }
+      } else {
+        CHECK_MINC_CALL(miset_volume_range(_vol,r_max,r_min));
+      }
+      CHECK_MINC_CALL(miset_real_value_hyperslab(_vol,_io_datatype,&start[0],&_slab[0],buffer));
+    } else if(_io_datatype==MI_TYPE_FLOAT || _io_datatype==MI_TYPE_DOUBLE) {
+      CHECK_MINC_CALL(miset_real_value_hyperslab(_vol,_io_datatype,&start[0],&_slab[0],buffer));
+    } else {
+      CHECK_MINC_CALL(miset_voxel_value_hyperslab(_vol,_io_datatype,&start[0],&_slab[0],buffer));
+    }
+  }
+
+  void minc_2_writer::write_all(void* buffer)
+  {
+    if(!_write_prepared)
+      REPORT_ERROR("Not ready to write, use setup_write_XXXX");
+
+    //writing slice by slice keeps per-slice scaling simple
+    size_t slice_bytes=static_cast<size_t>(_slab_len)*element_size();
+    char *ptr=static_cast<char*>(buffer);
+    for(begin();!last();next_slice(),ptr+=slice_bytes)
+      write(ptr);
+  }
+
+  void minc_2_writer::copy_headers(const minc_2_base& src)
+  {
+    minc_io_lock lock;
+    CHECK_MINC_CALL(micopy_attr(src.handle(),"/",_vol));
+    std::string hist=src.history();
+    if(!hist.empty())
+      CHECK_MINC_CALL(miadd_history_attr(_vol,hist.length()+1,hist.c_str()));
+  }
+
+  void minc_2_writer::append_history(const char *append_history)
+  {
+    minc_io_lock lock;
+    std::string hist=history();
+    if(!hist.empty() && hist[hist.length()-1]!='\n')
+      hist+="\n";
+    hist+=append_history;
+    CHECK_MINC_CALL(miadd_history_attr(_vol,hist.length()+1,hist.c_str()));
+  }
+
+  minc_2_writer::~minc_2_writer()
+  {
+    minc_2_writer::close();
+  }
+
+  void minc_2_writer::close(void)
+  {
+    minc_io_lock lock;
+    if(_vol && _write_prepared && _set_image_range && _image_range[0]<=_image_range[1])
+      miset_volume_range(_vol,_image_range[1],_image_range[0]);
+    _write_prepared=false;
+    minc_2_base::close();
+  }
+
+  minc_2_mapping::minc_2_mapping():
+    _addr(NULL),
+    _len(0),
+    _data(NULL)
+  {
+  }
+
+  minc_2_mapping::~minc_2_mapping()
+  {
+    unmap();
+  }
+
+  void minc_2_mapping::unmap(void)
+  {
+#ifndef WIN32
+    if(_addr)
+      munmap(_addr,_len);
+#endif
+    _addr=NULL;
+    _len=0;
+    _data=NULL;
+  }
+
+  bool minc_2_mapping::map(const minc_2_reader& rw,mitype_t datatype)
+  {
+    minc_io_lock lock;
+    unmap();
+#ifndef WIN32
+    misize_t offset,size;
+    if(miget_volume_image_storage(rw.handle(),datatype,&offset,&size)<0 || !size)
+      return false;
+
+    int fd=::open(rw.path().c_str(),O_RDONLY);
+    if(fd<0)
+      return false;
+
+    struct stat st;
+    if(fstat(fd,&st) || static_cast<misize_t>(st.st_size)<offset+size)
+    {
+      ::close(fd);
+      return false;
+    }
+
+    //mmap needs a page aligned offset
+    size_t page=static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    off_t start=static_cast<off_t>(offset-offset%page);
+    size_t delta=static_cast<size_t>(offset-start);
+
+    void *addr=mmap(NULL,size+delta,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,start);
+    ::close(fd);
+    if(addr==MAP_FAILED)
+      return false;
+
+    _addr=addr;
+    _len=size+delta;
+    _data=static_cast<char*>(addr)+delta;
+    return true;
+#else
+    return false;
+#endif
+  }
+}
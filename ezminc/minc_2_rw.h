@@ -0,0 +1,494 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : minc_2_rw.h
+@DESCRIPTION: Primitive C++ interface to minc files, uses MINC2 API only
+@COPYRIGHT  :
+              Copyright McConnell Brain Imaging Centre,
+              Montreal Neurological Institute, McGill University.
+              Permission to use, copy, modify, and distribute this
+              software and its documentation for any purpose and without
+              fee is hereby granted, provided that the above copyright
+              notice appear in all copies.  The author and McGill University
+              make no representations about the suitability of this
+              software for any purpose.  It is provided "as is" without
+              express or implied warranty.
+---------------------------------------------------------------------------- */
+#ifndef MINC_2_RW_H
+#define MINC_2_RW_H
+
+#include <vector>
+#include <string>
+#include <map>
+
+#include "minc_io_exceptions.h"
+#include "minc_1_rw.h"   // for dim_info and minc_info
+
+extern "C" {
+#include <minc2.h>
+}
+
+namespace minc
+{
+  //! statistics of the real voxel values of a volume, see minc_2_base::statistics
+  struct volume_statistics
+  {
+    size_t count;
+    double min,max;
+    double sum,sum2;
+    double mean,stddev;
+    double hist_min,hist_max;        // range spanned by the histogram
+    std::vector<double> histogram;   // empty unless bins were requested
+
+    volume_statistics():
+      count(0),min(0.0),max(0.0),sum(0.0),sum2(0.0),
+      mean(0.0),stddev(0.0),hist_min(0.0),hist_max(0.0)
+    {}
+  };
+
+  //! minc file rw base class, talks to the MINC2 volume API directly
+  //! has the same slice interface as minc_1_base, so that iterators and
+  //! load/save functions work with both
+  //! the object owns the volume handle: it can be moved but not copied
+  class minc_2_base
+  {
+  protected:
+    mihandle_t _vol;
+    std::vector<midimhandle_t> _dim_handles;
+    int _slab_len;
+    std::vector<long> _cur;
+    std::vector<misize_t> _slab;
+    size_t  _slice_dimensions;
+    bool _last;
+    bool _positive_directions;
+    mitype_t _datatype;
+    mitype_t _io_datatype;
+    int _ndims;
+    int _is_signed;
+    double _image_range[2];
+    std::vector<int> _map_to_std;
+    minc_info _info;
+
+    //! swap contents with another object, used for moving
+    void _swap(minc_2_base& that);
+
+    //! fill _slab and _slab_len from _slice_dimensions
+    void _setup_slab(void);
+
+    //! current slice position as misize_t array
+    void _cur_start(std::vector<misize_t>& start) const;
+
+  private:
+    //! copying would close the same volume handle twice
+    minc_2_base(const minc_2_base&);
+    minc_2_base& operator=(const minc_2_base&);
+
+  public:
+
+    //! get the minc volume handle
+    mihandle_t handle(void) const
+    {
+      return _vol;
+    }
+
+    //! get the data type of the file (MI_TYPE_BYTE, MI_TYPE_SHORT etc)
+    mitype_t datatype(void) const
+    {
+      return _datatype;
+    }
+
+    //! byte size of the volume elements
+    unsigned int element_size(void) const
+    {
+      switch(_io_datatype)
+      {
+        case MI_TYPE_FLOAT: return sizeof(float);
+        case MI_TYPE_DOUBLE: return sizeof(double);
+        case MI_TYPE_SHORT:
+        case MI_TYPE_USHORT: return sizeof(short);
+        case MI_TYPE_BYTE:
+        case MI_TYPE_UBYTE: return sizeof(char);
+        case MI_TYPE_INT:
+        case MI_TYPE_UINT: return sizeof(int);
+        default:return 0;
+      }
+    }
+
+    //! is data stored in signed format
+    bool is_signed(void) const
+    {
+      return _is_signed;
+    }
+
+    //! constructor
+    minc_2_base();
+
+#if __cplusplus >= 201103L
+    //! move constructor, takes over the volume handle
+    minc_2_base(minc_2_base&& that);
+
+    //! move assignment, closes our volume and takes over the other one
+    minc_2_base& operator=(minc_2_base&& that);
+#endif
+
+    //! destructor, closes minc file
+    virtual ~minc_2_base();
+
+    //! close the minc file
+    virtual void close(void);
+
+    //! is last slice was read?
+    bool last(void) const
+    {
+      return _last;
+    }
+
+    //! go to the beginning of file
+    void begin(void)
+    {
+      fill(_cur.begin(),_cur.end(),0);
+      _last=false;
+    }
+
+    //! advance to next slice
+    bool next_slice(void)
+    {
+      if(_last) return !_last;
+
+      for(int i=_ndims-_slice_dimensions-1;i>=0;i--)
+      {
+        _cur[i]++;
+        if(_cur[i]<static_cast<long>(_info[i].length))
+          break;
+        if(!i)
+          _last=true;
+        else
+          _cur[i]=0;
+      }
+      return !_last;
+    }
+
+    //! slice length in elements
+    int slice_len(void) const
+    {
+      return _slab_len;
+    }
+
+    //! number of dimensions
+    int dim_no(void) const
+    {
+      return _ndims;
+    }
+
+    //! get the dimension information
+    const dim_info& dim(unsigned int n) const
+    {
+      if(n>=static_cast<unsigned int>(_ndims))
+        REPORT_ERROR("Dimension is not defined");
+      return _info[n];
+    }
+
+    //! get the pointer to the dimension description array
+    const minc_info& info(void) const
+    {
+      return _info;
+    }
+
+    //! get the number of dimensions in one slice
+    int slice_dimensions(void) const
+    {
+      return _slice_dimensions;
+    }
+
+    //! get the current slice index
+    const std::vector<long> & current_slice(void) const
+    {
+      return _cur;
+    }
+
+    //! get the normalized dimensions sizes
+    //! ( 0 - vector_dimension, 1 - x, 2- y , 3 -z , 4 - time)
+    int ndim(int i) const
+    {
+      int j=_map_to_std[i];
+      if(j>=0) return _info[j].length;
+      return 0;
+    }
+
+    //! get normalized dimension start coordinate (see ndim)
+    double nstart(int i) const
+    {
+      int j=_map_to_std[i];
+      if(j>=0) return _info[j].start;
+      return 0.0;
+    }
+
+    //! get normalized dimension spacing  (see ndim)
+    double nspacing(int i) const
+    {
+      int j=_map_to_std[i];
+      if(j>=0) return _info[j].step;
+      return 0.0;
+    }
+
+    //! get normalized dimension direction cosine component  (see ndim)
+    double ndir_cos(int i,int j) const
+    {
+      int k=_map_to_std[i];
+      if(k>=0) return _info[k].dir_cos[j];
+      return 0.0;
+    }
+
+    //! check if a normalized dimension has direction cosine information
+    bool have_dir_cos(int i) const
+    {
+      int k=_map_to_std[i];
+      if(k>=0) return _info[k].have_dir_cos;
+      return false;
+    }
+
+    //! map file dimensions into normalized dimensions
+    int map_space(int i)
+    {
+      return _map_to_std[i];
+    }
+
+    //metadate info handling function:
+    //! read the minc history (:history attribute)
+    std::string history(void) const;
+
+    //! get the string attribute value, given the group path and name
+    std::string att_value_string(const char *var_name,const char *att_name) const;
+
+    //! get the double attribute value, given the group path and name
+    std::vector<double> att_value_double(const char *var_name,const char *att_name) const;
+
+    //! get the int attribute value, given the group path and name
+    std::vector<int> att_value_int(const char *var_name,const char *att_name) const;
+
+    //! compute the statistics of the real voxel values, with a histogram of bins bins
+    //! the image is read in bounded blocks, it does not have to fit in memory
+    volume_statistics statistics(int bins=0) const;
+
+    //! compute the statistics within a mask of the same dimensions (voxels >= 0.5)
+    volume_statistics statistics(const minc_2_base& mask,int bins=0) const;
+
+    //! compute the statistics for each label of a label volume of the same dimensions
+    std::map<int,volume_statistics> label_statistics(const minc_2_base& labels,int bins=0) const;
+
+    void insert(const char *varname,const char *attname,double val);
+    void insert(const char *varname,const char *attname,const char* val);
+    void insert(const char *varname,const char *attname,const std::vector<double> &val);
+    void insert(const char *varname,const char *attname,const std::vector<int> &val);
+
+    //! always true
+    bool is_minc2(void) const
+    {
+      return true;
+    }
+  };
+
+  //! minc file reader
+  class minc_2_reader:public minc_2_base
+  {
+    protected:
+      bool _metadate_only;
+      bool _read_prepared;
+
+      std::string _path;
+
+      //! dimensions which are read in the reverse of file order
+      std::vector<bool> _flipped;
+
+      //! slices are read one chunk at a time along the innermost
+      //! non-slice dimension, and then served from memory
+      std::vector<char> _cache;
+      std::vector<long> _cache_cur; // position of the cached block
+      long _cache_first;            // first cached slice
+      long _cache_count;            // number of cached slices
+      long _cache_slices;           // chunk length along _cache_dim
+      int  _cache_dim;
+
+      void _setup_read(mitype_t io_datatype);
+      void _fill_cache(void);
+
+    public:
+    //! default constructor
+    minc_2_reader();
+
+#if __cplusplus >= 201103L
+    //! move constructor
+    minc_2_reader(minc_2_reader&& that);
+#endif
+
+    //! close the minc file
+    virtual void close(void);
+
+    //! destructor
+    virtual ~minc_2_reader();
+
+    //! open a minc file
+    //! \param path - path to existing  minc file
+    //! \param positive_directions  - make all step sizes positive
+    //! \param metadate_only - file is opened only for the purpose of reading metadata
+    //! \param rw - file headers may be modified
+    void open(const char *path,bool positive_directions=false,bool metadate_only=false,bool rw=false);
+
+    //! path of the open file
+    const std::string& path(void) const
+    {
+      return _path;
+    }
+
+    //! true if some dimension is read in the reverse of file order
+    bool flipped(void) const;
+
+    //! read single slice
+    void read(void* slice);
+
+    //! read the whole volume, in file dimension order, into buffer
+    void read_all(void* buffer);
+
+    //! setup reading in float format
+    void setup_read_float(void);
+    //! setup reading in double format
+    void setup_read_double(void);
+    //! setup reading in signed short format
+    //! integer types always receive real values, normalized is accepted
+    //! for compatibility with minc_1_reader and ignored
+    void setup_read_short(bool normalized=false);
+    //! setup reading in unsigned short format
+    void setup_read_ushort(bool normalized=false);
+    //! setup reading in byte format
+    void setup_read_byte(bool normalized=false);
+    //! setup reading in int format
+    void setup_read_int(bool normalized=false);
+    //! setup reading in unsigned int format
+    void setup_read_uint(bool normalized=false);
+  };
+
+  //! minc file writer
+  class minc_2_writer:public minc_2_base
+  {
+    protected:
+      bool _set_image_range;
+      bool _set_slice_range;
+      bool _write_prepared;
+      bool _compress;
+
+      void _setup_write(mitype_t io_datatype);
+      void _slab_range(const void *buffer,double &r_min,double &r_max) const;
+
+    public:
+      //! open minc file for writing - will overwrite existing
+      //! \param path - path to minc file
+      //! \param inf  - information about dimensions
+      //! \param slice_dimensions - number of dimensions per slice (used for storage)
+      //! \param datatype - storage datatype
+      void open(const char *path,const minc_info& inf,int slice_dimensions,mitype_t datatype);
+
+      //! open minc file for writing, with the storage type given as in minc_1_writer
+      void open(const char *path,const minc_info& inf,int slice_dimensions,nc_type datatype,int is_signed=0);
+
+      //! open minc file for writing - will overwrite existing
+      //! \param path - path to minc file
+      //! \param imitate  - all information is copied from this opened minc file
+      void open(const char *path,const minc_2_base& imitate);
+
+      //! open minc file for writing - will overwrite existing
+      //! \param path - path to minc file
+      //! \param imitate_file  - all information is copied from this existing minc file
+      void open(const char *path,const char *imitate_file);
+
+      //! store the image zlib compressed (default) or uncompressed and
+      //! contiguous, so that it can be memory mapped, applies to the next open
+      void set_compression(bool compress)
+      {
+        _compress=compress;
+      }
+
+      //! prepare for writing float array
+      void setup_write_float(void);
+      //! prepare for writing double array
+      void setup_write_double(void);
+      //! prepare for writing short array
+      //! integer types are always written as real values, normalize is
+      //! accepted for compatibility with minc_1_writer and ignored
+      void setup_write_short(bool normalize=false);
+      //! prepare for writing unsigned short array
+      void setup_write_ushort(bool normalize=false);
+      //! prepare for writing unsigned char array
+      void setup_write_byte(bool normalize=false);
+      //! prepare for writing int array
+      void setup_write_int(bool normalize=false);
+      //! prepare for writing unsigned int array
+      void setup_write_uint(bool normalize=false);
+
+      //! copy header from another minc file
+      //! \param src - opened minc file
+      void copy_headers(const minc_2_base& src);
+
+      //! append a line into minc history
+      //! \param append_history - history line to append
+      void append_history(const char *append_history);
+
+      //! default constructor
+      minc_2_writer();
+
+#if __cplusplus >= 201103L
+      //! move constructor
+      minc_2_writer(minc_2_writer&& that);
+#endif
+
+      //! destructor
+      virtual ~minc_2_writer();
+
+      //! close the minc file
+      virtual void close(void);
+
+      //!write a single slice, size of the buffer should be more or equall to slab_len
+      void write(void* slice);
+
+      //! write the whole volume, in file dimension order, from buffer
+      void write_all(void* buffer);
+  };
+
+  //! private memory mapping of the image data of a minc file
+  //! only possible when the image is stored uncompressed and contiguous,
+  //! in the native byte order of the requested type
+  //! pages are shared with the page cache until they are modified
+  class minc_2_mapping
+  {
+    protected:
+      void *_addr;   // start of the mapped pages
+      size_t _len;   // length of the mapped pages
+      char *_data;   // start of the image data
+
+    private:
+      //! copying would unmap the same pages twice
+      minc_2_mapping(const minc_2_mapping&);
+      minc_2_mapping& operator=(const minc_2_mapping&);
+
+    public:
+      minc_2_mapping();
+      ~minc_2_mapping();
+
+      //! map the image of the file opened with rw, at its selected
+      //! resolution, voxels stored as datatype
+      //! \return false if the image can't be mapped
+      bool map(const minc_2_reader& rw,mitype_t datatype);
+
+      //! release the mapping
+      void unmap(void);
+
+      //! image data, in file dimension order
+      void* data(void) const
+      {
+        return _data;
+      }
+
+      bool mapped(void) const
+      {
+        return _data!=NULL;
+      }
+  };
+}
+#endif //MINC_2_RW_H
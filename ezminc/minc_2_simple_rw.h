@@ -0,0 +1,218 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : minc_2_simple_rw.h
+@DESCRIPTION: simple volume load/save through the MINC2 API
+@COPYRIGHT  :
+              Copyright McConnell Brain Imaging Centre,
+              Montreal Neurological Institute, McGill University.
+              Permission to use, copy, modify, and distribute this
+              software and its documentation for any purpose and without
+              fee is hereby granted, provided that the above copyright
+              notice appear in all copies.  The author and McGill University
+              make no representations about the suitability of this
+              software for any purpose.  It is provided "as is" without
+              express or implied warranty.
+---------------------------------------------------------------------------- */
+#ifndef MINC_2_SIMPLE_RW_H
+#define MINC_2_SIMPLE_RW_H
+
+#include <typeinfo>
+#include "minc_2_rw.h"
+#include "minc_1_simple_rw.h"
+
+namespace minc
+{
+  //! check if the file is stored as Z Y X, the layout of simple_volume
+  template<class B> bool is_zyx_volume(const B& rw)
+  {
+    return rw.dim_no()==3 &&
+           rw.info()[0].dim==dim_info::DIM_Z &&
+           rw.info()[1].dim==dim_info::DIM_Y &&
+           rw.info()[2].dim==dim_info::DIM_X;
+  }
+
+  //! set coordinate transfer parameters of the volume from the file
+  template<class T> void set_simple_volume_space(const minc_2_base& rw,simple_volume<T>& vol)
+  {
+    for(int i=0;i<3;i++)
+    {
+      vol.step()[i]=rw.nspacing(i+1);
+      vol.start()[i]=rw.nstart(i+1);
+
+      if(rw.have_dir_cos(i+1))
+      {
+        for(int j=0;j<3;j++)
+          vol.direction_cosines(i)[j]=rw.ndir_cos(i+1,j);
+      } else {
+        for(int j=0;j<3;j++)
+          vol.direction_cosines(i)[j]=(i==j?1.0:0.0); //identity
+      }
+    }
+  }
+
+  //! load 3D volume, when the file is stored as Z Y X the whole volume
+  //! is read in one call straight into the volume buffer
+  template<class T> void load_simple_volume(minc_2_reader& rw,simple_volume<T>& vol)
+  {
+    if(!is_zyx_volume(rw))
+    {
+      load_simple_volume<T,minc_2_reader>(rw,vol);
+      return;
+    }
+
+    if(typeid(T)==typeid(unsigned char))
+      rw.setup_read_byte();
+    else if(typeid(T)==typeid(short))
+      rw.setup_read_short();
+    else if(typeid(T)==typeid(unsigned short))
+      rw.setup_read_ushort();
+    else if(typeid(T)==typeid(int))
+      rw.setup_read_int();
+    else if(typeid(T)==typeid(float))
+      rw.setup_read_float();
+    else if(typeid(T)==typeid(double))
+      rw.setup_read_double();
+    else
+    {
+      load_simple_volume<T,minc_2_reader>(rw,vol);
+      return;
+    }
+
+    vol.resize(rw.ndim(1),rw.ndim(2),rw.ndim(3));
+    rw.read_all(vol.c_buf());
+
+    set_simple_volume_space(rw,vol);
+  }
+
+  //! save 3D volume, when the file is stored as Z Y X the volume buffer
+  //! is written slice by slice without reordering
+  template<class T> void save_simple_volume(minc_2_writer& rw,const simple_volume<T>& vol)
+  {
+    if(!is_zyx_volume(rw))
+    {
+      save_simple_volume<T,minc_2_writer>(rw,vol);
+      return;
+    }
+
+    if(typeid(T)==typeid(unsigned char))
+      rw.setup_write_byte();
+    else if(typeid(T)==typeid(short))
+      rw.setup_write_short();
+    else if(typeid(T)==typeid(unsigned short))
+      rw.setup_write_ushort();
+    else if(typeid(T)==typeid(int))
+      rw.setup_write_int();
+    else if(typeid(T)==typeid(float))
+      rw.setup_write_float();
+    else if(typeid(T)==typeid(double))
+      rw.setup_write_double();
+    else
+    {
+      save_simple_volume<T,minc_2_writer>(rw,vol);
+      return;
+    }
+    rw.write_all(const_cast<T*>(vol.c_buf()));
+  }
+
+  //! 3D volume which uses the memory mapped image of a minc file as its
+  //! data, instead of a copy on the heap
+  //! changes to the voxels are private to the process and never written back
+  template<class T> class mapped_simple_volume:public simple_volume<T>
+  {
+    protected:
+      minc_2_mapping _mapping;
+
+    public:
+      mapped_simple_volume()
+      {
+      }
+
+      //! release the mapping, the volume becomes empty
+      void unmap(void)
+      {
+        if(!_mapping.mapped())
+          return;
+        this->_vol=NULL;
+        this->_size=IDX<size_t>(0,0,0);
+        this->_count=0;
+        _mapping.unmap();
+      }
+
+      //! is the volume data mapped from the file
+      bool mapped(void) const
+      {
+        return _mapping.mapped();
+      }
+
+      //! map the image of the file opened with rw
+      //! \return false if the voxels can't be used as they are stored:
+      //!  the file is not Z Y X, not stored as T, scaled or compressed,
+      //!  or rw flips dimensions, as the mapped voxels are in file order
+      bool map(const minc_2_reader& rw)
+      {
+        mitype_t type;
+        if(typeid(T)==typeid(unsigned char))
+          type=MI_TYPE_UBYTE;
+        else if(typeid(T)==typeid(short))
+          type=MI_TYPE_SHORT;
+        else if(typeid(T)==typeid(unsigned short))
+          type=MI_TYPE_USHORT;
+        else if(typeid(T)==typeid(int))
+          type=MI_TYPE_INT;
+        else if(typeid(T)==typeid(float))
+          type=MI_TYPE_FLOAT;
+        else if(typeid(T)==typeid(double))
+          type=MI_TYPE_DOUBLE;
+        else
+          return false;
+
+        if(!is_zyx_volume(rw) || rw.flipped() || rw.datatype()!=type)
+          return false;
+
+        //integer voxels are only real values when they are not scaled
+        if(type!=MI_TYPE_FLOAT && type!=MI_TYPE_DOUBLE)
+        {
+          minc_io_lock lock;
+          miboolean_t slice_scaling;
+          double valid_max,valid_min,real_max,real_min;
+          if(miget_slice_scaling_flag(rw.handle(),&slice_scaling)<0 || slice_scaling ||
+             miget_volume_valid_range(rw.handle(),&valid_max,&valid_min)<0 ||
+             miget_volume_range(rw.handle(),&real_max,&real_min)<0 ||
+             valid_max!=real_max || valid_min!=real_min)
+            return false;
+        }
+
+        unmap();
+        if(!_mapping.map(rw,type))
+          return false;
+
+        if(reinterpret_cast<size_t>(_mapping.data())%sizeof(T))
+        {
+          _mapping.unmap();
+          return false;
+        }
+
+        if(this->_vol && this->_free_memory)
+          delete [] this->_vol;
+        this->_size=IDX<size_t>(rw.ndim(1),rw.ndim(2),rw.ndim(3));
+        this->_allocate(static_cast<T*>(_mapping.data()));
+        set_simple_volume_space(rw,*this);
+        return true;
+      }
+  };
+
+  //! open a 3D volume by mapping its image into memory,
+  //! the volume is loaded as usual if the image can't be mapped
+  //! \return true if the image was mapped
+  template<class T> bool map_simple_volume(const char *path,mapped_simple_volume<T>& vol)
+  {
+    minc_2_reader rw;
+    rw.open(path);
+    if(vol.map(rw))
+      return true;
+    vol.unmap();
+    load_simple_volume(rw,vol);
+    return false;
+  }
+}
+
+#endif //MINC_2_SIMPLE_RW_H
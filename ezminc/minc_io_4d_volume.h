@@ -13,10 +13,12 @@
               express or implied warranty.
 ---------------------------------------------------------------------------- */
 #ifndef MINC_IO_4D_VOLUME_H
+#define MINC_IO_4D_VOLUME_H
 
 #include "minc_io_simple_volume.h"
 #include <vector>
 #include <cstring>
+#include <algorithm>
 
 namespace minc
 {
@@ -166,6 +168,350 @@ namespace minc
       volume_list _volumes;
   }; 
 
+  //! zero-copy view of the time series of one voxel
+  template<class T> class series_view
+  {
+    protected:
+      T *_ptr;
+      size_t _stride;
+      size_t _len;
+    public:
+      series_view(T *ptr,size_t stride,size_t len):_ptr(ptr),_stride(stride),_len(len)
+      {
+      }
+
+      T& operator[](size_t t) const
+      {
+        return _ptr[t*_stride];
+      }
+
+      size_t size(void) const
+      {
+        return _len;
+      }
+
+      //! distance between consecutive frames, 1 if the series is contiguous
+      size_t stride(void) const
+      {
+        return _stride;
+      }
+
+      T* data(void) const
+      {
+        return _ptr;
+      }
+  };
+
+  //! zero-copy view of one frame
+  template<class T> class frame_view
+  {
+    protected:
+      T *_ptr;
+      size_t _stride[3];
+      size_t _size[3];
+    public:
+      frame_view(T *ptr,const size_t *stride,const size_t *size):_ptr(ptr)
+      {
+        for(int i=0;i<3;i++)
+        {
+          _stride[i]=stride[i];
+          _size[i]=size[i];
+        }
+      }
+
+      T& operator()(size_t x,size_t y,size_t z) const
+      {
+        return _ptr[x*_stride[0]+y*_stride[1]+z*_stride[2]];
+      }
+
+      size_t dim(int i) const
+      {
+        return _size[i];
+      }
+
+      //! distance between neighbouring voxels along x, 1 if the frame is contiguous
+      size_t stride(void) const
+      {
+        return _stride[0];
+      }
+
+      T* data(void) const
+      {
+        return _ptr;
+      }
+  };
+
+  //! 4D volume stored in one block of memory, either frame by frame
+  //! (time slowest varying, like simple_4d_volume) or voxel by voxel
+  //! (time fastest varying, each time series is contiguous)
+  template<class T> class simple_4d_series
+  {
+    public:
+      enum layout_t {FRAME_MAJOR,VOXEL_MAJOR};
+      enum {ndims=3};
+      typedef fixed_vec<ndims,double> vect;
+
+    protected:
+      std::vector<T> _data;
+      size_t _size[4];   // x y z t
+      size_t _stride[4]; // x y z t
+      layout_t _layout;
+
+      vect _start,_step;
+      vect _direction_cosines[3];
+      double _start_t,_step_t;
+
+      void _set_strides(void)
+      {
+        size_t nvox=_size[0]*_size[1]*_size[2];
+        size_t e=(_layout==VOXEL_MAJOR?_size[3]:1);
+        _stride[0]=e;
+        _stride[1]=e*_size[0];
+        _stride[2]=e*_size[0]*_size[1];
+        _stride[3]=(_layout==VOXEL_MAJOR?1:nvox);
+      }
+
+      //! dst[c][r]=src[r][c], in cache sized blocks
+      static void _transpose(const T *src,T *dst,size_t rows,size_t cols)
+      {
+        const size_t block=32;
+        for(size_t r0=0;r0<rows;r0+=block)
+        {
+          const size_t r1=std::min(r0+block,rows);
+          for(size_t c0=0;c0<cols;c0+=block)
+          {
+            const size_t c1=std::min(c0+block,cols);
+            for(size_t r=r0;r<r1;r++)
+              for(size_t c=c0;c<c1;c++)
+                dst[c*rows+r]=src[r*cols+c];
+          }
+        }
+      }
+
+      void _init(void)
+      {
+        for(int i=0;i<ndims;i++)
+        {
+          _start[i]=0.0;
+          _step[i]=1.0;
+          _direction_cosines[i]=IDX<double>(0.0,0.0,0.0);
+          _direction_cosines[i][i]=1.0;
+        }
+      }
+
+    public:
+      simple_4d_series():_layout(FRAME_MAJOR),_start_t(0.0),_step_t(0.0)
+      {
+        _init();
+        resize(0,0,0,0,FRAME_MAJOR);
+      }
+
+      simple_4d_series(size_t x,size_t y,size_t z,size_t t,layout_t l=FRAME_MAJOR):
+        _layout(l),_start_t(0.0),_step_t(0.0)
+      {
+        _init();
+        resize(x,y,z,t,l);
+      }
+
+      void resize(size_t x,size_t y,size_t z,size_t t,layout_t l)
+      {
+        _size[0]=x;_size[1]=y;_size[2]=z;_size[3]=t;
+        _layout=l;
+        _set_strides();
+        _data.resize(x*y*z*t);
+      }
+
+      void resize(size_t x,size_t y,size_t z,size_t t)
+      {
+        resize(x,y,z,t,_layout);
+      }
+
+      layout_t layout(void) const
+      {
+        return _layout;
+      }
+
+      //! change the layout, reordering the data with a blocked transpose
+      void set_layout(layout_t l)
+      {
+        if(l==_layout)
+          return;
+        const size_t nvox=_size[0]*_size[1]*_size[2];
+        std::vector<T> tmp(_data.size());
+        if(!tmp.empty())
+        {
+          if(l==VOXEL_MAJOR)
+            _transpose(&_data[0],&tmp[0],_size[3],nvox);
+          else
+            _transpose(&_data[0],&tmp[0],nvox,_size[3]);
+        }
+        _data.swap(tmp);
+        _layout=l;
+        _set_strides();
+      }
+
+      size_t dim(int i) const
+      {
+        return _size[i];
+      }
+
+      //! number of temporal frames
+      size_t frames(void) const
+      {
+        return _size[3];
+      }
+
+      //! distance between elements along x, y, z and t
+      size_t stride(int i) const
+      {
+        return _stride[i];
+      }
+
+      T* c_buf(void)
+      {
+        return _data.empty()?NULL:&_data[0];
+      }
+
+      const T* c_buf(void) const
+      {
+        return _data.empty()?NULL:&_data[0];
+      }
+
+      size_t c_buf_size(void) const
+      {
+        return _data.size();
+      }
+
+      size_t offset(size_t x,size_t y,size_t z,size_t t) const
+      {
+        return x*_stride[0]+y*_stride[1]+z*_stride[2]+t*_stride[3];
+      }
+
+      const T& get(size_t x,size_t y,size_t z,size_t t) const
+      {
+        return _data[offset(x,y,z,t)];
+      }
+
+      void set(size_t x,size_t y,size_t z,size_t t,const T& v)
+      {
+        _data[offset(x,y,z,t)]=v;
+      }
+
+      //! time series of a voxel, contiguous in VOXEL_MAJOR layout
+      series_view<T> series(size_t x,size_t y,size_t z)
+      {
+        return series_view<T>(c_buf()+offset(x,y,z,0),_stride[3],_size[3]);
+      }
+
+      series_view<const T> series(size_t x,size_t y,size_t z) const
+      {
+        return series_view<const T>(c_buf()+offset(x,y,z,0),_stride[3],_size[3]);
+      }
+
+      //! one frame, contiguous in FRAME_MAJOR layout
+      frame_view<T> frame(size_t t)
+      {
+        return frame_view<T>(c_buf()+offset(0,0,0,t),_stride,_size);
+      }
+
+      frame_view<const T> frame(size_t t) const
+      {
+        return frame_view<const T>(c_buf()+offset(0,0,0,t),_stride,_size);
+      }
+
+      //! copy from a collection of 3D volumes
+      void assign(const simple_4d_volume<T>& v,layout_t l)
+      {
+        resize(v.dim(0),v.dim(1),v.dim(2),v.frames(),l);
+        for(size_t t=0;t<_size[3];t++)
+        {
+          const T *src=v.frame(t).c_buf();
+          frame_view<T> dst=frame(t);
+          for(size_t z=0;z<_size[2];z++)
+            for(size_t y=0;y<_size[1];y++)
+              for(size_t x=0;x<_size[0];x++)
+                dst(x,y,z)=*src++;
+        }
+        _start=v.start();
+        _step=v.step();
+        for(int i=0;i<ndims;i++)
+          _direction_cosines[i]=v.direction_cosines(i);
+        _start_t=v.t_start();
+        _step_t=v.t_step();
+      }
+
+      //! copy into a collection of 3D volumes
+      void copy_to(simple_4d_volume<T>& v) const
+      {
+        v.resize(_size[0],_size[1],_size[2],_size[3]);
+        for(size_t t=0;t<_size[3];t++)
+        {
+          T *dst=v.frame(t).c_buf();
+          frame_view<const T> src=frame(t);
+          for(size_t z=0;z<_size[2];z++)
+            for(size_t y=0;y<_size[1];y++)
+              for(size_t x=0;x<_size[0];x++)
+                *dst++=src(x,y,z);
+        }
+        v.start()=_start;
+        v.step()=_step;
+        for(int i=0;i<ndims;i++)
+          v.direction_cosines(i)=_direction_cosines[i];
+        v.t_start()=_start_t;
+        v.t_step()=_step_t;
+      }
+
+      vect& start(void)
+      {
+        return _start;
+      }
+
+      const vect& start(void) const
+      {
+        return _start;
+      }
+
+      vect& step(void)
+      {
+        return _step;
+      }
+
+      const vect& step(void) const
+      {
+        return _step;
+      }
+
+      vect& direction_cosines(int i)
+      {
+        return _direction_cosines[i];
+      }
+
+      const vect& direction_cosines(int i) const
+      {
+        return _direction_cosines[i];
+      }
+
+      double & t_step(void)
+      {
+        return _step_t;
+      }
+
+      double t_step(void) const
+      {
+        return _step_t;
+      }
+
+      double & t_start(void)
+      {
+        return _start_t;
+      }
+
+      double t_start(void) const
+      {
+        return _start_t;
+      }
+  };
+
 }
 
 #endif //MINC_IO_4D_VOLUME_H
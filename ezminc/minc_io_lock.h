@@ -0,0 +1,78 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : minc_io_lock.h
+@DESCRIPTION: process-wide lock around the calls into libminc
+@COPYRIGHT  :
+              Copyright McConnell Brain Imaging Centre,
+              Montreal Neurological Institute, McGill University.
+              Permission to use, copy, modify, and distribute this
+              software and its documentation for any purpose and without
+              fee is hereby granted, provided that the above copyright
+              notice appear in all copies.  The author and McGill University
+              make no representations about the suitability of this
+              software for any purpose.  It is provided "as is" without
+              express or implied warranty.
+---------------------------------------------------------------------------- */
+#ifndef MINC_IO_LOCK_H
+#define MINC_IO_LOCK_H
+
+#ifndef WIN32
+#include <pthread.h>
+#endif
+
+namespace minc
+{
+  //! holds the process-wide libminc lock for its lifetime
+  //! libminc (its global error state, netCDF) and a HDF5 built without
+  //! thread safety can't be called from two threads at once: every
+  //! reader and writer method that calls into libminc takes this lock,
+  //! code calling libminc directly alongside background io must take it too
+  //! the lock is recursive, methods may call each other
+  class minc_io_lock
+  {
+    private:
+#ifndef WIN32
+      static void _init(void)
+      {
+        pthread_mutexattr_t attr;
+        pthread_mutexattr_init(&attr);
+        pthread_mutexattr_settype(&attr,PTHREAD_MUTEX_RECURSIVE);
+        pthread_mutex_init(_mutex(),&attr);
+        pthread_mutexattr_destroy(&attr);
+      }
+
+      //! one mutex for the whole process
+      static pthread_mutex_t* _mutex(void)
+      {
+        static pthread_mutex_t mutex;
+        return &mutex;
+      }
+
+      static pthread_mutex_t* _get(void)
+      {
+        static pthread_once_t once=PTHREAD_ONCE_INIT;
+        pthread_once(&once,_init);
+        return _mutex();
+      }
+#endif
+
+      minc_io_lock(const minc_io_lock&);
+      minc_io_lock& operator=(const minc_io_lock&);
+
+    public:
+      minc_io_lock()
+      {
+#ifndef WIN32
+        pthread_mutex_lock(_get());
+#endif
+      }
+
+      ~minc_io_lock()
+      {
+#ifndef WIN32
+        pthread_mutex_unlock(_get());
+#endif
+      }
+  };
+}//minc
+
+#endif //MINC_IO_LOCK_H
@@ -0,0 +1,413 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : minc_io_prefetch.h
+@DESCRIPTION: minc iterators which overlap file io with computation
+@COPYRIGHT  :
+              Copyright McConnell Brain Imaging Centre,
+              Montreal Neurological Institute, McGill University.
+              Permission to use, copy, modify, and distribute this
+              software and its documentation for any purpose and without
+              fee is hereby granted, provided that the above copyright
+              notice appear in all copies.  The author and McGill University
+              make no representations about the suitability of this
+              software for any purpose.  It is provided "as is" without
+              express or implied warranty.
+---------------------------------------------------------------------------- */
+#ifndef MINC_IO_PREFETCH_H
+#define MINC_IO_PREFETCH_H
+
+#include <vector>
+#ifndef WIN32
+#include <pthread.h>
+#endif
+
+#include "minc_1_simple.h"
+
+namespace minc
+{
+  //! runs one job on a background thread, at most one job at a time
+  //! the file handle is only ever used by one thread: the caller must
+  //! not touch the reader or writer between start() and wait()
+  //! other readers and writers may be used meanwhile, their calls into
+  //! libminc are serialized with the job's by minc_io_lock, code calling
+  //! libminc directly must hold a minc_io_lock while a job is in flight
+  class minc_io_job
+  {
+    protected:
+#ifndef WIN32
+      pthread_t _thread;
+#endif
+      bool _pending;
+      bool _failed;
+      generic_error _error;
+
+      //! the job itself
+      virtual void run(void)=0;
+
+      static void* _run(void *job)
+      {
+        minc_io_job *self=static_cast<minc_io_job*>(job);
+        try
+        {
+          self->run();
+        } catch(const generic_error& err) {
+          self->_error=err;
+          self->_failed=true;
+        } catch(...) {
+          //nothing may escape the thread, keep it for wait()
+          self->_error=generic_error(__FILE__,__LINE__,"Unexpected error in background minc io");
+          self->_failed=true;
+        }
+        return NULL;
+      }
+
+    private:
+      minc_io_job(const minc_io_job&);
+      minc_io_job& operator=(const minc_io_job&);
+
+    public:
+      minc_io_job():_pending(false),_failed(false),_error(__FILE__,__LINE__)
+      {
+      }
+
+      virtual ~minc_io_job()
+      {
+      }
+
+      //! start the job, runs it in place if no thread could be created
+      void start(void)
+      {
+        _failed=false;
+#ifndef WIN32
+        if(!pthread_create(&_thread,NULL,_run,this))
+        {
+          _pending=true;
+          return;
+        }
+#endif
+        _run(this);
+      }
+
+      //! wait for the job to finish, without reporting errors
+      void join(void)
+      {
+#ifndef WIN32
+        if(_pending)
+          pthread_join(_thread,NULL);
+#endif
+        _pending=false;
+      }
+
+      //! wait for the job to finish, rethrow the error it reported
+      void wait(void)
+      {
+        join();
+        if(_failed)
+        {
+          _failed=false;
+          throw _error;
+        }
+      }
+  };
+
+  //! input iterator which reads the next slice on a background thread,
+  //! while the current one is being processed
+  //! same interface as minc_input_iterator
+  template <class T,class R=minc_1_reader> class minc_prefetch_input_iterator:
+    protected minc_io_job
+  {
+    protected:
+      mutable R* _rw;
+      std::vector<T> _buf;
+      std::vector<T> _next_buf;
+      std::vector<long> _cur;
+      std::vector<long> _next_cur;
+      bool _last;
+      bool _next_last;
+      size_t _count;
+      //! shape of the volume, next() runs concurrently with the job
+      //! and must not ask the reader
+      int _dim_no;
+      int _slice_dims;
+      std::vector<long> _len;
+
+      //! advance the reader and read the following slice
+      virtual void run(void)
+      {
+        if(!_rw->next_slice())
+        {
+          _next_last=true;
+          return;
+        }
+        _rw->read(&_next_buf[0]);
+        _next_cur=_rw->current_slice();
+      }
+
+      void _prefetch(void)
+      {
+        //single slice volume, nothing to read ahead
+        if(_slice_dims>=_dim_no)
+          return;
+        _next_last=false;
+        start();
+      }
+
+    private:
+      //! iterator owns a background job, can't be copied
+      minc_prefetch_input_iterator(const minc_prefetch_input_iterator<T,R>& a);
+
+    public:
+
+    const std::vector<long>& cur(void) const
+    {
+      return _cur;
+    }
+
+    minc_prefetch_input_iterator(R& rw):_rw(&rw),_last(false),_next_last(false),_count(0),
+      _dim_no(0),_slice_dims(0)
+    {
+    }
+
+    minc_prefetch_input_iterator():_rw(NULL),_last(false),_next_last(false),_count(0),
+      _dim_no(0),_slice_dims(0)
+    {
+    }
+
+    ~minc_prefetch_input_iterator()
+    {
+      join();
+    }
+
+    void attach(R& rw)
+    {
+      join();
+      _rw=&rw;
+      _last=false;
+      _count=0;
+    }
+
+    bool next(void)
+    {
+      if(_last) return false;
+      _count++;
+      for(int i=_dim_no-1;i>(_dim_no-_slice_dims-1);i--)
+      {
+        _cur[i]++;
+        if(_cur[i]<_len[i])
+          break;
+        if(i>(_dim_no-_slice_dims))
+          _cur[i]=0;
+        else
+        {
+          //move to next slice
+          if(i==0) // the case when slice_dimensions==dim_no
+          {
+            _last=true;
+            _count=0;
+            break;
+          }
+          wait();
+          if(_next_last)
+          {
+            _last=true;
+            break;
+          }
+          _buf.swap(_next_buf);
+          _cur=_next_cur;
+          _count=0;
+          _prefetch();
+          break;
+        }
+      }
+      return !_last;
+    }
+
+    bool last(void)
+    {
+      return _last;
+    }
+
+    void begin(void)
+    {
+      join();
+      _cur.resize(MAX_VAR_DIMS,0);
+      _buf.resize(_rw->slice_len());
+      _next_buf.resize(_rw->slice_len());
+      _count=0;
+      _last=false;
+      _dim_no=_rw->dim_no();
+      _slice_dims=_rw->slice_dimensions();
+      _len.resize(_dim_no);
+      for(int i=0;i<_dim_no;i++)
+        _len[i]=static_cast<long>(_rw->dim(i).length);
+      _rw->begin();
+      _rw->read(&_buf[0]);
+      _cur=_rw->current_slice();
+      _prefetch();
+    }
+
+    const T& value(void) const
+    {
+      return _buf[_count];
+    }
+  };
+
+  //! output iterator which writes the finished slice on a background
+  //! thread, while the next one is being filled
+  //! same interface as minc_output_iterator
+  template <class T,class W=minc_1_writer> class minc_write_behind_output_iterator:
+    protected minc_io_job
+  {
+    protected:
+      mutable W* _rw;
+      std::vector<T> _buf;
+      std::vector<T> _write_buf;
+      std::vector<long> _cur;
+      bool _last;
+      size_t _count;
+      //! shape of the volume, next() runs concurrently with the job
+      //! and must not ask the writer
+      int _dim_no;
+      int _slice_dims;
+      std::vector<long> _len;
+
+      //! write the finished slice and advance the writer
+      virtual void run(void)
+      {
+        _rw->write(&_write_buf[0]);
+        _rw->next_slice();
+      }
+
+    private:
+      //! iterator owns a background job, can't be copied
+      minc_write_behind_output_iterator(const minc_write_behind_output_iterator<T,W>& a);
+
+    public:
+    const std::vector<long>& cur(void) const
+    {
+      return _cur;
+    }
+
+    minc_write_behind_output_iterator(W& rw):_rw(&rw),_last(false),_count(0),
+      _dim_no(0),_slice_dims(0)
+    {
+      _buf.resize(rw.slice_len());
+    }
+
+    minc_write_behind_output_iterator():_rw(NULL),_last(false),_count(0),
+      _dim_no(0),_slice_dims(0)
+    {
+    }
+
+    void attach(W& rw)
+    {
+      join();
+      _rw=&rw;
+      _last=false;
+      _count=0;
+    }
+
+    //! errors of the pending write are lost here, call finish() to see them
+    ~minc_write_behind_output_iterator()
+    {
+      join();
+      try
+      {
+        if(_count && !_last)
+          _rw->write(&_buf[0]);
+      } catch(...) {
+      }
+    }
+
+    //! wait until all finished slices are written
+    void flush(void)
+    {
+      wait();
+    }
+
+    //! write out everything, including a partly filled slice,
+    //! rethrow the error of any write still pending
+    void finish(void)
+    {
+      wait();
+      if(_count && !_last)
+        _rw->write(&_buf[0]);
+      _count=0;
+      _last=true;
+    }
+
+    bool next(void)
+    {
+      if(_last) return false;
+      _count++;
+      for(int i=_dim_no-1;i>(_dim_no-_slice_dims-1);i--)
+      {
+        _cur[i]++;
+        if(_cur[i]<_len[i])
+          break;
+        if(i>(_dim_no-_slice_dims))
+          _cur[i]=0;
+        else
+        {
+          _count=0;
+          _cur[i]=0;
+          if(i==0) // the case when slice_dimensions==dim_no
+          {
+            _rw->write(&_buf[0]);
+            _last=true;
+            return false;
+          }
+          //hand the slice over to the background writer
+          wait();
+          _buf.swap(_write_buf);
+          start();
+
+          //the writer's position is advanced by the job, follow it here
+          int j;
+          for(j=_dim_no-_slice_dims-1;j>=0;j--)
+          {
+            _cur[j]++;
+            if(_cur[j]<_len[j])
+              break;
+            _cur[j]=0;
+          }
+          if(j<0)
+          {
+            _last=true;
+            wait();
+          }
+          break;
+        }
+      }
+      return !_last;
+    }
+
+    bool last(void)
+    {
+      return _last;
+    }
+
+    void begin(void)
+    {
+      join();
+      _buf.resize(_rw->slice_len());
+      _write_buf.resize(_rw->slice_len());
+      _cur.resize(MAX_VAR_DIMS,0);
+      _count=0;
+      _last=false;
+      _dim_no=_rw->dim_no();
+      _slice_dims=_rw->slice_dimensions();
+      _len.resize(_dim_no);
+      for(int i=0;i<_dim_no;i++)
+        _len[i]=static_cast<long>(_rw->dim(i).length);
+      _rw->begin();
+      _cur=_rw->current_slice();
+    }
+
+    void value(const T& v)
+    {
+      _buf[_count]=v;
+    }
+  };
+}//minc
+
+#endif //MINC_IO_PREFETCH_H
@@ -0,0 +1,557 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : minc_io_resample.h
+@DESCRIPTION: resampling of simple_volume through affine and grid transforms
+@COPYRIGHT  :
+              Copyright McConnell Brain Imaging Centre,
+              Montreal Neurological Institute, McGill University.
+              Permission to use, copy, modify, and distribute this
+              software and its documentation for any purpose and without
+              fee is hereby granted, provided that the above copyright
+              notice appear in all copies.  The author and McGill University
+              make no representations about the suitability of this
+              software for any purpose.  It is provided "as is" without
+              express or implied warranty.
+---------------------------------------------------------------------------- */
+#ifndef MINC_IO_RESAMPLE_H
+#define MINC_IO_RESAMPLE_H
+
+#include <vector>
+#include <limits>
+#include <math.h>
+
+#include "minc_io_simple_volume.h"
+
+namespace minc
+{
+  //! affine transform between world coordinates: x'=M x + b,
+  //! the last column of m is b
+  class affine_transform
+  {
+    public:
+      double m[3][4];
+
+      //! identity transform
+      affine_transform()
+      {
+        for(int i=0;i<3;i++)
+          for(int j=0;j<4;j++)
+            m[i][j]=(i==j?1.0:0.0);
+      }
+
+      //! translation only
+      static affine_transform translation(double x,double y,double z)
+      {
+        affine_transform t;
+        t.m[0][3]=x;
+        t.m[1][3]=y;
+        t.m[2][3]=z;
+        return t;
+      }
+
+      fixed_vec<3,double> apply(const fixed_vec<3,double>& p) const
+      {
+        fixed_vec<3,double> r;
+        for(int i=0;i<3;i++)
+          r[i]=m[i][0]*p[0]+m[i][1]*p[1]+m[i][2]*p[2]+m[i][3];
+        return r;
+      }
+
+      //! composition, (a*b) applies b first
+      friend affine_transform operator*(const affine_transform& a,const affine_transform& b)
+      {
+        affine_transform r;
+        for(int i=0;i<3;i++)
+        {
+          for(int j=0;j<4;j++)
+            r.m[i][j]=a.m[i][0]*b.m[0][j]+a.m[i][1]*b.m[1][j]+a.m[i][2]*b.m[2][j];
+          r.m[i][3]+=a.m[i][3];
+        }
+        return r;
+      }
+
+      //! voxel to world transform of the volume, same as simple_volume::voxel_to_world
+      template<class T> static affine_transform voxel_to_world(const simple_volume<T>& v)
+      {
+        affine_transform t;
+        for(int i=0;i<3;i++)
+        {
+          t.m[i][3]=0.0;
+          for(int j=0;j<3;j++)
+          {
+            t.m[i][j]=v.step()[j]*v.direction_cosines(j)[i];
+            t.m[i][3]+=v.start()[j]*v.direction_cosines(j)[i];
+          }
+        }
+        return t;
+      }
+
+      //! world to voxel transform of the volume, same as simple_volume::world_to_voxel_c
+      template<class T> static affine_transform world_to_voxel(const simple_volume<T>& v)
+      {
+        affine_transform t;
+        for(int i=0;i<3;i++)
+        {
+          t.m[i][3]=0.0;
+          for(int j=0;j<3;j++)
+          {
+            t.m[i][j]=v.direction_cosines(i)[j]/v.step()[j];
+            t.m[i][3]-=v.start()[j]/v.step()[j]*v.direction_cosines(i)[j];
+          }
+        }
+        return t;
+      }
+  };
+
+  //! convert an interpolated value into the voxel type, rounding integer types
+  //! and clamping them to their range, cubic interpolation overshoots at edges
+  template<class T> inline T resample_cast(double v)
+  {
+    if(std::numeric_limits<T>::is_integer)
+    {
+      v=floor(v+0.5);
+      if(v<=static_cast<double>(std::numeric_limits<T>::min()))
+        return std::numeric_limits<T>::min();
+      if(v>=static_cast<double>(std::numeric_limits<T>::max()))
+        return std::numeric_limits<T>::max();
+      return static_cast<T>(v);
+    }
+    return static_cast<T>(v);
+  }
+
+  //! resampling kernels sample the source volume at continuous voxel
+  //! coordinates, which are already clamped into [0,dim-1]
+  //! margin() tells how far outside of that range a point still gets a value
+  //! line() samples a row running along the x axis of the source, where y
+  //! and z don't change, it returns false if the kernel has no such shortcut
+  //! kernels are meant for scalar voxel types
+  struct resample_kernel_base
+  {
+    template<class T> static bool line(const simple_volume<T>& /*v*/,float /*fy*/,float /*fz*/,
+                                       const float * /*x*/,size_t /*n*/,T * /*out*/,std::vector<float>& /*tmp*/)
+    {
+      return false;
+    }
+  };
+
+  //! nearest neighbour
+  struct nearest_kernel:public resample_kernel_base
+  {
+    static float margin(void)
+    {
+      return 0.5f;
+    }
+
+    template<class T> static T sample(const simple_volume<T>& v,float fx,float fy,float fz)
+    {
+      return v.get(static_cast<size_t>(static_cast<long>(fx+0.5f)),
+                   static_cast<size_t>(static_cast<long>(fy+0.5f)),
+                   static_cast<size_t>(static_cast<long>(fz+0.5f)));
+    }
+
+    template<class T> static bool line(const simple_volume<T>& v,float fy,float fz,
+                                       const float *x,size_t n,T *out,std::vector<float>& /*tmp*/)
+    {
+      const T *r=&v.get(static_cast<size_t>(0),
+                        static_cast<size_t>(static_cast<long>(fy+0.5f)),
+                        static_cast<size_t>(static_cast<long>(fz+0.5f)));
+      for(size_t i=0;i<n;i++)
+        out[i]=r[static_cast<long>(x[i]+0.5f)];
+      return true;
+    }
+  };
+
+  //! trilinear interpolation
+  struct trilinear_kernel:public resample_kernel_base
+  {
+    static float margin(void)
+    {
+      return 0.0f;
+    }
+
+    template<class T> static T sample(const simple_volume<T>& v,float fx,float fy,float fz)
+    {
+      const size_t sy=v.dim(0),sz=v.dim(0)*v.dim(1);
+      const size_t ix=static_cast<long>(fx);
+      const size_t iy=static_cast<long>(fy);
+      const size_t iz=static_cast<long>(fz);
+      const float dx=fx-ix,dy=fy-iy,dz=fz-iz;
+
+      //neighbours past the last voxel have zero weight, don't read them
+      const size_t ox=(ix+1<v.dim(0)?1:0);
+      const size_t oy=(iy+1<v.dim(1)?sy:0);
+      const size_t oz=(iz+1<v.dim(2)?sz:0);
+
+      const T *p=v.c_buf()+ix+iy*sy+iz*sz;
+      const float c00=p[0]      *(1.0f-dx)+p[ox]      *dx;
+      const float c10=p[oy]     *(1.0f-dx)+p[oy+ox]   *dx;
+      const float c01=p[oz]     *(1.0f-dx)+p[oz+ox]   *dx;
+      const float c11=p[oz+oy]  *(1.0f-dx)+p[oz+oy+ox]*dx;
+
+      const float c0=c00*(1.0f-dy)+c10*dy;
+      const float c1=c01*(1.0f-dy)+c11*dy;
+
+      return resample_cast<T>(c0*(1.0f-dz)+c1*dz);
+    }
+
+    //! blend the four source rows around (y,z) into one, then interpolate along it
+    template<class T> static bool line(const simple_volume<T>& v,float fy,float fz,
+                                       const float *x,size_t n,T *out,std::vector<float>& tmp)
+    {
+      const size_t nx=v.dim(0),sy=v.dim(0),sz=v.dim(0)*v.dim(1);
+      const size_t iy=static_cast<long>(fy);
+      const size_t iz=static_cast<long>(fz);
+      const float dy=fy-iy,dz=fz-iz;
+      const size_t oy=(iy+1<v.dim(1)?sy:0);
+      const size_t oz=(iz+1<v.dim(2)?sz:0);
+      const T *r00=v.c_buf()+iy*sy+iz*sz;
+      const T *r10=r00+oy,*r01=r00+oz,*r11=r00+oy+oz;
+      const float w00=(1.0f-dy)*(1.0f-dz),w10=dy*(1.0f-dz),w01=(1.0f-dy)*dz,w11=dy*dz;
+
+      //one extra element, so the last voxel has a right neighbour
+      tmp.resize(nx+1);
+      float *l=&tmp[0];
+      for(size_t k=0;k<nx;k++)
+        l[k]=w00*r00[k]+w10*r10[k]+w01*r01[k]+w11*r11[k];
+      l[nx]=l[nx-1];
+
+      for(size_t i=0;i<n;i++)
+      {
+        const long ix=static_cast<long>(x[i]);
+        const float dx=x[i]-ix;
+        out[i]=resample_cast<T>(l[ix]*(1.0f-dx)+l[ix+1]*dx);
+      }
+      return true;
+    }
+  };
+
+  //! tricubic (Catmull-Rom) interpolation, neighbours are clamped to the volume
+  struct cubic_kernel:public resample_kernel_base
+  {
+    static float margin(void)
+    {
+      return 0.0f;
+    }
+
+    static void taps(float f,size_t len,size_t stride,size_t *o,float *w)
+    {
+      const long i=static_cast<long>(f);
+      const float t=f-i,t2=t*t,t3=t2*t;
+      w[0]=0.5f*(-t3+2.0f*t2-t);
+      w[1]=0.5f*(3.0f*t3-5.0f*t2+2.0f);
+      w[2]=0.5f*(-3.0f*t3+4.0f*t2+t);
+      w[3]=0.5f*(t3-t2);
+      for(int k=0;k<4;k++)
+      {
+        long j=i+k-1;
+        if(j<0) j=0;
+        if(j>=static_cast<long>(len)) j=len-1;
+        o[k]=j*stride;
+      }
+    }
+
+    template<class T> static T sample(const simple_volume<T>& v,float fx,float fy,float fz)
+    {
+      size_t ox[4],oy[4],oz[4];
+      float wx[4],wy[4],wz[4];
+      taps(fx,v.dim(0),1,ox,wx);
+      taps(fy,v.dim(1),v.dim(0),oy,wy);
+      taps(fz,v.dim(2),v.dim(0)*v.dim(1),oz,wz);
+
+      float r=0.0f;
+      for(int c=0;c<4;c++)
+      {
+        float rc=0.0f;
+        for(int b=0;b<4;b++)
+        {
+          const T *p=v.c_buf()+oz[c]+oy[b];
+          rc+=wy[b]*(wx[0]*p[ox[0]]+wx[1]*p[ox[1]]+wx[2]*p[ox[2]]+wx[3]*p[ox[3]]);
+        }
+        r+=wz[c]*rc;
+      }
+      return resample_cast<T>(r);
+    }
+
+    //! blend the sixteen source rows around (y,z) into one, then interpolate along it
+    template<class T> static bool line(const simple_volume<T>& v,float fy,float fz,
+                                       const float *x,size_t n,T *out,std::vector<float>& tmp)
+    {
+      const size_t nx=v.dim(0);
+      size_t oy[4],oz[4];
+      float wy[4],wz[4];
+      taps(fy,v.dim(1),v.dim(0),oy,wy);
+      taps(fz,v.dim(2),v.dim(0)*v.dim(1),oz,wz);
+
+      //padded with edge values: one element before and two after the row
+      tmp.assign(nx+3,0.0f);
+      float *l=&tmp[1];
+      for(int c=0;c<4;c++)
+        for(int b=0;b<4;b++)
+        {
+          const T *r=v.c_buf()+oz[c]+oy[b];
+          const float w=wy[b]*wz[c];
+          for(size_t k=0;k<nx;k++)
+            l[k]+=w*r[k];
+        }
+      l[-1]=l[0];
+      l[nx]=l[nx+1]=l[nx-1];
+
+      for(size_t i=0;i<n;i++)
+      {
+        const long ix=static_cast<long>(x[i]);
+        const float t=x[i]-ix,t2=t*t,t3=t2*t;
+        const float *p=l+ix;
+        out[i]=resample_cast<T>(0.5f*((-t3+2.0f*t2-t)*p[-1]+(3.0f*t3-5.0f*t2+2.0f)*p[0]+
+                                      (-3.0f*t3+4.0f*t2+t)*p[1]+(t3-t2)*p[2]));
+      }
+      return true;
+    }
+  };
+
+  //! label resampling: the label with the largest total trilinear weight
+  //! among the eight neighbours wins
+  struct label_majority_kernel:public resample_kernel_base
+  {
+    static float margin(void)
+    {
+      return 0.0f;
+    }
+
+    template<class T> static T sample(const simple_volume<T>& v,float fx,float fy,float fz)
+    {
+      const size_t sy=v.dim(0),sz=v.dim(0)*v.dim(1);
+      const size_t ix=static_cast<long>(fx);
+      const size_t iy=static_cast<long>(fy);
+      const size_t iz=static_cast<long>(fz);
+      const float dx=fx-ix,dy=fy-iy,dz=fz-iz;
+      const size_t ox=(ix+1<v.dim(0)?1:0);
+      const size_t oy=(iy+1<v.dim(1)?sy:0);
+      const size_t oz=(iz+1<v.dim(2)?sz:0);
+      const T *p=v.c_buf()+ix+iy*sy+iz*sz;
+
+      const size_t off[8]={0,ox,oy,oy+ox,oz,oz+ox,oz+oy,oz+oy+ox};
+      const float w[8]={(1.0f-dx)*(1.0f-dy)*(1.0f-dz),dx*(1.0f-dy)*(1.0f-dz),
+                        (1.0f-dx)*dy*(1.0f-dz),       dx*dy*(1.0f-dz),
+                        (1.0f-dx)*(1.0f-dy)*dz,       dx*(1.0f-dy)*dz,
+                        (1.0f-dx)*dy*dz,              dx*dy*dz};
+      T labels[8];
+      float score[8];
+      int cnt=0,best=0;
+      for(int k=0;k<8;k++)
+      {
+        const T l=p[off[k]];
+        int j=0;
+        while(j<cnt && labels[j]!=l) j++;
+        if(j==cnt)
+        {
+          labels[cnt]=l;
+          score[cnt++]=0.0f;
+        }
+        score[j]+=w[k];
+        if(score[j]>score[best]) best=j;
+      }
+      return labels[best];
+    }
+  };
+
+  //! limits of the voxel coordinates which get a value from kernel K,
+  //! allowing for rounding errors of the transform
+  template<class K,class T> struct resample_limits
+  {
+    float lo,hi[3];
+
+    resample_limits(const simple_volume<T>& v)
+    {
+      lo=-K::margin()-1e-4f;
+      for(int i=0;i<3;i++)
+        hi[i]=v.dim(i)-1.0f-lo;
+    }
+
+    bool inside(float x,float y,float z) const
+    {
+      return x>=lo && x<=hi[0] && y>=lo && y<=hi[1] && z>=lo && z<=hi[2];
+    }
+  };
+
+  inline float resample_clamp(float f,float m)
+  {
+    return f<0.0f?0.0f:(f>m?m:f);
+  }
+
+  //! sample one row of output voxels, x,y,z are the continuous voxel
+  //! coordinates in the source, points outside of it get the fill value
+  template<class K,class T> void resample_row(const simple_volume<T>& v,
+                                              const float *x,const float *y,const float *z,
+                                              size_t n,T *out,const T& fill)
+  {
+    const resample_limits<K,T> lim(v);
+    const float mx=v.dim(0)-1.0f,my=v.dim(1)-1.0f,mz=v.dim(2)-1.0f;
+    for(size_t i=0;i<n;i++)
+    {
+      if(!lim.inside(x[i],y[i],z[i]))
+        out[i]=fill;
+      else
+        out[i]=K::sample(v,resample_clamp(x[i],mx),resample_clamp(y[i],my),resample_clamp(z[i],mz));
+    }
+  }
+
+  //! sample one row whose coordinates change linearly along the row:
+  //! the points inside of the source are then contiguous, and are
+  //! sampled without checking every voxel
+  //! along_x tells that only x changes along the row
+  template<class K,class T> void resample_linear_row(const simple_volume<T>& v,
+                                                     float *x,const float *y,const float *z,
+                                                     size_t n,T *out,const T& fill,
+                                                     bool along_x,std::vector<float>& tmp)
+  {
+    const resample_limits<K,T> lim(v);
+    const float mx=v.dim(0)-1.0f,my=v.dim(1)-1.0f,mz=v.dim(2)-1.0f;
+    size_t i0=0,i1=n;
+    while(i0<i1 && !lim.inside(x[i0],y[i0],z[i0]))
+      out[i0++]=fill;
+    while(i1>i0 && !lim.inside(x[i1-1],y[i1-1],z[i1-1]))
+      out[--i1]=fill;
+    if(i0==i1)
+      return;
+
+    if(along_x)
+    {
+      for(size_t i=i0;i<i1;i++)
+        x[i]=resample_clamp(x[i],mx);
+      if(K::line(v,resample_clamp(y[i0],my),resample_clamp(z[i0],mz),x+i0,i1-i0,out+i0,tmp))
+        return;
+    }
+    for(size_t i=i0;i<i1;i++)
+      out[i]=K::sample(v,resample_clamp(x[i],mx),resample_clamp(y[i],my),resample_clamp(z[i],mz));
+  }
+
+  //! per-thread row buffers
+  struct _resample_rows
+  {
+    std::vector<float> x,y,z;
+
+    _resample_rows(size_t n):x(n),y(n),z(n)
+    {
+    }
+
+    //! coordinates of a row, affine along the row
+    void fill(const affine_transform& t,double vy,double vz)
+    {
+      const size_t n=x.size();
+      const float bx=t.m[0][1]*vy+t.m[0][2]*vz+t.m[0][3];
+      const float by=t.m[1][1]*vy+t.m[1][2]*vz+t.m[1][3];
+      const float bz=t.m[2][1]*vy+t.m[2][2]*vz+t.m[2][3];
+      const float dx=t.m[0][0],dy=t.m[1][0],dz=t.m[2][0];
+      float *px=&x[0],*py=&y[0],*pz=&z[0];
+      for(size_t i=0;i<n;i++)
+      {
+        px[i]=bx+dx*i;
+        py[i]=by+dy*i;
+        pz[i]=bz+dz*i;
+      }
+    }
+  };
+
+  //! resample src into the sampling grid of dst (its size, start, step and
+  //! direction cosines), xfm maps world coordinates of dst into those of src
+  //! output slices are processed in parallel when OpenMP is enabled
+  template<class K,class T> void resample_volume(const simple_volume<T>& src,simple_volume<T>& dst,
+                                                 const affine_transform& xfm,const T& fill=T())
+  {
+    if(src.empty() || dst.empty())
+      REPORT_ERROR("Empty volume");
+
+    //from output voxel straight to input voxel
+    const affine_transform t=affine_transform::world_to_voxel(src)*xfm*affine_transform::voxel_to_world(dst);
+    const long nz=dst.dim(2);
+    const size_t ny=dst.dim(1),nx=dst.dim(0);
+
+    //rows of dst run along the x axis of src: y and z stay the same
+    const bool along_x=fabs(t.m[1][0]*nx)<1e-6 && fabs(t.m[2][0]*nx)<1e-6;
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(long z=0;z<nz;z++)
+    {
+      _resample_rows rows(nx);
+      std::vector<float> tmp;
+      for(size_t y=0;y<ny;y++)
+      {
+        rows.fill(t,static_cast<double>(y),static_cast<double>(z));
+        resample_linear_row<K>(src,&rows.x[0],&rows.y[0],&rows.z[0],nx,dst.c_buf()+(z*ny+y)*nx,fill,along_x,tmp);
+      }
+    }
+  }
+
+  //! resample src through a displacement grid followed by an affine transform:
+  //! a point p in the world coordinates of dst is mapped to xfm(p+grid(p))
+  //! the grid is interpolated linearly, displacement is zero outside of it
+  template<class K,class T> void resample_volume(const simple_volume<T>& src,simple_volume<T>& dst,
+                                                 const affine_transform& xfm,const minc_grid_volume& grid,
+                                                 const T& fill=T())
+  {
+    if(src.empty() || dst.empty() || grid.empty())
+      REPORT_ERROR("Empty volume");
+
+    const affine_transform to_world=affine_transform::voxel_to_world(dst);
+    const affine_transform to_grid=affine_transform::world_to_voxel(grid)*to_world;
+    const affine_transform to_src=affine_transform::world_to_voxel(src)*xfm;
+    const long nz=dst.dim(2);
+    const size_t ny=dst.dim(1),nx=dst.dim(0);
+
+    const resample_limits<trilinear_kernel,fixed_vec<3,float> > glim(grid);
+    const float gmx=grid.dim(0)-1.0f,gmy=grid.dim(1)-1.0f,gmz=grid.dim(2)-1.0f;
+    const size_t gsy=grid.dim(0),gsz=grid.dim(0)*grid.dim(1);
+    const fixed_vec<3,float> *gbuf=grid.c_buf();
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(long z=0;z<nz;z++)
+    {
+      _resample_rows world(nx),g(nx),rows(nx);
+      for(size_t y=0;y<ny;y++)
+      {
+        world.fill(to_world,static_cast<double>(y),static_cast<double>(z));
+        g.fill(to_grid,static_cast<double>(y),static_cast<double>(z));
+
+        //add the displacement
+        for(size_t i=0;i<nx;i++)
+        {
+          if(!glim.inside(g.x[i],g.y[i],g.z[i]))
+            continue;
+          const float fx=resample_clamp(g.x[i],gmx),fy=resample_clamp(g.y[i],gmy),fz=resample_clamp(g.z[i],gmz);
+          const size_t ix=static_cast<long>(fx);
+          const size_t iy=static_cast<long>(fy);
+          const size_t iz=static_cast<long>(fz);
+          const float dx=fx-ix,dy=fy-iy,dz=fz-iz;
+          const size_t ox=(fx<gmx?1:0);
+          const size_t oy=(fy<gmy?gsy:0);
+          const size_t oz=(fz<gmz?gsz:0);
+          const fixed_vec<3,float> *p=gbuf+ix+iy*gsy+iz*gsz;
+          float *d[3]={&world.x[i],&world.y[i],&world.z[i]};
+          for(int c=0;c<3;c++)
+          {
+            const float c0=(p[0][c]*(1.0f-dx)+p[ox][c]*dx)*(1.0f-dy)+
+                           (p[oy][c]*(1.0f-dx)+p[oy+ox][c]*dx)*dy;
+            const float c1=(p[oz][c]*(1.0f-dx)+p[oz+ox][c]*dx)*(1.0f-dy)+
+                           (p[oz+oy][c]*(1.0f-dx)+p[oz+oy+ox][c]*dx)*dy;
+            *d[c]+=c0*(1.0f-dz)+c1*dz;
+          }
+        }
+
+        //into source voxel coordinates
+        for(size_t i=0;i<nx;i++)
+        {
+          const double wx=world.x[i],wy=world.y[i],wz=world.z[i];
+          rows.x[i]=to_src.m[0][0]*wx+to_src.m[0][1]*wy+to_src.m[0][2]*wz+to_src.m[0][3];
+          rows.y[i]=to_src.m[1][0]*wx+to_src.m[1][1]*wy+to_src.m[1][2]*wz+to_src.m[1][3];
+          rows.z[i]=to_src.m[2][0]*wx+to_src.m[2][1]*wy+to_src.m[2][2]*wz+to_src.m[2][3];
+        }
+        resample_row<K>(src,&rows.x[0],&rows.y[0],&rows.z[0],nx,dst.c_buf()+(z*ny+y)*nx,fill);
+      }
+    }
+  }
+}//minc
+
+#endif //MINC_IO_RESAMPLE_H
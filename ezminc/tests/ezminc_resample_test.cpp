@@ -0,0 +1,179 @@
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : ezminc_resample_test.cpp
+@DESCRIPTION: test of simple_volume resampling through affine and grid transforms
+@COPYRIGHT  :
+              Copyright McConnell Brain Imaging Centre,
+              Montreal Neurological Institute, McGill University.
+              Permission to use, copy, modify, and distribute this
+              software and its documentation for any purpose and without
+              fee is hereby granted, provided that the above copyright
+              notice appear in all copies.  The author and McGill University
+              make no representations about the suitability of this
+              software for any purpose.  It is provided "as is" without
+              express or implied warranty.
+---------------------------------------------------------------------------- */
+#include <iostream>
+#include <math.h>
+
+#include "minc_io_resample.h"
+
+using namespace minc;
+
+//! linear function of the world coordinates, reproduced exactly by
+//! trilinear and cubic interpolation
+static float ramp(double x,double y,double z)
+{
+  return static_cast<float>(x+2.0*y+3.0*z);
+}
+
+static void make_ramp(simple_volume<float>& v)
+{
+  for(size_t k=0;k<v.dim(2);k++)
+    for(size_t j=0;j<v.dim(1);j++)
+      for(size_t i=0;i<v.dim(0);i++)
+      {
+        simple_volume<float>::vect w=v.voxel_to_world(IDX<size_t>(i,j,k));
+        v.set(i,j,k,ramp(w[0],w[1],w[2]));
+      }
+}
+
+//! compare with the ramp shifted by (sx,sy,sz), skipping the fill value
+static void check_shift(const simple_volume<float>& dst,
+                        double sx,double sy,double sz,const char *name)
+{
+  const float fill=-1000.0f;
+  size_t cnt=0;
+  for(size_t k=0;k<dst.dim(2);k++)
+    for(size_t j=0;j<dst.dim(1);j++)
+      for(size_t i=0;i<dst.dim(0);i++)
+      {
+        if(dst.get(i,j,k)==fill) continue;
+        simple_volume<float>::vect w=dst.voxel_to_world(IDX<size_t>(i,j,k));
+        if(fabs(dst.get(i,j,k)-ramp(w[0]+sx,w[1]+sy,w[2]+sz))>1e-3)
+        {
+          std::cerr<<name<<" @ "<<i<<","<<j<<","<<k<<" expected:"<<ramp(w[0]+sx,w[1]+sy,w[2]+sz)
+                   <<" got:"<<dst.get(i,j,k)<<std::endl;
+          REPORT_ERROR("Resampled data mismatched");
+        }
+        cnt++;
+      }
+  if(cnt<dst.c_buf_size()/2)
+    REPORT_ERROR("Too many voxels outside of the source");
+}
+
+int main(void)
+{
+  try
+  {
+    simple_volume<float> src(20,21,22);
+    src.step()=IDX<double>(1.0,1.5,2.0);
+    src.start()=IDX<double>(-10.0,5.0,0.0);
+    make_ramp(src);
+
+    const float fill=-1000.0f;
+
+    //same sampling: every kernel reproduces the input
+    simple_volume<float> dst(src,false);
+    resample_volume<nearest_kernel>(src,dst,affine_transform(),fill);
+    check_shift(dst,0,0,0,"nearest");
+    resample_volume<trilinear_kernel>(src,dst,affine_transform(),fill);
+    check_shift(dst,0,0,0,"trilinear");
+    resample_volume<cubic_kernel>(src,dst,affine_transform(),fill);
+    check_shift(dst,0,0,0,"cubic");
+
+    //finer sampling, shifted
+    simple_volume<float> fine(33,40,41);
+    fine.step()=IDX<double>(0.5,0.75,0.9);
+    fine.start()=IDX<double>(-9.0,6.0,1.0);
+    affine_transform shift=affine_transform::translation(0.3,-0.6,1.2);
+    resample_volume<trilinear_kernel>(src,fine,shift,fill);
+    check_shift(fine,0.3,-0.6,1.2,"trilinear shift");
+
+    //tricubic reproduces the ramp away from the clamped border
+    resample_volume<cubic_kernel>(src,fine,shift,fill);
+    for(size_t k=4;k<fine.dim(2)-4;k++)
+      for(size_t j=4;j<fine.dim(1)-4;j++)
+        for(size_t i=4;i<fine.dim(0)-4;i++)
+        {
+          simple_volume<float>::vect w=fine.voxel_to_world(IDX<size_t>(i,j,k));
+          if(fine.get(i,j,k)!=fill && fabs(fine.get(i,j,k)-ramp(w[0]+0.3,w[1]-0.6,w[2]+1.2))>1e-3)
+            REPORT_ERROR("Cubic shift mismatched");
+        }
+
+    //rotation in the x-y plane, rows of fine are no longer along the rows of src
+    affine_transform rot;
+    rot.m[0][0]=0.8;rot.m[0][1]=-0.6;
+    rot.m[1][0]=0.6;rot.m[1][1]=0.8;
+    rot.m[0][3]=-2.0;rot.m[1][3]=12.0;
+    resample_volume<trilinear_kernel>(src,fine,rot,fill);
+    size_t inside=0;
+    for(size_t k=0;k<fine.dim(2);k++)
+      for(size_t j=0;j<fine.dim(1);j++)
+        for(size_t i=0;i<fine.dim(0);i++)
+        {
+          if(fine.get(i,j,k)==fill) continue;
+          fixed_vec<3,double> w=rot.apply(fine.voxel_to_world(IDX<size_t>(i,j,k)));
+          if(fabs(fine.get(i,j,k)-ramp(w[0],w[1],w[2]))>1e-3)
+            REPORT_ERROR("Rotated data mismatched");
+          inside++;
+        }
+    if(!inside)
+      REPORT_ERROR("Rotated volume is empty");
+
+    //a constant displacement grid is the same as a translation
+    minc_grid_volume grid(10,10,10);
+    grid.step()=IDX<double>(5.0,5.0,5.0);
+    grid.start()=IDX<double>(-20.0,-5.0,-5.0);
+    grid=IDX<float>(0.3f,-0.6f,1.2f);
+    resample_volume<trilinear_kernel>(src,fine,affine_transform(),grid,fill);
+    check_shift(fine,0.3,-0.6,1.2,"trilinear grid");
+
+    //labels keep their values, the majority wins
+    simple_volume<unsigned char> labels(src.size()),labels_out(src.size());
+    labels.step()=src.step();
+    labels.start()=src.start();
+    labels_out.step()=src.step();
+    labels_out.start()=src.start();
+    for(size_t k=0;k<labels.dim(2);k++)
+      for(size_t j=0;j<labels.dim(1);j++)
+        for(size_t i=0;i<labels.dim(0);i++)
+          labels.set(i,j,k,i<10?1:(j<10?2:3));
+
+    resample_volume<label_majority_kernel>(labels,labels_out,affine_transform::translation(0.25,0.0,0.0));
+    for(size_t k=0;k<labels.dim(2);k++)
+      for(size_t j=0;j<labels.dim(1);j++)
+        for(size_t i=0;i<labels.dim(0)-1;i++)
+          if(labels_out.get(i,j,k)!=labels.get(i,j,k))
+            REPORT_ERROR("Label majority mismatched");
+
+    //cubic overshoots on both sides of a step edge, integer voxels are clamped
+    simple_volume<unsigned char> edge(20,4,4),edge_out(20,4,4);
+    for(size_t k=0;k<edge.dim(2);k++)
+      for(size_t j=0;j<edge.dim(1);j++)
+        for(size_t i=0;i<edge.dim(0);i++)
+          edge.set(i,j,k,i<10?0:255);
+
+    std::vector<float> x(edge.dim(0)),tmp;
+    std::vector<unsigned char> row(edge.dim(0));
+    for(size_t i=0;i<edge.dim(0)-1;i++)
+      x[i]=i+0.5f;
+    cubic_kernel::line(edge,1.0f,1.0f,&x[0],edge.dim(0)-1,&row[0],tmp);
+    resample_volume<cubic_kernel>(edge,edge_out,affine_transform::translation(0.5,0.0,0.0));
+    for(size_t i=0;i<edge.dim(0)-1;i++)
+    {
+      const unsigned char expected=i<9?0:(i>9?255:128);
+      if(cubic_kernel::sample(edge,x[i],1.0f,1.0f)!=expected)
+        REPORT_ERROR("Cubic sample of an edge out of range");
+      if(row[i]!=expected)
+        REPORT_ERROR("Cubic line of an edge out of range");
+      if(edge_out.get(i,static_cast<size_t>(1),static_cast<size_t>(1))!=expected)
+        REPORT_ERROR("Cubic resampling of an edge out of range");
+    }
+
+  } catch (const minc::generic_error & err) {
+    std::cerr << "Got an error at:" << err.file () << ":" << err.line () << std::endl;
+    std::cerr << err.msg()<<std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,533 @@
+#include <iostream>
+#include <unistd.h>
+#include <stdlib.h>
+#include <vector>
+#include <new>
+#include <math.h>
+
+#include "minc_2_rw.h"
+#include "minc_2_simple_rw.h"
+#include "minc_io_prefetch.h"
+
+using namespace minc;
+
+template<class TPixel> void make_rw2_test(const char * filename,int slice_dim,mitype_t datatype,double max_diff=0.0)
+{
+  std::string history="History ";
+
+  // generate info, stored as Z Y X
+  minc_info info(3);
+  int volume=1;
+
+  for(int i=0;i<3;i++)
+  {
+    info[i].dim=dim_info::dimensions( dim_info::DIM_Z-i);
+
+    info[i].length=10+i;
+    info[i].step  =i+0.1;
+    info[i].start =i-5.0;
+
+    info[i].have_dir_cos=true;
+
+    for(int j=0;j<3;j++)
+      info[i].dir_cos[j]=(2-i==j?1.0:0.0);
+
+    volume*=info[i].length;
+  }
+
+  //fill the buffer
+  std::vector<TPixel> buffer(volume);
+
+  if(typeid(TPixel)==typeid(float) || typeid(TPixel)==typeid(double))
+    for(int i=0;i<volume;i++)
+      buffer[i]=static_cast<TPixel>(random())*100.0/RAND_MAX;
+  else
+    for(int i=0;i<volume;i++)
+      buffer[i]=static_cast<TPixel>(random());
+
+  std::vector<double> double_attr(10);
+  std::vector<int> int_attr(10);
+  std::string  string_attr="Test string attribuite";
+
+  for(int i=0;i<10;i++)
+  {
+    double_attr[i]=i+0.1;
+    int_attr[i]=i*100;
+  }
+
+  //now let's write volume
+  minc_2_writer wrt;
+  wrt.open(filename,info,slice_dim,datatype);
+
+  //atributes
+  wrt.append_history(history.c_str());
+  wrt.insert("patient","double_attr",double_attr);
+  wrt.insert("patient","int_attr",int_attr);
+  wrt.insert("patient","string_attr",string_attr.c_str());
+
+  if(typeid(TPixel)==typeid(unsigned char))
+    wrt.setup_write_byte();
+  else if(typeid(TPixel)==typeid(int))
+    wrt.setup_write_int();
+  else if(typeid(TPixel)==typeid(float))
+    wrt.setup_write_float();
+  else if(typeid(TPixel)==typeid(double))
+    wrt.setup_write_double();
+  else
+    REPORT_ERROR("Data type not supported for minc io");
+
+  //write volume through the slice iterator
+  save_standard_volume(wrt,&buffer[0]);
+  wrt.close();
+
+  //reading volume
+  minc_2_reader rdr;
+  rdr.open(filename);
+
+  if(history!=rdr.history())
+      REPORT_ERROR("Mismatched history");
+
+  std::vector<double> double_attr_rd=rdr.att_value_double("patient","double_attr");
+  std::vector<int>  int_attr_rd=rdr.att_value_int("patient","int_attr");
+  std::string string_attr_rd=rdr.att_value_string("patient","string_attr");
+
+  if(string_attr_rd!=string_attr)
+    REPORT_ERROR("Mismatched string attribute");
+
+  for(int i=0;i<10;i++)
+  {
+    if(double_attr_rd[i]!=double_attr[i])
+      REPORT_ERROR("Mismatched double attribute");
+    if(int_attr_rd[i]!=int_attr[i])
+      REPORT_ERROR("Mismatched int attribute");
+  }
+  // let's compare info
+  for(int i=0;i<3;i++)
+  {
+    if(rdr.info()[i].dim!=info[i].dim)
+      REPORT_ERROR("Mismatched dimension");
+
+    if(rdr.info()[i].length!=info[i].length)
+      REPORT_ERROR("Mismatched dimension length");
+
+    if(rdr.info()[i].step!=info[i].step)
+      REPORT_ERROR("Mismatched step");
+
+    if(rdr.info()[i].start!=info[i].start)
+      REPORT_ERROR("Mismatched start");
+
+    for(int j=0;j<3;j++)
+      if(rdr.info()[i].dir_cos[j]!=info[i].dir_cos[j])
+        REPORT_ERROR("Mismatched direction cosines");
+  }
+
+  //read back through the slice iterator, then as a whole volume
+  if(typeid(TPixel)==typeid(unsigned char))
+    rdr.setup_read_byte();
+  else if(typeid(TPixel)==typeid(int))
+    rdr.setup_read_int();
+  else if(typeid(TPixel)==typeid(float))
+    rdr.setup_read_float();
+  else if(typeid(TPixel)==typeid(double))
+    rdr.setup_read_double();
+
+  std::vector<TPixel> in_buffer(volume);
+  load_standard_volume(rdr,&in_buffer[0]);
+
+  simple_volume<TPixel> in_vol;
+  load_simple_volume(rdr,in_vol);
+  rdr.close();
+
+  for(int i=0;i<volume;i++)
+  {
+    if(fabs((double)buffer[i]-(double)in_buffer[i])>max_diff ||
+       fabs((double)buffer[i]-(double)in_vol.c_buf()[i])>max_diff)
+    {
+      std::cerr<<"Expected:"<<buffer[i]<<" got:"<<in_buffer[i]<<","<<in_vol.c_buf()[i]<<" @ "<<i<<std::endl;
+      REPORT_ERROR("Data mismatched!");
+    }
+  }
+}
+
+//! write with the write-behind iterator, read back with the prefetching one
+template<class TPixel> void make_prefetch_test(const char * filename,mitype_t datatype)
+{
+  // T Z Y X
+  minc_info info(4);
+  const dim_info::dimensions dims[]={dim_info::DIM_TIME,dim_info::DIM_Z,dim_info::DIM_Y,dim_info::DIM_X};
+  const int lengths[]={5,12,11,10};
+  for(int i=0;i<4;i++)
+  {
+    info[i].dim=dims[i];
+    info[i].length=lengths[i];
+    info[i].step=1.0;
+    info[i].start=-5.0;
+  }
+
+  minc_2_writer wrt;
+  wrt.open(filename,info,2,datatype);
+  wrt.setup_write_float();
+  {
+    minc_write_behind_output_iterator<TPixel,minc_2_writer> out(wrt);
+    size_t i=0;
+    for(out.begin();!out.last();out.next(),i++)
+      out.value(static_cast<TPixel>(i%1000));
+    out.finish();
+    if(i!=5*12*11*10)
+      REPORT_ERROR("Wrong number of voxels written");
+  }
+  wrt.close();
+
+  minc_2_reader rdr;
+  rdr.open(filename);
+  rdr.setup_read_float();
+  minc_prefetch_input_iterator<TPixel,minc_2_reader> in(rdr);
+  size_t i=0;
+  for(in.begin();!in.last();in.next(),i++)
+  {
+    if(in.value()!=static_cast<TPixel>(i%1000))
+      REPORT_ERROR("Data mismatched!");
+    if(in.cur()[0]!=static_cast<long>(i/(12*11*10)) || in.cur()[3]!=static_cast<long>(i%10))
+      REPORT_ERROR("Position mismatched!");
+  }
+  if(i!=5*12*11*10)
+    REPORT_ERROR("Wrong number of voxels read");
+
+  //copy while both files are accessed in the background, then check the copy
+  std::string copy_name=std::string(filename)+".copy.mnc";
+  minc_2_reader src;
+  src.open(filename);
+  src.setup_read_float();
+  minc_2_writer dst;
+  dst.open(copy_name.c_str(),info,2,datatype);
+  dst.setup_write_float();
+  {
+    minc_prefetch_input_iterator<TPixel,minc_2_reader> from(src);
+    minc_write_behind_output_iterator<TPixel,minc_2_writer> to(dst);
+    for(from.begin(),to.begin();!from.last();from.next(),to.next())
+      to.value(from.value());
+    to.finish();
+  }
+  dst.close();
+
+  minc_2_reader cpy;
+  cpy.open(copy_name.c_str());
+  cpy.setup_read_float();
+  minc_input_iterator<TPixel,minc_2_reader> check(cpy);
+  i=0;
+  for(check.begin();!check.last();check.next(),i++)
+    if(check.value()!=static_cast<TPixel>(i%1000))
+      REPORT_ERROR("Copied data mismatched!");
+  if(i!=5*12*11*10)
+    REPORT_ERROR("Wrong number of voxels copied");
+}
+
+//! 4x4x4 writer which fails on one slice, with an error that is not a generic_error
+class failing_writer
+{
+  protected:
+    minc_info _info;
+    std::vector<long> _cur;
+    int _slices;
+    int _fail_at;
+  public:
+    failing_writer(int fail_at):_info(3),_cur(3,0),_slices(0),_fail_at(fail_at)
+    {
+      for(int i=0;i<3;i++)
+        _info[i].length=4;
+    }
+    int dim_no(void) const { return 3; }
+    int slice_dimensions(void) const { return 2; }
+    const dim_info& dim(unsigned int n) const { return _info[n]; }
+    size_t slice_len(void) const { return 16; }
+    const std::vector<long>& current_slice(void) const { return _cur; }
+    void begin(void) { _cur.assign(3,0); _slices=0; }
+    bool next_slice(void) { return ++_cur[0]<4; }
+    void write(const void *)
+    {
+      if(++_slices==_fail_at)
+        throw std::bad_alloc();
+    }
+};
+
+//! errors of the background writer reach the caller, whatever their type
+void make_failing_write_test(int fail_at)
+{
+  failing_writer wrt(fail_at);
+  bool caught=false;
+  try
+  {
+    minc_write_behind_output_iterator<float,failing_writer> out(wrt);
+    for(out.begin();!out.last();out.next())
+      out.value(1.0f);
+    out.finish();
+  } catch(const generic_error&) {
+    caught=true;
+  }
+  if(!caught)
+    REPORT_ERROR("Background write error was lost");
+}
+
+//! write and read back whole slices through the span iterators
+template<class TPixel> void make_span_test(const char * filename,mitype_t datatype)
+{
+  // Z Y X
+  minc_info info(3);
+  const int lengths[]={7,9,8};
+  for(int i=0;i<3;i++)
+  {
+    info[i].dim=dim_info::dimensions( dim_info::DIM_Z-i);
+    info[i].length=lengths[i];
+    info[i].step=1.0;
+    info[i].start=0.0;
+  }
+
+  minc_2_writer wrt;
+  wrt.open(filename,info,2,datatype);
+  wrt.setup_write_float();
+  minc_output_span_iterator<TPixel,minc_2_writer> out(wrt);
+  size_t i=0;
+  for(out.begin();!out.last();out.next())
+  {
+    if(out.size()!=9*8 || out.cur()[0]!=static_cast<long>(i/(9*8)) || out.cur()[1]!=0)
+      REPORT_ERROR("Wrong slice written");
+    for(size_t j=0;j<out.size();j++,i++)
+      out.data()[j]=static_cast<TPixel>(i);
+  }
+  wrt.close();
+  if(i!=7*9*8)
+    REPORT_ERROR("Wrong number of voxels written");
+
+  minc_2_reader rdr;
+  rdr.open(filename);
+  rdr.setup_read_float();
+  minc_input_span_iterator<TPixel,minc_2_reader> in(rdr);
+  i=0;
+  for(in.begin();!in.last();in.next())
+  {
+    if(in.cur()[0]!=static_cast<long>(i/(9*8)))
+      REPORT_ERROR("Position mismatched!");
+    for(size_t j=0;j<in.size();j++,i++)
+      if(in.data()[j]!=static_cast<TPixel>(i))
+        REPORT_ERROR("Data mismatched!");
+  }
+  if(i!=7*9*8)
+    REPORT_ERROR("Wrong number of voxels read");
+}
+
+//! contiguous images larger than 64k start on a page boundary, so that they can be mapped
+static void check_page_aligned(const char * filename)
+{
+  hid_t file_id=H5Fopen(filename,H5F_ACC_RDONLY,H5P_DEFAULT);
+  if(file_id<0)
+    REPORT_ERROR("Can't open the file with HDF5");
+
+  hid_t dset_id=H5Dopen2(file_id,"/minc-2.0/image/0/image",H5P_DEFAULT);
+  if(dset_id<0)
+  {
+    H5Fclose(file_id);
+    REPORT_ERROR("Can't open the image dataset");
+  }
+
+  haddr_t offset=H5Dget_offset(dset_id);
+  H5Dclose(dset_id);
+  H5Fclose(file_id);
+
+  if(offset==HADDR_UNDEF || offset%4096!=0)
+    REPORT_ERROR("Contiguous image is not page aligned");
+}
+
+//! map the image of an uncompressed file, and fall back to loading a compressed one
+template<class TPixel> void make_mapped_test(const char * filename,mitype_t datatype,bool compress)
+{
+  minc_info info(3);
+  for(int i=0;i<3;i++)
+  {
+    info[i].dim=dim_info::dimensions( dim_info::DIM_Z-i);
+    info[i].length=40+i; //big enough to be page aligned in the file
+    info[i].step=i+0.5;
+    info[i].start=-i;
+  }
+
+  simple_volume<TPixel> vol(42,41,40);
+  for(size_t i=0;i<vol.c_buf_size();i++)
+    vol.c_buf()[i]=static_cast<TPixel>(i%251);
+
+  minc_2_writer wrt;
+  wrt.set_compression(compress);
+  wrt.open(filename,info,2,datatype);
+  save_simple_volume(wrt,vol);
+  wrt.close();
+
+  if(!compress)
+    check_page_aligned(filename);
+
+  mapped_simple_volume<TPixel> in_vol;
+  if(map_simple_volume(filename,in_vol)==compress)
+    REPORT_ERROR(compress?"Compressed image was mapped":"Uncompressed image was not mapped");
+
+  if(in_vol.c_buf_size()!=vol.c_buf_size() || in_vol.step()[2]!=0.5 || in_vol.start()[0]!=-2.0)
+    REPORT_ERROR("Mismatched volume geometry");
+
+  for(size_t i=0;i<vol.c_buf_size();i++)
+    if(in_vol.c_buf()[i]!=vol.c_buf()[i])
+      REPORT_ERROR("Data mismatched!");
+}
+
+//! the mapped voxels are in file order, a reader which flips them can't be mapped
+template<class TPixel> void make_flipped_mapped_test(const char * filename,mitype_t datatype)
+{
+  minc_info info(3);
+  for(int i=0;i<3;i++)
+  {
+    info[i].dim=dim_info::dimensions( dim_info::DIM_Z-i);
+    info[i].length=40+i;
+    info[i].step=i+0.5;
+    info[i].start=-i;
+  }
+  info[0].step=-2.0;
+
+  simple_volume<TPixel> vol(42,41,40);
+  for(size_t i=0;i<vol.c_buf_size();i++)
+    vol.c_buf()[i]=static_cast<TPixel>(i%251);
+
+  minc_2_writer wrt;
+  wrt.set_compression(false);
+  wrt.open(filename,info,2,datatype);
+  save_simple_volume(wrt,vol);
+  wrt.close();
+
+  mapped_simple_volume<TPixel> in_vol;
+  minc_2_reader rdr;
+  rdr.open(filename,true);
+  if(in_vol.map(rdr))
+    REPORT_ERROR("Image read with flipped dimensions was mapped");
+  rdr.close();
+
+  rdr.open(filename);
+  if(!in_vol.map(rdr))
+    REPORT_ERROR("Image read in file order was not mapped");
+  if(in_vol.step()[2]!=-2.0 || in_vol.start()[2]!=0.0)
+    REPORT_ERROR("Mismatched volume geometry");
+  for(size_t i=0;i<vol.c_buf_size();i++)
+    if(in_vol.c_buf()[i]!=vol.c_buf()[i])
+      REPORT_ERROR("Data mismatched!");
+}
+
+//! load files with time slowest and fastest varying into both 4D layouts
+template<class TPixel> void make_4d_series_test(const char * filename,bool time_fastest)
+{
+  typedef simple_4d_series<TPixel> series;
+  const size_t nx=10,ny=11,nz=12,nt=5;
+
+  minc_info info(4);
+  const dim_info::dimensions slow_t[]={dim_info::DIM_TIME,dim_info::DIM_Z,dim_info::DIM_Y,dim_info::DIM_X};
+  const dim_info::dimensions fast_t[]={dim_info::DIM_Z,dim_info::DIM_Y,dim_info::DIM_X,dim_info::DIM_TIME};
+  const int slow_len[]={nt,nz,ny,nx};
+  const int fast_len[]={nz,ny,nx,nt};
+  for(int i=0;i<4;i++)
+  {
+    info[i].dim=time_fastest?fast_t[i]:slow_t[i];
+    info[i].length=time_fastest?fast_len[i]:slow_len[i];
+    info[i].step=1.5;
+    info[i].start=-5.0;
+  }
+
+  series vol(nx,ny,nz,nt,series::FRAME_MAJOR);
+  for(size_t t=0;t<nt;t++)
+    for(size_t z=0;z<nz;z++)
+      for(size_t y=0;y<ny;y++)
+        for(size_t x=0;x<nx;x++)
+          vol.set(x,y,z,t,static_cast<TPixel>(x+y*7+z*13+t*100));
+
+  minc_2_writer wrt;
+  wrt.open(filename,info,2,MI_TYPE_FLOAT);
+  save_4d_volume(wrt,vol);
+  wrt.close();
+
+  series frames,voxels;
+  minc_2_reader rdr;
+  rdr.open(filename);
+  load_4d_volume(rdr,frames,series::FRAME_MAJOR);
+  rdr.close();
+  rdr.open(filename);
+  load_4d_volume(rdr,voxels,series::VOXEL_MAJOR);
+  rdr.close();
+
+  if(frames.frames()!=nt || voxels.dim(0)!=nx || voxels.t_step()!=1.5 || frames.start()[2]!=-5.0)
+    REPORT_ERROR("Mismatched 4D geometry");
+  if(voxels.series(3,4,5).stride()!=1 || frames.frame(2).stride()!=1)
+    REPORT_ERROR("Views are not contiguous");
+
+  for(size_t z=0;z<nz;z++)
+    for(size_t y=0;y<ny;y++)
+      for(size_t x=0;x<nx;x++)
+      {
+        series_view<const TPixel> s=static_cast<const series&>(voxels).series(x,y,z);
+        for(size_t t=0;t<nt;t++)
+          if(s[t]!=vol.get(x,y,z,t) || frames.frame(t)(x,y,z)!=vol.get(x,y,z,t))
+            REPORT_ERROR("Data mismatched!");
+      }
+
+  //transposing in memory gives the same buffers
+  voxels.set_layout(series::FRAME_MAJOR);
+  frames.set_layout(series::VOXEL_MAJOR);
+  frames.set_layout(series::FRAME_MAJOR);
+  for(size_t i=0;i<vol.c_buf_size();i++)
+    if(voxels.c_buf()[i]!=vol.c_buf()[i] || frames.c_buf()[i]!=vol.c_buf()[i])
+      REPORT_ERROR("Transposed data mismatched!");
+
+  //round trip through simple_4d_volume
+  simple_4d_volume<TPixel> v4;
+  voxels.set_layout(series::VOXEL_MAJOR);
+  voxels.copy_to(v4);
+  frames.assign(v4,series::VOXEL_MAJOR);
+  if(v4.get(1,2,3,4)!=vol.get(1,2,3,4) || frames.get(9,10,11,4)!=vol.get(9,10,11,4))
+    REPORT_ERROR("Converted data mismatched!");
+}
+
+int main(int argc,char **argv)
+{
+  try
+  {
+    if(argc>1)
+    {
+      if(chdir(argv[1]))
+        REPORT_ERROR("Can't chdir!");
+    }
+
+    //no rounding expected
+    make_rw2_test<unsigned char>("EZminc2_byte_2.mnc",2,MI_TYPE_UBYTE);
+    make_rw2_test<int>("EZminc2_int_2.mnc",2,MI_TYPE_INT);
+    make_rw2_test<float>("EZminc2_float_2.mnc",2,MI_TYPE_FLOAT);
+    make_rw2_test<float>("EZminc2_float_3.mnc",3,MI_TYPE_FLOAT);
+    make_rw2_test<double>("EZminc2_double_2.mnc",2,MI_TYPE_DOUBLE);
+
+    // some rounding expected
+    make_rw2_test<float>("EZminc2_float_2_short.mnc",2,MI_TYPE_SHORT,0.1);
+    make_rw2_test<float>("EZminc2_float_3_short.mnc",3,MI_TYPE_SHORT,0.1);
+    make_rw2_test<double>("EZminc2_double_2_byte.mnc",2,MI_TYPE_UBYTE,0.5);
+
+    make_prefetch_test<float>("EZminc2_prefetch_float.mnc",MI_TYPE_FLOAT);
+    make_span_test<float>("EZminc2_span_float.mnc",MI_TYPE_FLOAT);
+    make_failing_write_test(2);
+    make_failing_write_test(4);
+
+    make_mapped_test<float>("EZminc2_mapped_float.mnc",MI_TYPE_FLOAT,false);
+    make_mapped_test<int>("EZminc2_mapped_int.mnc",MI_TYPE_INT,false);
+    make_mapped_test<short>("EZminc2_mapped_short.mnc",MI_TYPE_SHORT,false);
+    make_mapped_test<unsigned short>("EZminc2_mapped_ushort.mnc",MI_TYPE_USHORT,false);
+    make_mapped_test<float>("EZminc2_mapped_float_z.mnc",MI_TYPE_FLOAT,true);
+    make_flipped_mapped_test<float>("EZminc2_mapped_flipped.mnc",MI_TYPE_FLOAT);
+
+    make_4d_series_test<float>("EZminc2_4d_slow_t.mnc",false);
+    make_4d_series_test<float>("EZminc2_4d_fast_t.mnc",true);
+
+  } catch (const minc::generic_error & err) {
+    std::cerr << "Got an error at:" << err.file () << ":" << err.line () << std::endl;
+    std::cerr << err.msg()<<std::endl;
+    return 1;
+  }
+
+  return 0;
+}
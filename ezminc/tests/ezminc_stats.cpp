@@ -6,6 +6,7 @@
 
 #include "minc_1_rw.h"
 #include "minc_1_simple.h"
+#include "minc_io_prefetch.h"
 
 using namespace minc;
 
@@ -18,13 +19,6 @@ template<class TPixel> double calc_stats(const char * filename)
   minc_1_reader rdr;
   rdr.open(filename);
   
- 
-  int volume=1.0;
-  for(int i=0;i<3;i++)
-  {
-    volume*=rdr.info()[i].length;
-  }
-  
   if(typeid(TPixel)==typeid(unsigned char))
     rdr.setup_read_byte();
   else if(typeid(TPixel)==typeid(int))
@@ -37,14 +31,13 @@ template<class TPixel> double calc_stats(const char * filename)
     REPORT_ERROR("Data type not supported for minc io");
   
   
-  std::vector<TPixel> in_buffer(volume);
-  load_standard_volume(rdr,&in_buffer[0]);
-  rdr.close();
-  
+  //next slice is read while the current one is summed up
   double mean=0.0;
-  
-  for(int i=0;i<volume;i++)
-    mean+=in_buffer[i];
+  size_t volume=0;
+  minc_prefetch_input_iterator<TPixel> in(rdr);
+  for(in.begin();!in.last();in.next(),volume++)
+    mean+=in.value();
+  rdr.close();
   
   mean/=volume;
   
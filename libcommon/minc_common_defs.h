@@ -319,6 +319,7 @@ image dimensions */
 
 #define MI2_OPEN_READ 0x0001
 #define MI2_OPEN_RDWR 0x0002
+#define MI2_OPEN_HEADER 0x0004 /* With MI2_OPEN_READ: defer opening the image datasets */
 
 #define MI_VERSION_2_0 "MINC Version    2.0"
 
@@ -42,7 +42,11 @@ static const char *_CONFIG_VAR[]=
       "MINC_MAX_MEMORY_KB",
       "MINC_FILE_CACHE_MB",
       "MINC_CHECKSUM",
-      "MINC_PREFER_V2_API"
+      "MINC_PREFER_V2_API",
+      "MINC_DIRECT_CHUNK_READ",
+      "MINC_CONVERT_MEMORY_KB",
+      "MINC_ICV_FAST_PATHS",
+      "MINC_DIRECT_MINC1_READ"
   };
 
 enum {
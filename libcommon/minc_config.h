@@ -12,6 +12,10 @@ enum MINC_CONFIG {
   MICFG_MINC_FILE_CACHE,
   MICFG_MINC_CHECKSUM,
   MICFG_MINC_PREFER_V2_API,
+  MICFG_MINC_DIRECT_CHUNK_READ,
+  MICFG_MINC_CONVERT_MEMORY,
+  MICFG_MINC_ICV_FAST_PATHS,
+  MICFG_MINC_DIRECT_MINC1_READ,
   MICFG_COUNT
 };
 
@@ -229,6 +229,8 @@ static struct mierror_entry mierror_table[] = {
     { MI2_MSG_ERROR, "Illegal variable access operation" }, /* MI2_MSG_BADOP */
     { MI2_MSG_ERROR, "HDF5 function %s failed" } , /*MI2_MSG_HDF5*/
     { MI2_MSG_ERROR, "Error: %s"} , /*MI2_MSG_GENERIC*/
+    { MI2_MSG_WARNING, "Compression filter '%s' is not available, using zlib instead"} , /*MI2_MSG_FILTER_FALLBACK*/
+    { MI2_MSG_ERROR, "Compression filter '%s' is not available, check HDF5_PLUGIN_PATH"} , /*MI2_MSG_FILTER_MISSING*/
 };
 
 
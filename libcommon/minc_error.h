@@ -161,7 +161,9 @@ typedef enum mimsgcode {
     MI2_MSG_ICVCOORDS,
     MI2_MSG_BADOP,
     MI2_MSG_HDF5,
-    MI2_MSG_GENERIC
+    MI2_MSG_GENERIC,
+    MI2_MSG_FILTER_FALLBACK,
+    MI2_MSG_FILTER_MISSING
 } mimsgcode_t;
 
 int milog_message(mimsgcode_t code, ...);
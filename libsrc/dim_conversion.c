@@ -14,6 +14,8 @@
                  MI_get_dim_bufsize_step
                  MI_icv_get_dim_conversion
                  MI_icv_dimconvert
+                 MI_icv_dimconvert_rows
+                 MI_icv_dimconvert_resize
                  MI_icv_dimconv_init
 @CREATED    : September 9, 1992. (Peter Neelin)
 @MODIFIED   : 
@@ -94,6 +96,10 @@
 #include <math.h>
 #include <type_limits.h>
 
+/* Output pixels converted at a time by MI_icv_dimconvert_resize, so that
+   the input pixels and sums of a tile stay in the first level cache */
+#define MI_DIMCONV_TILE 256
+
 /* Private functions */
 PRIVATE int MI_icv_get_dim(mi_icv_type *icvp, int cdfid, int varid);
 PRIVATE int MI_get_dim_flip(mi_icv_type *icvp, int cdfid, int dimvid[], 
@@ -104,6 +110,10 @@ PRIVATE int MI_icv_get_dim_conversion(mi_icv_type *icvp, int subsc[]);
 PRIVATE int MI_icv_dimconvert(int operation, mi_icv_type *icvp,
                               long start[], long count[], void *values,
                               long bufstart[], long bufcount[], void *buffer);
+PRIVATE int MI_icv_dimconvert_rows(mi_icv_type *icvp, 
+                                   mi_icv_dimconv_type *dcp);
+PRIVATE int MI_icv_dimconvert_resize(mi_icv_type *icvp, 
+                                     mi_icv_dimconv_type *dcp);
 PRIVATE int MI_icv_dimconv_init(int operation, mi_icv_type *icvp,
                               mi_icv_dimconv_type *dcp,
                               long start[], long count[], void *values,
@@ -611,7 +621,10 @@ PRIVATE int MI_icv_get_dim_conversion(mi_icv_type *icvp, int subsc[])
 @GLOBALS    : 
 @CALLS      : NetCDF routines
 @CREATED    : August 27, 1992 (Peter Neelin)
-@MODIFIED   : 
+@MODIFIED   : October 16, 2026
+                 - hand rows without compression or expansion to
+                   MI_icv_dimconvert_rows, and whole buffers resized by
+                   2 or 4 to MI_icv_dimconvert_resize
 ---------------------------------------------------------------------------- */
 PRIVATE int MI_icv_dimconvert(int operation, mi_icv_type *icvp,
                               long start[], long count[], void *values,
@@ -641,6 +654,17 @@ PRIVATE int MI_icv_dimconvert(int operation, mi_icv_type *icvp,
    {MI_CHK_ERR(MI_icv_dimconv_init(operation, icvp, dcp, start, count, values,
                                    bufstart, bufcount, buffer))}
 
+   /* Without compression or expansion, convert whole rows at a time */
+   if (dcp->do_rows) {
+      MI_RETURN(MI_icv_dimconvert_rows(icvp, dcp));
+   }
+
+   /* Average or replicate pixels a tile at a time if the whole buffer
+      is resized by 2 or 4 */
+   if (dcp->do_resize) {
+      MI_RETURN(MI_icv_dimconvert_resize(icvp, dcp));
+   }
+
    /* Initialize local variables */
    iptr    = dcp->istart;
    optr    = dcp->ostart;
@@ -773,6 +797,263 @@ PRIVATE int MI_icv_dimconvert(int operation, mi_icv_type *icvp,
    MI_RETURN(MI_NOERROR);
 }
 
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MI_icv_dimconvert_rows
+@INPUT      : icvp       - icv structure pointer
+              dcp        - dimconvert structure pointer, set up by
+                 MI_icv_dimconv_init with do_rows TRUE
+@OUTPUT     : (none)
+@RETURNS    : MI_ERROR if an error occurs
+@DESCRIPTION: Fast path of MI_icv_dimconvert for the case where pixels are
+              neither compressed nor expanded, so that each row of the
+              fastest varying dimension maps onto one row of the output,
+              possibly flipped. Each row is converted with a single call
+              to MI_convert_type (which uses its type-specialized kernels)
+              and reversed in place if exactly one of the input and output
+              steps is negative.
+@METHOD     : Gives the same values as the general loop, which does the 
+              same fillvalue checking and scaling one pixel at a time.
+@GLOBALS    : 
+@CALLS      : MI_convert_type
+@CREATED    : October 16, 2026
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+PRIVATE int MI_icv_dimconvert_rows(mi_icv_type *icvp, 
+                                   mi_icv_dimconv_type *dcp)
+{
+   long counter[MAX_VAR_DIMS];  /* Dimension loop counter */
+   char *iptr, *optr;           /* Pointers to first pixel of the row */
+   char *irow, *orow;           /* Lowest addresses of the row */
+   char *lo, *hi;               /* Pointers for reversing a row */
+   char tmp[sizeof(double)];
+   long npix;                   /* Pixels per row */
+   int outsize;                 /* Output pixel size */
+   int fastdim;                 /* Dimension that varies fastest */
+   int idim, ibyte;
+
+   MI_SAVE_ROUTINE_NAME("MI_icv_dimconvert_rows");
+
+   fastdim = icvp->derv_dimconv_fastdim;
+   npix = dcp->end[fastdim];
+   outsize = nctypelen(dcp->outtype);
+
+   for (idim=0; idim<=fastdim; idim++) {
+      if (dcp->end[idim] <= 0) MI_RETURN(MI_NOERROR);
+      counter[idim] = 0;
+   }
+
+   /* Loop over rows */
+   for (;;) {
+      iptr = (char *) dcp->istart;
+      optr = (char *) dcp->ostart;
+      for (idim=0; idim<fastdim; idim++) {
+         iptr += counter[idim] * dcp->istep[idim];
+         optr += counter[idim] * dcp->ostep[idim];
+      }
+      irow = (dcp->istep[fastdim] < 0) ? 
+         iptr + (npix - 1) * dcp->istep[fastdim] : iptr;
+      orow = (dcp->ostep[fastdim] < 0) ? 
+         optr + (npix - 1) * dcp->ostep[fastdim] : optr;
+
+      if (MI_convert_type(npix, dcp->intype, dcp->insign, irow,
+                          dcp->outtype, dcp->outsign, orow, icvp) < 0) {
+         MI_RETURN(MI_ERROR);
+      }
+
+      /* Reverse the row if it is flipped */
+      if ((dcp->istep[fastdim] < 0) != (dcp->ostep[fastdim] < 0)) {
+         lo = orow;
+         hi = orow + (npix - 1) * outsize;
+         for (; lo < hi; lo += outsize, hi -= outsize) {
+            for (ibyte=0; ibyte<outsize; ibyte++) {
+               tmp[ibyte] = lo[ibyte];
+               lo[ibyte] = hi[ibyte];
+               hi[ibyte] = tmp[ibyte];
+            }
+         }
+      }
+
+      /* Move on to the next row */
+      idim = fastdim - 1;
+      while ((idim >= 0) && (++counter[idim] >= dcp->end[idim])) {
+         counter[idim] = 0;
+         idim--;
+      }
+      if (idim < 0) break;
+   }
+
+   MI_RETURN(MI_NOERROR);
+}
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MI_icv_dimconvert_resize
+@INPUT      : icvp       - icv structure pointer
+              dcp        - dimconvert structure pointer, set up by
+                 MI_icv_dimconv_init with do_resize TRUE
+@OUTPUT     : (none)
+@RETURNS    : MI_ERROR if an error occurs
+@DESCRIPTION: Fast path of MI_icv_dimconvert for a GET where each image
+              dimension is either shrunk or grown by 1, 2 or 4 and no
+              pixel of any block falls outside the buffers, so that none
+              of the edge handling of the general loop is needed.
+              Down-sampling averages the pixels of each block and
+              up-sampling replicates each pixel over its block.
+@METHOD     : Each row of the fastest varying dimension is done in tiles
+              of MI_DIMCONV_TILE output pixels. The offsets of a block
+              come in groups of resize_scale adjacent pixels along the
+              fastest dimension, so for each group the input of a whole
+              tile is one contiguous run. Pixels are summed in the same
+              order as in the general loop, which gives the same values.
+              Buffers with partial blocks at their edges are left to the
+              general loop.
+@GLOBALS    :
+@CALLS      :
+@CREATED    : October 16, 2026
+@MODIFIED   :
+---------------------------------------------------------------------------- */
+PRIVATE int MI_icv_dimconvert_resize(mi_icv_type *icvp,
+                                     mi_icv_dimconv_type *dcp)
+{
+   double ivalue[4*MI_DIMCONV_TILE]; /* Input pixels of a tile */
+   double sum1[MI_DIMCONV_TILE];     /* Counters for averaging values */
+   double sum0[MI_DIMCONV_TILE];
+   char out_of_range[MI_DIMCONV_TILE]; /* Flags for pixels out of range */
+   long counter[MAX_VAR_DIMS];  /* Dimension loop counter */
+   char *iptr, *optr;           /* Pointers to first pixel of the row */
+   char *ptr, *tptr;
+   long *pix_off;               /* Offsets of the pixels of a block */
+   long ngroup, igroup;         /* Groups of adjacent pixels in a block */
+   long npix, ntile;            /* Pixels per row and per tile */
+   long jpix, ipix;
+   long unit;                   /* Step between pixels of a group */
+   double dvalue, dtemp;        /* Pixel value */
+   double dmin, dmax, epsilon;  /* Range limits */
+   int scale;                   /* Pixels per group */
+   int insize;                  /* Input pixel size */
+   int fastdim;                 /* Dimension that varies fastest */
+   int idim;
+
+   MI_SAVE_ROUTINE_NAME("MI_icv_dimconvert_resize");
+
+   fastdim = icvp->derv_dimconv_fastdim;
+   npix = dcp->end[fastdim];
+   insize = nctypelen(dcp->intype);
+   scale = dcp->resize_scale;
+   if (dcp->do_compress) {
+      pix_off = dcp->in_pix_off;
+      ngroup = dcp->in_pix_num / scale;
+      unit = dcp->istep[fastdim] / scale;
+   }
+   else {
+      pix_off = dcp->out_pix_off;
+      ngroup = dcp->out_pix_num / scale;
+      unit = dcp->ostep[fastdim] / scale;
+   }
+   dmax = icvp->fill_valid_max;
+   dmin = icvp->fill_valid_min;
+   epsilon = (dmax - dmin) * FILLVALUE_EPSILON;
+   epsilon = fabs(epsilon);
+   dmax += epsilon;
+   dmin -= epsilon;
+
+   for (idim=0; idim<=fastdim; idim++) {
+      if (dcp->end[idim] <= 0) MI_RETURN(MI_NOERROR);
+      counter[idim] = 0;
+   }
+
+   /* Loop over rows */
+   for (;;) {
+      iptr = (char *) dcp->istart;
+      optr = (char *) dcp->ostart;
+      for (idim=0; idim<fastdim; idim++) {
+         iptr += counter[idim] * dcp->istep[idim];
+         optr += counter[idim] * dcp->ostep[idim];
+      }
+
+      for (jpix=0; jpix<npix; jpix+=MI_DIMCONV_TILE) {
+         ntile = MIN(MI_DIMCONV_TILE, npix - jpix);
+
+         /* Down-sample: add in each group of the blocks, then average */
+         if (dcp->do_compress) {
+            for (ipix=0; ipix<ntile; ipix++) {
+               sum1[ipix] = 0.0;
+               sum0[ipix] = 0.0;
+               out_of_range[ipix] = FALSE;
+            }
+            for (igroup=0; igroup<ngroup; igroup++) {
+               ptr = iptr + jpix * dcp->istep[fastdim]
+                  + pix_off[igroup * scale];
+               for (ipix=0; ipix<ntile*scale; ipix++) {
+                  tptr = ptr + ipix * insize;
+                  {MI_TO_DOUBLE(ivalue[ipix], dcp->intype, dcp->insign,
+                                tptr)}
+               }
+               for (ipix=0; ipix<ntile*scale; ipix++) {
+                  dvalue = ivalue[ipix];
+                  if (icvp->do_fillvalue &&
+                      ((dvalue < dmin) || (dvalue > dmax))) {
+                     out_of_range[ipix / scale] = TRUE;
+                  }
+                  else {
+                     sum1[ipix / scale] += dvalue;
+                     sum0[ipix / scale]++;
+                  }
+               }
+            }
+            for (ipix=0; ipix<ntile; ipix++) {
+               if (out_of_range[ipix]) {
+                  dvalue = icvp->user_fillvalue;
+               }
+               else {
+                  dvalue = (sum0[ipix] != 0.0) ?
+                     sum1[ipix] / sum0[ipix] : 0.0;
+                  if (icvp->do_scale)
+                     dvalue = icvp->scale * dvalue + icvp->offset;
+               }
+               tptr = optr + (jpix + ipix) * dcp->ostep[fastdim];
+               {MI_FROM_DOUBLE(dvalue, dcp->outtype, dcp->outsign, tptr)}
+            }
+         }
+
+         /* Up-sample: write each pixel over each group of its block */
+         else {
+            ptr = iptr + jpix * dcp->istep[fastdim];
+            for (ipix=0; ipix<ntile; ipix++) {
+               tptr = ptr + ipix * insize;
+               {MI_TO_DOUBLE(ivalue[ipix], dcp->intype, dcp->insign, tptr)}
+               dvalue = ivalue[ipix];
+               if (icvp->do_fillvalue &&
+                   ((dvalue < dmin) || (dvalue > dmax)))
+                  dvalue = icvp->user_fillvalue;
+               else if (icvp->do_scale)
+                  dvalue = icvp->scale * dvalue + icvp->offset;
+               ivalue[ipix] = dvalue;
+            }
+            for (igroup=0; igroup<ngroup; igroup++) {
+               ptr = optr + jpix * dcp->ostep[fastdim]
+                  + pix_off[igroup * scale];
+               for (ipix=0; ipix<ntile*scale; ipix++) {
+                  dtemp = ivalue[ipix / scale];
+                  tptr = ptr + (ipix / scale) * dcp->ostep[fastdim]
+                     + (ipix % scale) * unit;
+                  {MI_FROM_DOUBLE(dtemp, dcp->outtype, dcp->outsign, tptr)}
+               }
+            }
+         }
+      }
+
+      /* Move on to the next row */
+      idim = fastdim - 1;
+      while ((idim >= 0) && (++counter[idim] >= dcp->end[idim])) {
+         counter[idim] = 0;
+         idim--;
+      }
+      if (idim < 0) break;
+   }
+
+   MI_RETURN(MI_NOERROR);
+}
+
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : MI_icv_dimconv_init
 @INPUT      : operation  - MI_PRIV_GET or MI_PRIV_PUT
@@ -812,9 +1093,18 @@ PRIVATE int MI_icv_dimconv_init(int operation, mi_icv_type *icvp,
    long pixcount;
    int var_fd, usr_fd, dshift;
    long ipix;
+   /* Variables for checking whole-buffer resizing */
+   int fast_paths, resize_ok, flip;
+   long npos, lowest;
+   long *pix_off, pix_num, unit;
 
    MI_SAVE_ROUTINE_NAME("MI_icv_dimconv_init");
 
+   /* The fast paths can be turned off to compare them with the general
+      loop */
+   fast_paths = !(miget_cfg_present(MICFG_MINC_ICV_FAST_PATHS) &&
+                  !miget_cfg_bool(MICFG_MINC_ICV_FAST_PATHS));
+
    /* Check to see if any compression or expansion needs to be done.
       Work it out for a GET and then swap if a PUT. */
    if (operation==MI_PRIV_GET) {
@@ -828,6 +1118,12 @@ PRIVATE int MI_icv_dimconv_init(int operation, mi_icv_type *icvp,
 
    fastdim = icvp->derv_dimconv_fastdim;
 
+   /* Whole buffers are resized by MI_icv_dimconvert_resize only when
+      reading scalar images and only in one direction */
+   resize_ok = (fast_paths && (operation==MI_PRIV_GET) &&
+                !icvp->var_is_vector &&
+                (dcp->do_compress != dcp->do_expand));
+
    /* Get the indices of high and low image dimensions */
    imgdim_high=icvp->var_ndims-1;
    if (icvp->var_is_vector) imgdim_high--;
@@ -904,6 +1200,28 @@ PRIVATE int MI_icv_dimconv_init(int operation, mi_icv_type *icvp,
          }
       }
 
+      /* For resizing, each dimension must be shrunk or grown by 1, 2 or
+         4, shrunk dimensions must hold whole blocks of the buffer and
+         every output pixel must fall at its own place in the user's
+         buffer, so that no block needs clipping */
+      npos = dcp->end[idim];
+      flip = FALSE;
+      if ((idim >= imgdim_low) && (idim <= imgdim_high)) {
+         jdim = imgdim_high - idim;
+         scale = icvp->derv_dim_scale[jdim];
+         flip = icvp->derv_dim_flip[jdim];
+         if ((scale != 1) && (scale != 2) && (scale != 4))
+            resize_ok = FALSE;
+         if (icvp->derv_dim_grow[jdim])
+            npos *= scale;
+         else if ((bufstart[idim] % scale != 0) || 
+                  (bufcount[idim] % scale != 0))
+            resize_ok = FALSE;
+      }
+      lowest = flip ? values_index - npos + 1 : values_index;
+      if ((lowest < 0) || (lowest + npos > icvp->derv_icv_count[idim]))
+         resize_ok = FALSE;
+
       /* Force these offsets to stay within the presumed limits of the
        * allocated memory. Before implementing this change it was
        * possible for miicv_get() or miicv_put() to write outside the
@@ -1038,5 +1356,41 @@ PRIVATE int MI_icv_dimconv_init(int operation, mi_icv_type *icvp,
       dcp->istart = (void *) ((char *) values + values_off);
    }                   /* if PUT */
 
+   /* Rows can be converted in one piece if pixels are not compressed or
+      expanded and are contiguous apart from flipping */
+   dcp->do_rows = (!dcp->do_compress && !dcp->do_expand &&
+                   (dcp->intype != NC_CHAR) && (dcp->outtype != NC_CHAR) &&
+                   (labs(dcp->istep[fastdim]) == nctypelen(dcp->intype)) &&
+                   (labs(dcp->ostep[fastdim]) == nctypelen(dcp->outtype)));
+   dcp->do_rows = dcp->do_rows && fast_paths;
+
+   /* Resized buffers can be done a tile at a time if the pixels of each
+      block come in groups that are adjacent along the fastest dimension */
+   dcp->do_resize = FALSE;
+   if (resize_ok) {
+      dcp->resize_scale =
+         ((icvp->derv_dim_grow[0] != 0) == (dcp->do_expand != 0)) ?
+         icvp->derv_dim_scale[0] : 1;
+      if (dcp->do_compress) {
+         pix_num = dcp->in_pix_num;
+         pix_off = dcp->in_pix_off;
+         unit = dcp->istep[fastdim] / dcp->resize_scale;
+         dcp->do_resize = (unit == nctypelen(dcp->intype));
+      }
+      else {
+         pix_num = dcp->out_pix_num;
+         pix_off = dcp->out_pix_off;
+         unit = dcp->ostep[fastdim] / dcp->resize_scale;
+         dcp->do_resize = (dcp->istep[fastdim] == nctypelen(dcp->intype));
+      }
+      if (pix_num % dcp->resize_scale != 0)
+         dcp->do_resize = FALSE;
+      for (ipix=0; dcp->do_resize && (ipix<pix_num); ipix++) {
+         if (pix_off[ipix] != pix_off[ipix - ipix % dcp->resize_scale]
+                              + (ipix % dcp->resize_scale) * unit)
+            dcp->do_resize = FALSE;
+      }
+   }
+
    MI_RETURN(MI_NOERROR);
 }
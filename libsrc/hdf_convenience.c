@@ -62,6 +62,9 @@ static struct m2_file {
     int chunk_type;             /* Chunking enabled */
     int chunk_param;            /* Chunk length */
     int checksum;               /* Enable file checksumming */
+    char *ext_path;             /* File holding the image data, or NULL */
+    long long ext_offset;       /* Offset of the image data in ext_path */
+    long long ext_stride;       /* Bytes from one record to the next, or 0 */
 } *_m2_list;
 
 
@@ -98,6 +101,9 @@ hdf_id_add(hid_t file_id)
         new->chunk_type = MI2_CHUNK_UNKNOWN;
         new->chunk_param = 0;
         new->checksum = miget_cfg_bool(MICFG_MINC_CHECKSUM);
+        new->ext_path = NULL;
+        new->ext_offset = 0;
+        new->ext_stride = 0;
         _m2_list = new;
     }
     else {
@@ -151,6 +157,7 @@ hdf_id_del(int fd)
 
             H5Gclose(curr->grp_id);
             H5Fclose(curr->file_id);
+            free(curr->ext_path);
 	    free(curr);
 	    return (MI_NOERROR);
 	}
@@ -1285,6 +1292,8 @@ hdf_vardef(int fd, const char *varnm, nc_type vartype, int ndims,
     struct m2_dim *dim;
     int chunk_length;
     int comp_level;
+    int is_external;
+    hsize_t seg_size, iseg, nseg;
 
     /* Ignore deprecated variables */
     if (!strcmp(varnm, MIrootvariable)) {
@@ -1299,6 +1308,12 @@ hdf_vardef(int fd, const char *varnm, nc_type vartype, int ndims,
       return (MI_ERROR);
     }
 
+    /* The image may be left in place in another file, see
+     * hdf_set_external_image().
+     */
+    is_external = (file->ext_path != NULL && ndims > 0 &&
+                   !strcmp(varnm, MIimage));
+
     prp_id = H5Pcreate(H5P_DATASET_CREATE);
     H5Pset_attr_phase_change (prp_id, 0, 0);
     
@@ -1337,7 +1352,7 @@ hdf_vardef(int fd, const char *varnm, nc_type vartype, int ndims,
             }
         }
 
-        if (comp_level != 0) {
+        if (comp_level != 0 && !is_external) {
             /* If compression is specified, chunking must be enabled. */
             if (file->chunk_type == MI2_CHUNK_UNKNOWN) {
                 /* read from minc config file or environment variable */
@@ -1393,7 +1408,32 @@ hdf_vardef(int fd, const char *varnm, nc_type vartype, int ndims,
               H5Pset_fletcher32(prp_id);
             }
         }
-        
+
+        if (is_external) {
+            /* One segment of the other file per record, or a single
+             * segment without a record dimension. Nothing is ever
+             * written there, not even fill values.
+             */
+            seg_size = nctypelen(vartype);
+            nseg = 1;
+            for (i = (file->ext_stride > 0) ? 1 : 0; i < ndims; i++) {
+                seg_size *= dims[i];
+            }
+            if (file->ext_stride > 0) {
+                nseg = dims[0];
+            }
+            H5Pset_layout(prp_id, H5D_CONTIGUOUS);
+            H5Pset_fill_time(prp_id, H5D_FILL_TIME_NEVER);
+            for (iseg = 0; iseg < nseg; iseg++) {
+                if (H5Pset_external(prp_id, file->ext_path,
+                                    (off_t) (file->ext_offset +
+                                             iseg * file->ext_stride),
+                                    seg_size) < 0) {
+                    status = MI_ERROR;
+                    goto cleanup;
+                }
+            }
+        }
     }
 
     if (spc_id < 0) {
@@ -1404,6 +1444,11 @@ hdf_vardef(int fd, const char *varnm, nc_type vartype, int ndims,
     if (typ_id < 0) {
       goto cleanup;
     }
+
+    /* Data left in a netCDF file is big-endian */
+    if (is_external && nctypelen(vartype) > 1) {
+      H5Tset_order(typ_id, H5T_ORDER_BE);
+    }
     
     H5E_BEGIN_TRY {
         dst_id = H5Dcreate2(file->file_id, varpath, typ_id, spc_id, H5P_DEFAULT, prp_id, H5P_DEFAULT);
@@ -2332,8 +2377,16 @@ hdf_create(const char *path, int cmode, struct mi2opts *opts_ptr)
 
     /*Set cachine parameters*/
     fpid = H5Pcreate (H5P_FILE_ACCESS);
-    /* Limit file compatability to 1.8.x */
-    H5Pset_libver_bounds (fpid, H5F_LIBVER_V18, H5F_LIBVER_V18);
+
+    if (cmode & MI2_CREATE_MEMORY) {
+      /* Memory only file, path is just a name, retrieve it with hdf_close_image.
+       * Keep the default format bounds: the image of an open file with a
+       * 1.8 superblock fails its checksum once reopened */
+      H5Pset_fapl_core (fpid, 1024*1024, 0);
+    } else {
+      /* Limit file compatability to 1.8.x */
+      H5Pset_libver_bounds (fpid, H5F_LIBVER_V18, H5F_LIBVER_V18);
+    }
     
     /*setup a bigger cache to work with typical chunking ( MI_MAX_VAR_BUFFER_SIZE )*/
     H5Pset_cache(fpid, 0, 2503, miget_cfg_present(MICFG_MINC_FILE_CACHE)?miget_cfg_int(MICFG_MINC_FILE_CACHE)*100000:MI_MAX_VAR_BUFFER_SIZE*10, 1.0);    
@@ -2350,6 +2403,7 @@ hdf_create(const char *path, int cmode, struct mi2opts *opts_ptr)
     H5E_BEGIN_TRY {
         file_id = H5Fcreate(path, cmode, H5P_DEFAULT, fpid);
     } H5E_END_TRY;
+    H5Pclose(fpid);
     if (file_id < 0) {
       fprintf(stderr, "Error creating HDF file '%s' with mode '%x', result %d\n", path, cmode, (int)file_id);
       if (cmode != (int)H5F_ACC_EXCL || errno != EEXIST)
@@ -2418,6 +2472,32 @@ hdf_create(const char *path, int cmode, struct mi2opts *opts_ptr)
     return (file->fd);
 }
 
+/** Store the values of the image variable, when it is defined, in the
+ * file \a path instead, starting \a offset bytes in. If the first
+ * dimension of the image is the record dimension, records are \a stride
+ * bytes apart, otherwise \a stride is zero. The values must be stored
+ * big-endian, as in a netCDF classic file, and are read from there in
+ * place. The file must be created with MI2_CREATE_MEMORY and the image
+ * values must not be written.
+ */
+int
+hdf_set_external_image(int fd, const char *path, long long offset,
+                       long long stride)
+{
+    struct m2_file *file;
+
+    if ((file = hdf_id_check(fd)) == NULL) {
+        return (MI_ERROR);
+    }
+    free(file->ext_path);
+    if ((file->ext_path = strdup(path)) == NULL) {
+        return (MI_ERROR);
+    }
+    file->ext_offset = offset;
+    file->ext_stride = stride;
+    return (MI_NOERROR);
+}
+
 int
 hdf_close(int fd)
 {
@@ -2425,6 +2505,40 @@ hdf_close(int fd)
     return hdf_id_del(fd);      /* Delete it from the list. */
 }
 
+/** Close a file, returning its contents as a file image allocated with malloc.
+ * Used for files created with MI2_CREATE_MEMORY, which are lost on close.
+ */
+int
+hdf_close_image(int fd, void **image_ptr, size_t *size_ptr)
+{
+    struct m2_file *file;
+    ssize_t size;
+    void *image = NULL;
+
+    hdf_dim_commit(fd);         /* Make sure all dimensions were saved. */
+
+    if ((file = hdf_id_check(fd)) == NULL) {
+        return (MI_ERROR);
+    }
+
+    H5Fflush(file->file_id, H5F_SCOPE_LOCAL);
+    size = H5Fget_file_image(file->file_id, NULL, 0);
+    if (size > 0 && (image = malloc(size)) != NULL) {
+        if (H5Fget_file_image(file->file_id, image, size) != size) {
+            free(image);
+            image = NULL;
+        }
+    }
+    hdf_id_del(fd);
+
+    if (image == NULL) {
+        return (MI_ERROR);
+    }
+    *image_ptr = image;
+    *size_ptr = size;
+    return (MI_NOERROR);
+}
+
 /* 
  * Returns one (1) if the argument is the path name of an existing HDF5
  * file, or zero if the file does not exist or is not in the right format.
@@ -48,6 +48,9 @@ extern herr_t hdf_copy_attr(hid_t in_id, const char *attr_name, void *op_data);
 extern int hdf_open(const char *path, int mode);
 extern int hdf_create(const char *path, int mode, struct mi2opts *opts_ptr);
 extern int hdf_close(int fd);
+extern int hdf_close_image(int fd, void **image_ptr, size_t *size_ptr);
+extern int hdf_set_external_image(int fd, const char *path, long long offset,
+                                  long long stride);
 extern int hdf_access(const char *path);
 extern int hdf_flush(int fd);
 
@@ -28,6 +28,7 @@
                  MI_get_default_range
                  MI_icv_get_norm
                  MI_icv_access
+                 MI_icv_get_batched
                  MI_icv_zero_buffer
                  MI_icv_coords_tovar
                  MI_icv_calc_scale
@@ -180,6 +181,8 @@ PRIVATE double MI_get_default_range(char *what, nc_type datatype, int sign);
 PRIVATE int MI_icv_get_norm(mi_icv_type *icvp, int cdfid, int varid);
 PRIVATE int MI_icv_access(int operation, mi_icv_type *icvp, long start[], 
                           long count[], void *values);
+PRIVATE int MI_icv_get_batched(mi_icv_type *icvp, long var_start[],
+                               long var_count[], void *values);
 PRIVATE int MI_icv_zero_buffer(mi_icv_type *icvp, long count[], void *values);
 PRIVATE int MI_icv_coords_tovar(mi_icv_type *icvp, 
                                 long icv_start[], long icv_count[],
@@ -1334,7 +1337,8 @@ MNCAPI int miicv_put(int icvid, long start[], long count[], void *values)
 @GLOBALS    : 
 @CALLS      : NetCDF routines
 @CREATED    : August 11, 1992 (Peter Neelin)
-@MODIFIED   : 
+@MODIFIED   : October 16, 2026
+                 - batched reads for slice-normalized gets
 ---------------------------------------------------------------------------- */
 PRIVATE int MI_icv_access(int operation, mi_icv_type *icvp, long start[], 
                           long count[], void *values)
@@ -1389,6 +1393,13 @@ PRIVATE int MI_icv_access(int operation, mi_icv_type *icvp, long start[],
    else
       bufsize_step = NULL;
 
+   /* When normalizing slices on a plain get, read many slices at once and
+      scale them afterwards */
+   if ((operation==MI_PRIV_GET) && icvp->do_scale && 
+       !icvp->do_dimconvert && (icvp->derv_firstdim >= 0)) {
+      MI_RETURN(MI_icv_get_batched(icvp, var_start, var_count, values));
+   }
+
    /* Set up variables for looping through variable. The biggest chunk that
       we can get in one call is determined by the subscripts of MIimagemax
       and MIimagemin. These must be constant over the chunk that we get if
@@ -1457,6 +1468,127 @@ PRIVATE int MI_icv_access(int operation, mi_icv_type *icvp, long start[],
 }
 
 
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MI_icv_get_batched
+@INPUT      : icvp      - icv structure pointer
+              var_start - coordinates of start of hyperslab in variable
+              var_count - size of hyperslab in variable
+@OUTPUT     : values    - array of values to get
+@RETURNS    : MI_ERROR if an error occurs
+@DESCRIPTION: Gets values for MI_icv_access when the scale changes over
+              the hyperslab (MIimagemax and MIimagemin vary over dimension
+              derv_firstdim and slower) and no dimension conversion is
+              needed. Rather than reading one chunk of constant scale at 
+              a time, as many chunks as fit in MI_MAX_ICV_BATCH_SIZE are
+              read in the variable's own type with a single call, and each
+              chunk is then converted with its own scale and offset.
+@METHOD     : Batches run along dimension derv_firstdim, so that each one
+              is a hyperslab of the variable and a contiguous part of the
+              user's buffer.
+@GLOBALS    : 
+@CALLS      : MI_varaccess, MI_icv_calc_scale, MI_convert_type
+@CREATED    : October 16, 2026
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+PRIVATE int MI_icv_get_batched(mi_icv_type *icvp, long var_start[],
+                               long var_count[], void *values)
+{
+   long batch_start[MAX_VAR_DIMS];   /* Start of batch in variable */
+   long batch_count[MAX_VAR_DIMS];   /* Edge lengths of batch */
+   long chunk_start[MAX_VAR_DIMS];   /* Start of chunk of constant scale */
+   long var_end[MAX_VAR_DIMS];       /* Coordinates of last var element */
+   long chunk_nvalues;               /* Number of values in a chunk */
+   long max_chunks;                  /* Most chunks read in one call */
+   long ichunk;
+   size_t var_chunk_size, usr_chunk_size;
+   char *buffer;                     /* Values in variable type */
+   char *usr_values;                 /* Next values in user's buffer */
+   int firstdim;
+   int idim, ndims;
+   int status = MI_NOERROR;
+
+   MI_SAVE_ROUTINE_NAME("MI_icv_get_batched");
+
+   ndims = icvp->var_ndims;
+   firstdim = icvp->derv_firstdim;
+
+   /* Work out the size of a chunk of constant scale and how many of them
+      we read at once */
+   chunk_nvalues = 1;
+   for (idim=firstdim+1; idim < ndims; idim++)
+      chunk_nvalues *= var_count[idim];
+   var_chunk_size = (size_t) chunk_nvalues * icvp->var_typelen;
+   usr_chunk_size = (size_t) chunk_nvalues * nctypelen(icvp->user_type);
+   max_chunks = MI_MAX_ICV_BATCH_SIZE / MAX(var_chunk_size, 1);
+   max_chunks = MAX(1, MIN(max_chunks, var_count[firstdim]));
+
+   buffer = MALLOC(max_chunks * var_chunk_size, char);
+   if (buffer == NULL) {
+      MI_LOG_ERROR(MI_MSG_OUTOFMEM, max_chunks * var_chunk_size);
+      MI_RETURN(MI_ERROR);
+   }
+
+   for (idim=0; idim < ndims; idim++) {
+      batch_start[idim] = var_start[idim];
+      var_end[idim] = var_start[idim] + var_count[idim];
+      batch_count[idim] = (idim > firstdim) ? var_count[idim] : 1;
+   }
+
+   usr_values = (char *) values;
+   while ((status == MI_NOERROR) && (batch_start[0] < var_end[0])) {
+
+      /* Read the whole batch in the variable's type */
+      batch_count[firstdim] = MIN(max_chunks, 
+                                  var_end[firstdim] - batch_start[firstdim]);
+      if (MI_varaccess(MI_PRIV_GET, icvp->cdfid, icvp->varid,
+                       batch_start, batch_count,
+                       icvp->var_type, icvp->var_sign,
+                       buffer, NULL, NULL) < 0) {
+         status = MI_ERROR;
+         break;
+      }
+
+      /* Convert each chunk with its own scale */
+      for (idim=0; idim < ndims; idim++)
+         chunk_start[idim] = batch_start[idim];
+      for (ichunk=0; ichunk < batch_count[firstdim]; ichunk++) {
+         chunk_start[firstdim] = batch_start[firstdim] + ichunk;
+
+         /* As in MI_icv_access, the scale calculation can turn on 
+            fillvalue checking */
+         icvp->do_fillvalue = icvp->user_do_fillvalue;
+         icvp->fill_valid_min = icvp->var_vmin;
+         icvp->fill_valid_max = icvp->var_vmax;
+         if (icvp->do_scale) {
+            if (MI_icv_calc_scale(MI_PRIV_GET, icvp, chunk_start) < 0) {
+               status = MI_ERROR;
+               break;
+            }
+         }
+         if (MI_convert_type(chunk_nvalues, icvp->var_type, icvp->var_sign,
+                             buffer + ichunk * var_chunk_size,
+                             icvp->user_type, icvp->user_sign,
+                             usr_values, icvp) < 0) {
+            status = MI_ERROR;
+            break;
+         }
+         usr_values += usr_chunk_size;
+      }
+
+      /* Move on to the next batch */
+      batch_start[firstdim] += batch_count[firstdim];
+      for (idim=firstdim; 
+           (idim>0) && (batch_start[idim]>=var_end[idim]); idim--) {
+         batch_start[idim]=var_start[idim];
+         batch_start[idim-1]++;
+      }
+   }
+
+   FREE(buffer);
+
+   MI_RETURN(status);
+}
+
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : MI_icv_zero_buffer
 @INPUT      : icvp      - icv structure pointer
@@ -590,6 +590,8 @@ MNCAPI int milog_set_verbosity(int);
 
 /* from minc_format_convert.h*/
 MNCAPI int minc_format_convert(const char *input,const char *output);
+MNCAPI int minc_format_convert_image(const char *input,void **image_ptr,size_t *size_ptr);
+MNCAPI int minc_format_convert_header_image(const char *input,void **image_ptr,size_t *size_ptr);
 /* default voxel loop buffer size */
 #define MI2_DEF_BUFF_SIZE 4096
 #define MI2_DEF_MAX_MEM 104857
@@ -605,6 +607,7 @@ extern int miget_file_type(const char *filename);
 /* These must not interfere with any NC_ flags we might have to support. */
 #define MI2_CREATE_V2 0x10000    /* Force V2 format */
 #define MI2_CREATE_V1 0x20000    /* Force V1 format */
+#define MI2_CREATE_MEMORY 0x40000 /* Keep V2 file in memory only */
 
 /* Possible compression type values. */
 #define MI2_COMP_UNKNOWN (-1)
@@ -88,6 +88,10 @@
    related inefficiencies */
 #define MI_MAX_VAR_BUFFER_SIZE 1000000
 
+/* Maximum size of the variable buffer used to read several slices of a
+   normalized image in one call */
+#define MI_MAX_ICV_BATCH_SIZE (16 * MI_MAX_VAR_BUFFER_SIZE)
+
 /* Possible values for sign of a value */
 #define MI_PRIV_DEFSIGN   0
 #define MI_PRIV_SIGNED    1
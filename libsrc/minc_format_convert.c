@@ -21,6 +21,182 @@
 #include <stdio.h>
 #include <string.h>
 #include <minc.h>
+#include "hdf_convenience.h"
+
+/* Reads a big-endian integer of size bytes from a netCDF header */
+static int mi1_get_int(FILE *fp, int size, long long *value)
+{
+    unsigned char buf[8];
+    int i;
+
+    if (fread(buf, 1, size, fp) != (size_t) size) {
+        return MI_ERROR;
+    }
+    *value = 0;
+    for (i = 0; i < size; i++) {
+        *value = (*value << 8) | buf[i];
+    }
+    return MI_NOERROR;
+}
+
+/* Size of the values of a netCDF classic type, 0 if not a classic type */
+static int mi1_type_size(long long type)
+{
+    switch (type) {
+    case NC_BYTE:
+    case NC_CHAR:
+        return 1;
+    case NC_SHORT:
+        return 2;
+    case NC_INT:
+    case NC_FLOAT:
+        return 4;
+    case NC_DOUBLE:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+/* Reads a name from a netCDF header, padded to 4 bytes */
+static int mi1_get_name(FILE *fp, char *name)
+{
+    long long length;
+
+    if (mi1_get_int(fp, 4, &length) < 0 || length > NC_MAX_NAME ||
+        fread(name, 1, length, fp) != (size_t) length) {
+        return MI_ERROR;
+    }
+    name[length] = '\0';
+    return fseek(fp, (4 - length % 4) % 4, SEEK_CUR) == 0 ? MI_NOERROR : MI_ERROR;
+}
+
+/* Skips a list of attributes in a netCDF header */
+static int mi1_skip_atts(FILE *fp)
+{
+    char name[NC_MAX_NAME + 1];
+    long long tag, natts, type, nelems, i;
+
+    if (mi1_get_int(fp, 4, &tag) < 0 || mi1_get_int(fp, 4, &natts) < 0) {
+        return MI_ERROR;
+    }
+    for (i = 0; i < natts; i++) {
+        if (mi1_get_name(fp, name) < 0 ||
+            mi1_get_int(fp, 4, &type) < 0 || mi1_type_size(type) == 0 ||
+            mi1_get_int(fp, 4, &nelems) < 0) {
+            return MI_ERROR;
+        }
+        nelems *= mi1_type_size(type);
+        if (fseek(fp, (long) ((nelems + 3) & ~3LL), SEEK_CUR) != 0) {
+            return MI_ERROR;
+        }
+    }
+    return MI_NOERROR;
+}
+
+/* Finds where the values of variable varname start in the netCDF
+ * classic or 64-bit offset file path, reading only its header. For a
+ * record variable *stride_ptr is the distance from one record to the
+ * next, otherwise it is zero. Other formats are not handled.
+ */
+static int mi1_var_layout(const char *path, const char *varname,
+                          long long *offset_ptr, long long *stride_ptr)
+{
+    FILE *fp;
+    unsigned char magic[4];
+    char name[NC_MAX_NAME + 1];
+    long long dimlen[NC_MAX_DIMS];
+    long long value, tag, ndims, nvars, nvdims, dimid, type, varsize;
+    long long recsize = 0, lastsize = 0;
+    long long i, j;
+    int nrecvars = 0, recdim = -1;
+    int is_record, found = FALSE, found_record = FALSE;
+    int offset_size;
+    int status = MI_ERROR;
+
+    if ((fp = fopen(path, "rb")) == NULL) {
+        return MI_ERROR;
+    }
+
+    /* Classic (1) or 64-bit offset (2) format, not a streamed file */
+    if (fread(magic, 1, 4, fp) != 4 || memcmp(magic, "CDF", 3) != 0 ||
+        (magic[3] != 1 && magic[3] != 2)) {
+        goto cleanup;
+    }
+    offset_size = (magic[3] == 2) ? 8 : 4;
+    if (mi1_get_int(fp, 4, &value) < 0 || value == 0xFFFFFFFFLL) {
+        goto cleanup;
+    }
+
+    /* Dimensions, the record dimension has length 0 */
+    if (mi1_get_int(fp, 4, &tag) < 0 || mi1_get_int(fp, 4, &ndims) < 0 ||
+        ndims > NC_MAX_DIMS) {
+        goto cleanup;
+    }
+    for (i = 0; i < ndims; i++) {
+        if (mi1_get_name(fp, name) < 0 || mi1_get_int(fp, 4, &dimlen[i]) < 0) {
+            goto cleanup;
+        }
+        if (dimlen[i] == 0) {
+            recdim = (int) i;
+        }
+    }
+
+    /* Global attributes */
+    if (mi1_skip_atts(fp) < 0) {
+        goto cleanup;
+    }
+
+    /* Variables, records hold one value of every record variable, each
+       padded to 4 bytes unless it is the only one */
+    if (mi1_get_int(fp, 4, &tag) < 0 || mi1_get_int(fp, 4, &nvars) < 0) {
+        goto cleanup;
+    }
+    for (i = 0; i < nvars; i++) {
+        if (mi1_get_name(fp, name) < 0 || mi1_get_int(fp, 4, &nvdims) < 0) {
+            goto cleanup;
+        }
+        varsize = 1;
+        is_record = FALSE;
+        for (j = 0; j < nvdims; j++) {
+            if (mi1_get_int(fp, 4, &dimid) < 0 || dimid >= ndims) {
+                goto cleanup;
+            }
+            if (j == 0 && dimid == recdim) {
+                is_record = TRUE;
+            }
+            else {
+                varsize *= dimlen[dimid];
+            }
+        }
+        if (mi1_skip_atts(fp) < 0 ||
+            mi1_get_int(fp, 4, &type) < 0 || mi1_type_size(type) == 0 ||
+            mi1_get_int(fp, 4, &value) < 0 ||         /* vsize */
+            mi1_get_int(fp, offset_size, &value) < 0) { /* begin */
+            goto cleanup;
+        }
+        varsize *= mi1_type_size(type);
+        if (is_record) {
+            recsize += (varsize + 3) & ~3LL;
+            lastsize = varsize;
+            nrecvars++;
+        }
+        if (!strcmp(name, varname)) {
+            found = TRUE;
+            found_record = is_record;
+            *offset_ptr = value;
+        }
+    }
+
+    if (found) {
+        *stride_ptr = !found_record ? 0 : (nrecvars == 1) ? lastsize : recsize;
+        status = MI_NOERROR;
+    }
+
+cleanup:
+    fclose(fp);
+    return status;
+}
 
 
 static int micopy(int old_fd, int new_fd)
@@ -64,3 +240,95 @@ MNCAPI int minc_format_convert(const char *input,const char *output)
     
     return MI_NOERROR;
 }
+
+/* Convert a MINC1 file into a MINC2 file image held in memory, returned
+ * in *image_ptr (allocated with malloc), without touching the disk.
+ */
+MNCAPI int minc_format_convert_image(const char *input,void **image_ptr,size_t *size_ptr)
+{
+    int old_fd;
+    int new_fd;
+    struct mi2opts opts;
+
+    old_fd = miopen(input, NC_NOWRITE);
+    if (old_fd < 0) {
+        return MI_ERROR;
+    }
+
+    memset(&opts,0,sizeof(struct mi2opts));
+    opts.struct_version = MI2_OPTS_V1;
+
+    /* the name of a memory only file is never used on disk */
+    new_fd = micreatex(input, NC_CLOBBER|MI2_CREATE_V2|MI2_CREATE_MEMORY, &opts);
+    if (new_fd < 0) {
+        miclose(old_fd);
+        return MI_ERROR;
+    }
+
+    micopy(old_fd, new_fd);
+    miclose(old_fd);
+
+    return hdf_close_image(new_fd, image_ptr, size_ptr);
+}
+
+/* Convert the header of a MINC1 file into a MINC2 file image held in
+ * memory, returned in *image_ptr (allocated with malloc). The values of
+ * the image variable are not copied: the image dataset reads them in
+ * place from the MINC1 file, which must stay where it is while the image
+ * is in use. Only uncompressed netCDF classic and 64-bit offset files
+ * can be read this way.
+ */
+MNCAPI int minc_format_convert_header_image(const char *input,void **image_ptr,size_t *size_ptr)
+{
+    int old_fd;
+    int new_fd;
+    int imgid;
+    long long offset;
+    long long stride;
+    char *path;
+    struct mi2opts opts;
+
+    if (mi1_var_layout(input, MIimage, &offset, &stride) < 0) {
+        return MI_ERROR;
+    }
+
+    /* the MINC2 image refers to the MINC1 file from anywhere */
+#ifdef HAVE_REALPATH
+    path = realpath(input, NULL);
+#else
+    path = strdup(input);
+#endif
+    if (path == NULL) {
+        return MI_ERROR;
+    }
+
+    old_fd = miopen(input, NC_NOWRITE);
+    if (old_fd < 0) {
+        free(path);
+        return MI_ERROR;
+    }
+    imgid = ncvarid(old_fd, MIimage);
+
+    memset(&opts,0,sizeof(struct mi2opts));
+    opts.struct_version = MI2_OPTS_V1;
+
+    new_fd = micreatex(input, NC_CLOBBER|MI2_CREATE_V2|MI2_CREATE_MEMORY, &opts);
+    if (new_fd < 0 || imgid < 0 ||
+        hdf_set_external_image(new_fd, path, offset, stride) < 0) {
+        if (new_fd >= 0) {
+            miclose(new_fd);
+        }
+        miclose(old_fd);
+        free(path);
+        return MI_ERROR;
+    }
+    free(path);
+
+    /* Everything but the image values */
+    micopy_all_var_defs(old_fd, new_fd, 0, NULL);
+    ncendef(new_fd);
+    micopy_all_var_values(old_fd, new_fd, 1, &imgid);
+    miclose(old_fd);
+
+    return hdf_close_image(new_fd, image_ptr, size_ptr);
+}
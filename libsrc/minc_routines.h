@@ -95,5 +95,6 @@ extern int hdf_var_declare(int fd, char *varnm, char *varpath, int ndims,
 extern int hdf_create(const char *path, int cmode, struct mi2opts *opts_ptr);
 extern int hdf_open(const char *path, int mode);
 extern int hdf_close(int fd);
+extern int hdf_close_image(int fd, void **image_ptr, size_t *size_ptr);
 #endif /* MINC2 */
 #endif
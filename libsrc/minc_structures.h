@@ -190,6 +190,9 @@ typedef struct {
 /* Structure for passing values for MI_icv_dimconvert */
 typedef struct {
    int do_compress, do_expand;
+   int do_rows;                 /* Convert whole rows (no compress/expand) */
+   int do_resize;               /* Resize whole buffer by 2 or 4 */
+   int resize_scale;            /* Resize factor of the fastest dimension */
    long end[MAX_VAR_DIMS];
    long in_pix_num,     out_pix_num; /* Variables for compressing/expanding */
    long *in_pix_off,   *out_pix_off;
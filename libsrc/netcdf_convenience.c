@@ -1446,8 +1446,8 @@ MNCAPI int micopy_var_def(int incdfid, int invarid, int outcdfid)
       /* Otherwise create it */
       else {
          /* If the dimension is unlimited then try to create it unlimited
-            in the output file */
-         if (indim[i]==recdim) {
+            in the output file, MINC2 files have no unlimited dimension */
+         if ((indim[i]==recdim) && !MI2_ISH5OBJ(outcdfid)) {
             oldncopts=get_ncopts(); set_ncopts(0);
             outdim[i]=ncdimdef(outcdfid, dimname, NC_UNLIMITED);
             set_ncopts(oldncopts);
@@ -526,6 +526,207 @@ PRIVATE int MI_get_sign(nc_type datatype, int sign)
                                                   MI_PRIV_SIGNED );
 }
 
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MI_convert_kernel
+@INPUT      : number_of_values  - number of values to convert
+              invalues          - vector of values
+              scale, offset     - scaling applied to in-range values
+              dmin, dmax        - range of legal values (including epsilon)
+              fillvalue         - value stored for out-of-range input
+@OUTPUT     : outvalues         - output values
+@RETURNS    : (nothing)
+@DESCRIPTION: Type-specialized versions of the conversion loop in
+              MI_convert_type. There is one kernel for every pair of
+              (type, sign) and for every combination of scaling and
+              fillvalue checking, so that the element loop contains no
+              switch on type and can be vectorized by the compiler. The
+              arithmetic is exactly that of MI_TO_DOUBLE and
+              MI_FROM_DOUBLE.
+@METHOD     : Kernels are generated by the macros below; MI_convert_type
+              looks one up in MI_convert_kernels once per buffer.
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : October 16, 2026
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+typedef void (*MI_convert_kernel)(long number_of_values,
+                                  const void *invalues, void *outvalues,
+                                  double scale, double offset,
+                                  double dmin, double dmax, 
+                                  double fillvalue);
+
+/* Index of each (type, sign) pair in the kernel table */
+#define MI_KERNEL_UCHAR   0
+#define MI_KERNEL_SCHAR   1
+#define MI_KERNEL_USHORT  2
+#define MI_KERNEL_SSHORT  3
+#define MI_KERNEL_UINT    4
+#define MI_KERNEL_SINT    5
+#define MI_KERNEL_FLOAT   6
+#define MI_KERNEL_DOUBLE  7
+#define MI_KERNEL_NTYPES  8
+
+/* Kernel variants */
+#define MI_KERNEL_PLAIN      0
+#define MI_KERNEL_SCALE      1
+#define MI_KERNEL_FILL       2
+#define MI_KERNEL_FILL_SCALE 3
+#define MI_KERNEL_NVARIANTS  4
+
+/* Truncate dvalue and store it, as in MI_FROM_DOUBLE */
+#define MI_STORE_INTEGER(dvalue, ctype, minval, maxval, ptr) \
+   dvalue = MAX(minval, dvalue); \
+   dvalue = MIN(maxval, dvalue); \
+   *(ptr) = (ctype) ROUND(dvalue);
+
+#define MI_STORE_uchar(dvalue, ptr) \
+   MI_STORE_INTEGER(dvalue, unsigned char, 0, UCHAR_MAX, ptr)
+#define MI_STORE_schar(dvalue, ptr) \
+   MI_STORE_INTEGER(dvalue, signed char, SCHAR_MIN, SCHAR_MAX, ptr)
+#define MI_STORE_ushort(dvalue, ptr) \
+   MI_STORE_INTEGER(dvalue, unsigned short, 0, USHRT_MAX, ptr)
+#define MI_STORE_sshort(dvalue, ptr) \
+   MI_STORE_INTEGER(dvalue, signed short, SHRT_MIN, SHRT_MAX, ptr)
+#define MI_STORE_uint(dvalue, ptr) \
+   MI_STORE_INTEGER(dvalue, unsigned int, 0, UINT_MAX, ptr)
+#define MI_STORE_sint(dvalue, ptr) \
+   MI_STORE_INTEGER(dvalue, signed int, INT_MIN, INT_MAX, ptr)
+#define MI_STORE_float(dvalue, ptr) \
+   dvalue = MAX(-FLT_MAX, dvalue); \
+   *(ptr) = MIN(FLT_MAX, dvalue);
+#define MI_STORE_double(dvalue, ptr) \
+   *(ptr) = dvalue;
+
+/* Define the four kernel variants for one input and one output type */
+#define MI_DEFINE_KERNELS(inname, intype, outname, outtype) \
+PRIVATE void MI_convert_##inname##_##outname(long number_of_values, \
+   const void *invalues, void *outvalues, double scale, double offset, \
+   double dmin, double dmax, double fillvalue) \
+{ \
+   const intype *inptr = (const intype *) invalues; \
+   outtype *outptr = (outtype *) outvalues; \
+   double dvalue; \
+   long i; \
+   (void) scale; (void) offset; (void) dmin; (void) dmax; (void) fillvalue; \
+   for (i=0; i<number_of_values; i++) { \
+      dvalue = (double) inptr[i]; \
+      MI_STORE_##outname(dvalue, &outptr[i]) \
+   } \
+} \
+PRIVATE void MI_convert_##inname##_##outname##_scale(long number_of_values, \
+   const void *invalues, void *outvalues, double scale, double offset, \
+   double dmin, double dmax, double fillvalue) \
+{ \
+   const intype *inptr = (const intype *) invalues; \
+   outtype *outptr = (outtype *) outvalues; \
+   double dvalue; \
+   long i; \
+   (void) dmin; (void) dmax; (void) fillvalue; \
+   for (i=0; i<number_of_values; i++) { \
+      dvalue = scale * (double) inptr[i] + offset; \
+      MI_STORE_##outname(dvalue, &outptr[i]) \
+   } \
+} \
+PRIVATE void MI_convert_##inname##_##outname##_fill(long number_of_values, \
+   const void *invalues, void *outvalues, double scale, double offset, \
+   double dmin, double dmax, double fillvalue) \
+{ \
+   const intype *inptr = (const intype *) invalues; \
+   outtype *outptr = (outtype *) outvalues; \
+   double dvalue; \
+   long i; \
+   (void) scale; (void) offset; \
+   for (i=0; i<number_of_values; i++) { \
+      dvalue = (double) inptr[i]; \
+      if ((dvalue < dmin) || (dvalue > dmax)) dvalue = fillvalue; \
+      MI_STORE_##outname(dvalue, &outptr[i]) \
+   } \
+} \
+PRIVATE void MI_convert_##inname##_##outname##_fill_scale( \
+   long number_of_values, \
+   const void *invalues, void *outvalues, double scale, double offset, \
+   double dmin, double dmax, double fillvalue) \
+{ \
+   const intype *inptr = (const intype *) invalues; \
+   outtype *outptr = (outtype *) outvalues; \
+   double dvalue; \
+   long i; \
+   for (i=0; i<number_of_values; i++) { \
+      dvalue = (double) inptr[i]; \
+      if ((dvalue < dmin) || (dvalue > dmax)) dvalue = fillvalue; \
+      else dvalue = scale * dvalue + offset; \
+      MI_STORE_##outname(dvalue, &outptr[i]) \
+   } \
+}
+
+/* Apply X to an input type and every output type, in table order */
+#define MI_FOR_EACH_OUTTYPE(X, inname, intype) \
+   X(inname, intype, uchar,  unsigned char) \
+   X(inname, intype, schar,  signed char) \
+   X(inname, intype, ushort, unsigned short) \
+   X(inname, intype, sshort, signed short) \
+   X(inname, intype, uint,   unsigned int) \
+   X(inname, intype, sint,   signed int) \
+   X(inname, intype, float,  float) \
+   X(inname, intype, double, double)
+
+/* Apply X to every pair of input and output types, in table order */
+#define MI_FOR_EACH_TYPE_PAIR(X) \
+   MI_FOR_EACH_OUTTYPE(X, uchar,  unsigned char) \
+   MI_FOR_EACH_OUTTYPE(X, schar,  signed char) \
+   MI_FOR_EACH_OUTTYPE(X, ushort, unsigned short) \
+   MI_FOR_EACH_OUTTYPE(X, sshort, signed short) \
+   MI_FOR_EACH_OUTTYPE(X, uint,   unsigned int) \
+   MI_FOR_EACH_OUTTYPE(X, sint,   signed int) \
+   MI_FOR_EACH_OUTTYPE(X, float,  float) \
+   MI_FOR_EACH_OUTTYPE(X, double, double)
+
+MI_FOR_EACH_TYPE_PAIR(MI_DEFINE_KERNELS)
+
+#define MI_KERNEL_ENTRY(inname, intype, outname, outtype) \
+   { MI_convert_##inname##_##outname, \
+     MI_convert_##inname##_##outname##_scale, \
+     MI_convert_##inname##_##outname##_fill, \
+     MI_convert_##inname##_##outname##_fill_scale },
+
+/* Kernels indexed by [input type][output type][variant] */
+PRIVATE const MI_convert_kernel 
+MI_convert_kernels[MI_KERNEL_NTYPES * MI_KERNEL_NTYPES][MI_KERNEL_NVARIANTS] = {
+   MI_FOR_EACH_TYPE_PAIR(MI_KERNEL_ENTRY)
+};
+
+/* ----------------------------- MNI Header -----------------------------------
+@NAME       : MI_get_kernel_index
+@INPUT      : datatype - netcdf type
+              sign     - MI_PRIV_SIGNED or MI_PRIV_UNSIGNED
+@OUTPUT     : (none)
+@RETURNS    : index of the type in MI_convert_kernels, or -1 if there is
+              no kernel for this type.
+@DESCRIPTION: Maps a type and sign to a row or column of the kernel table.
+@METHOD     : 
+@GLOBALS    : 
+@CALLS      : 
+@CREATED    : October 16, 2026
+@MODIFIED   : 
+---------------------------------------------------------------------------- */
+PRIVATE int MI_get_kernel_index(nc_type datatype, int sign)
+{
+   switch (datatype) {
+   case NC_BYTE:
+      return (sign==MI_PRIV_UNSIGNED) ? MI_KERNEL_UCHAR : MI_KERNEL_SCHAR;
+   case NC_SHORT:
+      return (sign==MI_PRIV_UNSIGNED) ? MI_KERNEL_USHORT : MI_KERNEL_SSHORT;
+   case NC_INT:
+      return (sign==MI_PRIV_UNSIGNED) ? MI_KERNEL_UINT : MI_KERNEL_SINT;
+   case NC_FLOAT:
+      return MI_KERNEL_FLOAT;
+   case NC_DOUBLE:
+      return MI_KERNEL_DOUBLE;
+   default:
+      return -1;
+   }
+}
+
 /* ----------------------------- MNI Header -----------------------------------
 @NAME       : MI_convert_type
 @INPUT      : number_of_values  - number of values to copy
@@ -557,12 +758,16 @@ PRIVATE int MI_get_sign(nc_type datatype, int sign)
               Note that if a conversion must take place, then all input 
               values are converted to double. Values can be scaled through
               icvp->scale and icvp->offset by setting icvp->do_scale to TRUE.
-@METHOD     : 
+@METHOD     : The conversion is done by a type-specialized kernel chosen
+              once per call; the generic per-element loop is only used
+              for types without a kernel.
 @GLOBALS    : 
 @CALLS      : 
 @CREATED    : July 27, 1992 (Peter Neelin)
 @MODIFIED   : August 28, 1992 (P.N.)
                  - replaced type conversions with macros
+              October 16, 2026
+                 - use type-specialized kernels
 ---------------------------------------------------------------------------- */
 SEMIPRIVATE int MI_convert_type(long number_of_values,
                                 nc_type intype,  int insign,  void *invalues,
@@ -579,6 +784,8 @@ SEMIPRIVATE int MI_convert_type(long number_of_values,
    double fillvalue;       /* Value to fill with */
    double dmax, dmin;      /* Range of legal values */
    double epsilon;         /* Epsilon for legal values comparisons */
+   int inindex, outindex;  /* Kernel table indices for input and output */
+   int variant;            /* Kernel variant */
 
    MI_SAVE_ROUTINE_NAME("MI_convert_type");
 
@@ -622,6 +829,20 @@ SEMIPRIVATE int MI_convert_type(long number_of_values,
                        (size_t) number_of_values*inincr);
    }
    
+   /* Otherwise use the specialized kernel for these types, once for
+      the whole buffer */
+   else if (((inindex =MI_get_kernel_index(intype,  insgn ))>=0) &&
+            ((outindex=MI_get_kernel_index(outtype, outsgn))>=0)) {
+      if (do_fillvalue)
+         variant = do_scale ? MI_KERNEL_FILL_SCALE : MI_KERNEL_FILL;
+      else
+         variant = do_scale ? MI_KERNEL_SCALE : MI_KERNEL_PLAIN;
+      MI_convert_kernels[inindex * MI_KERNEL_NTYPES + outindex][variant]
+         (number_of_values, invalues, outvalues,
+          do_scale ? icvp->scale : 1.0, do_scale ? icvp->offset : 0.0,
+          dmin, dmax, fillvalue);
+   }
+
    /* Otherwise, loop through */
    else {
 
@@ -98,6 +98,10 @@ int miconvert_voxel_to_real(mihandle_t volume,
     double voxel_range, voxel_offset;
     double real_range, real_offset;
 
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
+
     if( volume->volume_type==MI_TYPE_FLOAT    || volume->volume_type==MI_TYPE_DOUBLE ||
       volume->volume_type==MI_TYPE_FCOMPLEX || volume->volume_type==MI_TYPE_DCOMPLEX ){
       // If floating values voxel_value is the real value
@@ -525,6 +529,10 @@ int miget_volume_real_range(mihandle_t volume, double real_range[])
     double *buffer;
     int i;
 
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
+
     /* First find the real minimum.
      */
     spc_id = H5Dget_space(volume->imin_id);
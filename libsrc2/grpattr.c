@@ -6,6 +6,8 @@
  * Functions to manipulate attributes and groups.
  ************************************************************************/
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <hdf5.h>
 
 #ifdef HAVE_CONFIG_H
@@ -35,11 +37,10 @@ struct milistdata {
 
 static void
 full_path_for_attr(char *fullpath, int length, const char *path,
-                   const char *name, mihandle_t vol)
+                   const char *name, int resolution)
 {
   if (!strcmp(path, MIimage)) {
-    snprintf(fullpath, length, MI_ROOT_PATH "/image/%d",
-             vol->selected_resolution);
+    snprintf(fullpath, length, MI_ROOT_PATH "/image/%d", resolution);
   }
   else {
     if ( (!strcmp(name, "history") ||
@@ -411,7 +412,7 @@ int midelete_attr ( mihandle_t vol, const char *path, const char *name )
     return ( MI_ERROR );
   }
 
-  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol);
+  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol->selected_resolution);
 
   /* Search through the path, descending into each group encountered.
    */
@@ -511,7 +512,7 @@ int miget_attr_length ( mihandle_t vol, const char *path, const char *name,
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"HDF file is not open");
   }
 
-  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol);
+  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol->selected_resolution);
 
   /* Search through the path, descending into each group encountered.
    */
@@ -599,7 +600,7 @@ int miget_attr_type ( mihandle_t vol, const char *path, const char *name,
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"HDF file is not open");
   }
 
-  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol);
+  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol->selected_resolution);
 
   /* Search through the path, descending into each group encountered.
    */
@@ -657,97 +658,606 @@ cleanup:
   return status;
 }
 
-/** Copy all attribute given a path
+/* Metadata snapshot: every group and dataset under MI_ROOT_PATH with the
+ * values of all of its attributes, read in one pass over the file.
+ * Nodes are sorted by path and attributes by name, so both are found
+ * with a binary search.
  */
-int micopy_attr ( mihandle_t vol, const char *path, mihandle_t new_vol )
+struct mimetaattr {
+  char *name;
+  mitype_t data_type;
+  size_t length;              /* Number of values, or string length */
+  void *values;               /* Strings are null-terminated */
+};
+
+struct mimetanode {
+  char *path;                 /* Absolute HDF5 path */
+  int attr_count;
+  int attr_alloc;
+  struct mimetaattr *attrs;
+};
+
+struct mimetadata {
+  int resolution;             /* Selected resolution, for MIimage paths */
+  int node_count;
+  int node_alloc;
+  struct mimetanode *nodes;
+};
+
+static int mimeta_compare_node ( const void *a, const void *b )
+{
+  return strcmp ( ( ( const struct mimetanode * ) a )->path,
+                  ( ( const struct mimetanode * ) b )->path );
+}
+
+static int mimeta_compare_attr ( const void *a, const void *b )
+{
+  return strcmp ( ( ( const struct mimetaattr * ) a )->name,
+                  ( ( const struct mimetaattr * ) b )->name );
+}
+
+static struct mimetanode *mimeta_add_node ( struct mimetadata *md,
+                                            const char *path )
+{
+  struct mimetanode *node;
+
+  if ( md->node_count == md->node_alloc ) {
+    int n = md->node_alloc ? md->node_alloc * 2 : 32;
+    node = realloc ( md->nodes, n * sizeof ( struct mimetanode ) );
+
+    if ( node == NULL ) {
+      return ( NULL );
+    }
+    md->nodes = node;
+    md->node_alloc = n;
+  }
+  node = &md->nodes[md->node_count];
+  memset ( node, 0, sizeof ( *node ) );
+
+  if ( ( node->path = strdup ( path ) ) == NULL ) {
+    return ( NULL );
+  }
+  md->node_count++;
+  return ( node );
+}
+
+/* Read one attribute into the node, with the value types used by
+ * miget_attr_type(). Attributes of other classes are skipped.
+ */
+static herr_t mimeta_attr_op ( hid_t loc_id, const char *name,
+                               const H5A_info_t *ainfo, void *op_data )
+{
+  struct mimetanode *node = ( struct mimetanode * ) op_data;
+  struct mimetaattr *attr;
+  hid_t attr_id;
+  hid_t type_id = -1;
+  hid_t spc_id = -1;
+  hid_t mtyp_id = -1;
+  hssize_t npoints;
+  size_t elsize = 0;
+  herr_t status = -1;
+  (void)ainfo;
+
+  if ( ( attr_id = H5Aopen ( loc_id, name, H5P_DEFAULT ) ) < 0 ) {
+    return ( -1 );
+  }
+  if ( node->attr_count == node->attr_alloc ) {
+    int n = node->attr_alloc ? node->attr_alloc * 2 : 8;
+    attr = realloc ( node->attrs, n * sizeof ( struct mimetaattr ) );
+
+    if ( attr == NULL ) {
+      goto cleanup;
+    }
+    node->attrs = attr;
+    node->attr_alloc = n;
+  }
+  attr = &node->attrs[node->attr_count];
+  memset ( attr, 0, sizeof ( *attr ) );
+
+  type_id = H5Aget_type ( attr_id );
+  spc_id = H5Aget_space ( attr_id );
+  npoints = H5Sget_simple_extent_npoints ( spc_id );
+
+  if ( type_id < 0 || npoints < 0 ) {
+    goto cleanup;
+  }
+
+  switch ( H5Tget_class ( type_id ) ) {
+  case H5T_STRING:
+    if ( H5Tis_variable_str ( type_id ) > 0 ) {
+      status = 0;             /* Not written by MINC, skip it */
+      goto cleanup;
+    }
+    attr->data_type = MI_TYPE_STRING;
+    attr->length = H5Tget_size ( type_id );
+    mtyp_id = H5Tcopy ( H5T_C_S1 );
+    H5Tset_size ( mtyp_id, attr->length );
+    elsize = attr->length;      /* per element, all of them are read */
+    break;
+  case H5T_INTEGER:
+    attr->data_type = MI_TYPE_INT;
+    mtyp_id = H5Tcopy ( H5T_NATIVE_INT );
+    elsize = sizeof ( int );
+    break;
+  case H5T_FLOAT:
+    if ( H5Tget_size ( type_id ) == sizeof ( float ) ) {
+      attr->data_type = MI_TYPE_FLOAT;
+      mtyp_id = H5Tcopy ( H5T_NATIVE_FLOAT );
+      elsize = sizeof ( float );
+    } else {
+      attr->data_type = MI_TYPE_DOUBLE;
+      mtyp_id = H5Tcopy ( H5T_NATIVE_DOUBLE );
+      elsize = sizeof ( double );
+    }
+    break;
+  default:
+    status = 0;
+    goto cleanup;
+  }
+  if ( attr->data_type != MI_TYPE_STRING ) {
+    attr->length = ( size_t ) npoints;
+  }
+
+  /* One extra byte keeps strings null-terminated */
+  attr->values = malloc ( elsize * npoints + 1 );
+  attr->name = strdup ( name );
+
+  if ( attr->values == NULL || attr->name == NULL ||
+       H5Aread ( attr_id, mtyp_id, attr->values ) < 0 ) {
+    free ( attr->values );
+    free ( attr->name );
+    goto cleanup;
+  }
+  ( ( char * ) attr->values ) [elsize * npoints] = '\0';
+  node->attr_count++;
+  status = 0;
+
+cleanup:
+  if ( mtyp_id >= 0 ) H5Tclose ( mtyp_id );
+  if ( spc_id >= 0 ) H5Sclose ( spc_id );
+  if ( type_id >= 0 ) H5Tclose ( type_id );
+  H5Aclose ( attr_id );
+  return ( status );
+}
+
+struct mimetawalk {
+  struct mimetadata *md;
+  const char *path;
+};
+
+/* The link and object info calls changed signature in HDF5 1.12 */
+#if H5_VERSION_GE(1,12,0)
+typedef H5L_info2_t mimeta_link_info_t;
+typedef H5O_info2_t mimeta_obj_info_t;
+#define mimeta_get_info(id, info) H5Oget_info3 ( id, info, H5O_INFO_BASIC )
+#define mimeta_iterate H5Literate2
+#else
+typedef H5L_info_t mimeta_link_info_t;
+typedef H5O_info_t mimeta_obj_info_t;
+#define mimeta_get_info(id, info) H5Oget_info ( id, info )
+#define mimeta_iterate H5Literate
+#endif
+
+static int mimeta_visit ( struct mimetadata *md, hid_t loc_id,
+                          const char *path, H5O_type_t type );
+
+static herr_t mimeta_link_op ( hid_t grp_id, const char *name,
+                               const mimeta_link_info_t *linfo, void *op_data )
+{
+  struct mimetawalk *walk = ( struct mimetawalk * ) op_data;
+  char path[MI2_MAX_PATH * 2];
+  mimeta_obj_info_t oinfo;
+  hid_t obj_id;
+  int r = 0;
+
+  if ( linfo->type != H5L_TYPE_HARD ) {
+    return ( 0 );
+  }
+  snprintf ( path, sizeof ( path ), "%s/%s", walk->path, name );
+
+  if ( ( obj_id = H5Oopen ( grp_id, name, H5P_DEFAULT ) ) < 0 ) {
+    return ( -1 );
+  }
+  if ( mimeta_get_info ( obj_id, &oinfo ) >= 0 &&
+       ( oinfo.type == H5O_TYPE_GROUP || oinfo.type == H5O_TYPE_DATASET ) ) {
+    r = mimeta_visit ( walk->md, obj_id, path, oinfo.type );
+  }
+  H5Oclose ( obj_id );
+  return ( r < 0 ? -1 : 0 );
+}
+
+static int mimeta_visit ( struct mimetadata *md, hid_t loc_id,
+                          const char *path, H5O_type_t type )
+{
+  struct mimetanode *node;
+  struct mimetawalk walk;
+  int index;
+
+  if ( ( node = mimeta_add_node ( md, path ) ) == NULL ) {
+    return ( MI_ERROR );
+  }
+  index = md->node_count - 1;
+
+  if ( H5Aiterate2 ( loc_id, H5_INDEX_NAME, H5_ITER_INC, NULL,
+                     mimeta_attr_op, node ) < 0 ) {
+    return ( MI_ERROR );
+  }
+  node = &md->nodes[index];
+  qsort ( node->attrs, node->attr_count, sizeof ( struct mimetaattr ),
+          mimeta_compare_attr );
+
+  if ( type == H5O_TYPE_GROUP ) {
+    walk.md = md;
+    walk.path = md->nodes[index].path;
+    /* The node array may move while the children are added */
+    if ( mimeta_iterate ( loc_id, H5_INDEX_NAME, H5_ITER_INC, NULL,
+                          mimeta_link_op, &walk ) < 0 ) {
+      return ( MI_ERROR );
+    }
+  }
+  return ( MI_NOERROR );
+}
+
+static struct mimetanode *mimeta_find_node ( mimetadata_t metadata,
+                                             const char *path )
+{
+  struct mimetanode key;
+
+  key.path = ( char * ) path;
+  return bsearch ( &key, metadata->nodes, metadata->node_count,
+                   sizeof ( struct mimetanode ), mimeta_compare_node );
+}
+
+/* Snapshot the group or dataset at the absolute path \a root and
+ * everything below it.
+ */
+static int mimeta_load ( mihandle_t vol, const char *root,
+                         struct mimetadata **metadata )
+{
+  struct mimetadata *md;
+  mimeta_obj_info_t oinfo;
+  hid_t loc_id;
+  int r = MI_ERROR;
+
+  if ( ( md = calloc ( 1, sizeof ( struct mimetadata ) ) ) == NULL ) {
+    return MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)sizeof ( struct mimetadata ));
+  }
+  md->resolution = vol->selected_resolution;
+
+  if ( ( loc_id = midescend_path ( vol->hdf_id, root ) ) >= 0 ) {
+    if ( mimeta_get_info ( loc_id, &oinfo ) >= 0 ) {
+      r = mimeta_visit ( md, loc_id, root, oinfo.type );
+    }
+    if ( H5Iget_type ( loc_id ) == H5I_GROUP ) {
+      H5Gclose ( loc_id );
+    } else {
+      H5Dclose ( loc_id );
+    }
+  }
+  if ( r < 0 ) {
+    mifree_metadata ( md );
+    return ( MI_ERROR );
+  }
+  qsort ( md->nodes, md->node_count, sizeof ( struct mimetanode ),
+          mimeta_compare_node );
+  *metadata = md;
+  return ( MI_NOERROR );
+}
+
+/** Read every group, dataset and attribute under the MINC root in one
+ * pass over the file.
+ */
+int miget_metadata ( mihandle_t vol, mimetadata_t *metadata )
+{
+  if ( vol == NULL || metadata == NULL ) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to get metadata with null volume or variable");
+  }
+  if ( vol->hdf_id < 0 ) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"HDF file is not open");
+  }
+  if ( mimeta_load ( vol, MI_ROOT_PATH, metadata ) < 0 ) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Can't read metadata");
+  }
+  return ( MI_NOERROR );
+}
+
+/** Free a metadata snapshot.
+ */
+int mifree_metadata ( mimetadata_t metadata )
 {
-  milisthandle_t hlist = NULL;
-  mitype_t data_type = MI_TYPE_UNKNOWN;
-  char namebuf[256];
-  char pathbuf[256];
-  char valstr[128];
+  int i, j;
+
+  if ( metadata == NULL ) {
+    return ( MI_ERROR );
+  }
+  for ( i = 0; i < metadata->node_count; i++ ) {
+    struct mimetanode *node = &metadata->nodes[i];
+
+    for ( j = 0; j < node->attr_count; j++ ) {
+      free ( node->attrs[j].name );
+      free ( node->attrs[j].values );
+    }
+    free ( node->attrs );
+    free ( node->path );
+  }
+  free ( metadata->nodes );
+  free ( metadata );
+  return ( MI_NOERROR );
+}
+
+/** Find an attribute in a metadata snapshot. \a path is either an absolute
+ * HDF5 path or a path in the form accepted by miget_attr_values().
+ */
+int miget_metadata_attr ( mimetadata_t metadata, const char *path,
+                          const char *name, mitype_t *data_type,
+                          size_t *length, const void **values )
+{
+  char fullpath[256];
+  struct mimetanode *node;
+  struct mimetaattr key, *attr;
+
+  if ( metadata == NULL || path == NULL || name == NULL ) {
+    return ( MI_ERROR );
+  }
+  if ( !strncmp ( path, MI_ROOT_PATH, strlen ( MI_ROOT_PATH ) ) ) {
+    strncpy ( fullpath, path, sizeof ( fullpath ) - 1 );
+    fullpath[sizeof ( fullpath ) - 1] = '\0';
+  } else {
+    full_path_for_attr ( fullpath, sizeof ( fullpath ), path, name,
+                         metadata->resolution );
+  }
+  if ( ( node = mimeta_find_node ( metadata, fullpath ) ) == NULL ) {
+    return ( MI_ERROR );
+  }
+  key.name = ( char * ) name;
+  attr = bsearch ( &key, node->attrs, node->attr_count,
+                   sizeof ( struct mimetaattr ), mimeta_compare_attr );
+
+  if ( attr == NULL ) {
+    return ( MI_ERROR );
+  }
+  if ( data_type != NULL ) *data_type = attr->data_type;
+  if ( length != NULL ) *length = attr->length;
+  if ( values != NULL ) *values = attr->values;
+  return ( MI_NOERROR );
+}
+
+/** Number of groups and datasets in a metadata snapshot.
+ */
+int miget_metadata_group_count ( mimetadata_t metadata, int *count )
+{
+  if ( metadata == NULL || count == NULL ) {
+    return ( MI_ERROR );
+  }
+  *count = metadata->node_count;
+  return ( MI_NOERROR );
+}
+
+/** Absolute path and number of attributes of a group or dataset in a
+ * metadata snapshot. Groups are sorted by path.
+ */
+int miget_metadata_group ( mimetadata_t metadata, int index,
+                           const char **path, int *attr_count )
+{
+  if ( metadata == NULL || index < 0 || index >= metadata->node_count ) {
+    return ( MI_ERROR );
+  }
+  if ( path != NULL ) *path = metadata->nodes[index].path;
+  if ( attr_count != NULL ) *attr_count = metadata->nodes[index].attr_count;
+  return ( MI_NOERROR );
+}
+
+/** Attribute \a index of group \a group in a metadata snapshot. Attributes
+ * are sorted by name.
+ */
+int miget_metadata_attr_by_index ( mimetadata_t metadata, int group,
+                                   int index, const char **name,
+                                   mitype_t *data_type, size_t *length,
+                                   const void **values )
+{
+  struct mimetaattr *attr;
+
+  if ( metadata == NULL || group < 0 || group >= metadata->node_count ||
+       index < 0 || index >= metadata->nodes[group].attr_count ) {
+    return ( MI_ERROR );
+  }
+  attr = &metadata->nodes[group].attrs[index];
+
+  if ( name != NULL ) *name = attr->name;
+  if ( data_type != NULL ) *data_type = attr->data_type;
+  if ( length != NULL ) *length = attr->length;
+  if ( values != NULL ) *values = attr->values;
+  return ( MI_NOERROR );
+}
+
+struct mijson {
+  char *buf;
+  size_t len;
+  size_t alloc;
+};
+
+static int mijson_put ( struct mijson *js, const char *str, size_t n )
+{
+  if ( js->len + n + 1 > js->alloc ) {
+    size_t alloc = js->alloc ? js->alloc : 4096;
+    char *buf;
+
+    while ( js->len + n + 1 > alloc ) {
+      alloc *= 2;
+    }
+    if ( ( buf = realloc ( js->buf, alloc ) ) == NULL ) {
+      return ( MI_ERROR );
+    }
+    js->buf = buf;
+    js->alloc = alloc;
+  }
+  memcpy ( js->buf + js->len, str, n );
+  js->len += n;
+  js->buf[js->len] = '\0';
+  return ( MI_NOERROR );
+}
+
+static int mijson_string ( struct mijson *js, const char *str, size_t n )
+{
+  char esc[8];
+  size_t i;
+  int r = mijson_put ( js, "\"", 1 );
+
+  for ( i = 0; i < n && str[i] != '\0'; i++ ) {
+    unsigned char c = ( unsigned char ) str[i];
+
+    if ( c == '"' || c == '\\' ) {
+      esc[0] = '\\';
+      esc[1] = ( char ) c;
+      r |= mijson_put ( js, esc, 2 );
+    } else if ( c == '\n' ) {
+      r |= mijson_put ( js, "\\n", 2 );
+    } else if ( c == '\t' ) {
+      r |= mijson_put ( js, "\\t", 2 );
+    } else if ( c < 0x20 ) {
+      snprintf ( esc, sizeof ( esc ), "\\u%04x", c );
+      r |= mijson_put ( js, esc, 6 );
+    } else {
+      r |= mijson_put ( js, str + i, 1 );
+    }
+  }
+  return r | mijson_put ( js, "\"", 1 );
+}
+
+static int mijson_number ( struct mijson *js, double value )
+{
+  char num[32];
+
+  /* JSON has no representation for NaN or infinity */
+  if ( value != value || value - value != 0.0 ) {
+    return mijson_put ( js, "null", 4 );
+  }
+  snprintf ( num, sizeof ( num ), "%.17g", value );
+  return mijson_put ( js, num, strlen ( num ) );
+}
+
+/** Serialize a metadata snapshot as a JSON object, with one member per
+ * group or dataset path holding an object of its attributes. Strings
+ * become JSON strings, single numbers become numbers and vectors become
+ * arrays. The string returned must be freed with mifree_name().
+ */
+int miget_metadata_json ( mimetadata_t metadata, char **json )
+{
+  struct mijson js = {NULL, 0, 0};
+  int i, j;
+  size_t k;
   int r;
-  size_t length;
-
-  /*TODO: make sure path size does not exceed 256 somehow*/
-  r = milist_start ( vol, path, 1, &hlist );
-
-  if ( r == MI_NOERROR ) {
-    while ( milist_attr_next ( vol, hlist, pathbuf, sizeof ( pathbuf ),
-                               namebuf, sizeof ( namebuf ) ) == MI_NOERROR ) {
-      /*TODO: Add error checking here*/
-      miget_attr_type ( vol, pathbuf, namebuf, &data_type );
-      miget_attr_length ( vol, pathbuf, namebuf, &length );
-    
-      switch ( data_type ) {
-
-      case MI_TYPE_STRING:
-        if(length<sizeof(valstr))
-        {
-          miget_attr_values ( vol, MI_TYPE_STRING, pathbuf, namebuf, length, valstr );
-          miset_attr_values ( new_vol, MI_TYPE_STRING, pathbuf, namebuf, length, valstr );
-        } else {
-          char *tmp_str=malloc(length+1); /*make sure we have space for terminating zero*/
-          miget_attr_values ( vol, MI_TYPE_STRING, pathbuf, namebuf, length+1, tmp_str );
-          miset_attr_values ( new_vol, MI_TYPE_STRING, pathbuf, namebuf, length+1, tmp_str );
-          free(tmp_str);
-        }
-        break;
-
-      case MI_TYPE_FLOAT:
-        if(length==1)
-        {
-          float valflt;
-          miget_attr_values ( vol, MI_TYPE_FLOAT, pathbuf, namebuf, 1, &valflt );
-          miset_attr_values ( new_vol, MI_TYPE_FLOAT, pathbuf, namebuf, 1, &valflt );
-        } else {
-          float *tmp=malloc(length*sizeof(float));
-          miget_attr_values ( vol, MI_TYPE_FLOAT, pathbuf, namebuf, length, tmp );
-          miset_attr_values ( new_vol, MI_TYPE_FLOAT, pathbuf, namebuf, length, tmp );
-          free(tmp);
-        }
-        break;
-        
-      case MI_TYPE_DOUBLE:
-        if(length==1)
-        {
-          float valdbl;
-          miget_attr_values ( vol, MI_TYPE_DOUBLE, pathbuf, namebuf, 1, &valdbl );
-          miset_attr_values ( new_vol, MI_TYPE_DOUBLE, pathbuf, namebuf, 1, &valdbl );
-        } else {
-          double *tmp=malloc(length*sizeof(double));
-          miget_attr_values ( vol, MI_TYPE_DOUBLE, pathbuf, namebuf, length, tmp );
-          miset_attr_values ( new_vol, MI_TYPE_DOUBLE, pathbuf, namebuf, length, tmp );
-          free(tmp);
-        }
-        break;
-
-      case MI_TYPE_INT:
-        if(length==1)
-        {
-          long  vallng;
-          miget_attr_values ( vol, MI_TYPE_INT, pathbuf, namebuf, 1, &vallng );
-          miset_attr_values ( new_vol, MI_TYPE_INT, pathbuf, namebuf, 1, &vallng );
-        } else {
-          long *tmp=malloc(length*sizeof(long));
-          miget_attr_values ( vol, MI_TYPE_INT, pathbuf, namebuf, length, tmp );
-          miset_attr_values ( new_vol, MI_TYPE_INT, pathbuf, namebuf, length, tmp );
-          free(tmp);
+
+  if ( metadata == NULL || json == NULL ) {
+    return ( MI_ERROR );
+  }
+  r = mijson_put ( &js, "{", 1 );
+
+  for ( i = 0; i < metadata->node_count; i++ ) {
+    struct mimetanode *node = &metadata->nodes[i];
+
+    if ( i > 0 ) r |= mijson_put ( &js, ",", 1 );
+    r |= mijson_put ( &js, "\n  ", 3 );
+    r |= mijson_string ( &js, node->path, strlen ( node->path ) );
+    r |= mijson_put ( &js, ": {", 3 );
+
+    for ( j = 0; j < node->attr_count; j++ ) {
+      struct mimetaattr *attr = &node->attrs[j];
+
+      if ( j > 0 ) r |= mijson_put ( &js, ",", 1 );
+      r |= mijson_put ( &js, "\n    ", 5 );
+      r |= mijson_string ( &js, attr->name, strlen ( attr->name ) );
+      r |= mijson_put ( &js, ": ", 2 );
+
+      if ( attr->data_type == MI_TYPE_STRING ) {
+        r |= mijson_string ( &js, attr->values, attr->length );
+        continue;
+      }
+      if ( attr->length != 1 ) r |= mijson_put ( &js, "[", 1 );
+
+      for ( k = 0; k < attr->length; k++ ) {
+        if ( k > 0 ) r |= mijson_put ( &js, ", ", 2 );
+
+        switch ( attr->data_type ) {
+        case MI_TYPE_INT:
+          r |= mijson_number ( &js, ( ( int * ) attr->values ) [k] );
+          break;
+        case MI_TYPE_FLOAT:
+          r |= mijson_number ( &js, ( ( float * ) attr->values ) [k] );
+          break;
+        default:
+          r |= mijson_number ( &js, ( ( double * ) attr->values ) [k] );
+          break;
         }
-        break;
-      default:
-        return MI_LOG_ERROR(MI2_MSG_GENERIC,"Unsupported attribute type");
       }
+      if ( attr->length != 1 ) r |= mijson_put ( &js, "]", 1 );
     }
-  } else {
-    MI_LOG_ERROR(MI2_MSG_GENERIC,"milist_start failed");
+    r |= mijson_put ( &js, node->attr_count ? "\n  }" : "}",
+                      node->attr_count ? 4 : 1 );
   }
+  r |= mijson_put ( &js, "\n}\n", 3 );
 
-  milist_finish ( hlist );
-
+  if ( r != MI_NOERROR ) {
+    free ( js.buf );
+    return MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)js.alloc);
+  }
+  *json = js.buf;
   return ( MI_NOERROR );
 }
 
+/** Copy all attribute given a path
+ */
+int micopy_attr ( mihandle_t vol, const char *path, mihandle_t new_vol )
+{
+  struct mimetadata *md;
+  char base[256];
+  char relpath[MI2_MAX_PATH * 2];
+  char message[sizeof ( base ) + 32];
+  size_t base_len;
+  int i, j;
+  int status = MI_NOERROR;
+
+  full_path_for_group ( base, sizeof ( base ), path );
+  base_len = strlen ( base );
+
+  while ( base_len > 1 && base[base_len - 1] == '/' ) {
+    base[--base_len] = '\0';
+  }
+
+  /* Read the whole subtree at once, then write it out */
+  if ( mimeta_load ( vol, base, &md ) < 0 ) {
+    snprintf ( message, sizeof ( message ), "Can't read metadata of %s", base );
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,message);
+  }
+
+  for ( i = 0; i < md->node_count; i++ ) {
+    struct mimetanode *node = &md->nodes[i];
+    const char *rest = node->path + base_len;
+
+    if ( node->attr_count == 0 ) {
+      continue;
+    }
+    if ( *rest == '\0' ) {
+      snprintf ( relpath, sizeof ( relpath ), "%s", path );
+    } else if ( *path != '\0' && path[strlen ( path ) - 1] == '/' ) {
+      snprintf ( relpath, sizeof ( relpath ), "%s%s", path, rest + 1 );
+    } else {
+      snprintf ( relpath, sizeof ( relpath ), "%s%s", path, rest );
+    }
+
+    for ( j = 0; j < node->attr_count; j++ ) {
+      struct mimetaattr *attr = &node->attrs[j];
+
+      if ( miset_attr_values ( new_vol, attr->data_type, relpath, attr->name,
+                               attr->length, attr->values ) < 0 ) {
+        status = MI_ERROR;
+      }
+    }
+  }
+  mifree_metadata ( md );
+  return ( status );
+}
+
 /** Get the values of an attribute.
  */
 int miget_attr_values ( mihandle_t vol, mitype_t data_type, const char *path,
@@ -772,7 +1282,7 @@ int miget_attr_values ( mihandle_t vol, mitype_t data_type, const char *path,
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"HDF file is not open");
   }
 
-  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol);
+  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol->selected_resolution);
 
   /* Search through the path, descending into each group encountered.
    */
@@ -897,7 +1407,7 @@ int miset_attr_values ( mihandle_t vol, mitype_t data_type, const char *path,
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"HDF file is not open");
   }
 
-  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol);
+  full_path_for_attr(fullpath, sizeof(fullpath), path, name, vol->selected_resolution);
 
   /* find last occurance of '/' */
   pch = strrchr ( path, '/' );
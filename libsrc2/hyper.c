@@ -12,6 +12,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <string.h>
 #ifdef _DEBUG
 #include <stdio.h>
 #endif
@@ -167,6 +168,132 @@ int mitranslate_hyperslab_origin(mihandle_t volume,
   return (n_different);
 }
 
+/** Dataspace of a dataset held open by the volume handle, created on
+ * first use and kept until mifree_hyperslab_cache(). Must not be closed
+ * by the caller; every user sets its own selection.
+ */
+hid_t miget_cached_space(hid_t dset_id, hid_t *fspc_id)
+{
+  if (*fspc_id < 0) {
+    *fspc_id = H5Dget_space(dset_id);
+  }
+  return *fspc_id;
+}
+
+/** Scratch buffer of at least \a size bytes, reused across calls on the
+ * same volume. Give it back with mirelease_scratch().
+ */
+void *miget_scratch(mihandle_t volume, int slot, size_t size)
+{
+  if (size == 0) {
+    size = 1;
+  }
+  if (size > MI2_SCRATCH_MAX) {
+    return malloc(size);
+  }
+  if (volume->scratch_size[slot] < size) {
+    free(volume->scratch[slot]);
+    volume->scratch[slot] = malloc(size);
+    volume->scratch_size[slot] = volume->scratch[slot] != NULL ? size : 0;
+  }
+  return volume->scratch[slot];
+}
+
+/** Release a buffer obtained from miget_scratch(), only buffers too large
+ * to be kept are actually freed.
+ */
+void mirelease_scratch(mihandle_t volume, int slot, void *buffer)
+{
+  if (buffer != NULL && buffer != volume->scratch[slot]) {
+    free(buffer);
+  }
+}
+
+/** Drop the dataspaces, types and buffers cached in the volume handle,
+ * when the datasets change or the volume is closed.
+ */
+void mifree_hyperslab_cache(mihandle_t volume)
+{
+  int i;
+
+  if (volume->image_fspc_id >= 0) {
+    H5Sclose(volume->image_fspc_id);
+  }
+  if (volume->imax_fspc_id >= 0) {
+    H5Sclose(volume->imax_fspc_id);
+  }
+  if (volume->imin_fspc_id >= 0) {
+    H5Sclose(volume->imin_fspc_id);
+  }
+  if (volume->buffer_type_id >= 0) {
+    H5Tclose(volume->buffer_type_id);
+  }
+  volume->image_fspc_id = -1;
+  volume->imax_fspc_id = -1;
+  volume->imin_fspc_id = -1;
+  volume->buffer_type_id = -1;
+  volume->buffer_type = MI_TYPE_UNKNOWN;
+
+  for (i = 0; i < MI2_SCRATCH_SLOTS; i++) {
+    free(volume->scratch[i]);
+    volume->scratch[i] = NULL;
+    volume->scratch_size[i] = 0;
+  }
+}
+
+/** Memory type for user buffers of \a mitype, kept in the handle for the
+ * next call with the same type. Must not be closed by the caller.
+ */
+static hid_t _miget_buffer_type(mihandle_t volume, mitype_t mitype)
+{
+  if (volume->buffer_type_id >= 0 && volume->buffer_type == mitype) {
+    return volume->buffer_type_id;
+  }
+  if (volume->buffer_type_id >= 0) {
+    H5Tclose(volume->buffer_type_id);
+  }
+  volume->buffer_type_id = mitype_to_hdftype(mitype, TRUE);
+  volume->buffer_type = mitype;
+  return volume->buffer_type_id;
+}
+
+/** Image dataset of the selected resolution and its dataspace. The ones
+ * held by the volume handle are used when available, otherwise the
+ * dataset is opened here. Release both with _mirelease_image().
+ */
+static int _miget_image(mihandle_t volume, hid_t *dset_id, hid_t *fspc_id)
+{
+  char path[MI2_MAX_PATH];
+
+  if (miopen_image_datasets(volume) < 0) {
+    return (MI_ERROR);
+  }
+
+  if (volume->image_id >= 0) {
+    *dset_id = volume->image_id;
+    MI_CHECK_HDF_CALL(*fspc_id = miget_cached_space(volume->image_id, &volume->image_fspc_id),"H5Dget_space");
+  } else {
+    sprintf(path, MI_ROOT_PATH "/image/%d/image", volume->selected_resolution);
+
+    MI_CHECK_HDF_CALL(*dset_id = H5Dopen1(volume->hdf_id, path),"H5Dopen1");
+    if (*dset_id < 0) {
+      return (MI_ERROR);
+    }
+    MI_CHECK_HDF_CALL(*fspc_id = H5Dget_space(*dset_id),"H5Dget_space");
+  }
+  return (*fspc_id < 0 ? MI_ERROR : MI_NOERROR);
+}
+
+static void _mirelease_image(mihandle_t volume, hid_t dset_id, hid_t fspc_id)
+{
+  if (fspc_id >= 0 && fspc_id != volume->image_fspc_id) {
+    H5Sclose(fspc_id);
+  }
+  if (dset_id >= 0 && dset_id != volume->image_id) {
+    H5Dclose(dset_id);
+  }
+}
+
 /** Read/write a hyperslab of data.  This is the simplified function
  * which performs no value conversion.  It is much more efficient than
  * mirw_hyperslab_icv()
@@ -190,7 +317,6 @@ static int mirw_hyperslab_raw(int opcode,
   int n_different = 0;
   misize_t buffer_size;
   void *temp_buffer=NULL;
-  char path[MI2_MAX_PATH];
   size_t icount[MI2_MAX_VAR_DIMS];
 
   /* Disallow write operations to anything but the highest resolution.
@@ -199,26 +325,15 @@ static int mirw_hyperslab_raw(int opcode,
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to write to a volume thumbnail");
   }
 
-  sprintf(path, MI_ROOT_PATH "/image/%d/image", volume->selected_resolution);
-  /*printf("Using:%s\n",path);*/
-  
-  /* Open the dataset with the specified path
-  */
-  MI_CHECK_HDF_CALL(dset_id = H5Dopen1(volume->hdf_id, path),"H5Dopen1");
-  if (dset_id < 0) {
-    return (MI_ERROR);
-  }
-
-  MI_CHECK_HDF_CALL(fspc_id = H5Dget_space(dset_id),"H5Dget_space");
-  if (fspc_id < 0) {
-    /*TODO: report can't get dataset*/
+  if (_miget_image(volume, &dset_id, &fspc_id) < 0) {
     goto cleanup;
   }
 
+  /* Both types are owned by the volume handle */
   if (midatatype == MI_TYPE_UNKNOWN) {
-    type_id = H5Tcopy(volume->mtype_id);
+    type_id = volume->mtype_id;
   } else {
-    type_id = mitype_to_hdftype(midatatype, TRUE);
+    type_id = _miget_buffer_type(volume, midatatype);
   }
 
   ndims = volume->number_of_dims;
@@ -248,7 +363,13 @@ static int mirw_hyperslab_raw(int opcode,
   
   
   if (opcode == MIRW_OP_READ) {
-    MI_CHECK_HDF_CALL(result = H5Dread(dset_id, type_id, mspc_id, fspc_id, H5P_DEFAULT,buffer),"H5Dread");
+    /* Whole-volume reads may be able to skip the HDF5 filter pipeline */
+    if (ndims > 0 && H5Sget_select_npoints(fspc_id) == H5Sget_simple_extent_npoints(fspc_id) &&
+        miread_chunks_direct(dset_id, type_id, buffer) == MI_NOERROR) {
+      result = 0;
+    } else {
+      MI_CHECK_HDF_CALL(result = H5Dread(dset_id, type_id, mspc_id, fspc_id, H5P_DEFAULT,buffer),"H5Dread");
+    }
     
     /* Restructure the array after reading the data in file orientation.
      */
@@ -264,6 +385,8 @@ static int mirw_hyperslab_raw(int opcode,
   } else {
 
     volume->is_dirty = TRUE; /* Mark as modified. */
+    miinvalidate_statistics(volume);
+    miinvalidate_label_index(volume);
 
     /* Restructure array before writing to file.
      * TODO: use temporary buffer for that!
@@ -286,7 +409,7 @@ static int mirw_hyperslab_raw(int opcode,
       }
 
       /*Use temporary array to preserve input data*/
-      temp_buffer=malloc(buffer_size);
+      temp_buffer=miget_scratch(volume, MI2_SCRATCH_DATA, buffer_size);
       if(temp_buffer==NULL)
       {
         /*TODO: report memory error*/
@@ -309,21 +432,11 @@ static int mirw_hyperslab_raw(int opcode,
 
 cleanup:
 
-  if (type_id >= 0) {
-    H5Tclose(type_id);
-  }
   if (mspc_id >= 0) {
     H5Sclose(mspc_id);
   }
-  if (fspc_id >= 0) {
-    H5Sclose(fspc_id);
-  }
-  if ( dset_id >=0 ) {
-    H5Dclose(dset_id);
-  }
-  if ( temp_buffer!= NULL) {
-    free( temp_buffer );
-  }
+  _mirelease_image(volume, dset_id, fspc_id);
+  mirelease_scratch(volume, MI2_SCRATCH_DATA, temp_buffer);
   return (result);
 }
 
@@ -395,7 +508,6 @@ static int mirw_hyperslab_icv(int opcode,
   double *image_slice_max_buffer=NULL;
   double *image_slice_min_buffer=NULL;
   int scaling_needed=0;
-  char path[MI2_MAX_PATH];
   
   hsize_t image_slice_start[MI2_MAX_VAR_DIMS];
   hsize_t image_slice_count[MI2_MAX_VAR_DIMS];
@@ -411,23 +523,12 @@ static int mirw_hyperslab_icv(int opcode,
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to write to a volume thumbnail");
   }
   
-  sprintf(path, MI_ROOT_PATH "/image/%d/image", volume->selected_resolution);
-  /*printf("Using:%s\n",path);*/
-  
-  /* Open the dataset with the specified path
-  */
-  MI_CHECK_HDF_CALL(dset_id = H5Dopen1(volume->hdf_id, path),"H5Dopen1");
-  if (dset_id < 0) {
-    return (MI_ERROR);
-  }
-
-  MI_CHECK_HDF_CALL(fspc_id = H5Dget_space(dset_id),"H5Dget_space");
-  if (fspc_id < 0) {
+  if (_miget_image(volume, &dset_id, &fspc_id) < 0) {
     goto cleanup;
   }
 
- 
-  buffer_type_id = mitype_to_hdftype(buffer_data_type, TRUE);
+  /* Owned by the volume handle */
+  buffer_type_id = _miget_buffer_type(volume, buffer_data_type);
   if(buffer_type_id<0)
   {
     goto cleanup;
@@ -479,12 +580,13 @@ static int mirw_hyperslab_icv(int opcode,
     image_slice_length=1;
     scaling_needed=1;
 
-    image_max_fspc_id=H5Dget_space(volume->imax_id);
-    image_min_fspc_id=H5Dget_space(volume->imin_id);
+    image_max_fspc_id=miget_cached_space(volume->imax_id, &volume->imax_fspc_id);
+    image_min_fspc_id=miget_cached_space(volume->imin_id, &volume->imin_fspc_id);
 
-    if ( image_max_fspc_id < 0 ) {
+    if ( image_max_fspc_id < 0 || image_min_fspc_id < 0 ) {
       /*Report error that image-max is not found!*/
-      return ( MI_ERROR );
+      result=MI_ERROR;
+      goto cleanup;
     }
 
     slice_ndims = H5Sget_simple_extent_ndims ( image_max_fspc_id );
@@ -515,7 +617,7 @@ static int mirw_hyperslab_icv(int opcode,
       image_slice_start[i] = 0;
     }
     
-    image_slice_max_buffer=malloc(total_number_of_slices*sizeof(double));
+    image_slice_max_buffer=miget_scratch(volume, MI2_SCRATCH_SLICE_MAX, total_number_of_slices*sizeof(double));
     if(!image_slice_max_buffer)
     {
       result=MI_ERROR;
@@ -523,7 +625,7 @@ static int mirw_hyperslab_icv(int opcode,
       goto cleanup;
     }
     
-    image_slice_min_buffer=malloc(total_number_of_slices*sizeof(double));
+    image_slice_min_buffer=miget_scratch(volume, MI2_SCRATCH_SLICE_MIN, total_number_of_slices*sizeof(double));
     
     if(!image_slice_min_buffer)
     {
@@ -559,13 +661,11 @@ static int mirw_hyperslab_icv(int opcode,
       goto cleanup;
     }
     H5Sclose(scaling_mspc_id);
-    H5Sclose(image_max_fspc_id);
-    H5Sclose(image_min_fspc_id);
   } else {
     slice_ndims=0;
     total_number_of_slices=1;
-    image_slice_max_buffer=malloc(sizeof(double));
-    image_slice_min_buffer=malloc(sizeof(double));
+    image_slice_max_buffer=miget_scratch(volume, MI2_SCRATCH_SLICE_MAX, sizeof(double));
+    image_slice_min_buffer=miget_scratch(volume, MI2_SCRATCH_SLICE_MIN, sizeof(double));
     miget_volume_range(volume,image_slice_max_buffer,image_slice_min_buffer);
     image_slice_length=1;
     /*it produces unity scaling*/
@@ -670,6 +770,8 @@ static int mirw_hyperslab_icv(int opcode,
   } else { /*opcode != MIRW_OP_READ*/
 
     volume->is_dirty = TRUE; /* Mark as modified. */
+    miinvalidate_statistics(volume);
+    miinvalidate_label_index(volume);
     
     if (n_different != 0 ) {
       /* Invert before calling */
@@ -684,7 +786,7 @@ static int mirw_hyperslab_icv(int opcode,
     if(scaling_needed || n_different != 0) 
     {
       /*create temporary copy, to be destroyed*/
-      temp_buffer=malloc(buffer_size);
+      temp_buffer=miget_scratch(volume, MI2_SCRATCH_DATA, buffer_size);
       if(!temp_buffer)
       {
         MI_LOG_ERROR(MI2_MSG_OUTOFMEM,buffer_size);
@@ -767,31 +869,13 @@ static int mirw_hyperslab_icv(int opcode,
       
 cleanup:
 
-  if (buffer_type_id >= 0) {
-    H5Tclose(buffer_type_id);
-  }
   if (mspc_id >= 0) {
     H5Sclose(mspc_id);
   }
-  if (fspc_id >= 0) {
-    H5Sclose(fspc_id);
-  }
-  if ( dset_id >=0 ) {
-    H5Dclose(dset_id);
-  }
-  
-  if(temp_buffer!=NULL)
-  {
-    free(temp_buffer);
-  }
-  if(image_slice_min_buffer!=NULL)
-  {
-    free(image_slice_min_buffer);
-  }
-  if(image_slice_max_buffer!=NULL)
-  {
-    free(image_slice_max_buffer);
-  }
+  _mirelease_image(volume, dset_id, fspc_id);
+  mirelease_scratch(volume, MI2_SCRATCH_DATA, temp_buffer);
+  mirelease_scratch(volume, MI2_SCRATCH_SLICE_MIN, image_slice_min_buffer);
+  mirelease_scratch(volume, MI2_SCRATCH_SLICE_MAX, image_slice_max_buffer);
   return (result);
 }
 
@@ -878,7 +962,6 @@ static int mirw_hyperslab_normalized(int opcode,
   double *image_slice_max_buffer=NULL;
   double *image_slice_min_buffer=NULL;
 
-  char path[MI2_MAX_PATH];
   
   hsize_t image_slice_start[MI2_MAX_VAR_DIMS];
   hsize_t image_slice_count[MI2_MAX_VAR_DIMS];
@@ -895,32 +978,17 @@ static int mirw_hyperslab_normalized(int opcode,
     return (MI_ERROR);
   }
   
-  sprintf(path, MI_ROOT_PATH "/image/%d/image", volume->selected_resolution);
-
-  /* Open the dataset with the specified path
-  */
-  MI_CHECK_HDF_CALL(dset_id = H5Dopen1(volume->hdf_id, path),"H5Dopen1");
-  if (dset_id < 0) {
-    return (MI_ERROR);
-  }
-
-  MI_CHECK_HDF_CALL(fspc_id = H5Dget_space(dset_id),"H5Dget_space");
-  if (fspc_id < 0) {
-    /*TODO: report can't get dataset*/
+  if (_miget_image(volume, &dset_id, &fspc_id) < 0) {
     goto cleanup;
   }
-  buffer_type_id = mitype_to_hdftype(buffer_data_type,TRUE);
+
+  /* Owned by the volume handle and by the library */
+  buffer_type_id = _miget_buffer_type(volume, buffer_data_type);
   if(buffer_type_id<0)
   {
     goto cleanup;
   }
-  
-  MI_CHECK_HDF_CALL(volume_type_id = H5Tcopy ( H5T_NATIVE_DOUBLE ),"H5Tcopy");
-  if(volume_type_id<0)
-  {
-    fprintf(stderr,"H5Tcopy: Fail %s:%d\n",__FILE__,__LINE__);
-    goto cleanup;
-  }
+  volume_type_id = H5T_NATIVE_DOUBLE;
   
   ndims = volume->number_of_dims;
   
@@ -965,8 +1033,8 @@ static int mirw_hyperslab_normalized(int opcode,
     total_number_of_slices=1;
     image_slice_length=1;
 
-    MI_CHECK_HDF_CALL(image_max_fspc_id=H5Dget_space(volume->imax_id),"H5Dget_space");
-    MI_CHECK_HDF_CALL(image_min_fspc_id=H5Dget_space(volume->imin_id),"H5Dget_space");
+    MI_CHECK_HDF_CALL(image_max_fspc_id=miget_cached_space(volume->imax_id, &volume->imax_fspc_id),"H5Dget_space");
+    MI_CHECK_HDF_CALL(image_min_fspc_id=miget_cached_space(volume->imin_id, &volume->imin_fspc_id),"H5Dget_space");
 
     if ( image_max_fspc_id < 0 || image_min_fspc_id<0 ) {
       result=MI_ERROR;
@@ -999,8 +1067,8 @@ static int mirw_hyperslab_normalized(int opcode,
       image_slice_start[i] = 0;
     }
     
-    image_slice_max_buffer=malloc(total_number_of_slices*sizeof(double));
-    image_slice_min_buffer=malloc(total_number_of_slices*sizeof(double));
+    image_slice_max_buffer=miget_scratch(volume, MI2_SCRATCH_SLICE_MAX, total_number_of_slices*sizeof(double));
+    image_slice_min_buffer=miget_scratch(volume, MI2_SCRATCH_SLICE_MIN, total_number_of_slices*sizeof(double));
     /*TODO check for allocation failure ?*/
     
     MI_CHECK_HDF_CALL(scaling_mspc_id = H5Screate_simple(slice_ndims, image_slice_count, NULL),"H5Screate_simple");
@@ -1029,13 +1097,12 @@ static int mirw_hyperslab_normalized(int opcode,
       goto cleanup;
     }
     H5Sclose(scaling_mspc_id);
-    H5Sclose(image_max_fspc_id);
     
   } else {
     slice_ndims=0;
     total_number_of_slices=1;
-    image_slice_max_buffer=malloc(sizeof(double));
-    image_slice_min_buffer=malloc(sizeof(double));
+    image_slice_max_buffer=miget_scratch(volume, MI2_SCRATCH_SLICE_MAX, sizeof(double));
+    image_slice_min_buffer=miget_scratch(volume, MI2_SCRATCH_SLICE_MIN, sizeof(double));
     miget_volume_range( volume,image_slice_max_buffer,image_slice_min_buffer );
     image_slice_length=1;
     for (i = 0; i < ndims; i++) {
@@ -1052,7 +1119,7 @@ static int mirw_hyperslab_normalized(int opcode,
 #endif
 
   /*Allocate temporary Buffer*/
-  temp_buffer=(double*)malloc(buffer_size);
+  temp_buffer=(double*)miget_scratch(volume, MI2_SCRATCH_DATA, buffer_size);
   if(!temp_buffer)
   {
     MI_LOG_ERROR(MI2_MSG_OUTOFMEM,buffer_size);
@@ -1112,6 +1179,8 @@ static int mirw_hyperslab_normalized(int opcode,
   } else { /*opcode != MIRW_OP_READ*/
     void *temp_buffer2;
     volume->is_dirty = TRUE; /* Mark as modified. */
+    miinvalidate_statistics(volume);
+    miinvalidate_label_index(volume);
     
     if (n_different != 0 ) {
       /* Invert before calling */
@@ -1125,7 +1194,7 @@ static int mirw_hyperslab_normalized(int opcode,
     }
     
     /*create temporary copy, to be destroyed*/
-    temp_buffer2=malloc(input_buffer_size);
+    temp_buffer2=miget_scratch(volume, MI2_SCRATCH_COPY, input_buffer_size);
     if(!temp_buffer2)
     {
       MI_LOG_ERROR(MI2_MSG_OUTOFMEM,input_buffer_size);
@@ -1165,11 +1234,11 @@ static int mirw_hyperslab_normalized(int opcode,
         break;
       default:
         /*TODO: report unsupported conversion*/
-        free(temp_buffer2);
+        mirelease_scratch(volume, MI2_SCRATCH_COPY, temp_buffer2);
         result=MI_ERROR;
         goto cleanup;
     }
-    free(temp_buffer2);
+    mirelease_scratch(volume, MI2_SCRATCH_COPY, temp_buffer2);
     
     MI_CHECK_HDF_CALL(result = H5Dwrite(dset_id, volume_type_id, mspc_id, fspc_id, H5P_DEFAULT, temp_buffer),"H5Dwrite");
     if(result<0)
@@ -1180,33 +1249,13 @@ static int mirw_hyperslab_normalized(int opcode,
       
 cleanup:
 
-  if (volume_type_id >= 0) {
-    H5Tclose(volume_type_id);
-  }
-  if (buffer_type_id >= 0) {
-    H5Tclose(buffer_type_id);
-  }
   if (mspc_id >= 0) {
     H5Sclose(mspc_id);
   }
-  if (fspc_id >= 0) {
-    H5Sclose(fspc_id);
-  }
-  if ( dset_id >=0 ) {
-    H5Dclose(dset_id);
-  }
-  if(temp_buffer!=NULL)
-  {
-    free(temp_buffer);
-  }
-  if(image_slice_min_buffer!=NULL)
-  {
-    free(image_slice_min_buffer);
-  }
-  if(image_slice_max_buffer!=NULL)
-  {
-    free(image_slice_max_buffer);
-  }
+  _mirelease_image(volume, dset_id, fspc_id);
+  mirelease_scratch(volume, MI2_SCRATCH_DATA, temp_buffer);
+  mirelease_scratch(volume, MI2_SCRATCH_SLICE_MIN, image_slice_min_buffer);
+  mirelease_scratch(volume, MI2_SCRATCH_SLICE_MAX, image_slice_max_buffer);
   return (result);
 }
 
@@ -1333,4 +1382,354 @@ int miset_voxel_value_hyperslab(mihandle_t volume,
                             start, count, (void *) buffer);
 }
 
+/** Restrict a hyperslab to one component of the record (vector)
+ * dimension of a volume. The start and count given for the record
+ * dimension are replaced.
+ */
+static int _miselect_component(mihandle_t volume, int component,
+                               const misize_t start[], const misize_t count[],
+                               misize_t cstart[], misize_t ccount[])
+{
+  int record = -1;
+  int i;
+
+  if (volume == NULL || start == NULL || count == NULL) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to read a component with null volume or variable");
+  }
+  if (miopen_image_datasets(volume) < 0) {
+    return (MI_ERROR);
+  }
+  for (i = 0; i < volume->number_of_dims; i++) {
+    int file_i = volume->dim_indices != NULL ? volume->dim_indices[i] : i;
+
+    cstart[i] = start[i];
+    ccount[i] = count[i];
+    if (volume->dim_handles[file_i]->dim_class == MI_DIMCLASS_RECORD) {
+      record = i;
+      if (component < 0 || (misize_t) component >= volume->dim_handles[file_i]->length) {
+        return MI_LOG_ERROR(MI2_MSG_GENERIC,"Record component out of range");
+      }
+    }
+  }
+  if (record < 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume has no record dimension");
+  }
+  cstart[record] = component;
+  ccount[record] = 1;
+  return (MI_NOERROR);
+}
+
+/** Read one component of the record (vector) dimension of a hyperslab,
+ * with no range conversions or normalization. The entries of \a start
+ * and \a count for the record dimension are ignored. Only the requested
+ * component is selected in the file, so with planar storage (see
+ * miset_props_planar_components()) only its chunks are read.
+ */
+int miget_voxel_component_hyperslab(mihandle_t volume,
+                                    mitype_t buffer_data_type,
+                                    int component,
+                                    const misize_t start[],
+                                    const misize_t count[],
+                                    void *buffer)
+{
+  misize_t cstart[MI2_MAX_VAR_DIMS];
+  misize_t ccount[MI2_MAX_VAR_DIMS];
+
+  if (_miselect_component(volume, component, start, count, cstart, ccount) < 0) {
+    return (MI_ERROR);
+  }
+  return mirw_hyperslab_raw(MIRW_OP_READ, volume, buffer_data_type,
+                            cstart, ccount, buffer);
+}
+
+/** Read one component of the record (vector) dimension of a hyperslab,
+ * converted to real values as by miget_real_value_hyperslab().
+ */
+int miget_real_component_hyperslab(mihandle_t volume,
+                                   mitype_t buffer_data_type,
+                                   int component,
+                                   const misize_t start[],
+                                   const misize_t count[],
+                                   void *buffer)
+{
+  misize_t cstart[MI2_MAX_VAR_DIMS];
+  misize_t ccount[MI2_MAX_VAR_DIMS];
+
+  if (_miselect_component(volume, component, start, count, cstart, ccount) < 0) {
+    return (MI_ERROR);
+  }
+  return mirw_hyperslab_icv(MIRW_OP_READ, volume, buffer_data_type,
+                            cstart, ccount, buffer);
+}
+
+/** One requested point, in the order it is read from the file */
+struct mipoint {
+  hsize_t chunk;    /* linear index of the chunk holding the point */
+  hsize_t offset;   /* linear offset of the point in the image */
+  misize_t index;   /* position of the point in the caller's arrays */
+};
+
+static int _mipoint_compare(const void *a, const void *b)
+{
+  const struct mipoint *pa = (const struct mipoint *)a;
+  const struct mipoint *pb = (const struct mipoint *)b;
+
+  if (pa->chunk != pb->chunk) {
+    return pa->chunk < pb->chunk ? -1 : 1;
+  }
+  if (pa->offset != pb->offset) {
+    return pa->offset < pb->offset ? -1 : 1;
+  }
+  return 0;
+}
+
+/** Read the voxel values, and optionally the slice ranges, of \a n points
+ * with a single element selection. Points are sorted by chunk first, so
+ * that each chunk touched is visited once.
+ */
+static int _miread_points(mihandle_t volume,
+                          misize_t n,
+                          int ndims,
+                          const misize_t coords[],
+                          double voxels[],
+                          double slice_min[],
+                          double slice_max[])
+{
+  hid_t dset_id = -1;
+  hid_t fspc_id = -1;
+  hid_t mspc_id = -1;
+  hid_t plist_id = -1;
+  hsize_t dims[MI2_MAX_VAR_DIMS];
+  hsize_t chunk[MI2_MAX_VAR_DIMS];
+  hsize_t hdf_start[MI2_MAX_VAR_DIMS];
+  hsize_t hdf_count[MI2_MAX_VAR_DIMS];
+  misize_t count[MI2_MAX_VAR_DIMS];
+  int dir[MI2_MAX_VAR_DIMS];
+  struct mipoint *points = NULL;
+  hsize_t *file_coords = NULL;
+  hsize_t *sorted = NULL;
+  double *temp = NULL;
+  hsize_t n_points = n;
+  int slice_ndims = 0;
+  int result = MI_ERROR;
+  misize_t i;
+  int j;
+
+  if (ndims != volume->number_of_dims || ndims <= 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Wrong number of coordinates");
+  }
+  if (n == 0) {
+    return (MI_NOERROR);
+  }
+
+  if (_miget_image(volume, &dset_id, &fspc_id) < 0) {
+    goto cleanup;
+  }
+  H5Sget_simple_extent_dims(fspc_id, dims, NULL);
+
+  /* Contiguous images are treated as a single chunk */
+  for (j = 0; j < ndims; j++) {
+    chunk[j] = dims[j];
+  }
+  MI_CHECK_HDF_CALL(plist_id = H5Dget_create_plist(dset_id),"H5Dget_create_plist");
+  if (plist_id >= 0 && H5Pget_layout(plist_id) == H5D_CHUNKED) {
+    H5Pget_chunk(plist_id, ndims, chunk);
+  }
+
+  points = (struct mipoint *)malloc(n * sizeof(struct mipoint));
+  file_coords = (hsize_t *)malloc(n * ndims * sizeof(hsize_t));
+  sorted = (hsize_t *)malloc(n * ndims * sizeof(hsize_t));
+  temp = (double *)malloc(n * sizeof(double));
+  if (points == NULL || file_coords == NULL || sorted == NULL || temp == NULL) {
+    MI_LOG_ERROR(MI2_MSG_OUTOFMEM, n * ndims * sizeof(hsize_t));
+    goto cleanup;
+  }
+
+  for (j = 0; j < ndims; j++) {
+    count[j] = 1;
+  }
+
+  for (i = 0; i < n; i++) {
+    hsize_t *fc = file_coords + i * ndims;
+    hsize_t chunk_index = 0;
+    hsize_t offset = 0;
+
+    mitranslate_hyperslab_origin(volume, coords + i * ndims, count, hdf_start, hdf_count, dir);
+
+    for (j = 0; j < ndims; j++) {
+      /* flipped coordinates past the end wrap around, and are caught here */
+      if (hdf_start[j] >= dims[j]) {
+        MI_LOG_ERROR(MI2_MSG_GENERIC,"Point outside of the volume");
+        goto cleanup;
+      }
+      fc[j] = hdf_start[j];
+      chunk_index = chunk_index * ((dims[j] + chunk[j] - 1) / chunk[j]) + hdf_start[j] / chunk[j];
+      offset = offset * dims[j] + hdf_start[j];
+    }
+    points[i].chunk = chunk_index;
+    points[i].offset = offset;
+    points[i].index = i;
+  }
+
+  qsort(points, n, sizeof(struct mipoint), _mipoint_compare);
+
+  for (i = 0; i < n; i++) {
+    memcpy(sorted + i * ndims, file_coords + points[i].index * ndims, ndims * sizeof(hsize_t));
+  }
+
+  MI_CHECK_HDF_CALL(mspc_id = H5Screate_simple(1, &n_points, NULL),"H5Screate_simple");
+  if (mspc_id < 0) {
+    goto cleanup;
+  }
+
+  MI_CHECK_HDF_CALL(result = H5Sselect_elements(fspc_id, H5S_SELECT_SET, n, sorted),"H5Sselect_elements");
+  if (result < 0) {
+    goto cleanup;
+  }
+  MI_CHECK_HDF_CALL(result = H5Dread(dset_id, H5T_NATIVE_DOUBLE, mspc_id, fspc_id, H5P_DEFAULT, temp),"H5Dread");
+  if (result < 0) {
+    goto cleanup;
+  }
+  for (i = 0; i < n; i++) {
+    voxels[points[i].index] = temp[i];
+  }
+
+  /* Slice ranges live in image-min and image-max, indexed by the
+   * leading dimensions of the image */
+  if (slice_min != NULL && slice_max != NULL) {
+    hid_t min_fspc_id = miget_cached_space(volume->imin_id, &volume->imin_fspc_id);
+    hid_t max_fspc_id = miget_cached_space(volume->imax_id, &volume->imax_fspc_id);
+
+    if (min_fspc_id < 0 || max_fspc_id < 0) {
+      result = MI_ERROR;
+      goto cleanup;
+    }
+    slice_ndims = H5Sget_simple_extent_ndims(min_fspc_id);
+    if (slice_ndims > ndims) {
+      slice_ndims = ndims;
+    }
+
+    for (i = 0; i < n; i++) {
+      memcpy(sorted + i * slice_ndims, file_coords + points[i].index * ndims, slice_ndims * sizeof(hsize_t));
+    }
+
+    if (slice_ndims == 0) {
+      H5Sselect_all(min_fspc_id);
+      H5Sselect_all(max_fspc_id);
+    } else {
+      H5Sselect_elements(min_fspc_id, H5S_SELECT_SET, n, sorted);
+      H5Sselect_elements(max_fspc_id, H5S_SELECT_SET, n, sorted);
+    }
+
+    MI_CHECK_HDF_CALL(result = H5Dread(volume->imin_id, H5T_NATIVE_DOUBLE, slice_ndims ? mspc_id : H5S_ALL, min_fspc_id, H5P_DEFAULT, temp),"H5Dread");
+    if (result < 0) {
+      goto cleanup;
+    }
+    for (i = 0; i < n; i++) {
+      slice_min[points[i].index] = slice_ndims ? temp[i] : temp[0];
+    }
+
+    MI_CHECK_HDF_CALL(result = H5Dread(volume->imax_id, H5T_NATIVE_DOUBLE, slice_ndims ? mspc_id : H5S_ALL, max_fspc_id, H5P_DEFAULT, temp),"H5Dread");
+    if (result < 0) {
+      goto cleanup;
+    }
+    for (i = 0; i < n; i++) {
+      slice_max[points[i].index] = slice_ndims ? temp[i] : temp[0];
+    }
+  }
+  result = MI_NOERROR;
+
+cleanup:
+  if (plist_id >= 0) {
+    H5Pclose(plist_id);
+  }
+  if (mspc_id >= 0) {
+    H5Sclose(mspc_id);
+  }
+  _mirelease_image(volume, dset_id, fspc_id);
+  free(points);
+  free(file_coords);
+  free(sorted);
+  free(temp);
+  return (result < 0 ? MI_ERROR : MI_NOERROR);
+}
+
+/** Read the voxel values of \a n points, given as \a ndims coordinates
+ * each in \a coords, with a single read of the image.
+ */
+int miget_voxel_values_at(mihandle_t volume,
+                          misize_t n,
+                          int ndims,
+                          const misize_t coords[],
+                          double voxels[])
+{
+  if (volume == NULL || (n > 0 && (coords == NULL || voxels == NULL))) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to read points with null volume or null variables");
+  }
+  return _miread_points(volume, n, ndims, coords, voxels, NULL, NULL);
+}
+
+/** Read the real values of \a n points, given as \a ndims coordinates
+ * each in \a coords, scaling all of them at once.
+ */
+int miget_real_values_at(mihandle_t volume,
+                         misize_t n,
+                         int ndims,
+                         const misize_t coords[],
+                         double values[])
+{
+  double valid_min, valid_max;
+  double vol_min, vol_max;
+  double *slice_min = NULL;
+  double *slice_max = NULL;
+  double voxel_range;
+  int result;
+  misize_t i;
+
+  if (volume == NULL || (n > 0 && (coords == NULL || values == NULL))) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to read points with null volume or null variables");
+  }
+  if (miopen_image_datasets(volume) < 0) {
+    return (MI_ERROR);
+  }
+
+  /* Floating point voxels are real values already */
+  if (volume->volume_type == MI_TYPE_FLOAT    || volume->volume_type == MI_TYPE_DOUBLE ||
+      volume->volume_type == MI_TYPE_FCOMPLEX || volume->volume_type == MI_TYPE_DCOMPLEX) {
+    return _miread_points(volume, n, ndims, coords, values, NULL, NULL);
+  }
+
+  miget_volume_valid_range(volume, &valid_max, &valid_min);
+  voxel_range = valid_max - valid_min;
+
+  if (!volume->has_slice_scaling) {
+    if (miget_volume_range(volume, &vol_max, &vol_min) < 0 ||
+        _miread_points(volume, n, ndims, coords, values, NULL, NULL) < 0) {
+      return (MI_ERROR);
+    }
+    for (i = 0; i < n; i++) {
+      values[i] = ((values[i] - valid_min) / voxel_range) * (vol_max - vol_min) + vol_min;
+    }
+    return (MI_NOERROR);
+  }
+
+  slice_min = (double *)malloc(n * sizeof(double));
+  slice_max = (double *)malloc(n * sizeof(double));
+  if (n > 0 && (slice_min == NULL || slice_max == NULL)) {
+    free(slice_min);
+    free(slice_max);
+    return MI_LOG_ERROR(MI2_MSG_OUTOFMEM, n * sizeof(double));
+  }
+
+  result = _miread_points(volume, n, ndims, coords, values, slice_min, slice_max);
+  if (result == MI_NOERROR) {
+    for (i = 0; i < n; i++) {
+      values[i] = ((values[i] - valid_min) / voxel_range) * (slice_max[i] - slice_min[i]) + slice_min[i];
+    }
+  }
+  free(slice_min);
+  free(slice_max);
+  return (result);
+}
+
 /* kate: indent-mode cstyle; indent-width 2; replace-tabs on; */
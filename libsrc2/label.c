@@ -10,15 +10,40 @@
  * Labeled volumes must have been created with the class MI_CLASS_LABEL,
  * and with any integer subtype.
  *
+ * The labels are read from the enumerated type once per volume handle
+ * and looked up in memory afterwards. An index of the chunks of the
+ * image which contain each label can be stored in the file, so that the
+ * voxels of one label can be found without reading the whole image.
+ *
  ************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 #include <hdf5.h>
 #include "minc2.h"
 #include "minc2_private.h"
 
 #define MI_LABEL_MAX 128
 
+#define MI_LABEL_INDEX_NAME "label_index"
+#define MI_LABEL_INDEX_PATH MI_ROOT_PATH "/" MI_INFO_NAME "/" MI_LABEL_INDEX_NAME
+
+struct milabelentry {
+  int value;
+  char *name;
+};
+
+/** \internal
+ * The labels of a volume in member order, and sorted by value and by
+ * name for binary searches.
+ */
+struct milabeltable {
+  int count;
+  struct milabelentry *entries;
+  struct milabelentry **by_value;
+  struct milabelentry **by_name;
+};
+
 static int miswap2(unsigned short tmp)
 {
     unsigned char *x = (unsigned char *) &tmp;
@@ -40,6 +65,154 @@ static int miswap4(unsigned int tmp)
     return (tmp);
 }
 
+static int milabel_compare_value(const void *a, const void *b)
+{
+  const struct milabelentry *x = *(struct milabelentry * const *) a;
+  const struct milabelentry *y = *(struct milabelentry * const *) b;
+
+  return (x->value > y->value) - (x->value < y->value);
+}
+
+static int milabel_compare_name(const void *a, const void *b)
+{
+  const struct milabelentry *x = *(struct milabelentry * const *) a;
+  const struct milabelentry *y = *(struct milabelentry * const *) b;
+
+  return strcmp(x->name, y->name);
+}
+
+/** \internal
+ * Free the cached labels of a volume, when it is closed or a label is
+ * defined.
+ */
+void mifree_label_table(mihandle_t volume)
+{
+  struct milabeltable *table = volume->label_table;
+  int i;
+
+  if (table == NULL) {
+    return;
+  }
+  for (i = 0; i < table->count; i++) {
+    free(table->entries[i].name);
+  }
+  free(table->entries);
+  free(table->by_value);
+  free(table->by_name);
+  free(table);
+  volume->label_table = NULL;
+}
+
+/* Value of an enumeration member, whatever the size of the base type */
+static int milabel_member_value(hid_t type_id, int idx, int *value)
+{
+  unsigned char buffer[sizeof(long long)];
+  hid_t super_id;
+  size_t size;
+  int is_signed;
+
+  super_id = H5Tget_super(type_id);
+  if (super_id < 0) {
+    return (MI_ERROR);
+  }
+  size = H5Tget_size(super_id);
+  is_signed = (H5Tget_sign(super_id) == H5T_SGN_2);
+  H5Tclose(super_id);
+
+  if (size > sizeof(buffer) || H5Tget_member_value(type_id, idx, buffer) < 0) {
+    return (MI_ERROR);
+  }
+  switch (size) {
+  case 1:
+    *value = is_signed ? (int) *(signed char *) buffer : (int) buffer[0];
+    break;
+  case 2:
+    {
+      unsigned short tmp;
+      memcpy(&tmp, buffer, sizeof(tmp));
+      *value = is_signed ? (int) (short) tmp : (int) tmp;
+    }
+    break;
+  case 4:
+    memcpy(value, buffer, sizeof(int));
+    break;
+  default:
+    return (MI_ERROR);
+  }
+  return (MI_NOERROR);
+}
+
+/* The labels of a volume, read from its memory type on first use */
+static struct milabeltable *milabel_table(mihandle_t volume)
+{
+  struct milabeltable *table;
+  int count;
+  int i;
+
+  if (volume->label_table != NULL) {
+    return volume->label_table;
+  }
+  if (miopen_image_datasets(volume) < 0) {
+    return NULL;
+  }
+  if (volume->mtype_id <= 0) {
+    MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume is not initialized");
+    return NULL;
+  }
+  H5E_BEGIN_TRY {
+    count = H5Tget_nmembers(volume->mtype_id);
+  } H5E_END_TRY;
+  if (count < 0) {
+    MI_LOG_ERROR(MI2_MSG_HDF5,"H5Tget_nmembers");
+    return NULL;
+  }
+
+  table = calloc(1, sizeof(struct milabeltable));
+  if (table == NULL) {
+    MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)sizeof(struct milabeltable));
+    return NULL;
+  }
+  volume->label_table = table;
+  table->entries = calloc(count + 1, sizeof(struct milabelentry));
+  table->by_value = malloc((count + 1) * sizeof(struct milabelentry *));
+  table->by_name = malloc((count + 1) * sizeof(struct milabelentry *));
+  if (table->entries == NULL || table->by_value == NULL ||
+      table->by_name == NULL) {
+    mifree_label_table(volume);
+    MI_LOG_ERROR(MI2_MSG_OUTOFMEM,count * (int)sizeof(struct milabelentry));
+    return NULL;
+  }
+
+  for (i = 0; i < count; i++) {
+    struct milabelentry *entry = &table->entries[i];
+    char *name;
+
+    table->count = i + 1;
+    name = H5Tget_member_name(volume->mtype_id, i);
+    if (name == NULL ||
+        milabel_member_value(volume->mtype_id, i, &entry->value) < 0) {
+      free(name);
+      mifree_label_table(volume);
+      MI_LOG_ERROR(MI2_MSG_HDF5,"H5Tget_member_value");
+      return NULL;
+    }
+    entry->name = strdup(name);
+    free(name);
+    if (entry->name == NULL) {
+      mifree_label_table(volume);
+      MI_LOG_ERROR(MI2_MSG_OUTOFMEM,MI_LABEL_MAX);
+      return NULL;
+    }
+    table->by_value[i] = entry;
+    table->by_name[i] = entry;
+  }
+  qsort(table->by_value, count, sizeof(struct milabelentry *),
+        milabel_compare_value);
+  qsort(table->by_name, count, sizeof(struct milabelentry *),
+        milabel_compare_name);
+  return table;
+}
+
 /**
  * This function associates a label name with an integer value for the given
  * volume. Functions which read and write voxel values will read/write 
@@ -62,11 +235,15 @@ int  midefine_label(mihandle_t volume, int value, const char *name)
       return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume class is not label");
     }
 
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
     if (volume->ftype_id <= 0 || volume->mtype_id <= 0) {
       return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume not initialized");
     }
 
     MI_CHECK_HDF_CALL_RET(result = H5Tenum_insert(volume->mtype_id, name, &value),"H5Tenum_insert");
+    mifree_label_table(volume);
 
     /* We might have to swap these values before adding them to
      * the file type.
@@ -96,7 +273,8 @@ int  midefine_label(mihandle_t volume, int value, const char *name)
 */
 int miget_label_name(mihandle_t volume, int value, char **name)
 {
-    int result;
+    struct milabeltable *table;
+    struct milabelentry key, *keyp = &key, **found;
 
     if (volume == NULL || name == NULL) {
        return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to use null volume or variable");
@@ -105,19 +283,25 @@ int miget_label_name(mihandle_t volume, int value, char **name)
     if (volume->volume_class != MI_CLASS_LABEL) {
          MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume class is not label");
     }
-    if (volume->mtype_id <= 0) {
-         MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume is not initialized");
+    if ((table = milabel_table(volume)) == NULL) {
+        return (MI_ERROR);
     }
+
+    /* The name is allocated even if the value is not defined */
     *name = malloc(MI_LABEL_MAX);
     if (*name == NULL) {
         return MI_LOG_ERROR(MI2_MSG_OUTOFMEM,MI_LABEL_MAX);
     }
+    (*name)[0] = '\0';
 
-    H5E_BEGIN_TRY {
-        result = H5Tenum_nameof(volume->mtype_id, &value, *name, MI_LABEL_MAX);
-    } H5E_END_TRY;
-
-    MI_CHECK_HDF_CALL_RET(result,"H5Tenum_nameof");
+    key.value = value;
+    found = bsearch(&keyp, table->by_value, table->count,
+                    sizeof(struct milabelentry *), milabel_compare_value);
+    if (found == NULL) {
+        return MI_LOG_ERROR(MI2_MSG_GENERIC,"Label value is not defined");
+    }
+    strncpy(*name, (*found)->name, MI_LABEL_MAX - 1);
+    (*name)[MI_LABEL_MAX - 1] = '\0';
     return (MI_NOERROR);
 }
 
@@ -127,7 +311,8 @@ int miget_label_name(mihandle_t volume, int value, char **name)
 */
 int miget_label_value(mihandle_t volume, const char *name, int *value_ptr)
 {
-    int result;
+    struct milabeltable *table;
+    struct milabelentry key, *keyp = &key, **found;
 
     if (volume == NULL || name == NULL || value_ptr == NULL) {
         return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to use null volume or variable");
@@ -137,15 +322,17 @@ int miget_label_value(mihandle_t volume, const char *name, int *value_ptr)
         return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume class is not label");
     }
 
-    if (volume->mtype_id <= 0) {
-        return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume is not initialized");
+    if ((table = milabel_table(volume)) == NULL) {
+        return (MI_ERROR);
     }
 
-    H5E_BEGIN_TRY {
-        result = H5Tenum_valueof(volume->mtype_id, name, value_ptr);
-    } H5E_END_TRY;
-
-    MI_CHECK_HDF_CALL_RET(result,"H5Tenum_valueof");
+    key.name = (char *) name;
+    found = bsearch(&keyp, table->by_name, table->count,
+                    sizeof(struct milabelentry *), milabel_compare_name);
+    if (found == NULL) {
+        return MI_LOG_ERROR(MI2_MSG_GENERIC,"Label name is not defined");
+    }
+    *value_ptr = (*found)->value;
     return (MI_NOERROR);
 }
 
@@ -154,8 +341,8 @@ int miget_label_value(mihandle_t volume, const char *name, int *value_ptr)
 */
 int miget_number_of_defined_labels(mihandle_t volume, int *number_of_labels)
 {
-  int result;
- 
+  struct milabeltable *table;
+
   if (volume == NULL) {
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to use null volume");
   }
@@ -163,17 +350,10 @@ int miget_number_of_defined_labels(mihandle_t volume, int *number_of_labels)
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume class is not label");
   }
 
-  if (volume->mtype_id <= 0) {
-    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume is not initialized");
+  if ((table = milabel_table(volume)) == NULL) {
+    return (MI_ERROR);
   }
-
-  H5E_BEGIN_TRY {
-    result = H5Tget_nmembers(volume->mtype_id);
-  } H5E_END_TRY;
-
-  MI_CHECK_HDF_CALL_RET(result,"H5Tget_nmembers");
-  
-  *number_of_labels = result;
+  *number_of_labels = table->count;
     
   return (MI_NOERROR);
 }
@@ -183,7 +363,8 @@ int miget_number_of_defined_labels(mihandle_t volume, int *number_of_labels)
 */
 int miget_label_value_by_index(mihandle_t volume, int idx, int *value)
 {
-  int result;
+  struct milabeltable *table;
+
   if (volume == NULL) {
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to use null volume");
   }
@@ -191,17 +372,515 @@ int miget_label_value_by_index(mihandle_t volume, int idx, int *value)
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume class is not label");
   }
   
-  if (volume->mtype_id <= 0) {
-    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume is not initialized");
+  if ((table = milabel_table(volume)) == NULL) {
+    return (MI_ERROR);
+  }
+  if (idx < 0 || idx >= table->count) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Label index out of range");
+  }
+  *value = table->entries[idx].value;
+
+  return (MI_NOERROR);
+}
+
+/** \internal
+ * Remove the stored label index before the voxel values change. Only the
+ * first change after the volume is opened, or after the index was last
+ * built, has to do anything.
+ */
+void miinvalidate_label_index(mihandle_t volume)
+{
+  if (volume->label_index_stale || volume->volume_class != MI_CLASS_LABEL) {
+    return;
+  }
+  volume->label_index_stale = TRUE;
+
+  H5E_BEGIN_TRY {
+    if (H5Lexists(volume->hdf_id, MI_LABEL_INDEX_PATH, H5P_DEFAULT) > 0) {
+      H5Ldelete(volume->hdf_id, MI_LABEL_INDEX_PATH, H5P_DEFAULT);
+    }
+  } H5E_END_TRY;
+}
+
+/* The chunks over which the label index is kept, in file order. An image
+ * which is not chunked is indexed by slices through its first dimension.
+ */
+struct milabelgrid {
+  int ndims;
+  hsize_t sizes[MI2_MAX_VAR_DIMS];
+  hsize_t chunk[MI2_MAX_VAR_DIMS];
+  hsize_t nchunks[MI2_MAX_VAR_DIMS];
+  long count;                   /* Number of chunks */
+  size_t chunk_voxels;          /* Voxels in a whole chunk */
+  size_t voxel_size;            /* Bytes per voxel in memory */
+  int is_signed;
+};
+
+struct milabelpair {
+  int label;
+  int chunk;
+};
+
+static int milabel_compare_int(const void *a, const void *b)
+{
+  int x = *(const int *) a;
+  int y = *(const int *) b;
+
+  return (x > y) - (x < y);
+}
+
+static int milabel_compare_pair(const void *a, const void *b)
+{
+  const struct milabelpair *x = a;
+  const struct milabelpair *y = b;
+
+  if (x->label != y->label) {
+    return (x->label > y->label) - (x->label < y->label);
+  }
+  return (x->chunk > y->chunk) - (x->chunk < y->chunk);
+}
+
+static int milabel_grid(mihandle_t volume, struct milabelgrid *grid)
+{
+  hid_t fspc_id;
+  hid_t super_id;
+  int d;
+
+  if (miopen_image_datasets(volume) < 0) {
+    return (MI_ERROR);
+  }
+  if (volume->image_id < 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume has no image");
+  }
+  fspc_id = miget_cached_space(volume->image_id, &volume->image_fspc_id);
+  if (fspc_id < 0) {
+    return (MI_ERROR);
+  }
+  grid->ndims = H5Sget_simple_extent_ndims(fspc_id);
+  if (grid->ndims < 1 || grid->ndims > MI2_MAX_VAR_DIMS) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume has no dimensions");
+  }
+  H5Sget_simple_extent_dims(fspc_id, grid->sizes, NULL);
+
+  if (volume->plist_id < 0 ||
+      H5Pget_layout(volume->plist_id) != H5D_CHUNKED ||
+      H5Pget_chunk(volume->plist_id, grid->ndims, grid->chunk) != grid->ndims) {
+    grid->chunk[0] = 1;
+    for (d = 1; d < grid->ndims; d++) {
+      grid->chunk[d] = grid->sizes[d];
+    }
+  }
+  /* Voxels are read in the memory type of the volume, HDF5 does not
+   * convert enumerations to other integer types */
+  super_id = H5Tget_super(volume->mtype_id);
+  if (super_id < 0) {
+    return MI_LOG_ERROR(MI2_MSG_HDF5,"H5Tget_super");
+  }
+  grid->voxel_size = H5Tget_size(super_id);
+  grid->is_signed = (H5Tget_sign(super_id) == H5T_SGN_2);
+  H5Tclose(super_id);
+  if (grid->voxel_size > sizeof(int)) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Unsupported label type");
+  }
+
+  grid->count = 1;
+  grid->chunk_voxels = 1;
+  for (d = 0; d < grid->ndims; d++) {
+    grid->nchunks[d] = (grid->sizes[d] + grid->chunk[d] - 1) / grid->chunk[d];
+    grid->count *= (long) grid->nchunks[d];
+    grid->chunk_voxels *= grid->chunk[d];
+  }
+  return (MI_NOERROR);
+}
+
+/* Read the voxel values of one chunk as int, returning its origin and
+ * extent */
+static int milabel_read_chunk(mihandle_t volume, const struct milabelgrid *grid,
+                              long chunk, hsize_t start[], hsize_t count[],
+                              int *buffer)
+{
+  unsigned char *bytes = (unsigned char *) buffer;
+  hid_t fspc_id;
+  hid_t mspc_id;
+  herr_t result;
+  long rest = chunk;
+  size_t n = 1;
+  size_t i;
+  int d;
+
+  for (d = grid->ndims - 1; d >= 0; d--) {
+    start[d] = (rest % grid->nchunks[d]) * grid->chunk[d];
+    rest /= (long) grid->nchunks[d];
+    count[d] = grid->sizes[d] - start[d] < grid->chunk[d] ?
+               grid->sizes[d] - start[d] : grid->chunk[d];
+  }
+  fspc_id = miget_cached_space(volume->image_id, &volume->image_fspc_id);
+  MI_CHECK_HDF_CALL_RET(H5Sselect_hyperslab(fspc_id, H5S_SELECT_SET, start, NULL, count, NULL),"H5Sselect_hyperslab");
+  MI_CHECK_HDF_CALL_RET(mspc_id = H5Screate_simple(grid->ndims, count, NULL),"H5Screate_simple");
+  MI_CHECK_HDF_CALL(result = H5Dread(volume->image_id, volume->mtype_id, mspc_id, fspc_id, H5P_DEFAULT, buffer),"H5Dread");
+  H5Sclose(mspc_id);
+  if (result < 0) {
+    return (MI_ERROR);
+  }
+
+  /* Widen the values in place, from the last one */
+  for (d = 0; d < grid->ndims; d++) {
+    n *= count[d];
+  }
+  for (i = n; i-- > 0; ) {
+    const unsigned char *voxel = bytes + i * grid->voxel_size;
+    unsigned short us;
+    int value;
+
+    switch (grid->voxel_size) {
+    case 1:
+      value = grid->is_signed ? (int) *(const signed char *) voxel : (int) *voxel;
+      break;
+    case 2:
+      memcpy(&us, voxel, sizeof(us));
+      value = grid->is_signed ? (int) (short) us : (int) us;
+      break;
+    default:
+      memcpy(&value, voxel, sizeof(int));
+      break;
+    }
+    buffer[i] = value;
+  }
+  return (MI_NOERROR);
+}
+
+static hssize_t milabel_attr_length(hid_t loc_id, const char *name)
+{
+  hssize_t length = -1;
+  hid_t attr_id;
+  hid_t spc_id;
+
+  H5E_BEGIN_TRY {
+    if ((attr_id = H5Aopen(loc_id, name, H5P_DEFAULT)) >= 0) {
+      spc_id = H5Aget_space(attr_id);
+      length = H5Sget_simple_extent_npoints(spc_id);
+      H5Sclose(spc_id);
+      H5Aclose(attr_id);
+    }
+  } H5E_END_TRY;
+  return length;
+}
+
+/** Build an index of the chunks of the image which contain each label
+ * and store it in the file, where miget_label_voxels() uses it. The index
+ * is removed as soon as the image data change.
+ * \ingroup mi2Label
+ */
+int micreate_label_index(mihandle_t volume)
+{
+  struct milabelgrid grid;
+  struct milabelpair *pairs = NULL;
+  hsize_t start[MI2_MAX_VAR_DIMS];
+  hsize_t count[MI2_MAX_VAR_DIMS];
+  int chunk_shape[MI2_MAX_VAR_DIMS];
+  int *buffer = NULL;
+  int *labels = NULL;
+  int *offsets = NULL;
+  int *chunks = NULL;
+  size_t n_pairs = 0;
+  size_t alloc_pairs = 0;
+  size_t i;
+  int n_labels = 0;
+  long chunk;
+  int d;
+  int status = MI_ERROR;
+
+  if (volume == NULL) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to use null volume");
+  }
+  if (volume->volume_class != MI_CLASS_LABEL) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume class is not label");
+  }
+  if ((volume->mode & MI2_OPEN_RDWR) == 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume is not open for writing");
+  }
+  if (milabel_grid(volume, &grid) < 0) {
+    return (MI_ERROR);
+  }
+  buffer = malloc(grid.chunk_voxels * sizeof(int));
+  if (buffer == NULL) {
+    return MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)(grid.chunk_voxels * sizeof(int)));
+  }
+
+  /* Collect the distinct labels of each chunk */
+  for (chunk = 0; chunk < grid.count; chunk++) {
+    size_t n = 1;
+
+    if (milabel_read_chunk(volume, &grid, chunk, start, count, buffer) < 0) {
+      goto cleanup;
+    }
+    for (d = 0; d < grid.ndims; d++) {
+      n *= count[d];
+    }
+    qsort(buffer, n, sizeof(int), milabel_compare_int);
+    for (i = 0; i < n; i++) {
+      if (i > 0 && buffer[i] == buffer[i - 1]) {
+        continue;
+      }
+      if (n_pairs == alloc_pairs) {
+        struct milabelpair *tmp;
+
+        alloc_pairs = alloc_pairs ? alloc_pairs * 2 : 256;
+        tmp = realloc(pairs, alloc_pairs * sizeof(struct milabelpair));
+        if (tmp == NULL) {
+          MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)(alloc_pairs * sizeof(struct milabelpair)));
+          goto cleanup;
+        }
+        pairs = tmp;
+      }
+      pairs[n_pairs].label = buffer[i];
+      pairs[n_pairs].chunk = (int) chunk;
+      n_pairs++;
+    }
+  }
+  qsort(pairs, n_pairs, sizeof(struct milabelpair), milabel_compare_pair);
+
+  /* Store the chunks of each label one after the other */
+  labels = malloc((n_pairs + 1) * sizeof(int));
+  offsets = malloc((n_pairs + 1) * sizeof(int));
+  chunks = malloc((n_pairs + 1) * sizeof(int));
+  if (labels == NULL || offsets == NULL || chunks == NULL) {
+    MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)(n_pairs * sizeof(int)));
+    goto cleanup;
+  }
+  for (i = 0; i < n_pairs; i++) {
+    if (i == 0 || pairs[i].label != pairs[i - 1].label) {
+      labels[n_labels] = pairs[i].label;
+      offsets[n_labels] = (int) i;
+      n_labels++;
+    }
+    chunks[i] = pairs[i].chunk;
+  }
+  offsets[n_labels] = (int) n_pairs;
+  for (d = 0; d < grid.ndims; d++) {
+    chunk_shape[d] = (int) grid.chunk[d];
   }
 
+  /* The offsets are written last, they mark the index complete */
+  volume->label_index_stale = FALSE;
+  H5E_BEGIN_TRY {
+    if (H5Lexists(volume->hdf_id, MI_LABEL_INDEX_PATH, H5P_DEFAULT) > 0) {
+      H5Ldelete(volume->hdf_id, MI_LABEL_INDEX_PATH, H5P_DEFAULT);
+    }
+  } H5E_END_TRY;
+  if (n_labels > 0 &&
+      (miset_attr_values(volume, MI_TYPE_INT, MI_LABEL_INDEX_NAME,
+                         "chunk_shape", grid.ndims, chunk_shape) < 0 ||
+       miset_attr_values(volume, MI_TYPE_INT, MI_LABEL_INDEX_NAME,
+                         "labels", n_labels, labels) < 0 ||
+       miset_attr_values(volume, MI_TYPE_INT, MI_LABEL_INDEX_NAME,
+                         "chunks", n_pairs, chunks) < 0 ||
+       miset_attr_values(volume, MI_TYPE_INT, MI_LABEL_INDEX_NAME,
+                         "offsets", n_labels + 1, offsets) < 0)) {
+    MI_LOG_ERROR(MI2_MSG_GENERIC,"Can't store label index");
+    goto cleanup;
+  }
+  status = MI_NOERROR;
+
+cleanup:
+  free(buffer);
+  free(pairs);
+  free(labels);
+  free(offsets);
+  free(chunks);
+  return (status);
+}
+
+/* The chunks which contain a label according to the stored index. Without
+ * a usable index *chunks is NULL and every chunk must be read. */
+static int milabel_index_chunks(mihandle_t volume,
+                                const struct milabelgrid *grid, int value,
+                                int **chunks, long *n_chunks)
+{
+  int chunk_shape[MI2_MAX_VAR_DIMS];
+  int *labels = NULL;
+  int *offsets = NULL;
+  int *found;
+  hssize_t n_labels, n_all;
+  htri_t exists = 0;
+  hid_t dset_id;
+  int d;
+
+  *chunks = NULL;
+  *n_chunks = grid->count;
+  if (volume->label_index_stale) {
+    return (MI_NOERROR);
+  }
   H5E_BEGIN_TRY {
-    result = H5Tget_member_value(volume->mtype_id,idx,value);
+    exists = H5Lexists(volume->hdf_id, MI_LABEL_INDEX_PATH, H5P_DEFAULT);
   } H5E_END_TRY;
+  if (exists <= 0 ||
+      (dset_id = midescend_path(volume->hdf_id, MI_LABEL_INDEX_PATH)) < 0) {
+    return (MI_NOERROR);
+  }
 
-  MI_CHECK_HDF_CALL_RET(result,"H5Tget_member_value");
+  n_labels = milabel_attr_length(dset_id, "labels");
+  n_all = milabel_attr_length(dset_id, "chunks");
+  if (n_labels < 1 || n_all < 1 ||
+      milabel_attr_length(dset_id, "offsets") != n_labels + 1 ||
+      milabel_attr_length(dset_id, "chunk_shape") != grid->ndims ||
+      miget_attr_at_loc(dset_id, "chunk_shape", MI_TYPE_INT, grid->ndims,
+                        chunk_shape) < 0) {
+    goto cleanup;
+  }
+  /* An index made for another chunk layout is of no use */
+  for (d = 0; d < grid->ndims; d++) {
+    if ((hsize_t) chunk_shape[d] != grid->chunk[d]) {
+      goto cleanup;
+    }
+  }
+  labels = malloc(n_labels * sizeof(int));
+  offsets = malloc((n_labels + 1) * sizeof(int));
+  if (labels == NULL || offsets == NULL ||
+      miget_attr_at_loc(dset_id, "labels", MI_TYPE_INT, n_labels, labels) < 0 ||
+      miget_attr_at_loc(dset_id, "offsets", MI_TYPE_INT, n_labels + 1,
+                        offsets) < 0) {
+    goto cleanup;
+  }
+
+  found = bsearch(&value, labels, n_labels, sizeof(int), milabel_compare_int);
+  if (found == NULL) {
+    *chunks = malloc(sizeof(int));
+    *n_chunks = 0;
+  } else {
+    int *all = malloc(n_all * sizeof(int));
+    long first = offsets[found - labels];
+
+    *n_chunks = offsets[found - labels + 1] - first;
+    *chunks = malloc((*n_chunks + 1) * sizeof(int));
+    if (all != NULL && *chunks != NULL &&
+        miget_attr_at_loc(dset_id, "chunks", MI_TYPE_INT, n_all, all) >= 0) {
+      memcpy(*chunks, all + first, *n_chunks * sizeof(int));
+    } else {
+      free(*chunks);
+      *chunks = NULL;
+      *n_chunks = grid->count;
+    }
+    free(all);
+  }
 
+cleanup:
+  free(labels);
+  free(offsets);
+  H5Dclose(dset_id);
   return (MI_NOERROR);
 }
 
+/** Find the voxels of a label volume which have the given label. On
+ * return \a coords holds the \a n_voxels voxel coordinates, one after the
+ * other, each in the apparent order of the dimensions. It must be freed
+ * with free(). If an index was stored by micreate_label_index() only the
+ * chunks which contain the label are read.
+ * \ingroup mi2Label
+ */
+int miget_label_voxels(mihandle_t volume, int value, misize_t *n_voxels,
+                       misize_t **coords)
+{
+  struct milabelgrid grid;
+  hsize_t start[MI2_MAX_VAR_DIMS];
+  hsize_t count[MI2_MAX_VAR_DIMS];
+  hsize_t hdf_start[MI2_MAX_VAR_DIMS];
+  hsize_t hdf_count[MI2_MAX_VAR_DIMS];
+  misize_t zero[MI2_MAX_VAR_DIMS];
+  misize_t one[MI2_MAX_VAR_DIMS];
+  int dir[MI2_MAX_VAR_DIMS];
+  int file_dim[MI2_MAX_VAR_DIMS];
+  int *buffer = NULL;
+  int *chunks = NULL;
+  misize_t *result = NULL;
+  size_t n_result = 0;
+  size_t alloc_result = 0;
+  long n_chunks;
+  long c;
+  int d;
+  int status = MI_ERROR;
+
+  if (volume == NULL || n_voxels == NULL || coords == NULL) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to use null volume or variable");
+  }
+  if (volume->volume_class != MI_CLASS_LABEL) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume class is not label");
+  }
+  if (milabel_grid(volume, &grid) < 0 ||
+      milabel_index_chunks(volume, &grid, value, &chunks, &n_chunks) < 0) {
+    return (MI_ERROR);
+  }
+
+  /* The file dimension and direction of each apparent dimension */
+  for (d = 0; d < grid.ndims; d++) {
+    zero[d] = 0;
+    one[d] = 1;
+    file_dim[d] = volume->dim_indices != NULL ? volume->dim_indices[d] : d;
+  }
+  mitranslate_hyperslab_origin(volume, zero, one, hdf_start, hdf_count, dir);
+
+  buffer = malloc(grid.chunk_voxels * sizeof(int));
+  if (buffer == NULL) {
+    MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)(grid.chunk_voxels * sizeof(int)));
+    goto cleanup;
+  }
+
+  for (c = 0; c < n_chunks; c++) {
+    hsize_t position[MI2_MAX_VAR_DIMS];
+    size_t n = 1;
+    size_t i;
+
+    if (milabel_read_chunk(volume, &grid, chunks != NULL ? chunks[c] : c,
+                           start, count, buffer) < 0) {
+      goto cleanup;
+    }
+    for (d = 0; d < grid.ndims; d++) {
+      n *= count[d];
+      position[d] = 0;
+    }
+    for (i = 0; i < n; i++) {
+      if (buffer[i] == value) {
+        misize_t *voxel;
+
+        if (n_result == alloc_result) {
+          misize_t *tmp;
+
+          alloc_result = alloc_result ? alloc_result * 2 : 1024;
+          tmp = realloc(result, alloc_result * grid.ndims * sizeof(misize_t));
+          if (tmp == NULL) {
+            MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)(alloc_result * grid.ndims * sizeof(misize_t)));
+            goto cleanup;
+          }
+          result = tmp;
+        }
+        voxel = result + n_result * grid.ndims;
+        for (d = 0; d < grid.ndims; d++) {
+          int f = file_dim[d];
+          hsize_t coord = start[f] + position[f];
+
+          voxel[d] = dir[d] > 0 ? coord : grid.sizes[f] - 1 - coord;
+        }
+        n_result++;
+      }
+      /* Next position within the chunk, the last dimension fastest */
+      for (d = grid.ndims - 1; d >= 0; d--) {
+        if (++position[d] < count[d]) {
+          break;
+        }
+        position[d] = 0;
+      }
+    }
+  }
+  *n_voxels = n_result;
+  *coords = result;
+  result = NULL;
+  status = MI_NOERROR;
+
+cleanup:
+  free(result);
+  free(buffer);
+  free(chunks);
+  return (status);
+}
+
 /* kate: indent-mode cstyle; indent-width 2; replace-tabs on; */
@@ -294,14 +294,11 @@ int miset_attr_at_loc ( hid_t hdf_loc, const char *name, mitype_t data_type,
   hid_t mtyp_id=-1;
   hid_t spc_id=-1;
   hid_t hdf_attr=-1;
+  hid_t old_typ=-1;
+  hid_t old_spc=-1;
   hsize_t hdf_len;
   int status=MI_ERROR;
 
-  H5E_BEGIN_TRY {
-    /* Delete attribute if it already exists. */
-    H5Adelete ( hdf_loc, name );
-  } H5E_END_TRY;
-
   switch ( data_type ) {
   case MI_TYPE_INT:
     ftyp_id = H5Tcopy ( H5T_STD_I32LE );
@@ -334,7 +331,30 @@ int miset_attr_at_loc ( hid_t hdf_loc, const char *name, mitype_t data_type,
       goto cleanup;
   }
 
-  if((hdf_attr = H5Acreate2 ( hdf_loc, name, ftyp_id, spc_id, H5P_DEFAULT, H5P_DEFAULT  ))<0)
+  /* An attribute of the same type and size is overwritten in place, any
+   * other is deleted and created again, which moves it in the file.
+   */
+  if ( H5Aexists ( hdf_loc, name ) > 0 ) {
+    if ( ( hdf_attr = H5Aopen ( hdf_loc, name, H5P_DEFAULT ) ) < 0 )
+      goto cleanup;
+
+    old_typ = H5Aget_type ( hdf_attr );
+    old_spc = H5Aget_space ( hdf_attr );
+
+    if ( old_typ < 0 || old_spc < 0 ||
+         H5Tequal ( old_typ, ftyp_id ) <= 0 ||
+         H5Sget_simple_extent_type ( old_spc ) != H5Sget_simple_extent_type ( spc_id ) ||
+         H5Sget_simple_extent_npoints ( old_spc ) != H5Sget_simple_extent_npoints ( spc_id ) ) {
+      H5Aclose ( hdf_attr );
+      hdf_attr = -1;
+
+      if ( H5Adelete ( hdf_loc, name ) < 0 )
+        goto cleanup;
+    }
+  }
+
+  if ( hdf_attr < 0 &&
+       (hdf_attr = H5Acreate2 ( hdf_loc, name, ftyp_id, spc_id, H5P_DEFAULT, H5P_DEFAULT  ))<0)
     goto cleanup;
   
   
@@ -348,6 +368,8 @@ cleanup:
   if(ftyp_id  >=0 )  H5Tclose ( ftyp_id );
   if(mtyp_id  >=0 )  H5Tclose ( mtyp_id );
   if(spc_id   >=0 )  H5Sclose ( spc_id );
+  if(old_typ  >=0 )  H5Tclose ( old_typ );
+  if(old_spc  >=0 )  H5Sclose ( old_spc );
   return status;
 }
 
@@ -387,30 +409,18 @@ int miset_attribute ( mihandle_t volume, const char *path, const char *name,
   return ( MI_NOERROR );
 }
 
-/** Get a double attribute from a minc file */
-int miget_attribute ( mihandle_t volume, const char *path, const char *name,
-                      mitype_t data_type, size_t length, void *values )
+/** Get an attribute of an open group or dataset. A missing attribute is
+ * reported as MI_ERROR without going through the HDF5 error stack.
+ */
+int miget_attr_at_loc ( hid_t hdf_loc, const char *name, mitype_t data_type,
+                        size_t length, void *values )
 {
-  hid_t hdf_file;
-  hid_t hdf_loc;
   hid_t mtyp_id = -1;         /* Parameter type */
   hid_t spc_id = -1;
   hid_t hdf_attr = -1;
   int status = MI_ERROR;      /* Guilty until proven innocent */
 
-  /* Get a handle to the actual HDF file
-  */
-  hdf_file = volume->hdf_id;
-
-  if ( hdf_file < 0 ) {
-    return ( MI_ERROR );
-  }
-
-  /* Find the group or dataset referenced by the path.
-  */
-  hdf_loc = midescend_path ( hdf_file, path );
-
-  if ( hdf_loc < 0 ) {
+  if ( H5Aexists ( hdf_loc, name ) <= 0 ) {
     return ( MI_ERROR );
   }
 
@@ -496,14 +506,41 @@ cleanup:
     H5Sclose ( spc_id );
   }
 
-  if ( hdf_loc >= 0 ) {
-    /* The hdf_loc identifier could be a group or a dataset.
-    */
-    if ( H5Iget_type ( hdf_loc ) == H5I_GROUP ) {
-      H5Gclose ( hdf_loc );
-    } else {
-      H5Dclose ( hdf_loc );
-    }
+  return ( status );
+}
+
+/** Get a double attribute from a minc file */
+int miget_attribute ( mihandle_t volume, const char *path, const char *name,
+                      mitype_t data_type, size_t length, void *values )
+{
+  hid_t hdf_file;
+  hid_t hdf_loc;
+  int status;
+
+  /* Get a handle to the actual HDF file
+  */
+  hdf_file = volume->hdf_id;
+
+  if ( hdf_file < 0 ) {
+    return ( MI_ERROR );
+  }
+
+  /* Find the group or dataset referenced by the path.
+  */
+  hdf_loc = midescend_path ( hdf_file, path );
+
+  if ( hdf_loc < 0 ) {
+    return ( MI_ERROR );
+  }
+
+  status = miget_attr_at_loc ( hdf_loc, name, data_type, length, values );
+
+  /* The hdf_loc identifier could be a group or a dataset.
+  */
+  if ( H5Iget_type ( hdf_loc ) == H5I_GROUP ) {
+    H5Gclose ( hdf_loc );
+  } else {
+    H5Dclose ( hdf_loc );
   }
 
   return ( status );
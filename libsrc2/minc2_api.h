@@ -93,6 +93,54 @@ int miset_attr_values(mihandle_t vol, mitype_t data_type,
  */
 int miadd_history_attr(mihandle_t vol, size_t length, const void *values);
 
+/** Read all groups, datasets and attributes under the MINC root into
+ * memory in one pass. The snapshot must be freed with mifree_metadata().
+ * \ingroup mi2Group
+ */
+int miget_metadata(mihandle_t vol, mimetadata_t *metadata);
+
+/** Free a metadata snapshot.
+ * \ingroup mi2Group
+ */
+int mifree_metadata(mimetadata_t metadata);
+
+/** Look up an attribute in a metadata snapshot. The path is either an
+ * absolute HDF5 path or one as given to miget_attr_values(). Integers are
+ * returned as int, floats as float or double depending on how they are
+ * stored, and strings are null-terminated. The values belong to the
+ * snapshot.
+ * \ingroup mi2Group
+ */
+int miget_metadata_attr(mimetadata_t metadata, const char *path,
+                        const char *name, mitype_t *data_type,
+                        size_t *length, const void **values);
+
+/** Get the number of groups and datasets in a metadata snapshot.
+ * \ingroup mi2Group
+ */
+int miget_metadata_group_count(mimetadata_t metadata, int *count);
+
+/** Get the absolute path and attribute count of a group or dataset in a
+ * metadata snapshot.
+ * \ingroup mi2Group
+ */
+int miget_metadata_group(mimetadata_t metadata, int index,
+                         const char **path, int *attr_count);
+
+/** Get an attribute of a group or dataset in a metadata snapshot by index.
+ * \ingroup mi2Group
+ */
+int miget_metadata_attr_by_index(mimetadata_t metadata, int group,
+                                 int index, const char **name,
+                                 mitype_t *data_type, size_t *length,
+                                 const void **values);
+
+/** Serialize a metadata snapshot as JSON. The string must be freed with
+ * mifree_name().
+ * \ingroup mi2Group
+ */
+int miget_metadata_json(mimetadata_t metadata, char **json);
+
 /** \defgroup mi2Memory FREE FUNCTIONS */
 
 /**
@@ -744,10 +792,48 @@ int miget_volume_voxel_count(mihandle_t volume, misize_t *number_of_voxels);
 
 /** Opens an existing MINC volume for read-only access if mode argument is
   * MI2_OPEN_READ, or read-write access if mode argument is MI2_OPEN_RDWR.
+  * With MI2_OPEN_READ|MI2_OPEN_HEADER only the dimensions and attributes
+  * are read; the image, image-max and image-min datasets are opened on
+  * the first call that needs them, such as miget_data_type() or a
+  * hyperslab read.
   * \ingroup mi2Vol
 */
 int miopen_volume(const char *filename, int mode, mihandle_t *volume);
 
+/** Opens an existing MINC volume like miopen_volume(), using the chunk
+  * cache settings from \a props (see miset_props_chunk_cache()). Other
+  * properties are ignored. \a props may be NULL.
+  * \ingroup mi2Vol
+*/
+int miopen_volume_with_props(const char *filename, int mode,
+                             mivolumeprops_t props, mihandle_t *volume);
+
+/** Get the raw data chunk cache size, number of hash slots and
+  * preemption policy actually used for the image dataset of \a volume.
+  * \ingroup mi2Vol
+*/
+int miget_volume_chunk_cache(mihandle_t volume, size_t *nbytes,
+                             size_t *nslots, double *w0);
+
+/** Get the file offset and size in bytes of the image of the selected
+  * resolution of \a volume, for mapping it into memory. \a nbytes is
+  * set to 0 unless the image is stored contiguous and uncompressed in
+  * the file itself, with voxels of \a type in native byte order.
+  * \ingroup mi2Vol
+*/
+int miget_volume_image_storage(mihandle_t volume, mitype_t type,
+                               misize_t *offset, misize_t *nbytes);
+
+/** Get the hit rate (0 to 1) of the HDF5 metadata cache of \a volume,
+  * which holds object headers and the chunk index. This is not the raw
+  * data chunk cache set with miset_props_chunk_cache() or
+  * miget_volume_chunk_cache(), HDF5 publishes no counters for that one.
+  * If \a reset is TRUE the statistics are restarted after reading them.
+  * \ingroup mi2Vol
+*/
+int miget_volume_metadata_cache_hit_rate(mihandle_t volume, double *hit_rate,
+                                         miboolean_t reset);
+
 
 /** Close an existing MINC volume. If the volume was newly created,
   *  all changes will be written to disk. In all cases this function closes
@@ -912,6 +998,124 @@ int miset_props_checksum(mivolumeprops_t props, int on);
  */
 int miget_props_checksum(mivolumeprops_t props, int *on);
 
+/** Enable the HDF5 byte shuffle filter, which groups the high and low
+ * bytes of multi-byte voxels together before compression. This
+ * usually improves the compression ratio of 16-bit images and speeds up
+ * decompression. Enabling shuffle turns on chunking.
+ * \param props A volume property list handle
+ * \param on TRUE to enable shuffling
+ * \ingroup mi2VPrp
+ */
+int miset_props_shuffle(mivolumeprops_t props, int on);
+
+/** Get byte shuffle setting for volume
+ * \ingroup mi2VPrp
+ */
+int miget_props_shuffle(mivolumeprops_t props, int *on);
+
+/** Enable the lossless HDF5 scale-offset prefilter for integer volumes.
+ * Each chunk is stored as offsets from its minimum using only as many
+ * bits as needed. The setting is ignored for floating point volumes.
+ * Enabling scale-offset turns on chunking.
+ * \param props A volume property list handle
+ * \param on TRUE to enable the scale-offset filter
+ * \ingroup mi2VPrp
+ */
+int miset_props_scaleoffset(mivolumeprops_t props, int on);
+
+/** Get scale-offset setting for volume
+ * \ingroup mi2VPrp
+ */
+int miget_props_scaleoffset(mivolumeprops_t props, int *on);
+
+/** Declare how the volume is expected to be read, so that the chunk
+ * shape can be chosen to match. MI_ACCESS_SLICE stores each slice
+ * through the two fastest-varying dimensions in one chunk,
+ * MI_ACCESS_CUBE uses small cubic chunks for random block access and
+ * MI_ACCESS_TIMESERIES keeps the whole time course of a voxel in one
+ * chunk. Any pattern other than MI_ACCESS_DEFAULT turns on chunking;
+ * it is ignored when explicit chunk sizes are set with
+ * miset_props_blocking().
+ * \param props A volume property list handle
+ * \param access_pattern The expected access pattern
+ * \ingroup mi2VPrp
+ */
+int miset_props_access_pattern(mivolumeprops_t props,
+                                miaccess_pattern_t access_pattern);
+
+/** Get the expected access pattern from a volume property list
+ * \ingroup mi2VPrp
+ */
+int miget_props_access_pattern(mivolumeprops_t props,
+                                miaccess_pattern_t *access_pattern);
+
+/** Set the raw data chunk cache used for a volume opened with
+ * miopen_volume_with_props() or created with micreate_volume(),
+ * instead of the process-wide MINC_FILE_CACHE setting.
+ * \param props A volume property list handle
+ * \param nbytes Cache size in bytes, or 0 to size it from the chunk layout
+ * \param nslots Number of hash table slots, or 0 to derive it from the
+ * chunk size (HDF5 recommends about 100 per cached chunk, ideally prime)
+ * \param w0 Preemption policy between 0 and 1 (1 evicts fully read
+ * chunks first), or a negative value for the default of 1
+ * \ingroup mi2VPrp
+ */
+int miset_props_chunk_cache(mivolumeprops_t props, size_t nbytes,
+                            size_t nslots, double w0);
+
+/** Get the chunk cache settings from a volume property list
+ * \ingroup mi2VPrp
+ */
+int miget_props_chunk_cache(mivolumeprops_t props, size_t *nbytes,
+                            size_t *nslots, double *w0);
+
+/** Reserve space in the header of a new volume for the global attributes,
+ * such as the history, so that they can be rewritten and grow up to that
+ * size without the file growing or leaving unused space behind.
+ * \param props A volume property list handle
+ * \param nbytes Bytes to reserve, or 0 for none; at most 60000 are used
+ * \ingroup mi2VPrp
+ */
+int miset_props_metadata_reserve(mivolumeprops_t props, size_t nbytes);
+
+/** Get the header space reserved by a volume property list
+ * \ingroup mi2VPrp
+ */
+int miget_props_metadata_reserve(mivolumeprops_t props, size_t *nbytes);
+
+/** Keep statistics of the real voxel values, with a histogram of \a bins
+ * bins, stored in a volume created with micreate_volume() or opened with
+ * miopen_volume_with_props(). They are recomputed when the volume is
+ * closed if its data or scaling were changed. See
+ * micompute_volume_statistics().
+ * \param props A volume property list handle
+ * \param bins Number of histogram bins, or 0 to not keep statistics
+ * \ingroup mi2VPrp
+ */
+int miset_props_statistics(mivolumeprops_t props, int bins);
+
+/** Get the number of histogram bins of the statistics kept for a volume
+ * \ingroup mi2VPrp
+ */
+int miget_props_statistics(mivolumeprops_t props, int *bins);
+
+/** Store each component of the record (vector) dimension of a new volume
+ * in chunks of its own, so that the components are stored one after the
+ * other rather than interleaved voxel by voxel. Reading one component
+ * with miget_voxel_component_hyperslab() then reads only its chunks.
+ * This turns chunking on, with the chunk shape otherwise chosen as
+ * usual.
+ * \param props A volume property list handle
+ * \param planar TRUE to store the components planar
+ * \ingroup mi2VPrp
+ */
+int miset_props_planar_components(mivolumeprops_t props, miboolean_t planar);
+
+/** Get whether record components are stored planar
+ * \ingroup mi2VPrp
+ */
+int miget_props_planar_components(mivolumeprops_t props, miboolean_t *planar);
+
 
 
 /** Set properties for uniform/nonuniform record dimension
@@ -1176,6 +1380,30 @@ int miset_voxel_value_hyperslab(mihandle_t volume,
                                        const misize_t count[],
                                        void *buffer);
 
+/** Read one component of the record (vector) dimension of a hyperslab
+ * into the preallocated buffer, with no range conversions. The start and
+ * count given for the record dimension are ignored, the buffer holds the
+ * voxels of the other dimensions only.
+ * \ingroup mi2Hyper
+ */
+int miget_voxel_component_hyperslab(mihandle_t volume,
+                                    mitype_t buffer_data_type,
+                                    int component,
+                                    const misize_t start[],
+                                    const misize_t count[],
+                                    void *buffer);
+
+/** Read one component of the record (vector) dimension of a hyperslab,
+ * converted to real values as by miget_real_value_hyperslab().
+ * \ingroup mi2Hyper
+ */
+int miget_real_component_hyperslab(mihandle_t volume,
+                                   mitype_t buffer_data_type,
+                                   int component,
+                                   const misize_t start[],
+                                   const misize_t count[],
+                                   void *buffer);
+
 
 /** \defgroup mi2Cvt CONVERT FUNCTIONS */
 
@@ -1332,6 +1560,42 @@ int miget_voxel_value(mihandle_t volume,
                              int ndims,
                              double *voxel_ptr);
 
+/** This function retrieves the voxel values of many positions in the
+ * MINC volume at once. The points are read with a single selection,
+ * ordered so that each chunk of the image is visited once.
+ *
+ * \param volume A volume handle
+ * \param n The number of points
+ * \param ndims The number of coordinates of each point
+ * \param coords The voxel positions, \a ndims values per point
+ * \param voxels Array of \a n doubles to hold the returned values
+ *
+ * \ingroup mi2Cvt
+ */
+int miget_voxel_values_at(mihandle_t volume,
+                                 misize_t n,
+                                 int ndims,
+                                 const misize_t coords[],
+                                 double voxels[]);
+
+/** This function retrieves the real values of many positions in the
+ * MINC volume at once, like miget_voxel_values_at(), and scales them
+ * with the slice or volume range.
+ *
+ * \param volume A volume handle
+ * \param n The number of points
+ * \param ndims The number of coordinates of each point
+ * \param coords The voxel positions, \a ndims values per point
+ * \param values Array of \a n doubles to hold the returned values
+ *
+ * \ingroup mi2Cvt
+ */
+int miget_real_values_at(mihandle_t volume,
+                                misize_t n,
+                                int ndims,
+                                const misize_t coords[],
+                                double values[]);
+
 
 /** This function sets the voxel value of a position in the MINC
  * volume.  The voxel value is the unscaled value, and corresponds to the
@@ -1471,6 +1735,84 @@ int miget_number_of_defined_labels(mihandle_t volume, int *number_of_labels);
 */
 int miget_label_value_by_index(mihandle_t volume, int idx, int *value);
 
+/**
+ * This function stores in a label volume open for writing an index of
+ * the image chunks which contain each label value. The index is removed
+ * when the image data change.
+ * \ingroup mi2Label
+ */
+int micreate_label_index(mihandle_t volume);
+
+/**
+ * This function returns the coordinates, in apparent dimension order, of
+ * the \a n_voxels voxels which have the label \a value. Only the chunks
+ * containing the label are read if an index was stored with
+ * micreate_label_index(). The coordinates must be freed with free().
+ * \ingroup mi2Label
+ */
+int miget_label_voxels(mihandle_t volume, int value, misize_t *n_voxels,
+                       misize_t **coords);
+
+/** \defgroup mi2Stats VOLUME STATISTICS functions */
+
+/** Compute the count, range, sum, sum of squares, mean, standard
+ * deviation and a histogram of \a bins equal bins of the real voxel values of a volume, in one pass
+ * over the image. If the volume is open for writing the statistics are
+ * stored in the file, where miget_volume_statistics() finds them until
+ * the data, scaling or valid range of the volume change. If \a stats is
+ * not NULL it receives the result, which must be released with
+ * mifree_volume_statistics().
+ * \ingroup mi2Stats
+ */
+int micompute_volume_statistics(mihandle_t volume, int bins,
+                                mivolstats_t *stats);
+
+/** Compute the same statistics over the voxels where the real value of
+ * \a mask, a volume of the same dimensions, is at least 0.5. With a NULL
+ * mask this is micompute_volume_statistics(). No histogram is made if
+ * \a bins is 0. The image is read in blocks of at most
+ * MINC_MAX_FILE_BUFFER_KB kilobytes, following its chunks.
+ * \ingroup mi2Stats
+ */
+int micompute_masked_statistics(mihandle_t volume, mihandle_t mask, int bins,
+                                mivolstats_t *stats);
+
+/** Compute the statistics of the real voxel values of a volume for each
+ * distinct value of the label volume \a labels, rounded to an integer,
+ * optionally within \a mask. The \a n_labels labels found are returned in
+ * increasing order in \a label_values, with their statistics in \a stats.
+ * Both arrays must be released with mifree_label_statistics().
+ * \ingroup mi2Stats
+ */
+int micompute_label_statistics(mihandle_t volume, mihandle_t labels,
+                               mihandle_t mask, int bins, int *n_labels,
+                               int **label_values, mivolstats_t **stats);
+
+/** Release the arrays returned by micompute_label_statistics().
+ * \ingroup mi2Stats
+ */
+int mifree_label_statistics(int n_labels, int *label_values,
+                            mivolstats_t *stats);
+
+/** Read the statistics stored in a volume, without reading the image.
+ * Fails if none were stored or they are out of date. The result must be
+ * released with mifree_volume_statistics().
+ * \ingroup mi2Stats
+ */
+int miget_volume_statistics(mihandle_t volume, mivolstats_t *stats);
+
+/** Release the histogram of a statistics structure.
+ * \ingroup mi2Stats
+ */
+int mifree_volume_statistics(mivolstats_t *stats);
+
+/** Estimate a percentile of the real voxel values from the histogram,
+ * for example 50 for the median.
+ * \ingroup mi2Stats
+ */
+int miget_statistics_percentile(const mivolstats_t *stats, double percent,
+                                double *value);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus defined */
@@ -68,6 +68,15 @@ struct mivolprops {
     char *record_name;
     int  template_flag;
     int checksum;               /*FLETCHER32 checksum is enabled*/
+    int shuffle;                /*byte shuffle before compression*/
+    int scaleoffset;            /*lossless integer scale-offset prefilter*/
+    miaccess_pattern_t access_pattern; /*expected access, sets chunk shape*/
+    size_t cache_bytes;         /*raw chunk cache size, 0 for automatic*/
+    size_t cache_slots;         /*chunk cache hash slots, 0 for automatic*/
+    double cache_w0;            /*chunk cache preemption policy, <0 for default*/
+    size_t metadata_reserve;    /*header bytes reserved for attributes*/
+    int stats_bins;             /*histogram bins of statistics kept up to date on close, 0 for none*/
+    miboolean_t planar_components; /*one record component per chunk*/
 }; 
 
 /** \internal
@@ -92,6 +101,17 @@ struct midimension {
   midimalign_t align;           /* MI_DIMALIGN_CENTRE, MI_DIMALIGN_START */
 };
 
+/** \internal
+ * Scratch buffers kept in the volume handle for value conversion
+ */
+#define MI2_SCRATCH_DATA      0  /* converted or restructured image data */
+#define MI2_SCRATCH_COPY      1  /* copy of the user buffer */
+#define MI2_SCRATCH_SLICE_MIN 2  /* slice minimums */
+#define MI2_SCRATCH_SLICE_MAX 3  /* slice maximums */
+#define MI2_SCRATCH_SLOTS     4
+/* Larger buffers are allocated for one call only */
+#define MI2_SCRATCH_MAX       (16*1024*1024)
+
 /** \internal
  * Volume handle  
  */
@@ -116,9 +136,25 @@ struct mivolume {
   hid_t image_id;               /* Dataset for image */
   hid_t imax_id;                /* Dataset for image-max */
   hid_t imin_id;                /* Dataset for image-min */
+  hid_t image_fspc_id;          /* Cached dataspace of image_id */
+  hid_t imax_fspc_id;           /* Cached dataspace of imax_id */
+  hid_t imin_fspc_id;           /* Cached dataspace of imin_id */
+  mitype_t buffer_type;         /* Type of the cached buffer_type_id */
+  hid_t buffer_type_id;         /* Cached memory type of user buffers */
+  void *scratch[MI2_SCRATCH_SLOTS];        /* Reusable conversion buffers */
+  size_t scratch_size[MI2_SCRATCH_SLOTS];  /* Their allocated sizes */
   double scale_min;             /* Global minimum */
   double scale_max;             /* Global maximum */
   miboolean_t is_dirty;         /* TRUE if data has been modified. */
+  miboolean_t is_deferred;      /* TRUE until the image datasets are opened */
+  miboolean_t open_failed;      /* TRUE if opening the image datasets failed */
+  miboolean_t stats_stale;      /* TRUE once stored statistics were removed */
+  int stats_bins;               /* Recompute statistics on close if not 0 */
+  struct milabeltable *label_table; /* Cached labels, see label.c */
+  miboolean_t label_index_stale; /* TRUE once a stored label index was removed */
+  size_t cache_bytes;           /* Requested chunk cache size, 0 for automatic */
+  size_t cache_slots;           /* Requested chunk cache slots, 0 for automatic */
+  double cache_w0;              /* Requested preemption policy, <0 for default */
 };
 
 /**
@@ -137,6 +173,10 @@ int miget_attribute(mihandle_t volume, const char *varpath,
                            const char *attname, mitype_t data_type, 
                            size_t maxvals, void *values);
 
+int miget_attr_at_loc(hid_t hdf_loc, const char *attname, 
+                             mitype_t data_type, 
+                             size_t maxvals, void *values);
+
 int miset_attr_at_loc(hid_t hdf_loc, const char *attname, 
                              mitype_t data_type, 
                              size_t maxvals, const void *values);
@@ -200,12 +240,37 @@ int mitranslate_hyperslab_origin(mihandle_t volume,
                                 hsize_t* hdf_start,
                                 hsize_t* hdf_count,
                                 int* dir);
+hid_t miget_cached_space(hid_t dset_id, hid_t *fspc_id);
+void *miget_scratch(mihandle_t volume, int slot, size_t size);
+void mirelease_scratch(mihandle_t volume, int slot, void *buffer);
+void mifree_hyperslab_cache(mihandle_t volume);
 /* From volume.c */
 void misave_valid_range(mihandle_t volume);
+int miopen_image_datasets(mihandle_t volume);
+hid_t _miopen_image_dataset(mihandle_t volume, const char *path);
+
+/* From chunk.c */
+int miread_chunks_direct(hid_t dset_id, hid_t mtype_id, void *buffer);
+
+/* From volprops.c */
+/** Registered HDF5 filter identifiers of the optional compression plugins */
+#define MI2_H5Z_FILTER_BLOSC 32001
+#define MI2_H5Z_FILTER_LZ4   32004
+#define MI2_H5Z_FILTER_ZSTD  32015
+
+int miset_plist_compression(hid_t hdf_plist, mivolumeprops_t props);
+int micheck_dataset_filters(hid_t dset_id);
 
 /* From valid.c*/
 void miinit_default_range(mitype_t mitype, double *valid_max, double *valid_min);
 
+/* From stats.c */
+void miinvalidate_statistics(mihandle_t volume);
+
+/* From label.c */
+void mifree_label_table(mihandle_t volume);
+void miinvalidate_label_index(mihandle_t volume);
+
 #ifndef HAVE_RINT
 double rint(double v);
 #endif
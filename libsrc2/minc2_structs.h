@@ -39,6 +39,12 @@ typedef struct mivolume *mihandle_t;
  */
 typedef void *milisthandle_t;
 
+/** \typedef mimetadata_t
+ * The mimetadata_t is an opaque type that represents an in-memory
+ * snapshot of the groups and attributes of a MINC file object.
+ */
+typedef struct mimetadata *mimetadata_t;
+
 /**
  * This typedef used to represent the type of an individual voxel <b>as
  * stored</b> by MINC 2.0. 
@@ -149,9 +155,22 @@ typedef enum {
  */
 typedef enum {
   MI_COMPRESS_NONE = 0,         /**< No compression */
-  MI_COMPRESS_ZLIB = 1          /**< GZIP compression */
+  MI_COMPRESS_ZLIB = 1,         /**< GZIP compression */
+  MI_COMPRESS_ZSTD = 2,         /**< Zstandard, requires HDF5 filter plugin 32015 */
+  MI_COMPRESS_LZ4  = 3,         /**< LZ4, requires HDF5 filter plugin 32004 */
+  MI_COMPRESS_BLOSC = 4         /**< Blosc (LZ4 + byte shuffle), requires HDF5 filter plugin 32001 */
 } micompression_t;
 
+/** \typedef miaccess_pattern_t
+ * Expected way a volume will be read, used to choose its chunk shape
+ */
+typedef enum {
+  MI_ACCESS_DEFAULT = 0,        /**< Chunks sized for the MINC1 API buffer */
+  MI_ACCESS_SLICE = 1,          /**< Whole slices through the two fastest dimensions */
+  MI_ACCESS_CUBE = 2,           /**< Small random blocks of neighbouring voxels */
+  MI_ACCESS_TIMESERIES = 3      /**< All time points of individual voxels */
+} miaccess_pattern_t;
+
 /** \typedef miboolean_t
  * Boolean value
  */
@@ -199,4 +218,22 @@ typedef struct {
   double imag;                  /**< Imaginary part */
 } midcomplex_t;
 
+/** \typedef mivolstats_t
+ * Statistics of the real voxel values of a volume, see
+ * micompute_volume_statistics().
+ */
+typedef struct {
+  misize_t count;               /**< Number of voxels counted */
+  double min;                   /**< Smallest real value */
+  double max;                   /**< Largest real value */
+  double sum;                   /**< Sum of the real values */
+  double sum2;                  /**< Sum of the squares of the real values */
+  double mean;                  /**< Mean real value */
+  double stddev;                /**< Sample standard deviation */
+  int bins;                     /**< Number of histogram bins */
+  double hist_min;              /**< Lower edge of the first bin */
+  double hist_max;              /**< Upper edge of the last bin */
+  double *histogram;            /**< Voxel count of each bin */
+} mivolstats_t;
+
 #endif //MINC2_STRUCTS_H
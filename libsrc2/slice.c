@@ -53,18 +53,23 @@ static int mirw_slice_minmax ( int opcode, mihandle_t volume,
   if ( volume == NULL || value == NULL ) {
     return ( MI_ERROR );    /* Bad parameters */
   }
+  if ( miopen_image_datasets ( volume ) < 0 ) {
+    return ( MI_ERROR );
+  }
 
   if ( !volume->has_slice_scaling ) {
     return mirw_volume_minmax ( opcode, volume, value );
   }
 
+  /* The dataspace is cached in the volume handle, don't close it */
   if ( opcode & MIRW_SCALE_MIN ) {
     dset_id = volume->imin_id;
+    fspc_id = miget_cached_space ( dset_id, &volume->imin_fspc_id );
   } else {
     dset_id = volume->imax_id;
+    fspc_id = miget_cached_space ( dset_id, &volume->imax_fspc_id );
   }
 
-  fspc_id = H5Dget_space ( dset_id );
   if ( fspc_id < 0 ) {
     return ( MI_ERROR );
   }
@@ -95,6 +100,7 @@ static int mirw_slice_minmax ( int opcode, mihandle_t volume,
   mspc_id = H5Screate ( H5S_SCALAR );
 
   if ( opcode & MIRW_SCALE_SET ) {
+    miinvalidate_statistics ( volume );
     result = H5Dwrite ( dset_id, H5T_NATIVE_DOUBLE, mspc_id, fspc_id,
                         H5P_DEFAULT, value );
   } else {
@@ -102,12 +108,11 @@ static int mirw_slice_minmax ( int opcode, mihandle_t volume,
                        H5P_DEFAULT, value );
   }
 
+  H5Sclose ( mspc_id );
+
   if ( result < 0 ) {
     return ( MI_ERROR );
   }
-
-  H5Sclose ( fspc_id );
-  H5Sclose ( mspc_id );
   return ( MI_NOERROR );
 }
 
@@ -251,6 +256,9 @@ static int mirw_volume_minmax ( int opcode, mihandle_t volume, double *value )
   if ( volume == NULL || value == NULL ) {
     return ( MI_ERROR );
   }
+  if ( miopen_image_datasets ( volume ) < 0 ) {
+    return ( MI_ERROR );
+  }
   if ( volume->has_slice_scaling ) {
     return ( MI_ERROR );
   }
@@ -285,6 +293,7 @@ static int mirw_volume_minmax ( int opcode, mihandle_t volume, double *value )
   mspc_id = H5Screate ( H5S_SCALAR );
 
   if ( opcode & MIRW_SCALE_SET ) {
+    miinvalidate_statistics ( volume );
     result = H5Dwrite ( dset_id, H5T_NATIVE_DOUBLE, mspc_id, fspc_id,
                         H5P_DEFAULT, value );
   } else {
@@ -404,6 +413,9 @@ int miget_slice_scaling_flag ( mihandle_t volume, miboolean_t *slice_scaling_fla
   if ( volume == NULL || slice_scaling_flag == NULL ) {
     return ( MI_ERROR );
   }
+  if ( miopen_image_datasets ( volume ) < 0 ) {
+    return ( MI_ERROR );
+  }
   *slice_scaling_flag = volume->has_slice_scaling;
   return ( MI_NOERROR );
 }
@@ -415,6 +427,9 @@ int miset_slice_scaling_flag ( mihandle_t volume, miboolean_t slice_scaling_flag
   if ( volume == NULL ) {
     return ( MI_ERROR );
   }
+  if ( miopen_image_datasets ( volume ) < 0 ) {
+    return ( MI_ERROR );
+  }
   volume->has_slice_scaling = slice_scaling_flag;
   return ( MI_NOERROR );
 }
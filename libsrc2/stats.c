@@ -0,0 +1,829 @@
+/**\file stats.c
+ * \brief MINC 2.0 Volume Statistics Functions
+ *
+ * The statistics of the real voxel values of a volume - count, range, sum,
+ * sum of squares, mean, standard deviation and a histogram - can be
+ * computed once and stored in the
+ * file as the attributes of the "statistics" variable, so that they can
+ * later be read back without scanning the image. They are removed as
+ * soon as the image data, the scaling or the valid range are changed.
+ * The same statistics can be computed within a mask volume, or for each
+ * label of a label volume, reading the image in blocks of bounded size.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif /*HAVE_CONFIG_H*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <hdf5.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "minc_config.h"
+#include "minc2.h"
+#include "minc2_private.h"
+
+#define MI_STATS_NAME "statistics"
+#define MI_STATS_PATH MI_ROOT_PATH "/" MI_INFO_NAME "/" MI_STATS_NAME
+
+/** Largest buffer used to read the image while computing statistics */
+#define _MI2_STATS_BUFFER_BYTES (8*1024*1024)
+
+/** \internal
+ * Remove the stored statistics before the real voxel values change. Only
+ * the first change after the volume is opened, or after the statistics
+ * were last computed, has to do anything.
+ */
+void miinvalidate_statistics(mihandle_t volume)
+{
+  if (volume->stats_stale) {
+    return;
+  }
+  volume->stats_stale = TRUE;
+
+  H5E_BEGIN_TRY {
+    if (H5Lexists(volume->hdf_id, MI_STATS_PATH, H5P_DEFAULT) > 0) {
+      H5Ldelete(volume->hdf_id, MI_STATS_PATH, H5P_DEFAULT);
+    }
+  } H5E_END_TRY;
+}
+
+static int mistats_store(mihandle_t volume, const mivolstats_t *stats)
+{
+  double count = (double) stats->count;
+  double range[2];
+
+  range[0] = stats->hist_min;
+  range[1] = stats->hist_max;
+
+  /* The histogram is written last, it marks the statistics complete */
+  if (miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME, "count", 1,
+                        &count) < 0 ||
+      miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME, "minimum", 1,
+                        &stats->min) < 0 ||
+      miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME, "maximum", 1,
+                        &stats->max) < 0 ||
+      miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME, "sum", 1,
+                        &stats->sum) < 0 ||
+      miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME, "sum2", 1,
+                        &stats->sum2) < 0 ||
+      miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME, "mean", 1,
+                        &stats->mean) < 0 ||
+      miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME, "stddev", 1,
+                        &stats->stddev) < 0 ||
+      miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME,
+                        "histogram_range", 2, range) < 0 ||
+      miset_attr_values(volume, MI_TYPE_DOUBLE, MI_STATS_NAME, "histogram",
+                        stats->bins, stats->histogram) < 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Can't store volume statistics");
+  }
+  return (MI_NOERROR);
+}
+
+/* The statistics engine. The image is read in blocks that follow its
+ * chunk layout and fit in a bounded buffer, together with the matching
+ * blocks of the mask and label volumes. Each block is split into parts
+ * that are accumulated in parallel, one table of per-label accumulators
+ * per thread. Within a part the values are summed relative to the first
+ * value of each label, and the part sums are folded into the running
+ * mean and sum of squared deviations with the pairwise update of Chan et
+ * al., so that the variance does not suffer from cancellation.
+ */
+struct mistatsentry {
+  int label;
+  double n;                   /* Running count, mean and squared deviations */
+  double mean;
+  double m2;
+  double min;
+  double max;
+  double part_n;              /* Sums of the current part, relative to */
+  double part_shift;          /* part_shift */
+  double part_s1;
+  double part_s2;
+  double *histogram;
+};
+
+struct mistatstable {
+  int count;
+  int alloc;
+  int last;                   /* Entry of the last label looked up */
+  struct mistatsentry *entries; /* Sorted by label */
+};
+
+/** Values per part accumulated by one thread at a time */
+#define _MI2_STATS_PART_SIZE 65536
+
+static struct mistatsentry *mistats_entry(struct mistatstable *table,
+                                          int label, int bins)
+{
+  struct mistatsentry *entry;
+  int lo = 0, hi = table->count;
+
+  if (table->last < table->count &&
+      table->entries[table->last].label == label) {
+    return &table->entries[table->last];
+  }
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+
+    if (table->entries[mid].label < label) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == table->count || table->entries[lo].label != label) {
+    if (table->count == table->alloc) {
+      int n = table->alloc ? table->alloc * 2 : 16;
+
+      entry = realloc(table->entries, n * sizeof(struct mistatsentry));
+      if (entry == NULL) {
+        return NULL;
+      }
+      table->entries = entry;
+      table->alloc = n;
+    }
+    entry = &table->entries[lo];
+    memmove(entry + 1, entry, (table->count - lo) * sizeof(*entry));
+    memset(entry, 0, sizeof(*entry));
+    entry->label = label;
+    entry->min = DBL_MAX;
+    entry->max = -DBL_MAX;
+    if (bins > 0 && (entry->histogram = calloc(bins, sizeof(double))) == NULL) {
+      memmove(entry, entry + 1, (table->count - lo) * sizeof(*entry));
+      return NULL;
+    }
+    table->count++;
+  }
+  table->last = lo;
+  return &table->entries[lo];
+}
+
+/* Combine count, mean and squared deviations of two sets of values */
+static void mistats_merge(struct mistatsentry *entry, double n, double mean,
+                          double m2)
+{
+  double total = entry->n + n;
+  double delta = mean - entry->mean;
+
+  if (n <= 0.0) {
+    return;
+  }
+  entry->mean += delta * n / total;
+  entry->m2 += m2 + delta * delta * entry->n * n / total;
+  entry->n = total;
+}
+
+static void mistats_flush_part(struct mistatstable *table)
+{
+  int i;
+
+  for (i = 0; i < table->count; i++) {
+    struct mistatsentry *entry = &table->entries[i];
+
+    if (entry->part_n > 0.0) {
+      double mean = entry->part_s1 / entry->part_n;
+
+      mistats_merge(entry, entry->part_n, entry->part_shift + mean,
+                    entry->part_s2 - entry->part_s1 * mean);
+      entry->part_n = entry->part_s1 = entry->part_s2 = 0.0;
+    }
+  }
+}
+
+static void mistats_free_table(struct mistatstable *table)
+{
+  int i;
+
+  for (i = 0; i < table->count; i++) {
+    free(table->entries[i].histogram);
+  }
+  free(table->entries);
+  memset(table, 0, sizeof(*table));
+}
+
+/* Accumulate values[0..n-1] in a thread's table. Returns FALSE when out of
+ * memory. */
+static int mistats_accumulate(struct mistatstable *table, const double *values,
+                              const double *mask, const int *labels,
+                              misize_t n, int bins, double hist_min,
+                              double scale)
+{
+  struct mistatsentry *entry = NULL;
+  misize_t i;
+
+  if (labels == NULL) {
+    entry = mistats_entry(table, 0, bins);
+    if (entry == NULL) {
+      return FALSE;
+    }
+  }
+  for (i = 0; i < n; i++) {
+    double value = values[i];
+    double shifted;
+
+    if (value != value || (mask != NULL && !(mask[i] >= 0.5))) {
+      continue;
+    }
+    if (labels != NULL) {
+      int label = labels[i];
+
+      if (entry == NULL || entry->label != label) {
+        entry = mistats_entry(table, label, bins);
+        if (entry == NULL) {
+          return FALSE;
+        }
+      }
+    }
+    if (entry->part_n == 0.0) {
+      entry->part_shift = value;
+    }
+    shifted = value - entry->part_shift;
+    entry->part_n += 1.0;
+    entry->part_s1 += shifted;
+    entry->part_s2 += shifted * shifted;
+    if (value < entry->min) entry->min = value;
+    if (value > entry->max) entry->max = value;
+
+    if (bins > 0) {
+      /* Values outside the recorded real range go in the end bins */
+      double position = (value - hist_min) * scale;
+
+      if (position < 1.0) {
+        entry->histogram[0] += 1.0;
+      } else if (position >= bins - 1) {
+        entry->histogram[bins - 1] += 1.0;
+      } else {
+        entry->histogram[(int) position] += 1.0;
+      }
+    }
+  }
+  mistats_flush_part(table);
+  return TRUE;
+}
+
+/* Widen the \a n label voxels of type \a type at the start of \a labels
+ * to int, in place. The enumerated type of a label volume only converts
+ * to an integer type of the same size. */
+static void mistats_widen_labels(int *labels, mitype_t type, misize_t n)
+{
+  misize_t i;
+
+  /* From the end, so that no voxel is overwritten before it is read */
+  for (i = n; i-- > 0; ) {
+    switch (type) {
+    case MI_TYPE_BYTE:
+      labels[i] = ((signed char *) labels)[i];
+      break;
+    case MI_TYPE_UBYTE:
+      labels[i] = ((unsigned char *) labels)[i];
+      break;
+    case MI_TYPE_SHORT:
+      labels[i] = ((short *) labels)[i];
+      break;
+    case MI_TYPE_USHORT:
+      labels[i] = ((unsigned short *) labels)[i];
+      break;
+    default:
+      return;
+    }
+  }
+}
+
+/* Fold the table of another thread into \a table */
+static int mistats_merge_table(struct mistatstable *table,
+                               struct mistatstable *other, int bins)
+{
+  int i, b;
+
+  for (i = 0; i < other->count; i++) {
+    struct mistatsentry *src = &other->entries[i];
+    struct mistatsentry *dst = mistats_entry(table, src->label, bins);
+
+    if (dst == NULL) {
+      return FALSE;
+    }
+    mistats_merge(dst, src->n, src->mean, src->m2);
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+    for (b = 0; b < bins; b++) {
+      dst->histogram[b] += src->histogram[b];
+    }
+  }
+  return TRUE;
+}
+
+/* Dimension sizes and chunk edges of a volume in the order its hyperslabs
+ * are addressed */
+static int mistats_shape(mihandle_t volume, int *ndims, misize_t sizes[],
+                         misize_t chunk[])
+{
+  midimhandle_t dimensions[MI2_MAX_VAR_DIMS];
+  hsize_t file_chunk[MI2_MAX_VAR_DIMS];
+  int chunked;
+  int d;
+
+  if (miopen_image_datasets(volume) < 0) {
+    return (MI_ERROR);
+  }
+  if (volume->image_id < 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Volume has no image");
+  }
+  if (miget_volume_dimension_count(volume, MI_DIMCLASS_ANY, MI_DIMATTR_ALL,
+                                   ndims) < 0 || *ndims < 1 ||
+      miget_volume_dimensions(volume, MI_DIMCLASS_ANY, MI_DIMATTR_ALL,
+                              volume->dim_indices != NULL ?
+                              MI_DIMORDER_APPARENT : MI_DIMORDER_FILE,
+                              *ndims, dimensions) < 0 ||
+      miget_dimension_sizes(dimensions, *ndims, sizes) < 0) {
+    return (MI_ERROR);
+  }
+  chunked = volume->plist_id >= 0 &&
+            H5Pget_layout(volume->plist_id) == H5D_CHUNKED &&
+            H5Pget_chunk(volume->plist_id, MI2_MAX_VAR_DIMS, file_chunk) == *ndims;
+
+  for (d = 0; d < *ndims; d++) {
+    int fd = volume->dim_indices != NULL ? volume->dim_indices[d] : d;
+
+    chunk[d] = chunked ? file_chunk[fd] : 1;
+  }
+  return (MI_NOERROR);
+}
+
+/* Compute statistics of \a volume, restricted to the voxels where \a mask
+ * is at least 0.5 if it is given, and for each label of \a labels if that
+ * is given. The result table has one entry per label, or a single entry. */
+static int mistats_compute(mihandle_t volume, mihandle_t mask,
+                           mihandle_t labels, int bins, double hist_range[],
+                           struct mistatstable *result)
+{
+  misize_t sizes[MI2_MAX_VAR_DIMS];
+  misize_t chunk[MI2_MAX_VAR_DIMS];
+  misize_t other_sizes[MI2_MAX_VAR_DIMS];
+  misize_t other_chunk[MI2_MAX_VAR_DIMS];
+  misize_t block[MI2_MAX_VAR_DIMS];
+  misize_t start[MI2_MAX_VAR_DIMS];
+  misize_t count[MI2_MAX_VAR_DIMS];
+  misize_t limit;
+  misize_t inner = 1;
+  misize_t nvalues;
+  size_t buffer_bytes;
+  double *values = NULL;
+  double *mask_values = NULL;
+  double *label_reals = NULL;
+  int *label_values = NULL;
+  miclass_t label_class = MI_CLASS_LABEL;
+  mitype_t label_type = MI_TYPE_INT;
+  int label_voxels = FALSE;
+  struct mistatstable *tables = NULL;
+  double scale;
+  int nthreads = 1;
+  int ndims, other_ndims;
+  int failed = 0;
+  int k, d, t;
+  int status = MI_ERROR;
+
+  if (mistats_shape(volume, &ndims, sizes, chunk) < 0 ||
+      miget_volume_real_range(volume, hist_range) < 0) {
+    return (MI_ERROR);
+  }
+  for (t = 0; t < 2; t++) {
+    mihandle_t other = t == 0 ? mask : labels;
+
+    if (other == NULL) {
+      continue;
+    }
+    if (mistats_shape(other, &other_ndims, other_sizes, other_chunk) < 0) {
+      return (MI_ERROR);
+    }
+    if (other_ndims != ndims ||
+        memcmp(other_sizes, sizes, ndims * sizeof(misize_t)) != 0) {
+      return MI_LOG_ERROR(MI2_MSG_GENERIC,"Mask or label volume has different dimensions");
+    }
+  }
+  /* Label values are the voxel values of a label volume, the rounded real
+   * values of any other volume */
+  if (labels != NULL &&
+      (miget_data_class(labels, &label_class) < 0 ||
+       miget_data_type(labels, &label_type) < 0)) {
+    return (MI_ERROR);
+  }
+  label_voxels = labels != NULL && label_class == MI_CLASS_LABEL &&
+                 (label_type == MI_TYPE_BYTE || label_type == MI_TYPE_UBYTE ||
+                  label_type == MI_TYPE_SHORT || label_type == MI_TYPE_USHORT ||
+                  label_type == MI_TYPE_INT || label_type == MI_TYPE_UINT);
+  scale = hist_range[1] > hist_range[0] ?
+          bins / (hist_range[1] - hist_range[0]) : 0.0;
+
+  /* The fastest dimensions are read whole as long as they fit in the
+   * buffer, the next one in whole chunks and the slower ones one at a
+   * time, so that each chunk is read only once */
+  buffer_bytes = miget_cfg_present(MICFG_MAXBUF) ?
+                 (size_t) miget_cfg_int(MICFG_MAXBUF) * 1024 :
+                 _MI2_STATS_BUFFER_BYTES;
+  limit = buffer_bytes / sizeof(double);
+  if (limit < 1) {
+    limit = 1;
+  }
+  for (k = ndims - 1; k >= 0 && inner * sizes[k] <= limit; k--) {
+    block[k] = sizes[k];
+    inner *= sizes[k];
+  }
+  if (k >= 0) {
+    block[k] = (limit / inner) / chunk[k] * chunk[k];
+    if (block[k] < chunk[k]) block[k] = chunk[k];
+    if (block[k] > sizes[k]) block[k] = sizes[k];
+    for (d = 0; d < k; d++) {
+      block[d] = 1;
+    }
+  }
+  nvalues = 1;
+  for (d = 0; d < ndims; d++) {
+    nvalues *= block[d];
+    start[d] = 0;
+  }
+
+  values = malloc(nvalues * sizeof(double));
+  if (mask != NULL) mask_values = malloc(nvalues * sizeof(double));
+  if (labels != NULL) label_values = malloc(nvalues * sizeof(int));
+  if (labels != NULL && !label_voxels) {
+    label_reals = malloc(nvalues * sizeof(double));
+  }
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+  tables = calloc(nthreads, sizeof(struct mistatstable));
+  if (values == NULL || tables == NULL ||
+      (mask != NULL && mask_values == NULL) ||
+      (labels != NULL && label_values == NULL) ||
+      (labels != NULL && !label_voxels && label_reals == NULL)) {
+    MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)(nvalues * sizeof(double)));
+    goto cleanup;
+  }
+
+  for (;;) {
+    long part, nparts;
+    misize_t n = 1;
+
+    for (d = 0; d < ndims; d++) {
+      count[d] = start[d] + block[d] > sizes[d] ? sizes[d] - start[d] : block[d];
+      n *= count[d];
+    }
+    /* HDF5 is not thread safe: read serially, then accumulate in parallel */
+    if (miget_real_value_hyperslab(volume, MI_TYPE_DOUBLE, start, count,
+                                   values) < 0 ||
+        (mask != NULL &&
+         miget_real_value_hyperslab(mask, MI_TYPE_DOUBLE, start, count,
+                                    mask_values) < 0) ||
+        (label_voxels &&
+         miget_voxel_value_hyperslab(labels, label_type, start, count,
+                                     label_values) < 0) ||
+        (label_reals != NULL &&
+         miget_real_value_hyperslab(labels, MI_TYPE_DOUBLE, start, count,
+                                    label_reals) < 0)) {
+      goto cleanup;
+    }
+    if (label_reals != NULL) {
+      misize_t i;
+
+      for (i = 0; i < n; i++) {
+        label_values[i] = (int) floor(label_reals[i] + 0.5);
+      }
+    }
+    else if (label_voxels) {
+      mistats_widen_labels(label_values, label_type, n);
+    }
+    nparts = (long) ((n + _MI2_STATS_PART_SIZE - 1) / _MI2_STATS_PART_SIZE);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(static) reduction(|:failed)
+#endif
+    for (part = 0; part < nparts; part++) {
+      misize_t offset = (misize_t) part * _MI2_STATS_PART_SIZE;
+      misize_t length = n - offset < _MI2_STATS_PART_SIZE ?
+                        n - offset : _MI2_STATS_PART_SIZE;
+      int thread = 0;
+
+#ifdef _OPENMP
+      thread = omp_get_thread_num();
+#endif
+      if (!mistats_accumulate(&tables[thread], values + offset,
+                              mask_values ? mask_values + offset : NULL,
+                              label_values ? label_values + offset : NULL,
+                              length, bins, hist_range[0], scale)) {
+        failed = 1;
+      }
+    }
+    if (failed) {
+      MI_LOG_ERROR(MI2_MSG_OUTOFMEM,(int)sizeof(struct mistatsentry));
+      goto cleanup;
+    }
+
+    /* Advance to the next block, the last dimension fastest */
+    for (d = ndims - 1; d >= 0; d--) {
+      start[d] += block[d];
+      if (start[d] < sizes[d]) {
+        break;
+      }
+      start[d] = 0;
+    }
+    if (d < 0) {
+      break;
+    }
+  }
+
+  for (t = 1; t < nthreads; t++) {
+    if (!mistats_merge_table(&tables[0], &tables[t], bins)) {
+      goto cleanup;
+    }
+  }
+  *result = tables[0];
+  memset(&tables[0], 0, sizeof(tables[0]));
+  status = MI_NOERROR;
+
+cleanup:
+  if (tables != NULL) {
+    for (t = 0; t < nthreads; t++) {
+      mistats_free_table(&tables[t]);
+    }
+  }
+  free(tables);
+  free(values);
+  free(mask_values);
+  free(label_reals);
+  free(label_values);
+  return (status);
+}
+
+/* Fill in a statistics structure from an accumulator, handing over its
+ * histogram */
+static void mistats_from_entry(struct mistatsentry *entry, int bins,
+                               const double hist_range[], mivolstats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+  stats->count = (misize_t) entry->n;
+  stats->min = entry->n > 0 ? entry->min : 0.0;
+  stats->max = entry->n > 0 ? entry->max : 0.0;
+  stats->mean = entry->mean;
+  stats->sum = entry->mean * entry->n;
+  stats->sum2 = entry->m2 + entry->mean * stats->sum;
+  stats->stddev = entry->n > 1 ? sqrt(entry->m2 / (entry->n - 1)) : 0.0;
+  stats->bins = bins;
+  stats->hist_min = hist_range[0];
+  stats->hist_max = hist_range[1];
+  stats->histogram = entry->histogram;
+  entry->histogram = NULL;
+}
+
+/** Compute the statistics of the real voxel values of a volume, with a
+ * histogram of \a bins bins spanning the real range of the volume. NaN
+ * values are not counted. If the volume is open for writing the result is
+ * also stored in the file. If \a stats is not NULL it receives the result,
+ * which must then be freed with mifree_volume_statistics().
+ * \ingroup mi2Stats
+ */
+int micompute_volume_statistics(mihandle_t volume, int bins,
+                                mivolstats_t *stats)
+{
+  if (volume == NULL || bins < 1) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Invalid volume or number of bins");
+  }
+  return micompute_masked_statistics(volume, NULL, bins, stats);
+}
+
+/** Compute the statistics of the real voxel values of a volume where the
+ * real value of \a mask is at least 0.5. Without a mask the statistics
+ * are also stored in the file if the volume is open for writing. A
+ * histogram is made if \a bins is positive.
+ * \ingroup mi2Stats
+ */
+int micompute_masked_statistics(mihandle_t volume, mihandle_t mask, int bins,
+                                mivolstats_t *stats)
+{
+  struct mistatstable table;
+  struct mistatsentry empty;
+  double hist_range[2];
+  mivolstats_t result;
+  int status = MI_NOERROR;
+
+  if (volume == NULL || bins < 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Invalid volume or number of bins");
+  }
+  if (miopen_image_datasets(volume) < 0 ||
+      mistats_compute(volume, mask, NULL, bins, hist_range, &table) < 0) {
+    return (MI_ERROR);
+  }
+
+  /* A mask may exclude every voxel */
+  memset(&empty, 0, sizeof(empty));
+  if (table.count == 0 && bins > 0) {
+    empty.histogram = calloc(bins, sizeof(double));
+  }
+  mistats_from_entry(table.count > 0 ? &table.entries[0] : &empty, bins,
+                     hist_range, &result);
+  mistats_free_table(&table);
+
+  if (mask == NULL && bins > 0 && (volume->mode & MI2_OPEN_RDWR) != 0) {
+    status = mistats_store(volume, &result);
+    if (status == MI_NOERROR) {
+      volume->stats_stale = FALSE;
+    }
+  }
+  if (status == MI_NOERROR && stats != NULL) {
+    *stats = result;
+  } else {
+    free(result.histogram);
+  }
+  return (status);
+}
+
+/** Compute the statistics of the real voxel values of a volume for each
+ * label of \a labels, whose real values are rounded to the nearest
+ * integer. Only voxels where \a mask is at least 0.5 are counted if it is
+ * given. On return \a label_values holds the \a n_labels labels found, in
+ * increasing order, and \a stats their statistics, with histograms if
+ * \a bins is positive. Both arrays must be freed with
+ * mifree_label_statistics().
+ * \ingroup mi2Stats
+ */
+int micompute_label_statistics(mihandle_t volume, mihandle_t labels,
+                               mihandle_t mask, int bins, int *n_labels,
+                               int **label_values, mivolstats_t **stats)
+{
+  struct mistatstable table;
+  double hist_range[2];
+  int i;
+
+  if (volume == NULL || labels == NULL || bins < 0 || n_labels == NULL ||
+      label_values == NULL || stats == NULL) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to compute label statistics with null volume or variable");
+  }
+  if (miopen_image_datasets(volume) < 0 ||
+      mistats_compute(volume, mask, labels, bins, hist_range, &table) < 0) {
+    return (MI_ERROR);
+  }
+  *label_values = malloc((table.count + 1) * sizeof(int));
+  *stats = malloc((table.count + 1) * sizeof(mivolstats_t));
+  if (*label_values == NULL || *stats == NULL) {
+    free(*label_values);
+    free(*stats);
+    mistats_free_table(&table);
+    return MI_LOG_ERROR(MI2_MSG_OUTOFMEM,table.count * (int)sizeof(mivolstats_t));
+  }
+  for (i = 0; i < table.count; i++) {
+    (*label_values)[i] = table.entries[i].label;
+    mistats_from_entry(&table.entries[i], bins, hist_range, &(*stats)[i]);
+  }
+  *n_labels = table.count;
+  mistats_free_table(&table);
+  return (MI_NOERROR);
+}
+
+/** Free the results of micompute_label_statistics().
+ * \ingroup mi2Stats
+ */
+int mifree_label_statistics(int n_labels, int *label_values,
+                            mivolstats_t *stats)
+{
+  int i;
+
+  if (stats != NULL) {
+    for (i = 0; i < n_labels; i++) {
+      mifree_volume_statistics(&stats[i]);
+    }
+  }
+  free(stats);
+  free(label_values);
+  return (MI_NOERROR);
+}
+
+/** Read the statistics stored in a volume by micompute_volume_statistics().
+ * The result must be freed with mifree_volume_statistics().
+ * \retval MI_ERROR if the volume has no statistics, or they are out of date
+ * \ingroup mi2Stats
+ */
+int miget_volume_statistics(mihandle_t volume, mivolstats_t *stats)
+{
+  hid_t dset_id;
+  htri_t exists = 0;
+  hid_t attr_id;
+  hid_t spc_id;
+  hssize_t bins = 0;
+  double count = 0.0;
+  double range[2];
+  int status = MI_ERROR;
+
+  if (volume == NULL || stats == NULL) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to get statistics with null volume or variable");
+  }
+  H5E_BEGIN_TRY {
+    exists = H5Lexists(volume->hdf_id, MI_STATS_PATH, H5P_DEFAULT);
+  } H5E_END_TRY;
+  if (exists <= 0) {
+    return (MI_ERROR);
+  }
+  if ((dset_id = midescend_path(volume->hdf_id, MI_STATS_PATH)) < 0) {
+    return (MI_ERROR);
+  }
+
+  memset(stats, 0, sizeof(*stats));
+  if (H5Aexists(dset_id, "histogram") <= 0) {
+    goto cleanup;
+  }
+  attr_id = H5Aopen(dset_id, "histogram", H5P_DEFAULT);
+  spc_id = H5Aget_space(attr_id);
+  bins = H5Sget_simple_extent_npoints(spc_id);
+  H5Sclose(spc_id);
+  H5Aclose(attr_id);
+  if (bins < 1) {
+    goto cleanup;
+  }
+
+  stats->histogram = malloc(bins * sizeof(double));
+  if (stats->histogram == NULL) {
+    goto cleanup;
+  }
+  stats->bins = (int) bins;
+  if (miget_attr_at_loc(dset_id, "count", MI_TYPE_DOUBLE, 1, &count) < 0 ||
+      miget_attr_at_loc(dset_id, "minimum", MI_TYPE_DOUBLE, 1,
+                        &stats->min) < 0 ||
+      miget_attr_at_loc(dset_id, "maximum", MI_TYPE_DOUBLE, 1,
+                        &stats->max) < 0 ||
+      miget_attr_at_loc(dset_id, "sum", MI_TYPE_DOUBLE, 1,
+                        &stats->sum) < 0 ||
+      miget_attr_at_loc(dset_id, "sum2", MI_TYPE_DOUBLE, 1,
+                        &stats->sum2) < 0 ||
+      miget_attr_at_loc(dset_id, "mean", MI_TYPE_DOUBLE, 1,
+                        &stats->mean) < 0 ||
+      miget_attr_at_loc(dset_id, "stddev", MI_TYPE_DOUBLE, 1,
+                        &stats->stddev) < 0 ||
+      miget_attr_at_loc(dset_id, "histogram_range", MI_TYPE_DOUBLE, 2,
+                        range) < 0 ||
+      miget_attr_at_loc(dset_id, "histogram", MI_TYPE_DOUBLE, stats->bins,
+                        stats->histogram) < 0) {
+    free(stats->histogram);
+    stats->histogram = NULL;
+    goto cleanup;
+  }
+  stats->count = (misize_t) count;
+  stats->hist_min = range[0];
+  stats->hist_max = range[1];
+  status = MI_NOERROR;
+
+cleanup:
+  H5Dclose(dset_id);
+  return (status);
+}
+
+/** Free the histogram of a statistics structure.
+ * \ingroup mi2Stats
+ */
+int mifree_volume_statistics(mivolstats_t *stats)
+{
+  if (stats == NULL) {
+    return (MI_ERROR);
+  }
+  free(stats->histogram);
+  stats->histogram = NULL;
+  stats->bins = 0;
+  return (MI_NOERROR);
+}
+
+/** Estimate the real value below which \a percent percent of the voxels
+ * lie, interpolating linearly within the histogram bins.
+ * \ingroup mi2Stats
+ */
+int miget_statistics_percentile(const mivolstats_t *stats, double percent,
+                                double *value)
+{
+  double target;
+  double sum = 0.0;
+  double width;
+  int bin;
+
+  if (stats == NULL || value == NULL || stats->histogram == NULL ||
+      stats->count == 0 || percent < 0.0 || percent > 100.0) {
+    return (MI_ERROR);
+  }
+  target = percent / 100.0 * (double) stats->count;
+  width = (stats->hist_max - stats->hist_min) / stats->bins;
+
+  for (bin = 0; bin < stats->bins - 1; bin++) {
+    if (sum + stats->histogram[bin] >= target) {
+      break;
+    }
+    sum += stats->histogram[bin];
+  }
+  *value = stats->hist_min + width * bin;
+  if (stats->histogram[bin] > 0.0) {
+    *value += width * (target - sum) / stats->histogram[bin];
+  }
+  if (*value < stats->min) *value = stats->min;
+  if (*value > stats->max) *value = stats->max;
+  return (MI_NOERROR);
+}
+
+/* kate: indent-mode cstyle; indent-width 2; replace-tabs on; */
@@ -30,6 +30,9 @@ miget_volume_valid_max(mihandle_t volume, /**< MINC 2.0 volume handle */
     if (volume == NULL || valid_max == NULL) {
         return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to get valid range min with null volume or variable");      /* Invalid arguments */
     }
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
     *valid_max = volume->valid_max;
     return (MI_NOERROR);
 }
@@ -45,10 +48,14 @@ int miset_volume_valid_max(mihandle_t volume, /**< MINC 2.0 volume handle */
     if (volume == NULL) {
         return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to set valid range max with null volume ");      /* Invalid arguments */
     }
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
     /* TODO?: Should we require valid max to have some specific relationship
      * to valid_min?
      */
     volume->valid_max = valid_max;
+    miinvalidate_statistics(volume);
     misave_valid_range(volume);
     return (MI_NOERROR);
 }
@@ -64,6 +71,9 @@ int miget_volume_valid_min(mihandle_t volume, /**< MINC 2.0 volume handle */
     if (volume == NULL || valid_min == NULL) {
         return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to get valid range min with null volume or variable");      /* Invalid arguments. */
     }
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
     *valid_min = volume->valid_min;
     return (MI_NOERROR);
 }
@@ -79,7 +89,11 @@ int miset_volume_valid_min(mihandle_t volume,  /**< MINC 2.0 volume handle */
     if (volume == NULL) {
         return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to set valid range min with null volume ");       /* Invalid arguments */
     }
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
     volume->valid_min = valid_min;
+    miinvalidate_statistics(volume);
     misave_valid_range(volume);
     return (MI_NOERROR);
 }
@@ -96,6 +110,9 @@ int miget_volume_valid_range(mihandle_t volume,  /**< MINC 2.0 volume handle */
     if (volume == NULL || valid_min == NULL || valid_max == NULL) {
         return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to get valid range with null volume or null variables");
     }
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
     *valid_min = volume->valid_min;
     *valid_max = volume->valid_max;
     return (MI_NOERROR);
@@ -113,12 +130,16 @@ int miset_volume_valid_range(mihandle_t volume, /**< MINC 2.0 volume handle */
     if (volume == NULL) {
         return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to set valid range with null volume ");
     }
+    if (miopen_image_datasets(volume) < 0) {
+        return (MI_ERROR);
+    }
     /* TODO?: Again, should we require min<max, for example?  Or should we
      * just do the right thing and swap them?  What if valid_max is greater
      * than the maximum value that can be represented by the volume's type?
      */
     volume->valid_min = valid_min;
     volume->valid_max = valid_max;
+    miinvalidate_statistics(volume);
     misave_valid_range(volume);
     return (MI_NOERROR);
 }
@@ -31,6 +31,123 @@
 /** Maximum number of elements in a filter parameter list. */
 #define MI2_MAX_CD_ELEMENTS 100
 
+/** \internal
+ * Return the HDF5 filter identifier and printable name of a compression
+ * type, or a negative filter id if the type does not use a filter.
+ */
+static H5Z_filter_t mifilter_for_compression(micompression_t compression_type,
+                                             const char **name)
+{
+  switch (compression_type) {
+    case MI_COMPRESS_ZLIB:
+      *name = "zlib";
+      return H5Z_FILTER_DEFLATE;
+    case MI_COMPRESS_ZSTD:
+      *name = "zstd";
+      return MI2_H5Z_FILTER_ZSTD;
+    case MI_COMPRESS_LZ4:
+      *name = "lz4";
+      return MI2_H5Z_FILTER_LZ4;
+    case MI_COMPRESS_BLOSC:
+      *name = "blosc";
+      return MI2_H5Z_FILTER_BLOSC;
+    default:
+      *name = "none";
+      return -1;
+  }
+}
+
+/** \internal
+ * Add the compression filter selected in \a props to the dataset creation
+ * property list \a hdf_plist. Registered (plugin) filters that are not
+ * available in this HDF5 installation are replaced by zlib with a warning,
+ * so that files can always be written.
+ */
+int miset_plist_compression(hid_t hdf_plist, mivolumeprops_t props)
+{
+  H5Z_filter_t filter_id;
+  const char *name;
+  unsigned int cd_values[7];
+  int level = props->zlib_level;
+
+  filter_id = mifilter_for_compression(props->compression_type, &name);
+  if (filter_id < 0)
+    return MI_NOERROR;
+
+  if (filter_id != H5Z_FILTER_DEFLATE && H5Zfilter_avail(filter_id) <= 0) {
+    MI_LOG_ERROR(MI2_MSG_FILTER_FALLBACK, name);
+    filter_id = H5Z_FILTER_DEFLATE;
+  }
+  if (level < 0 || level > MI2_MAX_ZLIB_LEVEL)
+    level = MI2_DEFAULT_ZLIB_LEVEL;
+
+  switch (filter_id) {
+    case H5Z_FILTER_DEFLATE:
+      MI_CHECK_HDF_CALL_RET(H5Pset_deflate(hdf_plist, level), "H5Pset_deflate")
+      break;
+    case MI2_H5Z_FILTER_ZSTD:
+      cd_values[0] = level;
+      MI_CHECK_HDF_CALL_RET(H5Pset_filter(hdf_plist, filter_id, H5Z_FLAG_MANDATORY, 1, cd_values), "H5Pset_filter")
+      break;
+    case MI2_H5Z_FILTER_LZ4:
+      /* Zero selects the plugin's default block size */
+      cd_values[0] = 0;
+      MI_CHECK_HDF_CALL_RET(H5Pset_filter(hdf_plist, filter_id, H5Z_FLAG_MANDATORY, 1, cd_values), "H5Pset_filter")
+      break;
+    case MI2_H5Z_FILTER_BLOSC:
+      /* Slots 0-3 are filled in by the plugin, then level, shuffle, codec */
+      cd_values[0] = cd_values[1] = cd_values[2] = cd_values[3] = 0;
+      cd_values[4] = level;
+      cd_values[5] = 1;         /* byte shuffle */
+      cd_values[6] = 1;         /* BLOSC_LZ4 */
+      MI_CHECK_HDF_CALL_RET(H5Pset_filter(hdf_plist, filter_id, H5Z_FLAG_MANDATORY, 7, cd_values), "H5Pset_filter")
+      break;
+    default:
+      break;
+  }
+  return MI_NOERROR;
+}
+
+/** \internal
+ * Check that every filter in the pipeline of the dataset \a dset_id can be
+ * decoded by this HDF5 installation, so that a missing plugin is reported
+ * once with its name instead of as an opaque read failure.
+ */
+int micheck_dataset_filters(hid_t dset_id)
+{
+  hid_t hdf_plist;
+  int nfilters;
+  int i;
+  int result = MI_NOERROR;
+
+  MI_CHECK_HDF_CALL_RET(hdf_plist = H5Dget_create_plist(dset_id), "H5Dget_create_plist")
+  nfilters = H5Pget_nfilters(hdf_plist);
+
+  for (i = 0; i < nfilters; i++) {
+    unsigned int flags;
+    size_t cd_nelmts = 0;
+    char fname[MI2_CHAR_LENGTH];
+    H5Z_filter_t fcode;
+
+    fname[0] = '\0';
+    fcode = H5Pget_filter2(hdf_plist, i, &flags, &cd_nelmts, NULL,
+                           sizeof(fname), fname, NULL);
+    if (fcode >= 0 && !(flags & H5Z_FLAG_OPTIONAL) && H5Zfilter_avail(fcode) <= 0) {
+      const char *name = fname;
+      if (name[0] == '\0') {
+        mifilter_for_compression(fcode == MI2_H5Z_FILTER_ZSTD ? MI_COMPRESS_ZSTD :
+                                 fcode == MI2_H5Z_FILTER_LZ4 ? MI_COMPRESS_LZ4 :
+                                 fcode == MI2_H5Z_FILTER_BLOSC ? MI_COMPRESS_BLOSC :
+                                 MI_COMPRESS_NONE, &name);
+      }
+      result = MI_LOG_ERROR(MI2_MSG_FILTER_MISSING, name);
+      break;
+    }
+  }
+  H5Pclose(hdf_plist);
+  return result;
+}
+
 /** Create a volume property list.  The new list will be returned in the
  * \a props parameter.    When the program is finished
  * using the property list it should call  mifree_volume_props() to free the
@@ -60,6 +177,15 @@ int minew_volume_props(mivolumeprops_t  *props)
   handle->record_name = NULL;
   handle->template_flag = 0;
   handle->checksum = miget_cfg_bool(MICFG_MINC_CHECKSUM);
+  handle->shuffle = 0;
+  handle->scaleoffset = 0;
+  handle->access_pattern = MI_ACCESS_DEFAULT;
+  handle->cache_bytes = 0;
+  handle->cache_slots = 0;
+  handle->cache_w0 = -1.0;
+  handle->metadata_reserve = 0;
+  handle->stats_bins = 0;
+  handle->planar_components = FALSE;
   
   *props = handle;
   
@@ -115,7 +241,7 @@ int miget_volume_props(mihandle_t volume, mivolumeprops_t *props)
   if (hdf_plist < 0) {
     return (MI_ERROR);
   }
-  handle = (mivolumeprops_t)malloc(sizeof(struct mivolprops));
+  handle = (mivolumeprops_t)calloc(1, sizeof(struct mivolprops));
   if (handle == NULL) {
     return (MI_ERROR);
   }
@@ -140,12 +266,10 @@ int miget_volume_props(mihandle_t volume, mivolumeprops_t *props)
     }
     /* Get the number of filters in the pipeline */
     nfilters = H5Pget_nfilters(hdf_plist);
-    if (nfilters == 0) {
-      handle->zlib_level = 0;
-      handle->compression_type = MI_COMPRESS_NONE;
-      handle->checksum = 0;
-    }
-    else {
+    handle->zlib_level = 0;
+    handle->compression_type = MI_COMPRESS_NONE;
+    handle->checksum = 0;
+    if (nfilters > 0) {
       for (i = 0; i < nfilters; i++) {
         cd_nelmts = MI2_MAX_CD_ELEMENTS;
         fcode = H5Pget_filter1(hdf_plist, i, &flags, &cd_nelmts,
@@ -156,12 +280,27 @@ int miget_volume_props(mihandle_t volume, mivolumeprops_t *props)
             handle->zlib_level = cd_values[0];
             break;
           case H5Z_FILTER_SHUFFLE:
+            handle->shuffle = 1;
+            break;
+          case H5Z_FILTER_SCALEOFFSET:
+            handle->scaleoffset = 1;
             break;
           case H5Z_FILTER_FLETCHER32:
             handle->checksum=1;
             break;
           case H5Z_FILTER_SZIP:
             break;
+          case MI2_H5Z_FILTER_ZSTD:
+            handle->compression_type = MI_COMPRESS_ZSTD;
+            handle->zlib_level = cd_nelmts > 0 ? cd_values[0] : 0;
+            break;
+          case MI2_H5Z_FILTER_LZ4:
+            handle->compression_type = MI_COMPRESS_LZ4;
+            break;
+          case MI2_H5Z_FILTER_BLOSC:
+            handle->compression_type = MI_COMPRESS_BLOSC;
+            handle->zlib_level = cd_nelmts > 4 ? cd_values[4] : 0;
+            break;
           default:
             break;
         }
@@ -177,6 +316,10 @@ int miget_volume_props(mihandle_t volume, mivolumeprops_t *props)
     handle->checksum = 0;
   }
   
+  handle->cache_bytes = volume->cache_bytes;
+  handle->cache_slots = volume->cache_slots;
+  handle->cache_w0 = volume->cache_w0;
+
   *props = handle;
   
   H5Pclose(hdf_plist);
@@ -247,6 +390,9 @@ int miselect_resolution(mihandle_t volume, int depth)
   if ( volume->hdf_id < 0 || depth > MI2_MAX_RESOLUTION_GROUP || depth < 0) {
     return (MI_ERROR);
   }
+  if (miopen_image_datasets(volume) < 0) {
+    return (MI_ERROR);
+  }
   
   grp_id = H5Gopen1(volume->hdf_id, MI_ROOT_PATH "/image");
   if (grp_id < 0) {
@@ -265,12 +411,16 @@ int miselect_resolution(mihandle_t volume, int depth)
   }
   
   volume->selected_resolution = depth;
+
+  /* Cached dataspaces belong to the datasets being replaced */
+  mifree_hyperslab_cache(volume);
   
   if (volume->image_id >= 0) {
     H5Dclose(volume->image_id);
   }
-  sprintf(path, "%d/image", depth);
-  volume->image_id = H5Dopen1(grp_id, path);
+  /* Reopened with the chunk cache of the volume */
+  sprintf(path, MI_ROOT_PATH "/image/%d/image", depth);
+  volume->image_id = _miopen_image_dataset(volume, path);
   
   if (volume->volume_class == MI_CLASS_REAL) {
     if (volume->imax_id >= 0) {
@@ -315,8 +465,13 @@ int miflush_from_resolution(mihandle_t volume, int depth)
  * Note that enabling compression will automatically
  * enable blocking with default parameters.
  * \param props A volume properties list
- * \param compression_type The type of compression to use (MI_COMPRESS_NONE
- * or MI_COMPRESS_ZLIB)
+ * \param compression_type The type of compression to use (MI_COMPRESS_NONE,
+ * MI_COMPRESS_ZLIB, MI_COMPRESS_ZSTD, MI_COMPRESS_LZ4 or MI_COMPRESS_BLOSC)
+ *
+ * The zstd, lz4 and blosc codecs are HDF5 registered filters loaded from
+ * plugins found via HDF5_PLUGIN_PATH. If the plugin is not available when
+ * the volume is created, zlib is used instead and a warning is logged.
+ * The level set by miset_props_zlib_compression() is used by zstd and blosc.
  * \ingroup mi2VPrp
  */
 int miset_props_compression_type(mivolumeprops_t props,
@@ -348,6 +503,12 @@ int miset_props_compression_type(mivolumeprops_t props,
       miset_props_blocking(props, MI2_MAX_VAR_DIMS, edge_lengths);
       */
       
+      break;
+    case MI_COMPRESS_ZSTD:
+    case MI_COMPRESS_LZ4:
+    case MI_COMPRESS_BLOSC:
+      props->compression_type = compression_type;
+      props->zlib_level = MI2_DEFAULT_ZLIB_LEVEL;
       break;
     default:
       return (MI_ERROR);
@@ -528,6 +689,161 @@ int miget_props_checksum(mivolumeprops_t props,int *on)
 }
 
 
+int miset_props_shuffle(mivolumeprops_t props, int on)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  props->shuffle=on;
+  return (MI_NOERROR);
+}
+
+
+int miget_props_shuffle(mivolumeprops_t props, int *on)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  *on=props->shuffle;
+  return (MI_NOERROR);
+}
+
+
+int miset_props_scaleoffset(mivolumeprops_t props, int on)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  props->scaleoffset=on;
+  return (MI_NOERROR);
+}
+
+
+int miget_props_scaleoffset(mivolumeprops_t props, int *on)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  *on=props->scaleoffset;
+  return (MI_NOERROR);
+}
+
+
+int miset_props_access_pattern(mivolumeprops_t props,
+                                miaccess_pattern_t access_pattern)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  switch (access_pattern) {
+    case MI_ACCESS_DEFAULT:
+    case MI_ACCESS_SLICE:
+    case MI_ACCESS_CUBE:
+    case MI_ACCESS_TIMESERIES:
+      props->access_pattern = access_pattern;
+      break;
+    default:
+      return (MI_ERROR);
+  }
+  return (MI_NOERROR);
+}
+
+
+int miget_props_access_pattern(mivolumeprops_t props,
+                                miaccess_pattern_t *access_pattern)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  *access_pattern = props->access_pattern;
+  return (MI_NOERROR);
+}
+
+
+int miset_props_chunk_cache(mivolumeprops_t props, size_t nbytes,
+                            size_t nslots, double w0)
+{
+  if (props == NULL || w0 > 1.0) {
+    return (MI_ERROR);
+  }
+  props->cache_bytes = nbytes;
+  props->cache_slots = nslots;
+  props->cache_w0 = w0;
+  return (MI_NOERROR);
+}
+
+
+int miget_props_chunk_cache(mivolumeprops_t props, size_t *nbytes,
+                            size_t *nslots, double *w0)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  *nbytes = props->cache_bytes;
+  *nslots = props->cache_slots;
+  *w0 = props->cache_w0;
+  return (MI_NOERROR);
+}
+
+
+int miset_props_metadata_reserve(mivolumeprops_t props, size_t nbytes)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  props->metadata_reserve = nbytes;
+  return (MI_NOERROR);
+}
+
+
+int miget_props_metadata_reserve(mivolumeprops_t props, size_t *nbytes)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  *nbytes = props->metadata_reserve;
+  return (MI_NOERROR);
+}
+
+
+int miset_props_statistics(mivolumeprops_t props, int bins)
+{
+  if (props == NULL || bins < 0) {
+    return (MI_ERROR);
+  }
+  props->stats_bins = bins;
+  return (MI_NOERROR);
+}
+
+
+int miget_props_statistics(mivolumeprops_t props, int *bins)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  *bins = props->stats_bins;
+  return (MI_NOERROR);
+}
+
+
+int miset_props_planar_components(mivolumeprops_t props, miboolean_t planar)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  props->planar_components = planar;
+  return (MI_NOERROR);
+}
+
+
+int miget_props_planar_components(mivolumeprops_t props, miboolean_t *planar)
+{
+  if (props == NULL) {
+    return (MI_ERROR);
+  }
+  *planar = props->planar_components;
+  return (MI_NOERROR);
+}
 
 
 // kate: indent-mode cstyle; indent-width 2; replace-tabs on; 
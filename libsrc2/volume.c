@@ -19,6 +19,10 @@
 #include <unistd.h>
 #endif //HAVE_UNISTD_H
 
+#ifdef HAVE_SYS_STAT_H
+#include <sys/stat.h>
+#endif //HAVE_SYS_STAT_H
+
 #ifdef HAVE_MINC1
 #include "minc.h"
 #endif //HAVE_MINC1
@@ -43,6 +47,30 @@
 /*Used to optimize chunking size for faster MINC1 API access*/
 #define _MI1_MAX_VAR_BUFFER_SIZE 1000000
 
+/** Largest chunk, in bytes, produced by the chunk shape optimizer */
+#define _MI2_MAX_CHUNK_BYTES (4*1024*1024)
+
+/** Largest per-dataset chunk cache requested automatically, in bytes */
+#define _MI2_MAX_CHUNK_CACHE (256*1024*1024)
+
+/** File space allocations of at least this many bytes are page aligned,
+    so that uncompressed images can be memory mapped */
+#define _MI2_ALIGN_THRESHOLD (64*1024)
+#define _MI2_ALIGN_BOUNDARY  4096
+
+/** Appended to the name of a converted MINC1 file to name its image */
+#define _MI2_IMAGE_SUFFIX "#minc2"
+
+/** Largest MINC1 file converted in memory, in bytes; bigger files are
+    converted through a temporary file (override with MINC_CONVERT_MEMORY_KB) */
+#define _MI2_MAX_MEMORY_CONVERT (64*1024*1024)
+
+/** Largest header space reserved for the global attributes, in bytes */
+#define _MI2_MAX_METADATA_RESERVE 60000
+
+/** Most attributes kept in a header before HDF5 moves them to a dense heap */
+#define _MI2_MAX_COMPACT_ATTRS 65535
+
 
 /**
 * \defgroup mi2Vol MINC 2.0 Volume Functions
@@ -108,10 +136,94 @@ static int _generate_ident( char * id_str, size_t length )
   return result;
 }
 
+/**
+ * file access properties, with the cache settings of the volume,
+ * default_bytes is the chunk cache size used when neither the volume
+ * nor MINC_FILE_CACHE set one
+ */
+static hid_t _hdf_access_plist(mihandle_t volume, size_t default_bytes)
+{
+  hid_t prp_id;
+
+  prp_id = H5Pcreate(H5P_FILE_ACCESS);
+  H5Pset_libver_bounds(prp_id, H5F_LIBVER_V18, H5F_LIBVER_V18);
+  if (volume->cache_bytes > 0) {
+    H5Pset_cache(prp_id, 0,
+                 volume->cache_slots > 0 ? volume->cache_slots : 2503,
+                 volume->cache_bytes,
+                 volume->cache_w0 < 0.0 ? 1.0 : volume->cache_w0);
+  } else {
+    H5Pset_cache(prp_id, 0, 2503, miget_cfg_present(MICFG_MINC_FILE_CACHE)?miget_cfg_int(MICFG_MINC_FILE_CACHE)*100000:default_bytes, 1.0);
+  }
+  return prp_id;
+}
+
+#ifdef HAVE_MINC1
+/**
+ * open a read only HDF5 file image, kept in memory, converted from the
+ * file path
+ */
+static hid_t _hdf_open_image(const char *path, const void *image, size_t size, mihandle_t volume)
+{
+  hid_t fd;
+  hid_t prp_id;
+  char *name;
+
+  /* the core driver won't open an image under the name of a file that
+     exists on disk */
+  name = malloc(strlen(path) + sizeof(_MI2_IMAGE_SUFFIX));
+  if (name == NULL)
+    return -1;
+  strcpy(name, path);
+  strcat(name, _MI2_IMAGE_SUFFIX);
+
+  prp_id = _hdf_access_plist(volume, _MI1_MAX_VAR_BUFFER_SIZE*10);
+  H5Pset_fapl_core(prp_id, 1024*1024, 0);
+  H5Pset_file_image(prp_id, (void*)image, size);
+
+  H5E_BEGIN_TRY {
+    fd = H5Fopen(name, H5F_ACC_RDONLY, prp_id);
+  } H5E_END_TRY;
+
+  H5Pclose(prp_id);
+  free(name);
+  return fd;
+}
+
+/**
+ * check if the image of a MINC1 file may be read in place
+ */
+static int _mi1_direct_read(void)
+{
+  return !(miget_cfg_present(MICFG_MINC_DIRECT_MINC1_READ) &&
+           !miget_cfg_bool(MICFG_MINC_DIRECT_MINC1_READ));
+}
+
+/**
+ * check if a MINC1 file is small enough to be converted in memory,
+ * the converted image and its copy in the core driver both stay resident
+ */
+static int _mi1_convert_in_memory(const char *path)
+{
+  size_t limit = miget_cfg_present(MICFG_MINC_CONVERT_MEMORY) ?
+                 (size_t) miget_cfg_int(MICFG_MINC_CONVERT_MEMORY) * 1024 :
+                 _MI2_MAX_MEMORY_CONVERT;
+#ifdef HAVE_SYS_STAT_H
+  struct stat st;
+
+  if (stat(path, &st) != 0)
+    return FALSE;
+  return ((size_t) st.st_size <= limit);
+#else
+  return FALSE;
+#endif
+}
+#endif
+
 /**
  * open HDF5 file 
  */
-static hid_t _hdf_open(const char *path, int mode)
+static hid_t _hdf_open(const char *path, int mode, mihandle_t volume)
 {
   hid_t fd;
   hid_t prp_id;
@@ -119,10 +231,8 @@ static hid_t _hdf_open(const char *path, int mode)
   hid_t dset_id;
   int ndims;*/
   
-  prp_id = H5Pcreate(H5P_FILE_ACCESS);
-  H5Pset_libver_bounds(prp_id, H5F_LIBVER_V18, H5F_LIBVER_V18);
-  H5Pset_cache(prp_id, 0, 2503, miget_cfg_present(MICFG_MINC_FILE_CACHE)?miget_cfg_int(MICFG_MINC_FILE_CACHE)*100000:_MI1_MAX_VAR_BUFFER_SIZE*10, 1.0);
-  
+  prp_id = _hdf_access_plist(volume, _MI1_MAX_VAR_BUFFER_SIZE*10);
+
   H5E_BEGIN_TRY {
 #ifdef HDF5_MMAP_TEST
     if (mode & 0x8000) {
@@ -209,23 +319,39 @@ static hid_t _hdf_open(const char *path, int mode)
 }
 
 
+/**
+ * Check if the image will be stored in chunks, otherwise it is contiguous
+ */
+static int _mi_props_chunked(mivolumeprops_t create_props)
+{
+  return (create_props != NULL &&
+          (create_props->compression_type != MI_COMPRESS_NONE ||
+           create_props->shuffle || create_props->scaleoffset ||
+           create_props->access_pattern != MI_ACCESS_DEFAULT ||
+           create_props->planar_components ||
+           create_props->edge_count != 0));
+}
+
 /** 
  * Create an HDF5 file. 
  */
-static hid_t _hdf_create(const char *path, int cmode)
+static hid_t _hdf_create(const char *path, int cmode, mihandle_t volume,
+                         size_t metadata_reserve, int align)
 {
   hid_t grp_id;
   hid_t fd;
   hid_t tmp_id;
   hid_t hdf_gpid;
+  hid_t root_gpid;
   hid_t fpid;
   
-  fpid = H5Pcreate (H5P_FILE_ACCESS);
+  /* Limit filetype to 1.8.x, a larger cache while writing */
+  fpid = _hdf_access_plist(volume, _MI1_MAX_VAR_BUFFER_SIZE*100);
 
-  /* Limit filetype to 1.8.x */
-  H5Pset_libver_bounds(fpid, H5F_LIBVER_V18, H5F_LIBVER_V18);
-  
-  H5Pset_cache(fpid, 0, 2503, miget_cfg_present(MICFG_MINC_FILE_CACHE)?miget_cfg_int(MICFG_MINC_FILE_CACHE)*100000:_MI1_MAX_VAR_BUFFER_SIZE*100, 1.0);
+  /* Only a contiguous image can be memory mapped */
+  if (align) {
+    H5Pset_alignment(fpid, _MI2_ALIGN_THRESHOLD, _MI2_ALIGN_BOUNDARY);
+  }
   
   H5E_BEGIN_TRY {
     fd = H5Fcreate(path, cmode, H5P_DEFAULT, fpid);
@@ -242,8 +368,32 @@ static hid_t _hdf_create(const char *path, int cmode)
 
   hdf_gpid = H5Pcreate (H5P_GROUP_CREATE);
   H5Pset_attr_phase_change (hdf_gpid, 0, 0);
-  
-  MI_CHECK_HDF_CALL_RET(grp_id = H5Gcreate2(fd, MI_ROOT_PATH , H5P_DEFAULT, hdf_gpid, H5P_DEFAULT),"H5Gcreate2")
+
+  /* The global attributes live in the header of the root group. HDF5
+   * sizes the first chunk of a group header once, when the group is
+   * created, from the link messages it is told to expect (about 46 bytes
+   * each with 32 byte names), so estimating enough of them preallocates
+   * the reserved bytes there. Link info is the only hint that sizes the
+   * header, the links themselves go elsewhere. The attributes are then
+   * kept compact however many there are, so they are stored in that space
+   * rather than in a dense heap, and an attribute deleted and created
+   * again larger, as the history is on every update, takes the space freed
+   * by the old one. An attribute too big for a header still goes to the
+   * dense heap. A header chunk can't exceed 64kB, so neither can the
+   * reservation.
+   */
+  root_gpid = H5Pcreate (H5P_GROUP_CREATE);
+  if (metadata_reserve > 0) {
+    if (metadata_reserve > _MI2_MAX_METADATA_RESERVE)
+      metadata_reserve = _MI2_MAX_METADATA_RESERVE;
+    H5Pset_est_link_info(root_gpid, (unsigned)(metadata_reserve / 46 + 1), 32);
+    H5Pset_attr_phase_change (root_gpid, _MI2_MAX_COMPACT_ATTRS, 0);
+  } else {
+    H5Pset_attr_phase_change (root_gpid, 0, 0);
+  }
+
+  MI_CHECK_HDF_CALL_RET(grp_id = H5Gcreate2(fd, MI_ROOT_PATH , H5P_DEFAULT, root_gpid, H5P_DEFAULT),"H5Gcreate2")
+  H5Pclose ( root_gpid );
 
   MI_CHECK_HDF_CALL_RET(tmp_id = H5Gcreate2(grp_id, "dimensions", H5P_DEFAULT, hdf_gpid, H5P_DEFAULT),"H5Gcreate2")
   H5Gclose(tmp_id);
@@ -272,6 +422,198 @@ static int _hdf_close(hid_t fd)
 }
 
 
+/** \internal
+ * Choose chunk dimensions (in file order, last varying fastest) suited to
+ * the declared access pattern. Record (vector) dimensions are kept whole
+ * so that all components of a voxel are stored together, unless planar
+ * components were requested.
+ */
+static void _mioptimize_chunk_shape(miaccess_pattern_t pattern,
+                                    int ndims, midimhandle_t dimensions[],
+                                    size_t unit_size, int planar,
+                                    hsize_t hdf_size[])
+{
+  int i;
+  int nfree = 0;
+  int nslice = 0;
+  hsize_t fixed = unit_size;
+  hsize_t edge;
+
+  for (i = 0; i < ndims; i++) {
+    hdf_size[i] = 1;
+    if (dimensions[i]->dim_class == MI_DIMCLASS_RECORD && !planar) {
+      hdf_size[i] = dimensions[i]->length;
+      fixed *= hdf_size[i];
+    }
+  }
+
+  switch (pattern) {
+  case MI_ACCESS_SLICE:
+    /* Whole planes through the two fastest dimensions, trimming the slower
+       of the two if one plane would make an excessively large chunk */
+    for (i = ndims - 1; i >= 0 && nslice < 2; i--) {
+      if (dimensions[i]->dim_class == MI_DIMCLASS_RECORD)
+        continue;
+      hdf_size[i] = dimensions[i]->length;
+      if (fixed * hdf_size[i] > _MI2_MAX_CHUNK_BYTES)
+        hdf_size[i] = _MI2_MAX_CHUNK_BYTES / fixed > 0 ? _MI2_MAX_CHUNK_BYTES / fixed : 1;
+      fixed *= hdf_size[i];
+      nslice++;
+    }
+    break;
+
+  case MI_ACCESS_TIMESERIES:
+    /* The whole time course in each chunk, with small spatial blocks */
+    for (i = 0; i < ndims; i++) {
+      if (dimensions[i]->dim_class == MI_DIMCLASS_TIME ||
+          dimensions[i]->dim_class == MI_DIMCLASS_TFREQUENCY) {
+        hdf_size[i] = dimensions[i]->length;
+        fixed *= hdf_size[i];
+      }
+      else if (dimensions[i]->dim_class != MI_DIMCLASS_RECORD) {
+        nfree++;
+      }
+    }
+    if (nfree > 0) {
+      hsize_t budget = _MI1_MAX_VAR_BUFFER_SIZE / fixed;
+      edge = (hsize_t) floor(pow((double) budget, 1.0 / nfree));
+      if (edge < 1)
+        edge = 1;
+      for (i = 0; i < ndims; i++) {
+        if (dimensions[i]->dim_class != MI_DIMCLASS_TIME &&
+            dimensions[i]->dim_class != MI_DIMCLASS_TFREQUENCY &&
+            dimensions[i]->dim_class != MI_DIMCLASS_RECORD) {
+          hdf_size[i] = edge;
+        }
+      }
+    }
+    break;
+
+  case MI_ACCESS_CUBE:
+  default:
+    /* Equal edges on every non-temporal dimension, one time point each */
+    for (i = 0; i < ndims; i++) {
+      if (dimensions[i]->dim_class != MI_DIMCLASS_TIME &&
+          dimensions[i]->dim_class != MI_DIMCLASS_TFREQUENCY &&
+          dimensions[i]->dim_class != MI_DIMCLASS_RECORD) {
+        hdf_size[i] = MI2_CHUNK_SIZE;
+      }
+    }
+    break;
+  }
+
+  for (i = 0; i < ndims; i++) {
+    if (hdf_size[i] > dimensions[i]->length)
+      hdf_size[i] = dimensions[i]->length;
+    if (hdf_size[i] < 1)
+      hdf_size[i] = 1;
+  }
+}
+
+/** \internal
+ * Build a dataset access property list for the image dataset of
+ * \a volume. If the handle was given an explicit chunk cache size it is
+ * used as is. Otherwise the raw data chunk cache is made large enough to
+ * hold every chunk crossed by one plane through the two fastest-varying
+ * dimensions, so that reading a volume slice by slice decompresses each
+ * chunk only once whatever the chunk shape. Returns H5P_DEFAULT when the
+ * file-level cache of \a default_bytes is already large enough, the
+ * dataset is not chunked, or MINC_FILE_CACHE fixes the cache size.
+ */
+static hid_t _micreate_chunk_cache_dapl(mihandle_t volume,
+                                        hid_t dcpl_id, hid_t type_id,
+                                        int ndims, const hsize_t *dims,
+                                        size_t default_bytes)
+{
+  hsize_t chunk[MI2_MAX_VAR_DIMS];
+  size_t chunk_bytes;
+  size_t nchunks = 1;
+  size_t cache_bytes;
+  size_t nslots;
+  hid_t dapl_id;
+  int chunked;
+  int i;
+
+  chunked = (H5Pget_layout(dcpl_id) == H5D_CHUNKED &&
+             H5Pget_chunk(dcpl_id, MI2_MAX_VAR_DIMS, chunk) == ndims);
+  chunk_bytes = H5Tget_size(type_id);
+  if (chunked) {
+    for (i = 0; i < ndims; i++) {
+      chunk_bytes *= chunk[i];
+      if (i >= ndims - 2) {
+        nchunks *= (dims[i] + chunk[i] - 1) / chunk[i];
+      }
+    }
+  }
+
+  if (volume->cache_bytes > 0) {
+    cache_bytes = volume->cache_bytes;
+  }
+  else {
+    if (!chunked || miget_cfg_present(MICFG_MINC_FILE_CACHE))
+      return H5P_DEFAULT;
+
+    cache_bytes = nchunks * chunk_bytes;
+    if (cache_bytes > _MI2_MAX_CHUNK_CACHE)
+      cache_bytes = _MI2_MAX_CHUNK_CACHE;
+    if (cache_bytes <= default_bytes && volume->cache_slots == 0 &&
+        volume->cache_w0 < 0.0)
+      return H5P_DEFAULT;
+    if (cache_bytes < default_bytes)
+      cache_bytes = default_bytes;
+  }
+
+  /* HDF5 recommends about 100 hash slots per cached chunk */
+  nslots = volume->cache_slots;
+  if (nslots == 0)
+    nslots = chunked ? (cache_bytes / chunk_bytes) * 100 + 1 : 2503;
+
+  dapl_id = H5Pcreate(H5P_DATASET_ACCESS);
+  if (dapl_id < 0)
+    return H5P_DEFAULT;
+  H5Pset_chunk_cache(dapl_id, nslots, cache_bytes,
+                     volume->cache_w0 < 0.0 ? 1.0 : volume->cache_w0);
+  return dapl_id;
+}
+
+/** \internal
+ * Open the image dataset at \a path, sizing its chunk cache to the chunk
+ * layout with _micreate_chunk_cache_dapl().
+ */
+hid_t _miopen_image_dataset(mihandle_t volume, const char *path)
+{
+  hid_t dset_id;
+  hid_t dcpl_id;
+  hid_t type_id;
+  hid_t space_id;
+  hid_t dapl_id = H5P_DEFAULT;
+  hsize_t dims[MI2_MAX_VAR_DIMS];
+  int ndims;
+
+  dset_id = H5Dopen2(volume->hdf_id, path, H5P_DEFAULT);
+  if (dset_id < 0)
+    return dset_id;
+
+  dcpl_id = H5Dget_create_plist(dset_id);
+  type_id = H5Dget_type(dset_id);
+  space_id = H5Dget_space(dset_id);
+  ndims = H5Sget_simple_extent_dims(space_id, dims, NULL);
+  if (dcpl_id >= 0 && type_id >= 0 && ndims > 0) {
+    dapl_id = _micreate_chunk_cache_dapl(volume, dcpl_id, type_id, ndims, dims,
+                                         _MI1_MAX_VAR_BUFFER_SIZE*10);
+  }
+  H5Sclose(space_id);
+  H5Tclose(type_id);
+  H5Pclose(dcpl_id);
+
+  if (dapl_id != H5P_DEFAULT) {
+    H5Dclose(dset_id);
+    dset_id = H5Dopen2(volume->hdf_id, path, dapl_id);
+    H5Pclose(dapl_id);
+  }
+  return dset_id;
+}
+
 /** Create the actual image for the volume.
   * Note that the image dataset muct be created in the hierarchy
   * before the image data can be added.
@@ -284,6 +626,7 @@ int micreate_volume_image(mihandle_t volume)
   int dimorder_len=0;
   hid_t dataspace_id;
   hid_t dset_id;
+  hid_t dapl_id;
   hsize_t hdf_size[MI2_MAX_VAR_DIMS];
 
   /* Try creating IMAGE dataset i.e. /minc-2.0/image/0/image
@@ -310,10 +653,17 @@ int micreate_volume_image(mihandle_t volume)
     return MI_ERROR;
   }
 
-  MI_CHECK_HDF_CALL_RET(dset_id = H5Dcreate2(volume->hdf_id, MI_ROOT_PATH "/image/0/image",
-                                             volume->ftype_id,
-                                             dataspace_id, H5P_DEFAULT,
-                                             volume->plist_id,H5P_DEFAULT),"H5Dcreate2")
+  dapl_id = _micreate_chunk_cache_dapl(volume, volume->plist_id, volume->ftype_id,
+                                       volume->number_of_dims, hdf_size,
+                                       _MI1_MAX_VAR_BUFFER_SIZE*100);
+
+  dset_id = H5Dcreate2(volume->hdf_id, MI_ROOT_PATH "/image/0/image",
+                       volume->ftype_id,
+                       dataspace_id, H5P_DEFAULT,
+                       volume->plist_id, dapl_id);
+  if (dapl_id != H5P_DEFAULT)
+    H5Pclose(dapl_id);
+  MI_CHECK_HDF_CALL_RET(dset_id,"H5Dcreate2")
 
   volume->image_id = dset_id;
 
@@ -440,11 +790,25 @@ static mihandle_t mialloc_volume_handle(void)
     handle->image_id = -1;
     handle->imax_id = -1;
     handle->imin_id = -1;
+    handle->image_fspc_id = -1;
+    handle->imax_fspc_id = -1;
+    handle->imin_fspc_id = -1;
+    handle->buffer_type = MI_TYPE_UNKNOWN;
+    handle->buffer_type_id = -1;
     handle->plist_id = -1;
     handle->has_slice_scaling = FALSE;
     handle->is_dirty = FALSE;
+    handle->is_deferred = FALSE;
+    handle->open_failed = FALSE;
+    handle->stats_stale = FALSE;
+    handle->stats_bins = 0;
+    handle->label_table = NULL;
+    handle->label_index_stale = FALSE;
     handle->dim_indices = NULL;
     handle->selected_resolution = 0;
+    handle->cache_bytes = 0;
+    handle->cache_slots = 0;
+    handle->cache_w0 = -1.0;
   }
   return (handle);
 }
@@ -585,7 +949,16 @@ int micreate_volume(const char *filename, int number_of_dimensions,
     and create ID and ID access as default.
   */
 
-  file_id = _hdf_create(filename, H5F_ACC_TRUNC);
+  if (create_props != NULL) {
+    handle->cache_bytes = create_props->cache_bytes;
+    handle->cache_slots = create_props->cache_slots;
+    handle->cache_w0 = create_props->cache_w0;
+    handle->stats_bins = create_props->stats_bins;
+  }
+
+  file_id = _hdf_create(filename, H5F_ACC_TRUNC, handle,
+                        create_props != NULL ? create_props->metadata_reserve : 0,
+                        !_mi_props_chunked(create_props));
   if (file_id < 0) {
     free(handle);
     return (MI_ERROR);
@@ -622,10 +995,7 @@ int micreate_volume(const char *filename, int number_of_dimensions,
     raw data for a dataset.
   */
 
-  if (create_props != NULL  &&
-      ( create_props->compression_type == MI_COMPRESS_ZLIB ||
-        create_props->edge_count != 0 )
-      )
+  if (_mi_props_chunked(create_props))
   {
     /* Set the storage to CHUNKED */
     MI_CHECK_HDF_CALL_RET( stat = H5Pset_layout(hdf_plist, H5D_CHUNKED),"H5Pset_layout")
@@ -644,12 +1014,20 @@ int micreate_volume(const char *filename, int number_of_dimensions,
             hdf_size[i] = dimensions[i]->length;
         }
       }
+    } else if (create_props->access_pattern != MI_ACCESS_DEFAULT) {
+      _mioptimize_chunk_shape(create_props->access_pattern,
+                              number_of_dimensions, dimensions,
+                              H5Tget_size(handle->ftype_id),
+                              create_props->planar_components, hdf_size);
     } else {
       hsize_t val = 1;
       size_t unit_size = H5Tget_size(handle->ftype_id);
       /*adopted code from hdf_convenience.c:1360 to match behaviour of MINC1 API*/
       for( i = number_of_dimensions-1; i >= 0; i-- ) {
-          if( _MI1_MAX_VAR_BUFFER_SIZE > dimensions[i]->length * val * unit_size ) {
+          if( create_props->planar_components &&
+              dimensions[i]->dim_class == MI_DIMCLASS_RECORD ) {
+              hdf_size[i] = 1; /* one component per chunk, see below */
+          } else if( _MI1_MAX_VAR_BUFFER_SIZE > dimensions[i]->length * val * unit_size ) {
               hdf_size[i] = dimensions[i]->length;
           } else {
             if ( dimensions[i]->length < (hsize_t)( _MI1_MAX_VAR_BUFFER_SIZE / ( val * unit_size ) ) )
@@ -661,11 +1039,35 @@ int micreate_volume(const char *filename, int number_of_dimensions,
       }
     }
 
+    /* Planar components: one record component per chunk, also when the
+       chunk edges were given explicitly */
+    if (create_props->planar_components) {
+      for (i = 0; i < number_of_dimensions; i++) {
+        if (dimensions[i]->dim_class == MI_DIMCLASS_RECORD)
+          hdf_size[i] = 1;
+      }
+    }
+
     /* Sets the size of the chunks used to store a chunked layout dataset */
     MI_CHECK_HDF_CALL_RET(stat = H5Pset_chunk(hdf_plist, number_of_dimensions, hdf_size),"H5Pset_chunk")
     
+    /* Prefilters run in the order they are added: scale-offset packs
+       integer voxels into fewer bits, shuffle groups bytes of equal
+       significance, then the compressor sees the transformed chunk */
+    if (create_props->scaleoffset &&
+        H5Tget_class(handle->ftype_id) == H5T_INTEGER)
+    {
+      MI_CHECK_HDF_CALL_RET(H5Pset_scaleoffset(hdf_plist, H5Z_SO_INT, H5Z_SO_INT_MINBITS_DEFAULT),"H5Pset_scaleoffset")
+    }
+
+    if (create_props->shuffle && H5Tget_size(handle->ftype_id) > 1)
+    {
+      MI_CHECK_HDF_CALL_RET(H5Pset_shuffle(hdf_plist),"H5Pset_shuffle")
+    }
+
     /* Sets compression method and compression level */
-    MI_CHECK_HDF_CALL_RET(stat = H5Pset_deflate(hdf_plist, create_props->zlib_level),"H5Pset_deflate")
+    if (miset_plist_compression(hdf_plist, create_props) < 0)
+      return MI_ERROR;
 
     
     if (create_props->checksum )
@@ -953,7 +1355,7 @@ int micreate_volume(const char *filename, int number_of_dimensions,
   miinvert_transform(handle->v2w_transform, handle->w2v_transform);
 
   /* Allocated space for the volume properties */
-  props_handle = (mivolumeprops_t)malloc(sizeof(struct mivolprops));
+  props_handle = (mivolumeprops_t)calloc(1, sizeof(struct mivolprops));
   /* Initialize volume properties with zero */
   memset(props_handle, 0, sizeof (struct mivolprops));
   /* If volume properties is specified by the user
@@ -966,15 +1368,16 @@ int micreate_volume(const char *filename, int number_of_dimensions,
     levels of resolution is specified maximum is 16.
     */
     props_handle->depth = create_props->depth;
-    /* Set compression type, currently two values
-    either no compression or zlib is applicable.
+    /* Set compression type: none, zlib or one of the
+    plugin codecs.
     */
     switch (create_props->compression_type) {
     case MI_COMPRESS_NONE:
-      props_handle->compression_type = MI_COMPRESS_NONE;
-      break;
     case MI_COMPRESS_ZLIB:
-      props_handle->compression_type = MI_COMPRESS_ZLIB;
+    case MI_COMPRESS_ZSTD:
+    case MI_COMPRESS_LZ4:
+    case MI_COMPRESS_BLOSC:
+      props_handle->compression_type = create_props->compression_type;
       break;
     default:
       free(props_handle);
@@ -1004,6 +1407,16 @@ int micreate_volume(const char *filename, int number_of_dimensions,
       strcpy(props_handle->record_name, create_props->record_name);
     }
     props_handle->template_flag = create_props->template_flag;
+    props_handle->checksum = create_props->checksum;
+    props_handle->shuffle = create_props->shuffle;
+    props_handle->scaleoffset = create_props->scaleoffset;
+    props_handle->access_pattern = create_props->access_pattern;
+    props_handle->cache_bytes = create_props->cache_bytes;
+    props_handle->cache_slots = create_props->cache_slots;
+    props_handle->cache_w0 = create_props->cache_w0;
+    props_handle->metadata_reserve = create_props->metadata_reserve;
+    props_handle->stats_bins = create_props->stats_bins;
+    props_handle->planar_components = create_props->planar_components;
   }
   /* Set the handle to volume properties */
   handle->create_props = props_handle;
@@ -1074,6 +1487,84 @@ int miget_volume_voxel_count(mihandle_t volume, misize_t *number_of_voxels)
   return (MI_NOERROR);
 }
 
+/** Get the raw data chunk cache settings in use for the image of a volume.
+    \ingroup mi2Vol
+*/
+int miget_volume_chunk_cache(mihandle_t volume, size_t *nbytes,
+                             size_t *nslots, double *w0)
+{
+  hid_t dapl_id;
+  herr_t r;
+
+  if (volume == NULL || miopen_image_datasets(volume) < 0 || volume->image_id < 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to get chunk cache of a volume without image");
+  }
+  MI_CHECK_HDF_CALL_RET(dapl_id = H5Dget_access_plist(volume->image_id),"H5Dget_access_plist");
+  r = H5Pget_chunk_cache(dapl_id, nslots, nbytes, w0);
+  H5Pclose(dapl_id);
+  MI_CHECK_HDF_CALL_RET(r,"H5Pget_chunk_cache");
+  return (MI_NOERROR);
+}
+
+/** Get where the image of the selected resolution of a volume is stored
+    in its file, when it can be used as it is stored.
+    \ingroup mi2Vol
+*/
+int miget_volume_image_storage(mihandle_t volume, mitype_t type,
+                               misize_t *offset, misize_t *nbytes)
+{
+  hid_t plist_id = -1;
+  hid_t ftype_id = -1;
+  hid_t mtype_id = -1;
+  haddr_t addr;
+  hsize_t size;
+
+  if (volume == NULL || miopen_image_datasets(volume) < 0 || volume->image_id < 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to get image storage of a volume without image");
+  }
+  *offset = 0;
+  *nbytes = 0;
+
+  H5E_BEGIN_TRY {
+    plist_id = H5Dget_create_plist(volume->image_id);
+    ftype_id = H5Dget_type(volume->image_id);
+    mtype_id = mitype_to_hdftype(type, TRUE);
+    if (plist_id >= 0 && ftype_id >= 0 && mtype_id >= 0 &&
+        H5Pget_layout(plist_id) == H5D_CONTIGUOUS &&
+        H5Pget_external_count(plist_id) == 0 &&
+        H5Tequal(ftype_id, mtype_id) > 0) {
+      addr = H5Dget_offset(volume->image_id);
+      size = H5Dget_storage_size(volume->image_id);
+      if (addr != HADDR_UNDEF && size > 0) {
+        *offset = addr;
+        *nbytes = size;
+      }
+    }
+    if (mtype_id >= 0) H5Tclose(mtype_id);
+    if (ftype_id >= 0) H5Tclose(ftype_id);
+    if (plist_id >= 0) H5Pclose(plist_id);
+  } H5E_END_TRY;
+  return (MI_NOERROR);
+}
+
+/** Get the hit rate of the HDF5 metadata cache of a volume since it was
+    opened or since the last call with \a reset set. This is not the
+    chunk cache of the image data.
+    \ingroup mi2Vol
+*/
+int miget_volume_metadata_cache_hit_rate(mihandle_t volume, double *hit_rate,
+                                         miboolean_t reset)
+{
+  if (volume == NULL || volume->hdf_id < 0) {
+    return MI_LOG_ERROR(MI2_MSG_GENERIC,"Trying to get cache statistics of a closed volume");
+  }
+  MI_CHECK_HDF_CALL_RET(H5Fget_mdc_hit_rate(volume->hdf_id, hit_rate),"H5Fget_mdc_hit_rate");
+  if (reset) {
+    MI_CHECK_HDF_CALL_RET(H5Freset_mdc_hit_rate_stats(volume->hdf_id),"H5Freset_mdc_hit_rate_stats");
+  }
+  return (MI_NOERROR);
+}
+
 /* Get the number of dimensions in the file */
 static int _miget_file_dimension_count(hid_t file_id)
 {
@@ -1215,6 +1706,7 @@ static int _miget_file_dimension(mihandle_t volume, const char *dimname,
   char temp[MI2_CHAR_LENGTH];
   midimhandle_t hdim;
   unsigned int len;
+  hid_t dim_id;
 
   /* Create a path with the dimension name */
   sprintf(path, MI_ROOT_PATH "/dimensions/%s", dimname);
@@ -1225,11 +1717,14 @@ static int _miget_file_dimension(mihandle_t volume, const char *dimname,
 
   hdim->name = strdup(dimname);
 
+  /* Open the dimension variable once for all of its attributes */
+  dim_id = midescend_path(volume->hdf_id, path);
+
   /* hdf5 macro can temporarily disable the automatic error printing */
   H5E_BEGIN_TRY {
     int r;
     /* Get the attribute (spacing) from a minc file */
-    r = miget_attribute(volume, path, "spacing", MI_TYPE_STRING, MI2_CHAR_LENGTH, temp);
+    r = miget_attr_at_loc(dim_id, "spacing", MI_TYPE_STRING, MI2_CHAR_LENGTH, temp);
     
     if (r==MI_NOERROR && !strcmp(temp, "irregular")) {
       hdim->attr |= MI_DIMATTR_NOT_REGULARLY_SAMPLED;
@@ -1239,7 +1734,7 @@ static int _miget_file_dimension(mihandle_t volume, const char *dimname,
     }
 
     /* Get the attribute (class) from a minc file */
-    r = miget_attribute(volume, path, "class", MI_TYPE_STRING,  MI2_CHAR_LENGTH, temp);
+    r = miget_attr_at_loc(dim_id, "class", MI_TYPE_STRING,  MI2_CHAR_LENGTH, temp);
     if (r < 0) {
       /* Get the default class. */
       if (!strcmp(dimname, MItime)) {
@@ -1273,7 +1768,7 @@ static int _miget_file_dimension(mihandle_t volume, const char *dimname,
      * the right type, then assign it to the structure member, to guarantee 
      * proper promotion.
      */
-    r = miget_attribute(volume, path, "length", MI_TYPE_UINT, 1, &len);
+    r = miget_attr_at_loc(dim_id, "length", MI_TYPE_UINT, 1, &len);
     if (r < 0) {
       MI_LOG_ERROR(MI2_MSG_GENERIC,"Can't determine dimension length");
     }
@@ -1281,18 +1776,18 @@ static int _miget_file_dimension(mihandle_t volume, const char *dimname,
 
     /* Get the attribute (start) from a minc file for NON vector_dimension only */
     if (strcmp(dimname, "vector_dimension")) {
-      r = miget_attribute(volume, path, MIstart, MI_TYPE_DOUBLE, 1, &hdim->start);
+      r = miget_attr_at_loc(dim_id, MIstart, MI_TYPE_DOUBLE, 1, &hdim->start);
       if (r < 0) {
         hdim->start = 0.0;
       }
       /* Get the attribute (step) from a minc file */
-      r = miget_attribute(volume, path, MIstep, MI_TYPE_DOUBLE, 1, &hdim->step);
+      r = miget_attr_at_loc(dim_id, MIstep, MI_TYPE_DOUBLE, 1, &hdim->step);
       if (r < 0) {
         hdim->step = 1.0;
       }
     }
     /* Get the attribute (direction_cosines) from a minc file */
-    r = miget_attribute(volume, path, MIdirection_cosines, MI_TYPE_DOUBLE, 3,
+    r = miget_attr_at_loc(dim_id, MIdirection_cosines, MI_TYPE_DOUBLE, 3,
                         hdim->direction_cosines);
     if (r < 0) {
       hdim->direction_cosines[MI2_X] = 0.0;
@@ -1307,7 +1802,7 @@ static int _miget_file_dimension(mihandle_t volume, const char *dimname,
       }
     }
 
-    r = miget_attribute(volume, path, "units", MI_TYPE_STRING,
+    r = miget_attr_at_loc(dim_id, "units", MI_TYPE_STRING,
                         MI2_CHAR_LENGTH, temp);
     if (r < 0) {
       hdim->units = strdup("");
@@ -1316,6 +1811,14 @@ static int _miget_file_dimension(mihandle_t volume, const char *dimname,
     }
 
   } H5E_END_TRY;
+
+  if (dim_id >= 0) {
+    if (H5Iget_type(dim_id) == H5I_GROUP) {
+      H5Gclose(dim_id);
+    } else {
+      H5Dclose(dim_id);
+    }
+  }
   /* Return the dimension handle */
   *hdim_ptr = hdim;
   hdim->volume_handle = volume;
@@ -1325,29 +1828,39 @@ static int _miget_file_dimension(mihandle_t volume, const char *dimname,
 
 /** Opens an existing MINC volume for read-only access if mode argument is
   * MI2_OPEN_READ, or read-write access if mode argument is MI2_OPEN_RDWR.
+  * With MI2_OPEN_READ|MI2_OPEN_HEADER only the dimensions and attributes
+  * are read; the image, image-max and image-min datasets are opened on
+  * the first call that needs them, such as miget_data_type() or a
+  * hyperslab read.
   * \ingroup mi2Vol
 */
 int miopen_volume(const char *filename, int mode, mihandle_t *volume)
+{
+  return miopen_volume_with_props(filename, mode, NULL, volume);
+}
+
+/** Opens an existing MINC volume like miopen_volume(), taking the chunk
+  * cache settings of \a props into account.
+  * \ingroup mi2Vol
+*/
+int miopen_volume_with_props(const char *filename, int mode,
+                             mivolumeprops_t props, mihandle_t *volume)
 {
   hid_t file_id;
-  hid_t dset_id;
-  hid_t space_id;
   mihandle_t handle;
   int hdf_mode;
   char dimorder[MI2_CHAR_LENGTH];
   int i,r;
   char *p1, *p2;
-  H5T_class_t hdf_class;
-  size_t nbytes;
-  int is_signed;
   int n_dimensions;
 
   /* Initialization.
     For the actual body of this function look at m2utils.c
   */
   miinit();
-  /* Convert the specified mode to hdf mode */
-  if (mode == MI2_OPEN_READ) {
+  /* Convert the specified mode to hdf mode, a header-only open is
+     always read-only */
+  if ((mode & ~MI2_OPEN_HEADER) == MI2_OPEN_READ) {
     hdf_mode = H5F_ACC_RDONLY;
   } else if (mode == MI2_OPEN_RDWR) {
     hdf_mode = H5F_ACC_RDWR;
@@ -1359,22 +1872,50 @@ int miopen_volume(const char *filename, int mode, mihandle_t *volume)
   if (handle == NULL) {
     return MI_LOG_ERROR(MI2_MSG_OUTOFMEM,sizeof(struct mivolume));
   }
+  if (props != NULL) {
+    handle->cache_bytes = props->cache_bytes;
+    handle->cache_slots = props->cache_slots;
+    handle->cache_w0 = props->cache_w0;
+    handle->stats_bins = props->stats_bins;
+  }
   
   /* Open the hdf file using the given filename and mode */
-  file_id = _hdf_open(filename, hdf_mode);
+  file_id = _hdf_open(filename, hdf_mode, handle);
  
   if (file_id < 0) {
     /*try to convert MINC1 file*/
 #ifdef HAVE_MINC1
     char * temp_file=NULL;
+    void * image=NULL;
+    size_t image_size=0;
+
+    /*convert only the header, the image is read from the MINC1 file*/
+    if ( hdf_mode == (int) H5F_ACC_RDONLY && _mi1_direct_read() &&
+         minc_format_convert_header_image(filename,&image,&image_size) == MI_NOERROR )
+    {
+      file_id = _hdf_open_image(filename, image, image_size, handle);
+      free( image );
+    }
+
+    /*convert small files in memory, without a temporary file*/
+    if ( file_id < 0 && hdf_mode == (int) H5F_ACC_RDONLY &&
+         _mi1_convert_in_memory(filename) &&
+         minc_format_convert_image(filename,&image,&image_size) == MI_NOERROR )
+    {
+      file_id = _hdf_open_image(filename, image, image_size, handle);
+      free( image );
+    }
 
-    if ( mode == MI2_OPEN_READ )
+    if ( file_id >= 0 )
+    {
+      /*converted in memory*/
+    } else if ( hdf_mode == (int) H5F_ACC_RDONLY )
     {
       if( (temp_file=micreate_tempfile()))
       {
          if( minc_format_convert(filename,temp_file) == MI_NOERROR )
          {
-           if( (file_id = _hdf_open(temp_file, hdf_mode) ) >0)
+           if( (file_id = _hdf_open(temp_file, hdf_mode, handle) ) >0)
            {
             unlink( temp_file ); /*file will be deleted immedeately after closing...*/
             free( temp_file );
@@ -1454,67 +1995,111 @@ int miopen_volume(const char *filename, int mode, mihandle_t *volume)
     return MI_LOG_ERROR(MI2_MSG_GENERIC,"Can't determine world indices");
   }
 
-  /* SEE IF SLICE SCALING IS ENABLED
-  */
-  handle->has_slice_scaling = FALSE;
+  /* Read the current voxel-to-world transform */
+  miget_voxel_to_world(handle, handle->v2w_transform);
+
+  /* Calculate the inverse transform */
+  miinvert_transform(handle->v2w_transform, handle->w2v_transform);
+
+  /* The image datasets are opened on first use of a header-only volume */
+  handle->is_deferred = TRUE;
+  if ((mode & MI2_OPEN_HEADER) == 0 && miopen_image_datasets(handle) < 0) {
+    return (MI_ERROR);
+  }
+
+  *volume = handle;
+  return (MI_NOERROR);
+}
+
+static int _miopen_image_datasets(mihandle_t volume);
+
+/** \internal
+ * Opens the image, image-max and image-min datasets of a volume and reads
+ * the scaling and valid range. Called once by miopen_volume(), or on the
+ * first data access of a volume opened with MI2_OPEN_HEADER. If this
+ * fails every later call fails too.
+ */
+int miopen_image_datasets(mihandle_t volume)
+{
+  if (!volume->is_deferred) {
+    return (volume->open_failed ? MI_ERROR : MI_NOERROR);
+  }
+  /* Cleared first, the valid range is read through the volume handle */
+  volume->is_deferred = FALSE;
+
+  if (_miopen_image_datasets(volume) < 0) {
+    volume->open_failed = TRUE;
+    return (MI_ERROR);
+  }
+  return (MI_NOERROR);
+}
+
+static int _miopen_image_datasets(mihandle_t volume)
+{
+  hid_t space_id;
+  H5T_class_t hdf_class;
+  size_t nbytes;
+  int is_signed;
+  int i;
+
   /* hdf5 macro can temporarily disable the automatic error printing */
   H5E_BEGIN_TRY {
-    /* Open the dataset image-max at the specified path*/
-    dset_id = H5Dopen1(file_id, MI_ROOT_PATH "/image/0/image-max");
+    /* Open both image-min and image-max datasets */
+    volume->imax_id = H5Dopen1(volume->hdf_id, MI_ROOT_PATH "/image/0/image-max");
+    volume->imin_id = H5Dopen1(volume->hdf_id, MI_ROOT_PATH "/image/0/image-min");
   } H5E_END_TRY;
-  
-  if (dset_id >= 0) {
+
+  /* SEE IF SLICE SCALING IS ENABLED
+  */
+  volume->has_slice_scaling = FALSE;
+  if (volume->imax_id >= 0) {
     /* Get the Id of the copy of the dataspace of the dataset */
-    space_id = H5Dget_space(dset_id);
+    space_id = H5Dget_space(volume->imax_id);
     if (space_id >= 0) {
       
       /* If the dimensionality of the image-max variable is one or
       * greater, we consider this volume to have slice-scaling enabled.
       */
       if ( H5Sget_simple_extent_ndims(space_id) >= 1) {
-        handle->has_slice_scaling = TRUE;
+        volume->has_slice_scaling = TRUE;
       }
       H5Sclose(space_id);	/* Close the dataspace handle */
     }
-    H5Dclose(dset_id);	/* Close the dataset handle */
   }
 
-  if (!handle->has_slice_scaling) {
+  if (!volume->has_slice_scaling) {
     /* Read the minimum scalar of the given type at the specified path */
-    miget_scalar(handle->hdf_id, H5T_NATIVE_DOUBLE,
-                 MI_ROOT_PATH "/image/0/image-min", &handle->scale_min);
+    miget_scalar(volume->hdf_id, H5T_NATIVE_DOUBLE,
+                 MI_ROOT_PATH "/image/0/image-min", &volume->scale_min);
     /* Read the maximum scalar of the given type at the specified path */
-    miget_scalar(handle->hdf_id, H5T_NATIVE_DOUBLE,
-                 MI_ROOT_PATH "/image/0/image-max", &handle->scale_max);
+    miget_scalar(volume->hdf_id, H5T_NATIVE_DOUBLE,
+                 MI_ROOT_PATH "/image/0/image-max", &volume->scale_max);
   }
 
-  /* Read the current voxel-to-world transform */
-  miget_voxel_to_world(handle, handle->v2w_transform);
-
-  /* Calculate the inverse transform */
-  miinvert_transform(handle->v2w_transform, handle->w2v_transform);
-
   /* Open the image dataset */
-  MI_CHECK_HDF_CALL_RET(handle->image_id = H5Dopen1(file_id, MI_ROOT_PATH "/image/0/image"),"H5Dopen1");
+  MI_CHECK_HDF_CALL_RET(volume->image_id = _miopen_image_dataset(volume, MI_ROOT_PATH "/image/0/image"),"H5Dopen2");
+  /* Report a missing compression plugin by name now; the header remains
+     accessible, but any attempt to read voxels will fail */
+  micheck_dataset_filters(volume->image_id);
   /* Get the Id for the copy of the datatype for the dataset */
-  MI_CHECK_HDF_CALL_RET(handle->ftype_id = H5Dget_type(handle->image_id),"H5Dget_type");
+  MI_CHECK_HDF_CALL_RET(volume->ftype_id = H5Dget_type(volume->image_id),"H5Dget_type");
 
-  switch (H5Tget_class(handle->ftype_id)) {
+  switch (H5Tget_class(volume->ftype_id)) {
   case H5T_INTEGER:
   case H5T_FLOAT:
-    handle->mtype_id = H5Tget_native_type(handle->ftype_id,
+    volume->mtype_id = H5Tget_native_type(volume->ftype_id,
                                           H5T_DIR_ASCEND);
     break;
 
   case H5T_COMPOUND:
-    handle->mtype_id = H5Tcreate(H5T_COMPOUND,
-                                 H5Tget_size(handle->ftype_id));
-    for (i = 0; i < H5Tget_nmembers(handle->ftype_id); i++) {
-      hid_t tmp_id = H5Tget_member_type(handle->ftype_id, i);
-      size_t tmp_off = H5Tget_member_offset(handle->ftype_id, i);
-      char *tmp_nm = H5Tget_member_name(handle->ftype_id, i);
+    volume->mtype_id = H5Tcreate(H5T_COMPOUND,
+                                 H5Tget_size(volume->ftype_id));
+    for (i = 0; i < H5Tget_nmembers(volume->ftype_id); i++) {
+      hid_t tmp_id = H5Tget_member_type(volume->ftype_id, i);
+      size_t tmp_off = H5Tget_member_offset(volume->ftype_id, i);
+      char *tmp_nm = H5Tget_member_name(volume->ftype_id, i);
       hid_t tmp2_id = H5Tget_native_type(tmp_id, H5T_DIR_ASCEND);
-      H5Tinsert(handle->mtype_id, tmp_nm, tmp_off, tmp2_id);
+      H5Tinsert(volume->mtype_id, tmp_nm, tmp_off, tmp2_id);
 
       free(tmp_nm);
       H5Tclose(tmp_id);
@@ -1523,53 +2108,46 @@ int miopen_volume(const char *filename, int mode, mihandle_t *volume)
     break;
 
   case H5T_ENUM:
-    handle->mtype_id = H5Tget_native_type(handle->ftype_id, H5T_DIR_ASCEND);
-    miinit_enum(handle->ftype_id);
-    miinit_enum(handle->mtype_id);
+    volume->mtype_id = H5Tget_native_type(volume->ftype_id, H5T_DIR_ASCEND);
+    miinit_enum(volume->ftype_id);
+    miinit_enum(volume->mtype_id);
     break;
 
   default:
     return (MI_ERROR);
   }
 
-  /* hdf5 macro can temporarily disable the automatic error printing */
-  H5E_BEGIN_TRY {
-    /* Open both image-min and image-max datasets */
-    handle->imax_id = H5Dopen1(file_id, MI_ROOT_PATH "/image/0/image-max");
-    handle->imin_id = H5Dopen1(file_id, MI_ROOT_PATH "/image/0/image-min");
-  } H5E_END_TRY;
-
   /* Convert the type to a MINC type.
   */
   /* Get the class Id for the datatype */
-  hdf_class = H5Tget_class(handle->ftype_id);
+  hdf_class = H5Tget_class(volume->ftype_id);
   /* Get the size of the datatype */
-  nbytes = H5Tget_size(handle->ftype_id);
+  nbytes = H5Tget_size(volume->ftype_id);
 
   switch (hdf_class) {
   case H5T_INTEGER:
   case H5T_ENUM:              /* label images */
-    is_signed = (H5Tget_sign(handle->ftype_id) == H5T_SGN_2);
+    is_signed = (H5Tget_sign(volume->ftype_id) == H5T_SGN_2);
 
     switch (nbytes) {
     case 1:
-      handle->volume_type = (is_signed ? MI_TYPE_BYTE : MI_TYPE_UBYTE);
+      volume->volume_type = (is_signed ? MI_TYPE_BYTE : MI_TYPE_UBYTE);
       break;
     case 2:
-      handle->volume_type = (is_signed ? MI_TYPE_SHORT : MI_TYPE_USHORT);
+      volume->volume_type = (is_signed ? MI_TYPE_SHORT : MI_TYPE_USHORT);
       break;
     case 4:
-      handle->volume_type = (is_signed ? MI_TYPE_INT : MI_TYPE_UINT);
+      volume->volume_type = (is_signed ? MI_TYPE_INT : MI_TYPE_UINT);
       break;
     default:
       return MI_LOG_ERROR(MI2_MSG_BADTYPE,hdf_class);
     }
     break;
   case H5T_FLOAT:
-    handle->volume_type = (nbytes == 4) ? MI_TYPE_FLOAT : MI_TYPE_DOUBLE;
+    volume->volume_type = (nbytes == 4) ? MI_TYPE_FLOAT : MI_TYPE_DOUBLE;
     break;
   case H5T_STRING:
-    handle->volume_type = MI_TYPE_STRING;
+    volume->volume_type = MI_TYPE_STRING;
     break;
   case H5T_ARRAY:
     /* TODO: handle this case for uniform records (arrays)? */
@@ -1582,9 +2160,8 @@ int miopen_volume(const char *filename, int mode, mihandle_t *volume)
   }
 
   /* Read the current settings for valid-range */
-  miread_valid_range(handle, &handle->valid_max, &handle->valid_min);
+  miread_valid_range(volume, &volume->valid_max, &volume->valid_min);
 
-  *volume = handle;
   return (MI_NOERROR);
 }
 
@@ -1618,8 +2195,17 @@ int miclose_volume(mihandle_t volume)
     volume->is_dirty = FALSE;
   }
 
+  /* Keep the statistics requested with miset_props_statistics() current */
+  if (volume->stats_stale && volume->stats_bins > 0 &&
+      volume->image_id >= 0 && (volume->mode & MI2_OPEN_RDWR) != 0) {
+    micompute_volume_statistics(volume, volume->stats_bins, NULL);
+  }
+
   miflush_volume(volume);
 
+  mifree_hyperslab_cache(volume);
+  mifree_label_table(volume);
+
   if (volume->image_id > 0) {
     H5Dclose(volume->image_id);
   }
@@ -1762,7 +2348,8 @@ int miget_slice_dimension_count(mihandle_t volume, midimclass_t dimclass,
   hid_t image_max_fspc_id;
   int slice_ndims;
   int result=-1;
-  if( miget_volume_dimension_count(volume,dimclass,attr, &number_of_volume_dimensions) <0 )
+  if( miget_volume_dimension_count(volume,dimclass,attr, &number_of_volume_dimensions) <0 ||
+      miopen_image_datasets(volume) < 0 )
   {
     return -1;
   }
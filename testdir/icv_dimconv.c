@@ -0,0 +1,335 @@
+/* Check that the fast paths of the icv dimension conversion give the
+ * same values as the general loop.
+ *
+ * Run with MINC_ICV_FAST_PATHS=0, "save" reads each test image through
+ * an icv that flips it and/or resizes it by 2 or 4 and saves what the
+ * general loop returns. Run again with the fast paths on (or off),
+ * "check" reads the same images and compares the buffers byte for byte.
+ * Flipped images are also written through an icv and the stored voxels
+ * compared the same way.
+ *
+ * The image sizes are odd or fall just around the tile of the resize
+ * kernel (256 pixels), and each image is also read with a start that
+ * does not fall on a block of the resizing.
+ *
+ * Usage: icv_dimconv save|check [directory]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <minc.h>
+
+#define TRUE 1
+#define FALSE 0
+
+#define NZ 3
+
+#define TESTRPT(msg, val) (error_cnt++, fprintf(stderr, \
+                                  "Error reported on line #%d, %s: %d\n", \
+                                  __LINE__, msg, val))
+
+static int error_cnt = 0;
+
+struct test_case {
+  long ny, nx;          /* Image size in the file */
+  long bsize, asize;    /* Image size read through the icv */
+  int ydir, xdir;       /* Directions asked of the icv */
+  nc_type type;         /* Type of the user's buffer */
+  int fillvalue;        /* Replace values outside the valid range */
+};
+
+static const struct test_case cases[] = {
+  /* same size, whole rows converted at once */
+  {37,   41,  37,   41, MI_ICV_NEGATIVE, MI_ICV_NEGATIVE, NC_DOUBLE, FALSE},
+  {37,   41,  37,   41, MI_ICV_POSITIVE, MI_ICV_NEGATIVE, NC_SHORT,  FALSE},
+  {37,   41,  37,   41, MI_ICV_ANYDIR,   MI_ICV_ANYDIR,   NC_SHORT,  TRUE},
+  /* shrunk by 2 and 4, one tile and one pixel more */
+  {20,  512,  10,  256, MI_ICV_ANYDIR,   MI_ICV_ANYDIR,   NC_DOUBLE, FALSE},
+  {20,  514,  10,  257, MI_ICV_POSITIVE, MI_ICV_NEGATIVE, NC_DOUBLE, FALSE},
+  {20,  514,  10,  257, MI_ICV_ANYDIR,   MI_ICV_ANYDIR,   NC_DOUBLE, TRUE},
+  {16, 1024,   4,  256, MI_ICV_NEGATIVE, MI_ICV_POSITIVE, NC_SHORT,  FALSE},
+  {12, 1028,   3,  257, MI_ICV_NEGATIVE, MI_ICV_NEGATIVE, NC_DOUBLE, FALSE},
+  /* grown by 2 and 4, odd sizes around a tile */
+  { 9,  255,  18,  510, MI_ICV_ANYDIR,   MI_ICV_ANYDIR,   NC_DOUBLE, FALSE},
+  { 5,  257,  20, 1028, MI_ICV_NEGATIVE, MI_ICV_NEGATIVE, NC_DOUBLE, FALSE},
+  { 7,  256,  14,  512, MI_ICV_ANYDIR,   MI_ICV_NEGATIVE, NC_SHORT,  TRUE},
+  /* left to the general loop: resized by 3, shrunk and grown at once */
+  {21,   36,   7,   12, MI_ICV_NEGATIVE, MI_ICV_ANYDIR,   NC_DOUBLE, FALSE},
+  {20,  128,  10,  256, MI_ICV_ANYDIR,   MI_ICV_NEGATIVE, NC_DOUBLE, FALSE}
+};
+
+/* Voxel value as a function of its position */
+static short voxel_value(long z, long y, long x)
+{
+  return (short)((z * 7919 + y * 131 + x * 17) % 4001 - 2000);
+}
+
+/* Create an image with a different range for each slice, a valid range
+ * smaller than the stored values and, unless fill is FALSE, voxel values
+ * set from voxel_value. Returns the file id or MI_ERROR. */
+static int create_image(const char *filename, long ny, long nx, int fill,
+                        int *imgid)
+{
+  static char *dimnames[] = {MIzspace, MIyspace, MIxspace};
+  long lengths[3];
+  long start[3] = {0, 0, 0};
+  long count[3];
+  int dim[3];
+  int cdfid, dimvar, img, max, min;
+  double valid_range[2] = {-1500.0, 1500.0};
+  double dvalue;
+  short *values;
+  long z, y, x, i;
+
+  lengths[0] = NZ;
+  lengths[1] = ny;
+  lengths[2] = nx;
+  cdfid = micreate(filename, NC_CLOBBER);
+  if (cdfid == MI_ERROR)
+    return MI_ERROR;
+  for (i = 0; i < 3; i++) {
+    dim[i] = ncdimdef(cdfid, dimnames[i], lengths[i]);
+    dimvar = micreate_std_variable(cdfid, dimnames[i], NC_DOUBLE, 0, &dim[i]);
+    miattputdbl(cdfid, dimvar, MIstep, 0.5);
+    miattputdbl(cdfid, dimvar, MIstart, -10.0);
+  }
+  img = micreate_std_variable(cdfid, MIimage, NC_SHORT, 3, dim);
+  miset_valid_range(cdfid, img, valid_range);
+  max = micreate_std_variable(cdfid, MIimagemax, NC_DOUBLE, 1, dim);
+  min = micreate_std_variable(cdfid, MIimagemin, NC_DOUBLE, 1, dim);
+  ncendef(cdfid);
+
+  for (z = 0; z < NZ; z++) {
+    dvalue = 100.0 + 25.0 * z;
+    ncvarput1(cdfid, max, &z, &dvalue);
+    dvalue = -50.0 - 10.0 * z;
+    ncvarput1(cdfid, min, &z, &dvalue);
+  }
+
+  if (fill) {
+    values = malloc(NZ * ny * nx * sizeof(short));
+    if (values == NULL) {
+      miclose(cdfid);
+      return MI_ERROR;
+    }
+    for (z = 0, i = 0; z < NZ; z++)
+      for (y = 0; y < ny; y++)
+        for (x = 0; x < nx; x++, i++)
+          values[i] = voxel_value(z, y, x);
+    count[0] = NZ;
+    count[1] = ny;
+    count[2] = nx;
+    ncvarput(cdfid, img, start, count, values);
+    free(values);
+  }
+  *imgid = img;
+  return cdfid;
+}
+
+static int create_icv(const struct test_case *tc)
+{
+  int icv = miicv_create();
+
+  miicv_setint(icv, MI_ICV_TYPE, tc->type);
+  miicv_setint(icv, MI_ICV_DO_NORM, TRUE);
+  miicv_setint(icv, MI_ICV_DO_FILLVALUE, tc->fillvalue);
+  miicv_setint(icv, MI_ICV_DO_DIM_CONV, TRUE);
+  miicv_setint(icv, MI_ICV_KEEP_ASPECT, FALSE);
+  miicv_setint(icv, MI_ICV_YDIM_DIR, tc->ydir);
+  miicv_setint(icv, MI_ICV_XDIM_DIR, tc->xdir);
+  miicv_setint(icv, MI_ICV_BDIM_SIZE, tc->bsize);
+  miicv_setint(icv, MI_ICV_ADIM_SIZE, tc->asize);
+  return icv;
+}
+
+/* Read the whole image through the icv, then a part of it starting
+ * off the blocks, one after the other in the buffer */
+static char *read_case(const char *filename, const struct test_case *tc,
+                       size_t *nbytes)
+{
+  long start[3] = {0, 0, 0};
+  long count[3];
+  long pstart[3] = {1, 1, 3};
+  long pcount[3];
+  size_t nwhole, npart;
+  char *buffer;
+  int cdfid, img, icv;
+
+  count[0] = NZ;
+  count[1] = tc->bsize;
+  count[2] = tc->asize;
+  pcount[0] = 1;
+  pcount[1] = tc->bsize - 2;
+  pcount[2] = tc->asize - 5;
+  nwhole = NZ * tc->bsize * tc->asize * nctypelen(tc->type);
+  npart = pcount[1] * pcount[2] * nctypelen(tc->type);
+  *nbytes = nwhole + npart;
+
+  buffer = calloc(1, *nbytes);
+  if (buffer == NULL) {
+    TESTRPT("out of memory", 0);
+    return NULL;
+  }
+  cdfid = miopen(filename, NC_NOWRITE);
+  if (cdfid == MI_ERROR) {
+    TESTRPT("miopen failed", cdfid);
+    free(buffer);
+    return NULL;
+  }
+  img = ncvarid(cdfid, MIimage);
+  icv = create_icv(tc);
+  if (miicv_attach(icv, cdfid, img) == MI_ERROR ||
+      miicv_get(icv, start, count, buffer) == MI_ERROR ||
+      miicv_get(icv, pstart, pcount, buffer + nwhole) == MI_ERROR) {
+    TESTRPT("reading through the icv failed", 0);
+    free(buffer);
+    buffer = NULL;
+  }
+  miicv_free(icv);
+  miclose(cdfid);
+  return buffer;
+}
+
+/* Write a flipped image through the icv and return the stored voxels */
+static char *write_case(const char *filename, const struct test_case *tc,
+                        size_t *nbytes)
+{
+  long start[3] = {0, 0, 0};
+  long count[3];
+  double *values;
+  char *buffer;
+  long z, y, x, i;
+  int cdfid, img, icv;
+
+  count[0] = NZ;
+  count[1] = tc->ny;
+  count[2] = tc->nx;
+  *nbytes = NZ * tc->ny * tc->nx * sizeof(short);
+  values = malloc(NZ * tc->ny * tc->nx * sizeof(double));
+  buffer = malloc(*nbytes);
+  if (values == NULL || buffer == NULL) {
+    TESTRPT("out of memory", 0);
+    free(values);
+    free(buffer);
+    return NULL;
+  }
+  for (z = 0, i = 0; z < NZ; z++)
+    for (y = 0; y < tc->ny; y++)
+      for (x = 0; x < tc->nx; x++, i++)
+        values[i] = voxel_value(z, y, x) / 40.0;
+
+  cdfid = create_image(filename, tc->ny, tc->nx, FALSE, &img);
+  if (cdfid == MI_ERROR) {
+    TESTRPT("creating the image failed", 0);
+    free(values);
+    free(buffer);
+    return NULL;
+  }
+  icv = create_icv(tc);
+  miicv_setint(icv, MI_ICV_TYPE, NC_DOUBLE);
+  if (miicv_attach(icv, cdfid, img) == MI_ERROR ||
+      miicv_put(icv, start, count, values) == MI_ERROR ||
+      ncvarget(cdfid, img, start, count, buffer) == MI_ERROR) {
+    TESTRPT("writing through the icv failed", 0);
+    free(buffer);
+    buffer = NULL;
+  }
+  miicv_free(icv);
+  miclose(cdfid);
+  free(values);
+  return buffer;
+}
+
+int main(int argc, char **argv)
+{
+  const char *dir = ".";
+  char filename[1024];
+  char rawname[1024];
+  char *buffer;
+  char *reference;
+  size_t nbytes;
+  size_t i;
+  int saving, writing;
+  int cdfid, img;
+  FILE *fp;
+
+  if (argc < 2 || (strcmp(argv[1], "save") && strcmp(argv[1], "check"))) {
+    fprintf(stderr, "Usage: %s save|check [directory]\n", argv[0]);
+    return 1;
+  }
+  saving = !strcmp(argv[1], "save");
+  if (argc > 2)
+    dir = argv[2];
+
+  ncopts = 0;
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const struct test_case *tc = &cases[i];
+
+    for (writing = FALSE; writing <= TRUE; writing++) {
+      /* only images that are not resized can be written */
+      if (writing && (tc->ny != tc->bsize || tc->nx != tc->asize))
+        continue;
+
+      snprintf(filename, sizeof(filename), "%s/icv_dimconv-%d%s.mnc",
+               dir, (int)i, writing ? "-put" : "");
+      snprintf(rawname, sizeof(rawname), "%s/icv_dimconv-%d%s.raw",
+               dir, (int)i, writing ? "-put" : "");
+
+      if (writing) {
+        buffer = write_case(filename, tc, &nbytes);
+      }
+      else {
+        if (saving) {
+          cdfid = create_image(filename, tc->ny, tc->nx, TRUE, &img);
+          if (cdfid == MI_ERROR) {
+            TESTRPT("creating the image failed", (int)i);
+            continue;
+          }
+          miclose(cdfid);
+        }
+        buffer = read_case(filename, tc, &nbytes);
+      }
+      if (buffer == NULL)
+        continue;
+
+      if (saving) {
+        if ((fp = fopen(rawname, "wb")) == NULL ||
+            fwrite(buffer, 1, nbytes, fp) != nbytes) {
+          TESTRPT("can't save the reference data", (int)i);
+        }
+        if (fp != NULL)
+          fclose(fp);
+        free(buffer);
+        continue;
+      }
+
+      reference = malloc(nbytes);
+      if (reference == NULL) {
+        TESTRPT("out of memory", 0);
+        free(buffer);
+        continue;
+      }
+      if ((fp = fopen(rawname, "rb")) == NULL ||
+          fread(reference, 1, nbytes, fp) != nbytes) {
+        TESTRPT("can't load the reference data", (int)i);
+      }
+      else if (memcmp(buffer, reference, nbytes) != 0) {
+        TESTRPT(writing ? "icv write differs from the general loop" :
+                "icv read differs from the general loop", (int)i);
+      }
+      if (fp != NULL)
+        fclose(fp);
+      free(reference);
+      free(buffer);
+    }
+  }
+
+  if (error_cnt != 0) {
+    fprintf(stderr, "%d error%s reported\n",
+            error_cnt, (error_cnt == 1) ? "" : "s");
+  }
+  else {
+    fprintf(stderr, "No errors\n");
+  }
+  return (error_cnt);
+}
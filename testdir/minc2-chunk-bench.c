@@ -0,0 +1,271 @@
+/* Compare chunk layouts chosen for different access patterns.
+ *
+ * A 4D (time, z, y, x) short volume is written once per access pattern
+ * (default, slice, cube, time series), compressed with zlib. Each file is
+ * then read slice by slice, as random small cubes and as random voxel
+ * time courses, and the time of each read is reported. All reads are
+ * checked against the values written. The last file is read once more
+ * with a small chunk cache set through miopen_volume_with_props().
+ *
+ * Usage: minc2-chunk-bench [size] [time points] [output file]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "minc2.h"
+
+#define NDIMS 4
+#define CUBE 8
+#define NCUBES 64
+#define NSERIES 256
+
+#define TESTRPT(msg, val) (error_cnt++, fprintf(stderr, \
+                                  "Error reported on line #%d, %s: %d\n", \
+                                  __LINE__, msg, val))
+
+static int error_cnt = 0;
+
+/* Wall clock time in milliseconds, the reads wait for the disk and the
+ * decompression, which the CPU time of the process doesn't show */
+static double wall_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return 1000.0 * ts.tv_sec + ts.tv_nsec / 1e6;
+}
+
+/* Voxel value as a function of its position, so that any read can be
+ * checked without keeping the whole volume around */
+static short voxel(int t, int z, int y, int x)
+{
+  return (short)((t * 7 + z * 5 + y * 3 + x) % 4000);
+}
+
+static int write_volume(const char *filename, miaccess_pattern_t pattern,
+                        int n, int nt)
+{
+  char *dimnames[] = {"time", "zspace", "yspace", "xspace"};
+  midimclass_t classes[] = {MI_DIMCLASS_TIME, MI_DIMCLASS_SPATIAL,
+                            MI_DIMCLASS_SPATIAL, MI_DIMCLASS_SPATIAL};
+  midimhandle_t hdims[NDIMS];
+  mihandle_t vol;
+  mivolumeprops_t props;
+  misize_t start[NDIMS] = {0, 0, 0, 0};
+  misize_t count[NDIMS];
+  short *buffer;
+  int i, t, z, y, x;
+  int r;
+
+  buffer = malloc((size_t)n * n * n * sizeof(short));
+  if (buffer == NULL) {
+    TESTRPT("out of memory", 0);
+    return -1;
+  }
+  for (i = 0; i < NDIMS; i++) {
+    micreate_dimension(dimnames[i], classes[i], MI_DIMATTR_REGULARLY_SAMPLED,
+                       i == 0 ? nt : n, &hdims[i]);
+  }
+  minew_volume_props(&props);
+  miset_props_compression_type(props, MI_COMPRESS_ZLIB);
+  miset_props_access_pattern(props, pattern);
+
+  r = micreate_volume(filename, NDIMS, hdims, MI_TYPE_SHORT, MI_CLASS_REAL,
+                      props, &vol);
+  mifree_volume_props(props);
+  if (r < 0) {
+    TESTRPT("micreate_volume failed", r);
+    free(buffer);
+    return -1;
+  }
+  micreate_volume_image(vol);
+  miset_volume_valid_range(vol, 4000, 0);
+
+  count[0] = 1;
+  count[1] = count[2] = count[3] = n;
+  for (t = 0; t < nt; t++) {
+    for (z = 0, i = 0; z < n; z++)
+      for (y = 0; y < n; y++)
+        for (x = 0; x < n; x++, i++)
+          buffer[i] = voxel(t, z, y, x);
+    start[0] = t;
+    r = miset_voxel_value_hyperslab(vol, MI_TYPE_SHORT, start, count, buffer);
+    if (r < 0) {
+      TESTRPT("miset_voxel_value_hyperslab failed", r);
+      break;
+    }
+  }
+  miclose_volume(vol);
+  free(buffer);
+  return 0;
+}
+
+static double read_slices(mihandle_t vol, int n, int nt, short *buffer)
+{
+  misize_t start[NDIMS] = {0, 0, 0, 0};
+  misize_t count[NDIMS] = {1, 1, 0, 0};
+  double t0 = wall_ms();
+  int t, z, i;
+
+  count[2] = count[3] = n;
+  for (t = 0; t < nt; t++) {
+    for (z = 0; z < n; z++) {
+      start[0] = t;
+      start[1] = z;
+      if (miget_voxel_value_hyperslab(vol, MI_TYPE_SHORT, start, count, buffer) < 0) {
+        TESTRPT("slice read failed", z);
+        return 0.0;
+      }
+      for (i = 0; i < n * n; i++) {
+        if (buffer[i] != voxel(t, z, i / n, i % n)) {
+          TESTRPT("slice data mismatch", i);
+          return 0.0;
+        }
+      }
+    }
+  }
+  return wall_ms() - t0;
+}
+
+static double read_cubes(mihandle_t vol, int n, int nt, short *buffer)
+{
+  misize_t start[NDIMS];
+  misize_t count[NDIMS] = {1, CUBE, CUBE, CUBE};
+  double t0 = wall_ms();
+  int c, i;
+
+  srand(1);
+  for (c = 0; c < NCUBES; c++) {
+    start[0] = rand() % nt;
+    for (i = 1; i < NDIMS; i++)
+      start[i] = rand() % (n - CUBE + 1);
+    if (miget_voxel_value_hyperslab(vol, MI_TYPE_SHORT, start, count, buffer) < 0) {
+      TESTRPT("cube read failed", c);
+      return 0.0;
+    }
+    if (buffer[CUBE * CUBE * CUBE - 1] !=
+        voxel((int)start[0], (int)start[1] + CUBE - 1,
+              (int)start[2] + CUBE - 1, (int)start[3] + CUBE - 1)) {
+      TESTRPT("cube data mismatch", c);
+      return 0.0;
+    }
+  }
+  return wall_ms() - t0;
+}
+
+static double read_series(mihandle_t vol, int n, int nt, short *buffer)
+{
+  misize_t start[NDIMS] = {0, 0, 0, 0};
+  misize_t count[NDIMS] = {0, 1, 1, 1};
+  double t0 = wall_ms();
+  int s, t;
+
+  count[0] = nt;
+  srand(2);
+  for (s = 0; s < NSERIES; s++) {
+    start[1] = rand() % n;
+    start[2] = rand() % n;
+    start[3] = rand() % n;
+    if (miget_voxel_value_hyperslab(vol, MI_TYPE_SHORT, start, count, buffer) < 0) {
+      TESTRPT("time series read failed", s);
+      return 0.0;
+    }
+    for (t = 0; t < nt; t++) {
+      if (buffer[t] != voxel(t, (int)start[1], (int)start[2], (int)start[3])) {
+        TESTRPT("time series data mismatch", t);
+        return 0.0;
+      }
+    }
+  }
+  return wall_ms() - t0;
+}
+
+int main(int argc, char **argv)
+{
+  static const miaccess_pattern_t patterns[] = {
+    MI_ACCESS_DEFAULT, MI_ACCESS_SLICE, MI_ACCESS_CUBE, MI_ACCESS_TIMESERIES
+  };
+  static const char *pattern_names[] = { "default", "slice", "cube", "series" };
+  const char *filename = "minc2-chunk-bench.mnc";
+  int n = 64;
+  int nt = 20;
+  short *buffer;
+  double hit_rate = 0.0;
+  int i;
+
+  if (argc > 1)
+    n = atoi(argv[1]);
+  if (argc > 2)
+    nt = atoi(argv[2]);
+  if (argc > 3)
+    filename = argv[3];
+  if (n < CUBE)
+    n = CUBE;
+  if (nt < 1)
+    nt = 1;
+
+  buffer = malloc((size_t)n * n * sizeof(short) + (size_t)nt * sizeof(short) +
+                  CUBE * CUBE * CUBE * sizeof(short));
+  if (buffer == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 1;
+  }
+
+  printf("%-8s %12s %12s %12s %8s\n", "layout", "slices(ms)", "cubes(ms)",
+         "series(ms)", "md hits");
+  for (i = 0; i < (int)(sizeof(patterns) / sizeof(patterns[0])); i++) {
+    mihandle_t vol;
+    double ts, tc, tt;
+
+    if (write_volume(filename, patterns[i], n, nt) < 0)
+      continue;
+    if (miopen_volume(filename, MI2_OPEN_READ, &vol) < 0) {
+      TESTRPT("miopen_volume failed", i);
+      continue;
+    }
+    ts = read_slices(vol, n, nt, buffer);
+    tc = read_cubes(vol, n, nt, buffer);
+    tt = read_series(vol, n, nt, buffer);
+    miget_volume_metadata_cache_hit_rate(vol, &hit_rate, TRUE);
+    miclose_volume(vol);
+    printf("%-8s %12.1f %12.1f %12.1f %8.3f\n", pattern_names[i], ts, tc, tt,
+           hit_rate);
+  }
+
+  /* Reopen the last file with a small explicit chunk cache */
+  {
+    mivolumeprops_t props;
+    mihandle_t vol;
+    size_t nbytes, nslots;
+    double w0;
+
+    minew_volume_props(&props);
+    miset_props_chunk_cache(props, 1 << 20, 521, 0.75);
+    if (miopen_volume_with_props(filename, MI2_OPEN_READ, props, &vol) < 0) {
+      TESTRPT("miopen_volume_with_props failed", 0);
+    }
+    else {
+      if (miget_volume_chunk_cache(vol, &nbytes, &nslots, &w0) < 0 ||
+          nbytes != (1 << 20) || nslots != 521 || w0 != 0.75) {
+        TESTRPT("chunk cache settings not applied", (int)nbytes);
+      }
+      printf("%-8s %12.1f\n", "1MB", read_slices(vol, n, nt, buffer));
+      miclose_volume(vol);
+    }
+    mifree_volume_props(props);
+  }
+  free(buffer);
+  remove(filename);
+
+  if (error_cnt != 0) {
+    fprintf(stderr, "%d error%s reported\n",
+            error_cnt, (error_cnt == 1) ? "" : "s");
+  }
+  else {
+    fprintf(stderr, "No errors\n");
+  }
+  return (error_cnt);
+}
+
+/* kate: indent-mode cstyle; indent-width 2; replace-tabs on; */
@@ -0,0 +1,214 @@
+/* Compare the compression codecs available to MINC2 volumes.
+ *
+ * For a structural-like short image, a label image and a float image,
+ * each codec is used to write and read back the same volume, and the
+ * write time, read time and compression ratio are reported. Codecs whose
+ * HDF5 plugin is not installed fall back to zlib, which is shown in the
+ * "actual" column. Each codec is also run with the byte shuffle (s) and
+ * integer scale-offset (o) prefilters.
+ *
+ * Usage: minc2-compression-bench [size] [output file]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "minc2.h"
+
+#define NDIMS 3
+
+#define PREFILTER_SHUFFLE     1
+#define PREFILTER_SCALEOFFSET 2
+
+#define TESTRPT(msg, val) (error_cnt++, fprintf(stderr, \
+                                  "Error reported on line #%d, %s: %d\n", \
+                                  __LINE__, msg, val))
+
+static int error_cnt = 0;
+
+/* Wall clock time in milliseconds, it includes the file I/O and the
+ * filter plugins that CPU time of the process would undercount */
+static double wall_ms(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return 1000.0 * ts.tv_sec + ts.tv_nsec / 1e6;
+}
+
+static const char *codec_name(micompression_t c)
+{
+  switch (c) {
+    case MI_COMPRESS_NONE:  return "none";
+    case MI_COMPRESS_ZLIB:  return "zlib";
+    case MI_COMPRESS_ZSTD:  return "zstd";
+    case MI_COMPRESS_LZ4:   return "lz4";
+    case MI_COMPRESS_BLOSC: return "blosc";
+  }
+  return "?";
+}
+
+/* Fill a buffer with a smooth pattern plus a little noise, similar to
+ * what an anatomical scan, a label map or a float image would contain */
+static void fill_image(mitype_t type, int n, void *buffer)
+{
+  int i, j, k;
+  size_t idx = 0;
+  srand(12345);
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < n; j++) {
+      for (k = 0; k < n; k++, idx++) {
+        double r = sqrt((double)(i - n/2)*(i - n/2) + (j - n/2)*(j - n/2) + (k - n/2)*(k - n/2));
+        double v = 1000.0 * exp(-r / n) + (rand() % 16);
+        switch (type) {
+          case MI_TYPE_SHORT:
+            ((short *)buffer)[idx] = (short)v;
+            break;
+          case MI_TYPE_UBYTE:
+            ((unsigned char *)buffer)[idx] = (unsigned char)(r < n / 4 ? 1 : r < n / 3 ? 2 : 0);
+            break;
+          default:
+            ((float *)buffer)[idx] = (float)(v / 1000.0);
+            break;
+        }
+      }
+    }
+  }
+}
+
+static int run_one(const char *filename, mitype_t type, const char *label,
+                   micompression_t codec, int prefilter, int n)
+{
+  midimhandle_t hdims[NDIMS];
+  mihandle_t vol;
+  mivolumeprops_t props;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS];
+  micompression_t actual = MI_COMPRESS_NONE;
+  size_t voxel_size = (type == MI_TYPE_SHORT ? 2 : type == MI_TYPE_UBYTE ? 1 : 4);
+  size_t nbytes = (size_t)n * n * n * voxel_size;
+  void *out_buf = malloc(nbytes);
+  void *in_buf = malloc(nbytes);
+  char *dimnames[] = {"zspace", "yspace", "xspace"};
+  double t0, t1, t2;
+  struct stat st;
+  int i;
+  int r;
+
+  if (out_buf == NULL || in_buf == NULL) {
+    TESTRPT("out of memory", 0);
+    free(out_buf);
+    free(in_buf);
+    return -1;
+  }
+  fill_image(type, n, out_buf);
+
+  for (i = 0; i < NDIMS; i++) {
+    count[i] = n;
+    micreate_dimension(dimnames[i], MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, n, &hdims[i]);
+  }
+  minew_volume_props(&props);
+  miset_props_compression_type(props, codec);
+  miset_props_shuffle(props, (prefilter & PREFILTER_SHUFFLE) != 0);
+  miset_props_scaleoffset(props, (prefilter & PREFILTER_SCALEOFFSET) != 0);
+
+  t0 = wall_ms();
+  r = micreate_volume(filename, NDIMS, hdims, type, MI_CLASS_REAL, props, &vol);
+  if (r < 0) {
+    /* The volume owns the dimensions only once it was created */
+    TESTRPT("micreate_volume failed", r);
+    for (i = 0; i < NDIMS; i++) {
+      mifree_dimension_handle(hdims[i]);
+    }
+  }
+  else {
+    micreate_volume_image(vol);
+    miset_volume_valid_range(vol, type == MI_TYPE_UBYTE ? 255 : 32767, 0);
+    r = miset_voxel_value_hyperslab(vol, type, start, count, out_buf);
+    if (r < 0) {
+      TESTRPT("miset_voxel_value_hyperslab failed", r);
+    }
+    miclose_volume(vol);
+  }
+  t1 = wall_ms();
+
+  r = miopen_volume(filename, MI2_OPEN_READ, &vol);
+  if (r < 0) {
+    TESTRPT("miopen_volume failed", r);
+  }
+  else {
+    mivolumeprops_t file_props;
+    r = miget_voxel_value_hyperslab(vol, type, start, count, in_buf);
+    if (r < 0 || memcmp(in_buf, out_buf, nbytes) != 0) {
+      TESTRPT("data read back does not match", r);
+    }
+    if (miget_volume_props(vol, &file_props) == MI_NOERROR) {
+      miget_props_compression_type(file_props, &actual);
+      mifree_volume_props(file_props);
+    }
+    miclose_volume(vol);
+  }
+  t2 = wall_ms();
+
+  if (stat(filename, &st) != 0)
+    st.st_size = 0;
+
+  printf("%-6s %-6s %-6s %-4s %10.1f %10.1f %8.2f\n", label,
+         codec_name(codec), codec_name(actual),
+         (prefilter == PREFILTER_SHUFFLE ? "s" :
+          prefilter == PREFILTER_SCALEOFFSET ? "o" :
+          prefilter ? "o+s" : "-"),
+         t1 - t0,
+         t2 - t1,
+         st.st_size > 0 ? (double)nbytes / st.st_size : 0.0);
+
+  mifree_volume_props(props);
+  free(out_buf);
+  free(in_buf);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  static const micompression_t codecs[] = {
+    MI_COMPRESS_NONE, MI_COMPRESS_ZLIB, MI_COMPRESS_ZSTD,
+    MI_COMPRESS_LZ4, MI_COMPRESS_BLOSC
+  };
+  static const mitype_t types[] = { MI_TYPE_SHORT, MI_TYPE_UBYTE, MI_TYPE_FLOAT };
+  static const char *type_names[] = { "t1", "label", "float" };
+  const char *filename = "minc2-compression-bench.mnc";
+  int n = 64;
+  int i, j, k;
+
+  if (argc > 1)
+    n = atoi(argv[1]);
+  if (argc > 2)
+    filename = argv[2];
+  if (n < 2)
+    n = 2;
+
+  printf("%-6s %-6s %-6s %-4s %10s %10s %8s\n",
+         "image", "codec", "actual", "pre", "write(ms)", "read(ms)", "ratio");
+  for (i = 0; i < (int)(sizeof(types) / sizeof(types[0])); i++) {
+    for (j = 0; j < (int)(sizeof(codecs) / sizeof(codecs[0])); j++) {
+      for (k = 0; k < 4; k++) {
+        run_one(filename, types[i], type_names[i], codecs[j], k, n);
+      }
+    }
+  }
+  remove(filename);
+
+  if (error_cnt != 0) {
+    fprintf(stderr, "%d error%s reported\n",
+            error_cnt, (error_cnt == 1) ? "" : "s");
+  }
+  else {
+    fprintf(stderr, "No errors\n");
+  }
+  return (error_cnt);
+}
+
+/* kate: indent-mode cstyle; indent-width 2; replace-tabs on; */
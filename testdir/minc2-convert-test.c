@@ -41,6 +41,8 @@ main(void)
     double v1, v2;
     double r1, r2, r3;
     double cosines[3];
+    misize_t *points;
+    double *values, *voxels;
 
     result = micreate_dimension("xspace", MI_DIMCLASS_SPATIAL, 
                                 MI_DIMATTR_REGULARLY_SAMPLED, CX, &hdims[0]);
@@ -184,6 +186,47 @@ main(void)
         }
     }
 
+    /* Read a scattered set of points at once, in no particular order,
+     * and compare with reading them one by one.
+     */
+    n = CX * CY;
+    points = malloc(n * NDIMS * sizeof(misize_t));
+    values = malloc(n * sizeof(double));
+    voxels = malloc(n * sizeof(double));
+    for (i = 0; i < n; i++) {
+        points[i * NDIMS + 0] = (i * 7) % CX;
+        points[i * NDIMS + 1] = (i * 13) % CY;
+        points[i * NDIMS + 2] = (i * 29) % CZ;
+    }
+
+    result = miget_real_values_at(hvol, n, NDIMS, points, values);
+    if (result < 0) {
+        TESTRPT("miget_real_values_at error", result);
+    }
+    result = miget_voxel_values_at(hvol, n, NDIMS, points, voxels);
+    if (result < 0) {
+        TESTRPT("miget_voxel_values_at error", result);
+    }
+
+    for (i = 0; i < n; i++) {
+        miget_real_value(hvol, points + i * NDIMS, NDIMS, &r1);
+        miget_voxel_value(hvol, points + i * NDIMS, NDIMS, &v1);
+        if (!NEARLY_EQUAL(r1, values[i]) || !NEARLY_EQUAL(v1, voxels[i])) {
+            fprintf(stderr, "r1 %f values %f v1 %f voxels %f\n", 
+                    r1, values[i], v1, voxels[i]);
+            TESTRPT("Batch value mismatch", i);
+        }
+    }
+
+    points[0] = CX;
+    result = miget_real_values_at(hvol, n, NDIMS, points, values);
+    if (result != MI_ERROR) {
+        TESTRPT("miget_real_values_at outside of the volume", result);
+    }
+    free(points);
+    free(values);
+    free(voxels);
+
     world[MI2_X] = -80;
     world[MI2_Y] = 150;
     world[MI2_Z] = 120;
@@ -0,0 +1,304 @@
+/* Check that whole-volume reads give the same data with and without
+ * direct chunk reads.
+ *
+ * Run with MINC_DIRECT_CHUNK_READ=0, "write" creates the test volumes
+ * and saves what the regular HDF5 read path returns for each of them.
+ * Run with direct reads on, "read" reads the same volumes again and
+ * compares the buffers byte for byte.
+ *
+ * The dimensions are not multiples of the chunk size, so the edge chunks
+ * are only partly used. The volumes are compressed with zlib, with and
+ * without the byte shuffle; one chunk is stored with zlib skipped in its
+ * filter mask, and one volume is only partly written, so that direct
+ * reads have to give up after the first chunks.
+ *
+ * Usage: minc2-direct-chunk-test write|read [directory]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "minc2.h"
+
+#define NDIMS 3
+#define NZ 19
+#define NY 17
+#define NX 13
+#define CHUNK 8
+
+#define TESTRPT(msg, val) (error_cnt++, fprintf(stderr, \
+                                  "Error reported on line #%d, %s: %d\n", \
+                                  __LINE__, msg, val))
+
+static int error_cnt = 0;
+
+struct test_case {
+  const char *name;
+  mitype_t type;
+  int shuffle;
+  int raw_chunk;   /* store the first chunk with zlib skipped */
+  misize_t nz;     /* slices written, the rest is left to the fill value */
+};
+
+static const struct test_case cases[] = {
+  {"zlib",    MI_TYPE_SHORT, 0, 1, NZ},
+  {"shuffle", MI_TYPE_SHORT, 1, 0, NZ},
+  {"float",   MI_TYPE_FLOAT, 1, 0, NZ},
+  {"sparse",  MI_TYPE_SHORT, 1, 0, CHUNK}
+};
+
+static size_t type_size(mitype_t type)
+{
+  return type == MI_TYPE_FLOAT ? sizeof(float) : sizeof(short);
+}
+
+/* Voxel value as a function of its position */
+static void set_voxel(void *buffer, mitype_t type, size_t i,
+                      int z, int y, int x)
+{
+  if (type == MI_TYPE_FLOAT)
+    ((float *)buffer)[i] = z * 100.0f + y * 10.0f + x + 0.25f;
+  else
+    ((short *)buffer)[i] = (short)(z * 1000 + y * 50 + x - 9000);
+}
+
+#if H5_VERSION_GE(1,10,2)
+/* Overwrite the first chunk of a volume without a shuffle with the
+ * same values, stored uncompressed: the filter mask tells readers to
+ * skip zlib for it */
+static int write_raw_chunk(const char *filename, mitype_t type)
+{
+  hid_t file_id, dset_id, mtype_id;
+  hsize_t offset[NDIMS] = {0, 0, 0};
+  size_t nbytes = CHUNK * CHUNK * CHUNK * type_size(type);
+  void *chunk;
+  int z, y, x;
+  size_t i;
+  int r = -1;
+
+  chunk = calloc(CHUNK * CHUNK * CHUNK, type_size(type));
+  if (chunk == NULL)
+    return -1;
+  for (z = 0, i = 0; z < CHUNK; z++)
+    for (y = 0; y < CHUNK; y++)
+      for (x = 0; x < CHUNK; x++, i++)
+        set_voxel(chunk, type, i, z, y, x);
+
+  mtype_id = (type == MI_TYPE_FLOAT) ? H5T_NATIVE_FLOAT : H5T_NATIVE_SHORT;
+  file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+  if (file_id >= 0) {
+    dset_id = H5Dopen2(file_id, "/minc-2.0/image/0/image", H5P_DEFAULT);
+    if (dset_id >= 0) {
+      hid_t ftype_id = H5Dget_type(dset_id);
+
+      /* the stored bytes must be the native ones */
+      if (ftype_id >= 0 && H5Tequal(ftype_id, mtype_id) > 0 &&
+          H5Dwrite_chunk(dset_id, H5P_DEFAULT, 1, offset, nbytes, chunk) >= 0)
+        r = 0;
+      if (ftype_id >= 0)
+        H5Tclose(ftype_id);
+      H5Dclose(dset_id);
+    }
+    if (H5Fclose(file_id) < 0)
+      r = -1;
+  }
+  free(chunk);
+  return r;
+}
+#endif
+
+static int write_volume(const char *filename, const struct test_case *tc)
+{
+  char *dimnames[] = {"zspace", "yspace", "xspace"};
+  misize_t lengths[] = {NZ, NY, NX};
+  int edges[] = {CHUNK, CHUNK, CHUNK};
+  midimhandle_t hdims[NDIMS];
+  mihandle_t vol;
+  mivolumeprops_t props;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {0, NY, NX};
+  void *buffer;
+  int i, z, y, x;
+  size_t n;
+  int r;
+
+  buffer = malloc(NZ * NY * NX * type_size(tc->type));
+  if (buffer == NULL) {
+    TESTRPT("out of memory", 0);
+    return -1;
+  }
+  for (z = 0, n = 0; z < NZ; z++)
+    for (y = 0; y < NY; y++)
+      for (x = 0; x < NX; x++, n++)
+        set_voxel(buffer, tc->type, n, z, y, x);
+
+  for (i = 0; i < NDIMS; i++) {
+    micreate_dimension(dimnames[i], MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, lengths[i], &hdims[i]);
+  }
+  minew_volume_props(&props);
+  miset_props_compression_type(props, MI_COMPRESS_ZLIB);
+  miset_props_blocking(props, NDIMS, edges);
+  miset_props_shuffle(props, tc->shuffle);
+
+  r = micreate_volume(filename, NDIMS, hdims, tc->type, MI_CLASS_REAL,
+                      props, &vol);
+  mifree_volume_props(props);
+  if (r < 0) {
+    TESTRPT("micreate_volume failed", r);
+    free(buffer);
+    return -1;
+  }
+  micreate_volume_image(vol);
+
+  count[0] = tc->nz;
+  r = miset_voxel_value_hyperslab(vol, tc->type, start, count, buffer);
+  if (r < 0) {
+    TESTRPT("miset_voxel_value_hyperslab failed", r);
+  }
+  miclose_volume(vol);
+  free(buffer);
+
+  if (tc->raw_chunk) {
+#if H5_VERSION_GE(1,10,2)
+    if (write_raw_chunk(filename, tc->type) < 0) {
+      TESTRPT("writing a raw chunk failed", 0);
+      return -1;
+    }
+#endif
+  }
+  return r < 0 ? -1 : 0;
+}
+
+/* Read the whole volume at once, the only read that may go direct */
+static void *read_volume(const char *filename, mitype_t type)
+{
+  mihandle_t vol;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {NZ, NY, NX};
+  void *buffer;
+  int r;
+
+  buffer = malloc(NZ * NY * NX * type_size(type));
+  if (buffer == NULL) {
+    TESTRPT("out of memory", 0);
+    return NULL;
+  }
+  r = miopen_volume(filename, MI2_OPEN_READ, &vol);
+  if (r < 0) {
+    TESTRPT("miopen_volume failed", r);
+    free(buffer);
+    return NULL;
+  }
+  r = miget_voxel_value_hyperslab(vol, type, start, count, buffer);
+  miclose_volume(vol);
+  if (r < 0) {
+    TESTRPT("miget_voxel_value_hyperslab failed", r);
+    free(buffer);
+    return NULL;
+  }
+  return buffer;
+}
+
+/* Check the voxels that were written against the values they were
+ * given, the direct reads are then compared with these buffers */
+static void check_values(const void *buffer, const struct test_case *tc)
+{
+  void *expected = malloc(type_size(tc->type));
+  size_t nbytes = type_size(tc->type);
+  int z, y, x;
+  size_t n;
+
+  if (expected == NULL) {
+    TESTRPT("out of memory", 0);
+    return;
+  }
+  for (z = 0, n = 0; z < (int)tc->nz; z++)
+    for (y = 0; y < NY; y++)
+      for (x = 0; x < NX; x++, n++) {
+        set_voxel(expected, tc->type, 0, z, y, x);
+        if (memcmp((const char *)buffer + n * nbytes, expected, nbytes) != 0) {
+          TESTRPT("voxel value mismatch", (int)n);
+          free(expected);
+          return;
+        }
+      }
+  free(expected);
+}
+
+int main(int argc, char **argv)
+{
+  const char *dir = ".";
+  char filename[1024];
+  char rawname[1024];
+  size_t nbytes;
+  size_t i;
+  int writing;
+
+  if (argc < 2 || (strcmp(argv[1], "write") && strcmp(argv[1], "read"))) {
+    fprintf(stderr, "Usage: %s write|read [directory]\n", argv[0]);
+    return 1;
+  }
+  writing = !strcmp(argv[1], "write");
+  if (argc > 2)
+    dir = argv[2];
+
+  for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    const struct test_case *tc = &cases[i];
+    void *buffer;
+    void *reference;
+    FILE *fp;
+
+    snprintf(filename, sizeof(filename), "%s/direct-chunk-%s.mnc", dir, tc->name);
+    snprintf(rawname, sizeof(rawname), "%s/direct-chunk-%s.raw", dir, tc->name);
+    nbytes = NZ * NY * NX * type_size(tc->type);
+
+    if (writing) {
+      if (write_volume(filename, tc) < 0)
+        continue;
+      if ((buffer = read_volume(filename, tc->type)) == NULL)
+        continue;
+      check_values(buffer, tc);
+      if ((fp = fopen(rawname, "wb")) == NULL ||
+          fwrite(buffer, 1, nbytes, fp) != nbytes) {
+        TESTRPT("can't save the reference data", (int)i);
+      }
+      if (fp != NULL)
+        fclose(fp);
+      free(buffer);
+      continue;
+    }
+
+    reference = malloc(nbytes);
+    if (reference == NULL) {
+      TESTRPT("out of memory", 0);
+      continue;
+    }
+    if ((fp = fopen(rawname, "rb")) == NULL ||
+        fread(reference, 1, nbytes, fp) != nbytes) {
+      TESTRPT("can't load the reference data", (int)i);
+      if (fp != NULL)
+        fclose(fp);
+      free(reference);
+      continue;
+    }
+    fclose(fp);
+
+    if ((buffer = read_volume(filename, tc->type)) != NULL) {
+      if (memcmp(buffer, reference, nbytes) != 0) {
+        TESTRPT("direct read differs from the regular read", (int)i);
+        fprintf(stderr, "  volume: %s\n", tc->name);
+      }
+      free(buffer);
+    }
+    free(reference);
+  }
+
+  if (error_cnt != 0) {
+    fprintf(stderr, "%d error%s reported\n",
+            error_cnt, (error_cnt == 1) ? "" : "s");
+  }
+  else {
+    fprintf(stderr, "No errors\n");
+  }
+  return (error_cnt);
+}
@@ -10,6 +10,39 @@ __LINE__, msg, val))
 
 static int error_cnt = 0;
 
+/* MINC writes scalar strings only, add an array of fixed-length
+ * strings to a group of the file with HDF5 itself */
+static int add_string_array(const char *filename, const char *group)
+{
+  static const char names[4][8] = {"alpha", "beta", "gamma", "delta"};
+  hsize_t dims[1] = {4};
+  hid_t file_id, grp_id, type_id, spc_id, attr_id;
+  int r = -1;
+
+  file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+  if (file_id < 0)
+    return -1;
+  grp_id = H5Gopen2(file_id, group, H5P_DEFAULT);
+  if (grp_id >= 0) {
+    type_id = H5Tcopy(H5T_C_S1);
+    H5Tset_size(type_id, sizeof(names[0]));
+    spc_id = H5Screate_simple(1, dims, NULL);
+    attr_id = H5Acreate2(grp_id, "names", type_id, spc_id, H5P_DEFAULT,
+                         H5P_DEFAULT);
+    if (attr_id >= 0) {
+      if (H5Awrite(attr_id, type_id, names) >= 0)
+        r = 0;
+      H5Aclose(attr_id);
+    }
+    H5Sclose(spc_id);
+    H5Tclose(type_id);
+    H5Gclose(grp_id);
+  }
+  if (H5Fclose(file_id) < 0)
+    r = -1;
+  return r;
+}
+
 int main(void)
 {
   mihandle_t hvol;
@@ -31,6 +64,10 @@ int main(void)
   char namebuf[256]="";
   char pathbuf1[1024]="";
   int count=0;
+  mimetadata_t meta;
+  const void *values;
+  char *json;
+  float gain = 0;
   
   r = micreate_volume("tst-grpa.mnc", 0, NULL, MI_TYPE_UINT,
                       MI_CLASS_REAL, NULL, &hvol);
@@ -310,6 +347,70 @@ int main(void)
     TESTRPT("milist_finish failed", r);  
   }
 
+  r = miget_attr_values(hvol1, MI_TYPE_FLOAT, "/OPT", "gain", 1, &gain);
+  if (r < 0 || gain != val1) {
+    TESTRPT("micopy_attr lost an attribute", r);
+  }
+
+  printf("read all metadata at once\n");
+  r = miget_metadata(hvol, &meta);
+  if (r < 0) {
+    TESTRPT("miget_metadata failed", r);
+  } else {
+    r = miget_metadata_attr(meta, "/test2", "maxvals", &data_type, &length,
+                            &values);
+    if (r < 0 || data_type != MI_TYPE_DOUBLE || length != TESTARRAYSIZE) {
+      TESTRPT("miget_metadata_attr failed", r);
+    } else {
+      for (r = 0; r < TESTARRAYSIZE; r++) {
+        if (((const double *)values)[r] != tstarr[r]) {
+          TESTRPT("snapshot value differs", r);
+        }
+      }
+    }
+    r = miget_metadata_attr(meta, "/test1/stuff", "objtype", &data_type,
+                            &length, &values);
+    if (r < 0 || data_type != MI_TYPE_STRING ||
+        strcmp((const char *)values, "bicycle") != 0) {
+      TESTRPT("miget_metadata_attr string failed", r);
+    }
+    if (miget_metadata_attr(meta, "/test1/stuff", "nothing", NULL, NULL,
+                            NULL) == MI_NOERROR) {
+      TESTRPT("missing attribute found in snapshot", 0);
+    }
+    if (miget_metadata_group_count(meta, &count) < 0 || count < 10) {
+      TESTRPT("miget_metadata_group_count failed", count);
+    }
+    r = miget_metadata_json(meta, &json);
+    if (r < 0) {
+      TESTRPT("miget_metadata_json failed", r);
+    } else {
+      if (strstr(json, "\"/minc-2.0/info/test1/stuff\": {") == NULL ||
+          strstr(json, "\"objtype\": \"bicycle\"") == NULL ||
+          strstr(json, "\"gain\": 12.5") == NULL) {
+        TESTRPT("unexpected JSON", 0);
+        fputs(json, stderr);
+      }
+      mifree_name(json);
+    }
+    mifree_metadata(meta);
+  }
+
+  printf("read an array of strings\n");
+  if (add_string_array("tst-grpa.mnc", "/minc-2.0/info/test1") < 0) {
+    TESTRPT("writing a string array failed", 0);
+  } else if ((r = miget_metadata(hvol, &meta)) < 0) {
+    TESTRPT("miget_metadata failed", r);
+  } else {
+    r = miget_metadata_attr(meta, "/test1", "names", &data_type,
+                            &length, &values);
+    if (r < 0 || data_type != MI_TYPE_STRING || length != 8 ||
+        strcmp((const char *)values, "alpha") != 0) {
+      TESTRPT("miget_metadata_attr string array failed", r);
+    }
+    mifree_metadata(meta);
+  }
+
   r = miclose_volume(hvol1);
   if(r<0)
   {
@@ -0,0 +1,341 @@
+/* Compare the cost of a metadata scan with and without MI2_OPEN_HEADER.
+ *
+ * A number of small slice-scaled volumes is written into a directory,
+ * then every .mnc file of the directory is opened, its dimension sizes,
+ * steps and one group attribute are read, and it is closed again: once with
+ * MI2_OPEN_READ and once with MI2_OPEN_READ|MI2_OPEN_HEADER. The time of
+ * each scan is reported. A header-only volume is then checked to give the
+ * same data type, valid range, scaling and voxel values as a full open,
+ * and a header-only volume with an unreadable image to fail on every
+ * data access.
+ *
+ * Usage: minc2-header-bench [files] [directory]
+ *
+ * With 0 files nothing is written and an existing directory is scanned.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include "minc2.h"
+
+#define NDIMS 3
+#define SIZE 16
+
+#define TESTRPT(msg, val) (error_cnt++, fprintf(stderr, \
+                                  "Error reported on line #%d, %s: %d\n", \
+                                  __LINE__, msg, val))
+
+static int error_cnt = 0;
+
+static int write_volume(const char *filename, int seed)
+{
+  char *dimnames[] = {"zspace", "yspace", "xspace"};
+  midimhandle_t hdims[NDIMS];
+  mihandle_t vol;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {SIZE, SIZE, SIZE};
+  short buffer[SIZE * SIZE * SIZE];
+  double step[NDIMS] = {1.5, 1.0, 1.0};
+  int i, r;
+
+  for (i = 0; i < NDIMS; i++) {
+    micreate_dimension(dimnames[i], MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, SIZE, &hdims[i]);
+  }
+  miset_dimension_separations(hdims, NDIMS, step);
+
+  r = micreate_volume(filename, NDIMS, hdims, MI_TYPE_SHORT, MI_CLASS_REAL,
+                      NULL, &vol);
+  if (r < 0) {
+    TESTRPT("micreate_volume failed", r);
+    return -1;
+  }
+  miset_slice_scaling_flag(vol, TRUE);
+  micreate_volume_image(vol);
+  miset_volume_valid_range(vol, 1000, 0);
+  miset_attr_values(vol, MI_TYPE_INT, "/bench", "seed", 1, &seed);
+
+  for (i = 0; i < SIZE * SIZE * SIZE; i++) {
+    buffer[i] = (short)((i + seed) % 1000);
+  }
+  miset_voxel_value_hyperslab(vol, MI_TYPE_SHORT, start, count, buffer);
+
+  start[1] = start[2] = 0;
+  for (i = 0; i < SIZE; i++) {
+    start[0] = i;
+    miset_slice_range(vol, start, NDIMS, seed + i + 10.0, -(double)i);
+  }
+  miclose_volume(vol);
+  return 0;
+}
+
+/* Read what an indexer would: dimension sizes, separations and one
+ * attribute */
+static int scan_volume(const char *filename, int mode)
+{
+  mihandle_t vol;
+  midimhandle_t hdims[MI2_MAX_VAR_DIMS];
+  misize_t sizes[MI2_MAX_VAR_DIMS];
+  double steps[MI2_MAX_VAR_DIMS];
+  int ndims;
+  int seed = 0;
+
+  if (miopen_volume(filename, mode, &vol) < 0) {
+    TESTRPT("miopen_volume failed", mode);
+    return -1;
+  }
+  if (miget_volume_dimension_count(vol, MI_DIMCLASS_ANY, MI_DIMATTR_ALL,
+                                   &ndims) < 0 ||
+      miget_volume_dimensions(vol, MI_DIMCLASS_ANY, MI_DIMATTR_ALL,
+                              MI_DIMORDER_FILE, ndims, hdims) < 0 ||
+      miget_dimension_sizes(hdims, ndims, sizes) < 0 ||
+      miget_dimension_separations(hdims, MI_ORDER_FILE, ndims, steps) < 0) {
+    TESTRPT("dimension query failed", mode);
+  }
+  miget_attr_values(vol, MI_TYPE_INT, "/bench", "seed", 1, &seed);
+  miclose_volume(vol);
+  return seed;
+}
+
+static double scan_directory(const char *dirname, int mode, int *n_files)
+{
+  char path[1024];
+  struct dirent *entry;
+  DIR *dir;
+  size_t len;
+  clock_t t0 = clock();
+
+  *n_files = 0;
+  if ((dir = opendir(dirname)) == NULL) {
+    TESTRPT("can't open directory", 0);
+    return 0.0;
+  }
+  while ((entry = readdir(dir)) != NULL) {
+    len = strlen(entry->d_name);
+    if (len < 4 || strcmp(entry->d_name + len - 4, ".mnc") != 0) {
+      continue;
+    }
+    snprintf(path, sizeof(path), "%s/%s", dirname, entry->d_name);
+    scan_volume(path, mode);
+    (*n_files)++;
+  }
+  closedir(dir);
+  return 1000.0 * (clock() - t0) / CLOCKS_PER_SEC;
+}
+
+/* A header-only volume must behave like a fully opened one */
+static void check_header_volume(const char *filename)
+{
+  mihandle_t full, header;
+  mitype_t type_full, type_header;
+  double vmax_full, vmin_full, vmax_header, vmin_header;
+  double min_full, max_full, min_header, max_header;
+  double value_full, value_header;
+  misize_t coords[NDIMS] = {3, 5, 7};
+  miboolean_t scaling;
+
+  if (miopen_volume(filename, MI2_OPEN_READ, &full) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+    return;
+  }
+  if (miopen_volume(filename, MI2_OPEN_READ | MI2_OPEN_HEADER, &header) < 0) {
+    TESTRPT("miopen_volume with MI2_OPEN_HEADER failed", 0);
+    miclose_volume(full);
+    return;
+  }
+
+  /* Data access before any other query opens the image datasets */
+  miget_real_value(full, coords, NDIMS, &value_full);
+  if (miget_real_value(header, coords, NDIMS, &value_header) < 0 ||
+      value_full != value_header) {
+    TESTRPT("real value differs", (int)value_header);
+  }
+
+  miget_data_type(full, &type_full);
+  miget_data_type(header, &type_header);
+  if (type_full != type_header) {
+    TESTRPT("data type differs", type_header);
+  }
+  miget_volume_valid_range(full, &vmax_full, &vmin_full);
+  miget_volume_valid_range(header, &vmax_header, &vmin_header);
+  if (vmax_full != vmax_header || vmin_full != vmin_header) {
+    TESTRPT("valid range differs", (int)vmax_header);
+  }
+  if (miget_slice_scaling_flag(header, &scaling) < 0 || !scaling) {
+    TESTRPT("slice scaling lost", scaling);
+  }
+  miget_slice_range(full, coords, NDIMS, &max_full, &min_full);
+  miget_slice_range(header, coords, NDIMS, &max_header, &min_header);
+  if (max_full != max_header || min_full != min_header) {
+    TESTRPT("slice range differs", (int)max_header);
+  }
+  miclose_volume(header);
+
+  /* A header-only volume which is never read closes cleanly */
+  if (miopen_volume(filename, MI2_OPEN_READ | MI2_OPEN_HEADER, &header) < 0 ||
+      miclose_volume(header) < 0) {
+    TESTRPT("unused header-only volume failed", 0);
+  }
+  if (miopen_volume(filename, MI2_OPEN_RDWR | MI2_OPEN_HEADER, &header) >= 0) {
+    TESTRPT("MI2_OPEN_HEADER accepted for writing", 0);
+    miclose_volume(header);
+  }
+  miclose_volume(full);
+}
+
+/* Copy an attribute of the image dataset to its replacement */
+static herr_t copy_attribute(hid_t loc_id, const char *name,
+                             const H5A_info_t *info, void *op_data)
+{
+  hid_t dst_id = *(hid_t *)op_data;
+  hid_t attr_id = H5Aopen(loc_id, name, H5P_DEFAULT);
+  hid_t type_id = H5Aget_type(attr_id);
+  hid_t space_id = H5Aget_space(attr_id);
+  void *buffer = calloc(1, H5Aget_storage_size(attr_id) + 1);
+  hid_t copy_id;
+
+  (void)info;
+  H5Aread(attr_id, type_id, buffer);
+  copy_id = H5Acreate2(dst_id, name, type_id, space_id, H5P_DEFAULT,
+                       H5P_DEFAULT);
+  H5Awrite(copy_id, type_id, buffer);
+  H5Aclose(copy_id);
+  free(buffer);
+  H5Sclose(space_id);
+  H5Tclose(type_id);
+  H5Aclose(attr_id);
+  return 0;
+}
+
+/* Replace the image dataset by one of a type MINC can't read, keeping its
+ * shape and attributes so that the header still opens */
+static int break_image(const char *filename)
+{
+  hid_t file_id, dset_id, space_id, copy_id;
+  int r = -1;
+
+  file_id = H5Fopen(filename, H5F_ACC_RDWR, H5P_DEFAULT);
+  if (file_id < 0) {
+    return -1;
+  }
+  dset_id = H5Dopen2(file_id, "/minc-2.0/image/0/image", H5P_DEFAULT);
+  if (dset_id >= 0) {
+    space_id = H5Dget_space(dset_id);
+    copy_id = H5Dcreate2(file_id, "/minc-2.0/image/0/broken", H5T_NATIVE_B16,
+                         space_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    H5Aiterate2(dset_id, H5_INDEX_NAME, H5_ITER_NATIVE, NULL,
+                copy_attribute, &copy_id);
+    H5Dclose(copy_id);
+    H5Sclose(space_id);
+    H5Dclose(dset_id);
+    if (H5Ldelete(file_id, "/minc-2.0/image/0/image", H5P_DEFAULT) >= 0 &&
+        H5Lmove(file_id, "/minc-2.0/image/0/broken", file_id,
+                "/minc-2.0/image/0/image", H5P_DEFAULT, H5P_DEFAULT) >= 0) {
+      r = 0;
+    }
+  }
+  H5Fclose(file_id);
+  return r;
+}
+
+/* A header-only volume whose image can't be opened must keep failing */
+static void check_broken_image(const char *filename)
+{
+  mihandle_t vol;
+  misize_t coords[NDIMS] = {1, 2, 3};
+  mitype_t type;
+  double value;
+  int i;
+
+  if (write_volume(filename, 0) < 0 || break_image(filename) < 0) {
+    TESTRPT("can't make a volume with an unreadable image", 0);
+    remove(filename);
+    return;
+  }
+  if (miopen_volume(filename, MI2_OPEN_READ | MI2_OPEN_HEADER, &vol) < 0) {
+    TESTRPT("header-only open of a volume with unreadable image failed", 0);
+    remove(filename);
+    return;
+  }
+  /* The failure is reported by every access, not just the first one */
+  for (i = 0; i < 2; i++) {
+    if (miget_data_type(vol, &type) >= 0) {
+      TESTRPT("data type of an unreadable image", i);
+    }
+    if (miget_real_value(vol, coords, NDIMS, &value) >= 0) {
+      TESTRPT("read from an unreadable image succeeded", i);
+    }
+  }
+  miclose_volume(vol);
+  remove(filename);
+}
+
+int main(int argc, char **argv)
+{
+  char filename[1024];
+  const char *dirname = ".";
+  int n_files = 64;
+  int n_full, n_header;
+  double t_full, t_header;
+  int i;
+
+  if (argc > 1) {
+    n_files = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    dirname = argv[2];
+  }
+  if (n_files < 0) {
+    fprintf(stderr, "Usage: %s [files] [directory]\n", argv[0]);
+    return 1;
+  }
+
+  for (i = 0; i < n_files; i++) {
+    snprintf(filename, sizeof(filename), "%s/header-bench-%04d.mnc",
+             dirname, i);
+    if (write_volume(filename, i) < 0) {
+      break;
+    }
+  }
+
+  /* The first scan warms the operating system's file cache */
+  scan_directory(dirname, MI2_OPEN_READ, &n_full);
+  t_full = scan_directory(dirname, MI2_OPEN_READ, &n_full);
+  t_header = scan_directory(dirname, MI2_OPEN_READ | MI2_OPEN_HEADER,
+                            &n_header);
+  if (n_full != n_header) {
+    TESTRPT("scans saw different files", n_header);
+  }
+  printf("%-8s %8s %12s %12s\n", "mode", "files", "total(ms)", "per file(ms)");
+  printf("%-8s %8d %12.1f %12.3f\n", "full", n_full, t_full,
+         n_full ? t_full / n_full : 0.0);
+  printf("%-8s %8d %12.1f %12.3f\n", "header", n_header, t_header,
+         n_header ? t_header / n_header : 0.0);
+
+  if (n_files > 0) {
+    snprintf(filename, sizeof(filename), "%s/header-bench-%04d.mnc",
+             dirname, 0);
+    check_header_volume(filename);
+  }
+  for (i = 0; i < n_files; i++) {
+    snprintf(filename, sizeof(filename), "%s/header-bench-%04d.mnc",
+             dirname, i);
+    remove(filename);
+  }
+  snprintf(filename, sizeof(filename), "%s/header-bench-broken.mnc",
+           dirname);
+  check_broken_image(filename);
+
+  if (error_cnt != 0) {
+    fprintf(stderr, "%d error%s reported\n",
+            error_cnt, (error_cnt == 1) ? "" : "s");
+  }
+  else {
+    fprintf(stderr, "No errors\n");
+  }
+  return (error_cnt);
+}
+
+/* kate: indent-mode cstyle; indent-width 2; replace-tabs on; */
@@ -0,0 +1,279 @@
+/* Measure how a file grows when its history is updated over and over.
+ *
+ * A volume is created, once without and once with header space reserved
+ * by miset_props_metadata_reserve(). It is then reopened for writing a
+ * number of times, and each time a line is appended to the history and a
+ * few scalar attributes are rewritten, as a processing pipeline recording
+ * its provenance would. The growth of the file and the time per update
+ * are reported. With the reservation the file must not grow while the
+ * history fits in it, and the history must read back intact either way.
+ * Finally the history alone is appended to over and over, both within one
+ * open and across reopens, and the file must keep its size.
+ *
+ * Usage: minc2-history-bench [updates] [reserve bytes] [file name]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "minc2.h"
+
+#define NDIMS 3
+#define SIZE 64
+#define LINE "mincmath -clobber -add in1.mnc in2.mnc out.mnc\n"
+
+#define TESTRPT(msg, val) (error_cnt++, fprintf(stderr, \
+                                  "Error reported on line #%d, %s: %d\n", \
+                                  __LINE__, msg, val))
+
+static int error_cnt = 0;
+
+static long file_size(const char *filename)
+{
+  struct stat st;
+
+  if (stat(filename, &st) < 0) {
+    return -1;
+  }
+  return (long)st.st_size;
+}
+
+static int create_volume(const char *filename, size_t reserve)
+{
+  char *dimnames[] = {"zspace", "yspace", "xspace"};
+  midimhandle_t hdims[NDIMS];
+  mivolumeprops_t props;
+  mihandle_t vol;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {SIZE, SIZE, SIZE};
+  short *buffer;
+  int i, r;
+
+  for (i = 0; i < NDIMS; i++) {
+    micreate_dimension(dimnames[i], MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, SIZE, &hdims[i]);
+  }
+  minew_volume_props(&props);
+  miset_props_metadata_reserve(props, reserve);
+
+  r = micreate_volume(filename, NDIMS, hdims, MI_TYPE_SHORT, MI_CLASS_REAL,
+                      props, &vol);
+  mifree_volume_props(props);
+  if (r < 0) {
+    TESTRPT("micreate_volume failed", r);
+    return -1;
+  }
+  micreate_volume_image(vol);
+
+  buffer = malloc(SIZE * SIZE * SIZE * sizeof(short));
+  for (i = 0; i < SIZE * SIZE * SIZE; i++) {
+    buffer[i] = (short)(i % 1000);
+  }
+  miset_voxel_value_hyperslab(vol, MI_TYPE_SHORT, start, count, buffer);
+  free(buffer);
+
+  miadd_history_attr(vol, strlen(LINE), LINE);
+  miclose_volume(vol);
+  return 0;
+}
+
+/* Append one history line and rewrite a few attributes, returning the
+ * length of the new history */
+static size_t update_volume(const char *filename, int iteration)
+{
+  mihandle_t vol;
+  char *history;
+  size_t length = 0;
+  double value = iteration;
+
+  if (miopen_volume(filename, MI2_OPEN_RDWR, &vol) < 0) {
+    TESTRPT("miopen_volume failed", iteration);
+    return 0;
+  }
+  miget_attr_length(vol, "", "history", &length);
+
+  history = malloc(length + sizeof(LINE) + 1);
+  if (miget_attr_values(vol, MI_TYPE_STRING, "", "history", length + 1,
+                        history) < 0) {
+    TESTRPT("miget_attr_values failed", iteration);
+    history[0] = '\0';
+  }
+  strcat(history, LINE);
+  length = strlen(history);
+
+  if (miadd_history_attr(vol, length, history) < 0) {
+    TESTRPT("miadd_history_attr failed", iteration);
+  }
+  miset_attr_values(vol, MI_TYPE_DOUBLE, "processing", "iteration", 1, &value);
+  miset_attr_values(vol, MI_TYPE_INT, "processing", "count", 1, &iteration);
+
+  free(history);
+  miclose_volume(vol);
+  return length;
+}
+
+static int check_history(const char *filename, int n_lines)
+{
+  mihandle_t vol;
+  char *history;
+  size_t length = 0;
+  int i, lines = 0;
+
+  if (miopen_volume(filename, MI2_OPEN_READ, &vol) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+    return -1;
+  }
+  miget_attr_length(vol, "", "history", &length);
+  history = malloc(length + 1);
+  miget_attr_values(vol, MI_TYPE_STRING, "", "history", length + 1, history);
+  for (i = 0; history[i] != '\0'; i++) {
+    if (history[i] == '\n') {
+      lines++;
+    }
+  }
+  if (lines != n_lines) {
+    TESTRPT("history has the wrong number of lines", lines);
+  }
+  free(history);
+  miclose_volume(vol);
+  return 0;
+}
+
+/* Append to the history alone, n_updates times within one open and as
+ * many times again reopening the file each time, checking that the file
+ * keeps its size while the history fits in the reserved space */
+static int check_history_growth(const char *filename, size_t reserve,
+                                int n_updates)
+{
+  mihandle_t vol;
+  char *history;
+  size_t length;
+  long size0;
+  int i, pass;
+
+  if (create_volume(filename, reserve) < 0) {
+    return -1;
+  }
+  size0 = file_size(filename);
+  history = malloc((2 * n_updates + 2) * sizeof(LINE));
+  strcpy(history, LINE);
+
+  for (pass = 0; pass < 2; pass++) {
+    if (pass == 0 && miopen_volume(filename, MI2_OPEN_RDWR, &vol) < 0) {
+      TESTRPT("miopen_volume failed", pass);
+      break;
+    }
+    for (i = 0; i < n_updates; i++) {
+      if (pass == 1 && miopen_volume(filename, MI2_OPEN_RDWR, &vol) < 0) {
+        TESTRPT("miopen_volume failed", i);
+        break;
+      }
+      strcat(history, LINE);
+      length = strlen(history);
+      if (length + 512 >= reserve) {
+        TESTRPT("history outgrew the reserved space", (int)length);
+      }
+      if (miadd_history_attr(vol, length, history) < 0) {
+        TESTRPT("miadd_history_attr failed", i);
+      }
+      if (pass == 1) {
+        miclose_volume(vol);
+      }
+    }
+    if (pass == 0) {
+      miclose_volume(vol);
+    }
+    if (file_size(filename) != size0) {
+      TESTRPT("repeated history updates grew the file",
+              (int)(file_size(filename) - size0));
+    }
+  }
+  free(history);
+  check_history(filename, 2 * n_updates + 1);
+  remove(filename);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  const char *filename = "history-bench.mnc";
+  size_t reserve = 65536;
+  size_t reserves[2];
+  int n_updates = 100;
+  int n_fit = 0;
+  int i, j;
+
+  if (argc > 1) {
+    n_updates = atoi(argv[1]);
+  }
+  if (argc > 2) {
+    reserve = (size_t)atol(argv[2]);
+  }
+  if (argc > 3) {
+    filename = argv[3];
+  }
+  reserves[0] = 0;
+  reserves[1] = reserve;
+
+  printf("%-10s %8s %12s %12s %14s\n", "reserve", "updates", "size(kB)",
+         "growth(kB)", "per update(ms)");
+
+  for (j = 0; j < 2; j++) {
+    long size0, size_fit = 0;
+    size_t length = 0;
+    clock_t t0;
+    double t;
+
+    if (create_volume(filename, reserves[j]) < 0) {
+      continue;
+    }
+    size0 = file_size(filename);
+    t0 = clock();
+    for (i = 0; i < n_updates; i++) {
+      length = update_volume(filename, i);
+      /* The first update adds the processing attributes */
+      if (i == 0) {
+        size0 = file_size(filename);
+      }
+      /* Leave room for the other global attributes, within the largest
+         reservation honoured */
+      else if (length + 512 < reserves[j] && length + 512 < 60000) {
+        size_fit = file_size(filename);
+        n_fit = i + 1;
+      }
+    }
+    t = 1000.0 * (clock() - t0) / CLOCKS_PER_SEC;
+
+    printf("%-10lu %8d %12.1f %12.1f %14.3f\n", (unsigned long)reserves[j],
+           n_updates, file_size(filename) / 1024.0,
+           (file_size(filename) - size0) / 1024.0,
+           n_updates ? t / n_updates : 0.0);
+
+    if (reserves[j] > 0 && n_fit > 0 && size_fit != size0) {
+      TESTRPT("file grew within the reserved space",
+              (int)(size_fit - size0));
+    }
+    check_history(filename, n_updates + 1);
+    remove(filename);
+  }
+
+  /* Stay well within the reservation whatever the number of updates */
+  if (reserve > 0) {
+    int n_fit_lines = (int)((reserve < 60000 ? reserve : 60000) / 2 /
+                            sizeof(LINE) / 2);
+    check_history_growth(filename,
+                         reserve, n_updates < n_fit_lines ? n_updates : n_fit_lines);
+  }
+
+  if (error_cnt != 0) {
+    fprintf(stderr, "%d error%s reported\n",
+            error_cnt, (error_cnt == 1) ? "" : "s");
+  }
+  else {
+    fprintf(stderr, "No errors\n");
+  }
+  return (error_cnt);
+}
+
+/* kate: indent-mode cstyle; indent-width 2; replace-tabs on; */
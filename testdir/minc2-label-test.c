@@ -152,6 +152,9 @@ main ( void )
   int blue_value;
   int counter = 0;
   int id;
+  misize_t n_voxels;
+  misize_t *voxels;
+  char *name;
   int *buf = ( int * ) malloc ( CX * CY * CZ * sizeof ( int ) );
   double *dbuf = ( double * ) malloc ( CX * CY * CZ * sizeof ( double ) );
   int result;
@@ -267,6 +270,85 @@ main ( void )
     }
   }
 #endif
+
+  /* Labels are looked up in the cached table */
+  if ( miget_label_name ( vol, white_value, &name ) != MI_NOERROR ) {
+    TESTRPT ( "miget_label_name", white_value );
+  } else {
+    if ( strcmp ( name, "White" ) != 0 ) {
+      TESTRPT ( "miget_label_name, White", 0 );
+    }
+    mifree_name ( name );
+  }
+
+  /* The white voxels are the odd ones, with or without the index */
+  for ( i = 0; i < 2; i++ ) {
+    if ( i == 1 && micreate_label_index ( vol ) != MI_NOERROR ) {
+      TESTRPT ( "micreate_label_index", 0 );
+    }
+    voxels = NULL;
+    if ( miget_label_voxels ( vol, white_value, &n_voxels, &voxels ) != MI_NOERROR ) {
+      TESTRPT ( "miget_label_voxels", i );
+      continue;
+    }
+    if ( n_voxels != CX * CY * CZ / 2 ) {
+      TESTRPT ( "wrong number of white voxels", ( int ) n_voxels );
+    }
+    for ( j = 0; j < ( int ) n_voxels; j++ ) {
+      id = voxels[j * 3] * CY * CX + voxels[j * 3 + 1] * CX + voxels[j * 3 + 2];
+      if ( ( id & 1 ) == 0 ) {
+        TESTRPT ( "voxel is not white", id );
+      }
+    }
+    free ( voxels );
+  }
+  voxels = NULL;
+  if ( miget_label_voxels ( vol, 0xff0000, &n_voxels, &voxels ) != MI_NOERROR ||
+       n_voxels != 0 ) {
+    TESTRPT ( "red voxels found", ( int ) n_voxels );
+  }
+  free ( voxels );
+
+  /* Writing removes the index */
+  coords[0] = coords[1] = coords[2] = 0;
+  miset_voxel_value ( vol, coords, NDIMS, white_value );
+  voxels = NULL;
+  if ( miget_label_voxels ( vol, white_value, &n_voxels, &voxels ) != MI_NOERROR ||
+       n_voxels != CX * CY * CZ / 2 + 1 ) {
+    TESTRPT ( "white voxels not updated", ( int ) n_voxels );
+  }
+  free ( voxels );
+
+  /* Coordinates follow a flipped apparent x axis, with or without the index */
+  miset_dimension_apparent_voxel_order ( cp_hdims[2], MI_COUNTER_FILE_ORDER );
+  for ( i = 0; i < 2; i++ ) {
+    if ( i == 1 && micreate_label_index ( vol ) != MI_NOERROR ) {
+      TESTRPT ( "micreate_label_index", 0 );
+    }
+    voxels = NULL;
+    if ( miget_label_voxels ( vol, white_value, &n_voxels, &voxels ) != MI_NOERROR ) {
+      TESTRPT ( "miget_label_voxels, flipped", i );
+      continue;
+    }
+    if ( n_voxels != CX * CY * CZ / 2 + 1 ) {
+      TESTRPT ( "wrong number of flipped white voxels", ( int ) n_voxels );
+    }
+    for ( j = 0; j < ( int ) n_voxels; j++ ) {
+      double voxel = 0.0;
+
+      id = voxels[j * 3] * CY * CX + voxels[j * 3 + 1] * CX +
+           ( CX - 1 - voxels[j * 3 + 2] );
+      if ( ( id & 1 ) == 0 && id != 0 ) {
+        TESTRPT ( "flipped voxel is not white", id );
+      }
+      miget_voxel_value ( vol, &voxels[j * 3], NDIMS, &voxel );
+      if ( voxel != white_value ) {
+        TESTRPT ( "flipped voxel reads back wrong", ( int ) voxel );
+      }
+    }
+    free ( voxels );
+  }
+
   result = miclose_volume ( vol );
   if (result != MI_NOERROR) {
     error_cnt++;
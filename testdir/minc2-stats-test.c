@@ -0,0 +1,533 @@
+/* Test the volume statistics stored in a MINC file: that they are kept
+ * up to date when requested through the volume properties, that they
+ * match the image, that they are removed when the data or the scaling
+ * change, and that they can be computed on request, within a mask and
+ * for each label of a label volume.
+ *
+ * Usage: minc2-stats-test [file name]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "minc2.h"
+
+#define NDIMS 3
+#define CZ 12
+#define CY 20
+#define CX 24
+#define NVOXELS (CZ * CY * CX)
+#define BINS 64
+#define NLABELS 5
+
+#define TESTRPT(msg, val) (error_cnt++, fprintf(stderr, \
+                                  "Error reported on line #%d, %s: %d\n", \
+                                  __LINE__, msg, val))
+
+static int error_cnt = 0;
+
+static int create_volume(const char *filename)
+{
+  char *dimnames[] = {"zspace", "yspace", "xspace"};
+  misize_t lengths[NDIMS] = {CZ, CY, CX};
+  midimhandle_t hdims[NDIMS];
+  mivolumeprops_t props;
+  mihandle_t vol;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {CZ, CY, CX};
+  unsigned short buffer[NVOXELS];
+  int i, r;
+
+  for (i = 0; i < NDIMS; i++) {
+    micreate_dimension(dimnames[i], MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, lengths[i], &hdims[i]);
+  }
+  minew_volume_props(&props);
+  miset_props_statistics(props, BINS);
+
+  r = micreate_volume(filename, NDIMS, hdims, MI_TYPE_USHORT, MI_CLASS_REAL,
+                      props, &vol);
+  mifree_volume_props(props);
+  if (r < 0) {
+    TESTRPT("micreate_volume failed", r);
+    return -1;
+  }
+  miset_slice_scaling_flag(vol, TRUE);
+  micreate_volume_image(vol);
+  miset_volume_valid_range(vol, 4095, 0);
+
+  for (i = 0; i < NVOXELS; i++) {
+    buffer[i] = (unsigned short)((i * 7919) % 4096);
+  }
+  miset_voxel_value_hyperslab(vol, MI_TYPE_USHORT, start, count, buffer);
+
+  start[1] = start[2] = 0;
+  for (i = 0; i < CZ; i++) {
+    start[0] = i;
+    miset_slice_range(vol, start, NDIMS, 100.0 + i, -10.0 * i);
+  }
+  /* Closing computes the statistics */
+  miclose_volume(vol);
+  return 0;
+}
+
+/* Compare the stored statistics with a scan of the image */
+static void check_statistics(mihandle_t vol, const mivolstats_t *stats)
+{
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {CZ, CY, CX};
+  double *values = malloc(NVOXELS * sizeof(double));
+  double sum = 0.0, sum2 = 0.0, min = 1e300, max = -1e300;
+  double width, median, sorted_median;
+  int below = 0;
+  int i;
+
+  miget_real_value_hyperslab(vol, MI_TYPE_DOUBLE, start, count, values);
+  for (i = 0; i < NVOXELS; i++) {
+    sum += values[i];
+    sum2 += values[i] * values[i];
+    if (values[i] < min) min = values[i];
+    if (values[i] > max) max = values[i];
+  }
+  if (stats->count != NVOXELS) {
+    TESTRPT("wrong voxel count", (int)stats->count);
+  }
+  if (fabs(stats->sum - sum) > 1e-9 * fabs(sum) ||
+      fabs(stats->sum2 - sum2) > 1e-9 * fabs(sum2)) {
+    TESTRPT("wrong sums", 0);
+  }
+  if (stats->min != min || stats->max != max) {
+    TESTRPT("wrong range", (int)stats->max);
+  }
+  if (fabs(stats->mean - sum / NVOXELS) > 1e-9) {
+    TESTRPT("wrong mean", (int)stats->mean);
+  }
+  sum2 = 0.0;
+  for (i = 0; i < NVOXELS; i++) {
+    sum2 += (values[i] - stats->mean) * (values[i] - stats->mean);
+  }
+  if (fabs(stats->stddev - sqrt(sum2 / (NVOXELS - 1))) > 1e-9 * stats->stddev) {
+    TESTRPT("wrong standard deviation", (int)stats->stddev);
+  }
+  sum = 0.0;
+  for (i = 0; i < stats->bins; i++) {
+    sum += stats->histogram[i];
+  }
+  if (sum != NVOXELS) {
+    TESTRPT("histogram does not add up", (int)sum);
+  }
+
+  /* The estimated median must split the voxels evenly, to within a bin */
+  width = (stats->hist_max - stats->hist_min) / stats->bins;
+  if (miget_statistics_percentile(stats, 50.0, &median) < 0) {
+    TESTRPT("miget_statistics_percentile failed", 0);
+  }
+  for (i = 0; i < NVOXELS; i++) {
+    if (values[i] < median - width) {
+      below++;
+    }
+  }
+  if (below > NVOXELS / 2) {
+    TESTRPT("median estimate too high", below);
+  }
+  below = 0;
+  for (i = 0; i < NVOXELS; i++) {
+    if (values[i] <= median + width) {
+      below++;
+    }
+  }
+  if (below < NVOXELS / 2) {
+    TESTRPT("median estimate too low", below);
+  }
+  sorted_median = 0.0;
+  if (miget_statistics_percentile(stats, 0.0, &sorted_median) < 0 ||
+      sorted_median != min ||
+      miget_statistics_percentile(stats, 100.0, &sorted_median) < 0 ||
+      sorted_median != max) {
+    TESTRPT("extreme percentiles differ from the range", 0);
+  }
+  free(values);
+}
+
+/* Write a float volume of the same dimensions, voxel i holding f(i) */
+static int create_float_volume(const char *filename, double (*f)(int))
+{
+  char *dimnames[] = {"zspace", "yspace", "xspace"};
+  misize_t lengths[NDIMS] = {CZ, CY, CX};
+  midimhandle_t hdims[NDIMS];
+  mihandle_t vol;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {CZ, CY, CX};
+  float buffer[NVOXELS];
+  int i, r;
+
+  for (i = 0; i < NDIMS; i++) {
+    micreate_dimension(dimnames[i], MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, lengths[i], &hdims[i]);
+  }
+  r = micreate_volume(filename, NDIMS, hdims, MI_TYPE_FLOAT, MI_CLASS_REAL,
+                      NULL, &vol);
+  if (r < 0) {
+    TESTRPT("micreate_volume failed", r);
+    return -1;
+  }
+  micreate_volume_image(vol);
+  for (i = 0; i < NVOXELS; i++) {
+    buffer[i] = (float) f(i);
+  }
+  miset_voxel_value_hyperslab(vol, MI_TYPE_FLOAT, start, count, buffer);
+  miset_volume_range(vol, NLABELS, 0);
+  miclose_volume(vol);
+  return 0;
+}
+
+static double mask_value(int i)
+{
+  return (i % 3) == 0 ? 1.0 : 0.0;
+}
+
+static double label_value(int i)
+{
+  return (double)((i / 7) % NLABELS);
+}
+
+/* Statistics within a mask and per label must match a scan of the image */
+static void check_mask_and_labels(mihandle_t vol, const char *mask_name,
+                                  const char *label_name)
+{
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {CZ, CY, CX};
+  double *values = malloc(NVOXELS * sizeof(double));
+  double sum[NLABELS], sum2[NLABELS];
+  double mask_sum = 0.0, mask_sum2 = 0.0, mean, var;
+  int n[NLABELS];
+  int mask_n = 0;
+  mihandle_t mask, labels;
+  mivolstats_t stats, *label_stats;
+  int *label_values;
+  int n_labels;
+  int i;
+
+  if (create_float_volume(mask_name, mask_value) < 0 ||
+      create_float_volume(label_name, label_value) < 0 ||
+      miopen_volume(mask_name, MI2_OPEN_READ, &mask) < 0 ||
+      miopen_volume(label_name, MI2_OPEN_READ, &labels) < 0) {
+    TESTRPT("can't create mask and label volumes", 0);
+    free(values);
+    return;
+  }
+  miget_real_value_hyperslab(vol, MI_TYPE_DOUBLE, start, count, values);
+  for (i = 0; i < NLABELS; i++) {
+    sum[i] = sum2[i] = 0.0;
+    n[i] = 0;
+  }
+  for (i = 0; i < NVOXELS; i++) {
+    int label = (int) label_value(i);
+
+    sum[label] += values[i];
+    sum2[label] += values[i] * values[i];
+    n[label]++;
+    if (mask_value(i) > 0.0) {
+      mask_sum += values[i];
+      mask_sum2 += values[i] * values[i];
+      mask_n++;
+    }
+  }
+
+  if (micompute_masked_statistics(vol, mask, 0, &stats) < 0) {
+    TESTRPT("micompute_masked_statistics failed", 0);
+  } else {
+    mean = mask_sum / mask_n;
+    var = (mask_sum2 - mask_sum * mean) / (mask_n - 1);
+    if (stats.count != (misize_t) mask_n ||
+        fabs(stats.mean - mean) > 1e-9 * fabs(mean) ||
+        fabs(stats.stddev - sqrt(var)) > 1e-6 * sqrt(var)) {
+      TESTRPT("wrong masked statistics", (int) stats.count);
+    }
+    if (stats.histogram != NULL) {
+      TESTRPT("histogram made without bins", stats.bins);
+    }
+    mifree_volume_statistics(&stats);
+  }
+
+  if (micompute_label_statistics(vol, labels, NULL, 8, &n_labels,
+                                 &label_values, &label_stats) < 0) {
+    TESTRPT("micompute_label_statistics failed", 0);
+  } else {
+    if (n_labels != NLABELS) {
+      TESTRPT("wrong number of labels", n_labels);
+    }
+    for (i = 0; i < n_labels && i < NLABELS; i++) {
+      double hist_total = 0.0;
+      int b;
+
+      mean = sum[i] / n[i];
+      if (label_values[i] != i || label_stats[i].count != (misize_t) n[i] ||
+          fabs(label_stats[i].mean - mean) > 1e-9 * fabs(mean) ||
+          fabs(label_stats[i].sum2 - sum2[i]) > 1e-9 * sum2[i]) {
+        TESTRPT("wrong label statistics", label_values[i]);
+      }
+      for (b = 0; b < label_stats[i].bins; b++) {
+        hist_total += label_stats[i].histogram[b];
+      }
+      if (hist_total != n[i]) {
+        TESTRPT("label histogram does not add up", (int) hist_total);
+      }
+    }
+    mifree_label_statistics(n_labels, label_values, label_stats);
+  }
+
+  /* Labels within the mask */
+  if (micompute_label_statistics(vol, labels, mask, 0, &n_labels,
+                                 &label_values, &label_stats) < 0) {
+    TESTRPT("micompute_label_statistics failed", 0);
+  } else {
+    misize_t total = 0;
+
+    for (i = 0; i < n_labels; i++) {
+      total += label_stats[i].count;
+    }
+    if (total != (misize_t) mask_n) {
+      TESTRPT("masked label counts do not add up", (int) total);
+    }
+    mifree_label_statistics(n_labels, label_values, label_stats);
+  }
+
+  miclose_volume(mask);
+  miclose_volume(labels);
+  remove(mask_name);
+  remove(label_name);
+  free(values);
+}
+
+/* The labels of a label volume are its voxel values, not real values
+ * scaled to the valid range of the voxel type */
+static void check_label_class(mihandle_t vol, const char *label_name)
+{
+  char *dimnames[] = {"zspace", "yspace", "xspace"};
+  misize_t lengths[NDIMS] = {CZ, CY, CX};
+  midimhandle_t hdims[NDIMS];
+  mihandle_t labels;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {CZ, CY, CX};
+  unsigned char buffer[NVOXELS];
+  mivolstats_t *label_stats;
+  int *label_values;
+  int n[NLABELS] = {0};
+  int n_labels;
+  int i, r;
+
+  for (i = 0; i < NDIMS; i++) {
+    micreate_dimension(dimnames[i], MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, lengths[i], &hdims[i]);
+  }
+  r = micreate_volume(label_name, NDIMS, hdims, MI_TYPE_UBYTE, MI_CLASS_LABEL,
+                      NULL, &labels);
+  if (r < 0) {
+    TESTRPT("micreate_volume failed", r);
+    return;
+  }
+  /* An enumerated type can't be empty */
+  for (i = 0; i < NLABELS; i++) {
+    char name[16];
+
+    snprintf(name, sizeof(name), "label%d", i);
+    midefine_label(labels, i, name);
+  }
+  micreate_volume_image(labels);
+  for (i = 0; i < NVOXELS; i++) {
+    buffer[i] = (unsigned char) label_value(i);
+    n[buffer[i]]++;
+  }
+  miset_voxel_value_hyperslab(labels, MI_TYPE_UBYTE, start, count, buffer);
+  miclose_volume(labels);
+
+  if (miopen_volume(label_name, MI2_OPEN_READ, &labels) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+    return;
+  }
+  if (micompute_label_statistics(vol, labels, NULL, 0, &n_labels,
+                                 &label_values, &label_stats) < 0) {
+    TESTRPT("micompute_label_statistics failed", 0);
+  } else {
+    if (n_labels != NLABELS) {
+      TESTRPT("wrong number of labels in a label volume", n_labels);
+    }
+    for (i = 0; i < n_labels && i < NLABELS; i++) {
+      if (label_values[i] != i || label_stats[i].count != (misize_t) n[i]) {
+        TESTRPT("wrong label count in a label volume", label_values[i]);
+      }
+    }
+    mifree_label_statistics(n_labels, label_values, label_stats);
+  }
+  miclose_volume(labels);
+  remove(label_name);
+}
+
+/* The stored standard deviation must survive a large offset, where the
+ * sum of squares has lost all the digits of the variance */
+static void check_large_offset(const char *filename)
+{
+  char *dimnames[] = {"zspace", "yspace", "xspace"};
+  midimhandle_t hdims[NDIMS];
+  mivolumeprops_t props;
+  mivolstats_t stats;
+  mihandle_t vol;
+  misize_t start[NDIMS] = {0, 0, 0};
+  misize_t count[NDIMS] = {CZ, CY, CX};
+  double *buffer = malloc(NVOXELS * sizeof(double));
+  double expected;
+  int i;
+
+  for (i = 0; i < NDIMS; i++) {
+    micreate_dimension(dimnames[i], MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, count[i], &hdims[i]);
+  }
+  minew_volume_props(&props);
+  miset_props_statistics(props, BINS);
+  if (micreate_volume(filename, NDIMS, hdims, MI_TYPE_DOUBLE, MI_CLASS_REAL,
+                      props, &vol) < 0) {
+    TESTRPT("micreate_volume failed", 0);
+    mifree_volume_props(props);
+    for (i = 0; i < NDIMS; i++) {
+      mifree_dimension_handle(hdims[i]);
+    }
+    free(buffer);
+    return;
+  }
+  mifree_volume_props(props);
+  micreate_volume_image(vol);
+  for (i = 0; i < NVOXELS; i++) {
+    buffer[i] = 1e9 + (i % 3);
+  }
+  miset_volume_valid_range(vol, 1e9 + 2, 1e9);
+  miset_voxel_value_hyperslab(vol, MI_TYPE_DOUBLE, start, count, buffer);
+  miclose_volume(vol);
+
+  /* The values 0, 1 and 2 in equal numbers around the offset */
+  expected = sqrt(2.0 / 3.0 * NVOXELS / (NVOXELS - 1));
+  if (miopen_volume(filename, MI2_OPEN_READ, &vol) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+  } else {
+    if (miget_volume_statistics(vol, &stats) < 0) {
+      TESTRPT("no statistics stored", 0);
+    } else {
+      if (fabs(stats.stddev - expected) > 1e-6) {
+        TESTRPT("standard deviation lost to the offset",
+                (int)(stats.stddev * 1000));
+      }
+      mifree_volume_statistics(&stats);
+    }
+    miclose_volume(vol);
+  }
+  remove(filename);
+  free(buffer);
+}
+
+int main(int argc, char **argv)
+{
+  const char *filename = "stats-test.mnc";
+  char mask_name[1024], label_name[1024];
+  misize_t coords[NDIMS] = {1, 2, 3};
+  mivolstats_t stats;
+  mihandle_t vol;
+
+  if (argc > 1) {
+    filename = argv[1];
+  }
+  if (create_volume(filename) < 0) {
+    return 1;
+  }
+
+  /* Stored when the volume was closed */
+  if (miopen_volume(filename, MI2_OPEN_READ, &vol) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+    return 1;
+  }
+  if (miget_volume_statistics(vol, &stats) < 0) {
+    TESTRPT("no statistics stored", 0);
+  } else {
+    if (stats.bins != BINS) {
+      TESTRPT("wrong number of bins", stats.bins);
+    }
+    check_statistics(vol, &stats);
+    mifree_volume_statistics(&stats);
+  }
+  miclose_volume(vol);
+
+  /* Writing data removes them */
+  if (miopen_volume(filename, MI2_OPEN_RDWR, &vol) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+    return 1;
+  }
+  miset_voxel_value(vol, coords, NDIMS, 17.0);
+  if (miget_volume_statistics(vol, &stats) == MI_NOERROR) {
+    TESTRPT("statistics kept after a write", 0);
+    mifree_volume_statistics(&stats);
+  }
+  miclose_volume(vol);
+
+  if (miopen_volume(filename, MI2_OPEN_READ, &vol) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+    return 1;
+  }
+  if (miget_volume_statistics(vol, &stats) == MI_NOERROR) {
+    TESTRPT("statistics stored after a write", 0);
+    mifree_volume_statistics(&stats);
+  }
+  /* Computed but not stored in a read-only volume */
+  if (micompute_volume_statistics(vol, 10, &stats) < 0) {
+    TESTRPT("micompute_volume_statistics failed", 0);
+  } else {
+    check_statistics(vol, &stats);
+    mifree_volume_statistics(&stats);
+  }
+  snprintf(mask_name, sizeof(mask_name), "%s.mask.mnc", filename);
+  snprintf(label_name, sizeof(label_name), "%s.labels.mnc", filename);
+  check_mask_and_labels(vol, mask_name, label_name);
+  check_label_class(vol, label_name);
+  miclose_volume(vol);
+
+  /* Computed and stored on request */
+  if (miopen_volume(filename, MI2_OPEN_RDWR, &vol) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+    return 1;
+  }
+  if (micompute_volume_statistics(vol, 100, NULL) < 0) {
+    TESTRPT("micompute_volume_statistics failed", 0);
+  }
+  miclose_volume(vol);
+
+  if (miopen_volume(filename, MI2_OPEN_RDWR, &vol) < 0) {
+    TESTRPT("miopen_volume failed", 0);
+    return 1;
+  }
+  if (miget_volume_statistics(vol, &stats) < 0 || stats.bins != 100) {
+    TESTRPT("statistics not stored on request", stats.bins);
+  } else {
+    check_statistics(vol, &stats);
+    mifree_volume_statistics(&stats);
+  }
+
+  /* Changing the scaling removes them too */
+  miset_slice_range(vol, coords, NDIMS, 500.0, 0.0);
+  if (miget_volume_statistics(vol, &stats) == MI_NOERROR) {
+    TESTRPT("statistics kept after a scaling change", 0);
+    mifree_volume_statistics(&stats);
+  }
+  miclose_volume(vol);
+  remove(filename);
+
+  check_large_offset(filename);
+
+  if (error_cnt != 0) {
+    fprintf(stderr, "%d error%s reported\n",
+            error_cnt, (error_cnt == 1) ? "" : "s");
+  }
+  else {
+    fprintf(stderr, "No errors\n");
+  }
+  return (error_cnt);
+}
+
+/* kate: indent-mode cstyle; indent-width 2; replace-tabs on; */
@@ -54,6 +54,173 @@ static void create_test_file ( void )
   free(buf);
 }
 
+/* Write a small vector volume with interleaved or planar components and
+ * check that single components read back like the interleaved data */
+#define PZ 6
+#define PY 10
+#define PX 14
+#define PV 6
+
+/* Read the chunk shape of the image dataset, in file order */
+static int get_image_chunk ( const char *filename, hsize_t chunk[] )
+{
+  hid_t file_id, dset_id, plist_id;
+  int rank = -1;
+
+  file_id = H5Fopen ( filename, H5F_ACC_RDONLY, H5P_DEFAULT );
+  if ( file_id < 0 ) {
+    return -1;
+  }
+  dset_id = H5Dopen2 ( file_id, "/minc-2.0/image/0/image", H5P_DEFAULT );
+  if ( dset_id >= 0 ) {
+    plist_id = H5Dget_create_plist ( dset_id );
+    rank = H5Pget_chunk ( plist_id, NDIMS, chunk );
+    H5Pclose ( plist_id );
+    H5Dclose ( dset_id );
+  }
+  H5Fclose ( file_id );
+  return rank;
+}
+
+static void check_components ( miboolean_t planar )
+{
+  midimhandle_t hdim[NDIMS];
+  mivolumeprops_t props;
+  mihandle_t hvol;
+  float *buf = malloc ( PZ * PY * PX * PV * sizeof ( float ) );
+  float *comp = malloc ( PZ * PY * PX * sizeof ( float ) );
+  double *real = malloc ( PZ * PY * PX * sizeof ( double ) );
+  misize_t start[NDIMS] = {0, 0, 0, 0};
+  misize_t count[NDIMS] = {PZ, PY, PX, PV};
+  miboolean_t flag = FALSE;
+  int i, v;
+
+  micreate_dimension ( "zspace", MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, PZ, &hdim[0] );
+  micreate_dimension ( "yspace", MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, PY, &hdim[1] );
+  micreate_dimension ( "xspace", MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, PX, &hdim[2] );
+  micreate_dimension ( "vector_dimension", MI_DIMCLASS_RECORD,
+                       MI_DIMATTR_REGULARLY_SAMPLED, PV, &hdim[3] );
+
+  minew_volume_props ( &props );
+  miset_props_planar_components ( props, planar );
+  miget_props_planar_components ( props, &flag );
+  if ( flag != planar ) {
+    TESTRPT ( "planar components property not kept", flag );
+  }
+  if ( micreate_volume ( "example_planar.mnc", NDIMS, hdim, MI_TYPE_FLOAT,
+                         MI_CLASS_REAL, props, &hvol ) < 0 ) {
+    TESTRPT ( "failed to create vector volume", planar );
+    mifree_volume_props ( props );
+    return;
+  }
+  mifree_volume_props ( props );
+  micreate_volume_image ( hvol );
+
+  for ( i = 0; i < PZ * PY * PX * PV; i++ ) {
+    buf[i] = ( float ) i;
+  }
+  miset_voxel_value_hyperslab ( hvol, MI_TYPE_FLOAT, start, count, buf );
+  miset_volume_range ( hvol, PZ * PY * PX * PV, 0 );
+  miclose_volume ( hvol );
+
+  if ( planar ) {
+    hsize_t chunk[NDIMS];
+
+    if ( get_image_chunk ( "example_planar.mnc", chunk ) != NDIMS ) {
+      TESTRPT ( "planar volume is not chunked", 0 );
+    } else if ( chunk[3] != 1 ) {
+      TESTRPT ( "wrong record chunk edge", ( int ) chunk[3] );
+    }
+  }
+
+  if ( miopen_volume ( "example_planar.mnc", MI2_OPEN_READ, &hvol ) < 0 ) {
+    TESTRPT ( "failed to open vector volume", planar );
+    return;
+  }
+  /* The record entries of start and count are ignored */
+  start[1] = 2;
+  count[1] = PY - 4;
+  start[3] = 5;
+  count[3] = 99;
+  for ( v = 0; v < PV; v++ ) {
+    if ( miget_voxel_component_hyperslab ( hvol, MI_TYPE_FLOAT, v, start, count,
+                                           comp ) < 0 ||
+         miget_real_component_hyperslab ( hvol, MI_TYPE_DOUBLE, v, start, count,
+                                          real ) < 0 ) {
+      TESTRPT ( "failed to read a component", v );
+      continue;
+    }
+    for ( i = 0; i < PZ * ( PY - 4 ) * PX; i++ ) {
+      int z = i / ( ( PY - 4 ) * PX );
+      int y = ( i / PX ) % ( PY - 4 ) + 2;
+      int x = i % PX;
+      float expected = buf[( ( z * PY + y ) * PX + x ) * PV + v];
+
+      if ( comp[i] != expected || real[i] != expected ) {
+        TESTRPT ( "component value differs", i );
+        break;
+      }
+    }
+  }
+  if ( miget_voxel_component_hyperslab ( hvol, MI_TYPE_FLOAT, PV, start, count,
+                                         comp ) >= 0 ) {
+    TESTRPT ( "component out of range accepted", PV );
+  }
+  miclose_volume ( hvol );
+  remove ( "example_planar.mnc" );
+  free ( buf );
+  free ( comp );
+  free ( real );
+}
+
+/* Planar chunks are as large as those of a scalar volume: the record
+ * dimension must not count towards the default chunk size */
+#define LZ 64
+#define LY 128
+#define LX 128
+#define LV 3
+
+static void check_planar_chunks ( void )
+{
+  midimhandle_t hdim[NDIMS];
+  mivolumeprops_t props;
+  mihandle_t hvol;
+  hsize_t chunk[NDIMS];
+
+  micreate_dimension ( "zspace", MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, LZ, &hdim[0] );
+  micreate_dimension ( "yspace", MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, LY, &hdim[1] );
+  micreate_dimension ( "xspace", MI_DIMCLASS_SPATIAL,
+                       MI_DIMATTR_REGULARLY_SAMPLED, LX, &hdim[2] );
+  micreate_dimension ( "vector_dimension", MI_DIMCLASS_RECORD,
+                       MI_DIMATTR_REGULARLY_SAMPLED, LV, &hdim[3] );
+
+  minew_volume_props ( &props );
+  miset_props_planar_components ( props, TRUE );
+  if ( micreate_volume ( "example_planar_large.mnc", NDIMS, hdim, MI_TYPE_FLOAT,
+                         MI_CLASS_REAL, props, &hvol ) < 0 ) {
+    TESTRPT ( "failed to create planar volume", 0 );
+    mifree_volume_props ( props );
+    return;
+  }
+  mifree_volume_props ( props );
+  micreate_volume_image ( hvol );
+  miclose_volume ( hvol );
+
+  /* Whole planes, as many as fit into the 1000000 byte default chunk */
+  if ( get_image_chunk ( "example_planar_large.mnc", chunk ) != NDIMS ) {
+    TESTRPT ( "planar volume is not chunked", 0 );
+  } else if ( chunk[3] != 1 || chunk[2] != LX || chunk[1] != LY ||
+              chunk[0] != 1000000 / ( LY * LX * sizeof ( float ) ) ) {
+    TESTRPT ( "wrong planar chunk shape", ( int ) chunk[0] );
+  }
+  remove ( "example_planar_large.mnc" );
+}
+
 int main ( void )
 {
   mihandle_t vol;
@@ -178,6 +345,10 @@ int main ( void )
   free(Atmp);
   miclose_volume(vol);
 
+  check_components ( FALSE );
+  check_components ( TRUE );
+  check_planar_chunks();
+
   if ( error_cnt != 0 ) {
     fprintf ( stderr, "%d error%s reported\n",
               error_cnt, ( error_cnt == 1 ) ? "" : "s" );
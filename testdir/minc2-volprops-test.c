@@ -19,7 +19,9 @@ int main(int argc, char **argv)
   int depth;
   int edge_lengths[MI2_MAX_VAR_DIMS];
   int edge_count;
+  int flag;
   int i;
+  size_t reserve;
 
   r = minew_volume_props(&props);
 
@@ -73,6 +75,43 @@ int main(int argc, char **argv)
     printf("Got zlib level %d \n", zlib_level);
   }
 
+  r = miset_props_compression_type(props, MI_COMPRESS_ZSTD);
+  if (r < 0) {
+    TESTRPT("failed", r);
+  }
+  r = miget_props_compression_type(props,&compression_type);
+  if (r < 0 || compression_type != MI_COMPRESS_ZSTD) {
+    TESTRPT("failed", r);
+  }
+  else {
+    printf("Got compression type %d \n", compression_type);
+  }
+
+  r = miset_props_shuffle(props, 1);
+  if (r < 0) {
+    TESTRPT("failed", r);
+  }
+  r = miget_props_shuffle(props, &flag);
+  if (r < 0 || flag != 1) {
+    TESTRPT("failed", r);
+  }
+  r = miset_props_scaleoffset(props, 1);
+  if (r < 0) {
+    TESTRPT("failed", r);
+  }
+  r = miget_props_scaleoffset(props, &flag);
+  if (r < 0 || flag != 1) {
+    TESTRPT("failed", r);
+  }
+  r = miset_props_metadata_reserve(props, 16384);
+  if (r < 0) {
+    TESTRPT("failed", r);
+  }
+  r = miget_props_metadata_reserve(props, &reserve);
+  if (r < 0 || reserve != 16384) {
+    TESTRPT("failed", r);
+  }
+
   mifree_volume_props(props);
 
   while (--argc > 0) {
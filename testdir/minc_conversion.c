@@ -6,6 +6,7 @@
 #include <minc2.h>
 #include <limits.h>
 #include <float.h>
+#include <math.h>
 #if HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -392,6 +393,113 @@ static void test4(struct testinfo *ip, struct dimdef *dims, int ndims)
   
 }
 
+/* Test case 5 - unsigned byte image over the record dimension, with
+ * per-frame image-max and image-min, so that every record holds three
+ * variables padded to 4 bytes.
+ */
+#define NFRAMES 3
+#define FYSIZE 5
+#define FXSIZE 7
+
+static void test5(void)
+{
+  char *name;
+  int fd;
+  int dim[3];
+  int maxid, minid, imgid;
+  int stat;
+  long start[3] = {0, 0, 0};
+  long count[3] = {NFRAMES, FYSIZE, FXSIZE};
+  unsigned char values[NFRAMES][FYSIZE][FXSIZE];
+  unsigned char result[NFRAMES][FYSIZE][FXSIZE];
+  double frame_max[NFRAMES];
+  double frame_min[NFRAMES];
+  mihandle_t vol;
+  misize_t vstart[3] = {0, 0, 0};
+  misize_t vcount[3] = {NFRAMES, FYSIZE, FXSIZE};
+  misize_t location[3] = {NFRAMES - 1, 1, 2};
+  double real_value;
+  int ndim;
+  int t, y, x;
+
+  printf("test5\n");
+
+  name = micreate_tempfile();
+  if (name == NULL) {
+    FUNC_ERROR("micreate_tempfile");
+    return;
+  }
+  fd = micreate(name, NC_CLOBBER|MI2_CREATE_V1);
+  if (fd < 0) {
+    FUNC_ERROR("micreate");
+    free(name);
+    return;
+  }
+
+  dim[0] = ncdimdef(fd, MItime, NC_UNLIMITED);
+  dim[1] = ncdimdef(fd, MIyspace, FYSIZE);
+  dim[2] = ncdimdef(fd, MIxspace, FXSIZE);
+  maxid = micreate_std_variable(fd, (char*)MIimagemax, NC_DOUBLE, 1, dim);
+  minid = micreate_std_variable(fd, (char*)MIimagemin, NC_DOUBLE, 1, dim);
+  imgid = micreate_std_variable(fd, (char*)MIimage, NC_BYTE, 3, dim);
+  if (maxid < 0 || minid < 0 || imgid < 0) {
+    FUNC_ERROR("micreate_std_variable");
+  }
+  miattputstr(fd, imgid, MIsigntype, MI_UNSIGNED);
+  miattputdbl(fd, imgid, MIvalid_max, 255.0);
+  miattputdbl(fd, imgid, MIvalid_min, 0.0);
+  ncendef(fd);
+
+  for (t = 0; t < NFRAMES; t++) {
+    frame_max[t] = t + 1.0;
+    frame_min[t] = 0.0;
+    for (y = 0; y < FYSIZE; y++) {
+      for (x = 0; x < FXSIZE; x++) {
+        values[t][y][x] = (unsigned char) (t * 100 + y * 10 + x);
+      }
+    }
+  }
+  if (ncvarput(fd, maxid, start, count, frame_max) < 0 ||
+      ncvarput(fd, minid, start, count, frame_min) < 0 ||
+      ncvarput(fd, imgid, start, count, values) < 0) {
+    FUNC_ERROR("ncvarput");
+  }
+  miclose(fd);
+
+  if (miopen_volume(name, MI2_OPEN_READ, &vol) < 0) {
+    FUNC_ERROR("miopen_volume");
+  }
+  else {
+    if (miget_volume_dimension_count(vol, MI_DIMCLASS_ANY, MI_DIMATTR_ALL,
+                                     &ndim) < 0 || ndim != 3) {
+      FUNC_ERROR("miget_volume_dimension_count");
+    }
+
+    stat = miget_voxel_value_hyperslab(vol, MI_TYPE_UBYTE, vstart, vcount,
+                                       result);
+    if (stat < 0) {
+      FUNC_ERROR("miget_voxel_value_hyperslab");
+    }
+    else if (memcmp(values, result, sizeof(values)) != 0) {
+      fprintf(stderr, "5. Data error in the record image\n");
+      errors++;
+    }
+
+    /* Scaled by the image-max of the last frame */
+    if (miget_real_value(vol, location, 3, &real_value) < 0) {
+      FUNC_ERROR("miget_real_value");
+    }
+    else if (fabs(real_value - values[NFRAMES - 1][1][2] / 255.0 * NFRAMES) > 1e-6) {
+      fprintf(stderr, "5. Real value error %f\n", real_value);
+      errors++;
+    }
+    miclose_volume(vol);
+  }
+
+  unlink(name);
+  free(name);
+}
+
 /* Test MINC API's 
  */
 int main(int argc, char **argv)
@@ -410,6 +518,8 @@ int main(int argc, char **argv)
   
   /*now let's use MINC2 API*/
   test4(&info, dimtab1, 3);
+
+  test5();
   
   /*unlink(info.name);*/		/* Delete the temporary file. */
 